@@ -25,6 +25,8 @@
 
 #include "AbortableRenderInfo.h"
 
+#include <algorithm> // max
+#include <memory>
 #include <set>
 #include <sstream>
 #include <string>
@@ -51,6 +53,49 @@ NATRON_NAMESPACE_ENTER
 
 typedef std::set<AbortableThread*> ThreadSet;
 
+NATRON_NAMESPACE_ANONYMOUS_ENTER
+
+/**
+ * @brief Accumulates the abort latency of all aborted renders in the process, see AbortableRenderInfo::getAbortLatencyStatistics
+ **/
+struct AbortLatencyStatistics
+{
+    QMutex lock;
+    int nbAbortedRenders;
+    double lastLatency;
+    double totalLatency;
+    double maxLatency;
+
+    AbortLatencyStatistics()
+        : lock()
+        , nbAbortedRenders(0)
+        , lastLatency(0.)
+        , totalLatency(0.)
+        , maxLatency(0.)
+    {
+    }
+
+    void addLatency(double latency)
+    {
+        QMutexLocker k(&lock);
+
+        ++nbAbortedRenders;
+        lastLatency = latency;
+        totalLatency += latency;
+        maxLatency = std::max(maxLatency, latency);
+    }
+};
+
+AbortLatencyStatistics&
+abortLatencyStatistics()
+{
+    static AbortLatencyStatistics stats;
+
+    return stats;
+}
+
+NATRON_NAMESPACE_ANONYMOUS_EXIT
+
 struct AbortableRenderInfoPrivate
 {
     AbortableRenderInfo* _p;
@@ -64,6 +109,12 @@ struct AbortableRenderInfoPrivate
     QTimer* abortTimeoutTimer;
     QThread* ownerThread;
 
+    // Started when setAborted() is called, protected by threadsMutex
+    std::unique_ptr<TimeLapse> abortRequestTimer;
+
+    // Time between setAborted() and the exit of the last thread of the render, protected by threadsMutex
+    double abortLatency;
+
     AbortableRenderInfoPrivate(AbortableRenderInfo* p,
                                bool canAbort,
                                U64 age)
@@ -77,6 +128,8 @@ struct AbortableRenderInfoPrivate
         , timerStarted(false)
         , abortTimeoutTimer(new QTimer)
         , ownerThread( QThread::currentThread() )
+        , abortRequestTimer()
+        , abortLatency(-1.)
     {
         aborted.fetchAndStoreAcquire(0);
 
@@ -131,6 +184,21 @@ AbortableRenderInfo::setAborted()
     if (abortedValue > 0) {
         return;
     }
+
+    // Measure the time it takes for all threads of this render to exit
+    bool noThreadRunning;
+    {
+        QMutexLocker k(&_imp->threadsMutex);
+        _imp->abortRequestTimer.reset(new TimeLapse);
+        noThreadRunning = _imp->threadsForThisRender.empty();
+        if (noThreadRunning) {
+            _imp->abortLatency = 0.;
+        }
+    }
+    if (noThreadRunning) {
+        abortLatencyStatistics().addLatency(0.);
+    }
+
     bool callInSeparateThread = false;
     {
         QMutexLocker k(&_imp->timerMutex);
@@ -159,6 +227,7 @@ AbortableRenderInfo::unregisterThreadForRender(AbortableThread* thread)
 {
     bool ret = false;
     bool threadsEmpty = false;
+    double abortLatency = -1.;
     {
         QMutexLocker k(&_imp->threadsMutex);
         ThreadSet::iterator found = _imp->threadsForThisRender.find(thread);
@@ -169,6 +238,16 @@ AbortableRenderInfo::unregisterThreadForRender(AbortableThread* thread)
         }
         // Stop the timer if no more threads are running for this render
         threadsEmpty = _imp->threadsForThisRender.empty();
+
+        // This was the last thread running for an aborted render: record how long it took to exit
+        if ( threadsEmpty && ret && _imp->abortRequestTimer && (_imp->abortLatency < 0) ) {
+            _imp->abortLatency = _imp->abortRequestTimer->getTimeSinceCreation();
+            abortLatency = _imp->abortLatency;
+        }
+    }
+
+    if (abortLatency >= 0) {
+        abortLatencyStatistics().addLatency(abortLatency);
     }
 
     if (threadsEmpty) {
@@ -183,6 +262,29 @@ AbortableRenderInfo::unregisterThreadForRender(AbortableThread* thread)
     return ret;
 }
 
+double
+AbortableRenderInfo::getAbortLatency() const
+{
+    QMutexLocker k(&_imp->threadsMutex);
+
+    return _imp->abortLatency;
+}
+
+void
+AbortableRenderInfo::getAbortLatencyStatistics(int* nbAbortedRenders,
+                                               double* lastLatency,
+                                               double* averageLatency,
+                                               double* maxLatency)
+{
+    AbortLatencyStatistics& stats = abortLatencyStatistics();
+    QMutexLocker k(&stats.lock);
+
+    *nbAbortedRenders = stats.nbAbortedRenders;
+    *lastLatency = stats.lastLatency;
+    *averageLatency = stats.nbAbortedRenders > 0 ? stats.totalLatency / stats.nbAbortedRenders : 0.;
+    *maxLatency = stats.maxLatency;
+}
+
 void
 AbortableRenderInfo::onStartTimerInOriginalThreadTriggered()
 {
@@ -130,6 +130,21 @@ public:
      **/
     bool unregisterThreadForRender(AbortableThread* thread);
 
+    /**
+     * @brief Returns the time (in seconds) elapsed between the call to setAborted() and the moment the last thread
+     * registered for this render exited, or -1 if the render was not aborted or some threads are still running.
+     **/
+    double getAbortLatency() const;
+
+    /**
+     * @brief Returns statistics over all the renders aborted so far in this process. This is used to monitor how
+     * responsive the Viewer stays while the user interacts with a heavy graph. Latencies are in seconds.
+     **/
+    static void getAbortLatencyStatistics(int* nbAbortedRenders,
+                                          double* lastLatency,
+                                          double* averageLatency,
+                                          double* maxLatency);
+
 public Q_SLOTS:
 
     /**
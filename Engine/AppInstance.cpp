@@ -40,6 +40,7 @@
 #include <QtCore/QUrl>
 #include <QtCore/QFileInfo>
 #include <QtCore/QEventLoop>
+#include <QtCore/QThread>
 #include <QtCore/QSettings>
 #include <QtNetwork/QNetworkReply>
 
@@ -69,6 +70,7 @@ CLANG_DIAG_ON(unknown-pragmas)
 #include "Engine/ProcessHandler.h"
 #include "Engine/ReadNode.h"
 #include "Engine/Settings.h"
+#include "Engine/Timer.h"
 #include "Engine/WriteNode.h"
 
 NATRON_NAMESPACE_ENTER
@@ -601,12 +603,14 @@ AppInstance::loadInternal(const CLArgs& cl,
 
         std::list<AppInstance::RenderWork> writersWork;
 
-
-        if ( info.suffix() == QString::fromUtf8(NATRON_PROJECT_FILE_EXT) ) {
+        TimeLapse phaseTimer;
+        if ( ( info.suffix() == QString::fromUtf8(NATRON_PROJECT_FILE_EXT) ) ||
+             ( info.suffix() == QString::fromUtf8(NATRON_PROJECT_BINARY_FILE_EXT) ) ) {
             ///Load the project
             if ( !_imp->_currentProject->loadProject( info.path(), info.fileName() ) ) {
                 throw std::invalid_argument( tr("Project file loading failed.").toStdString() );
             }
+            appPTR->reportStartupPhase("Project load", phaseTimer.getTimeElapsedReset());
         } else if ( info.suffix() == QString::fromUtf8("py") ) {
             ///Load the python script
             loadPythonScript(info);
@@ -623,6 +627,23 @@ AppInstance::loadInternal(const CLArgs& cl,
             }
         }
 
+        ///Convert the project instead of rendering it, the format is given by the extension of the file
+        const QString& saveAsFilePath = cl.getSaveAsFilePath();
+        if ( !saveAsFilePath.isEmpty() ) {
+            QFileInfo saveAsInfo(saveAsFilePath);
+            QString saveAsDir = saveAsInfo.absolutePath();
+            StrUtils::ensureLastPathSeparator(saveAsDir);
+            phaseTimer.getTimeElapsedReset();
+            if ( !_imp->_currentProject->saveProject(saveAsDir, saveAsInfo.fileName(), 0) ) {
+                throw std::runtime_error( tr("Failed to save the project to %1.").arg(saveAsFilePath).toStdString() );
+            }
+            double saveTime = phaseTimer.getTimeElapsedReset();
+            appPTR->reportStartupPhase("Project save", saveTime);
+            std::cout << tr("Project saved to %1 in %2 s.").arg(saveAsFilePath).arg(saveTime).toStdString() << std::endl;
+
+            return;
+        }
+
 
         getWritersWorkForCL(cl, writersWork);
 
@@ -656,6 +677,10 @@ AppInstance::loadInternal(const CLArgs& cl,
             }
         }
 
+        appPTR->reportStartupPhase("Render setup", phaseTimer.getTimeElapsedReset());
+        ///Background renders block until all frames are written: end the startup profile before they are launched
+        appPTR->printStartupProfile();
+
         ///launch renders
         if ( !writersWork.empty() ) {
             startWritersRendering(false, writersWork);
@@ -668,7 +693,8 @@ AppInstance::loadInternal(const CLArgs& cl,
         if ( info.exists() ) {
             if ( info.suffix() == QString::fromUtf8("py") ) {
                 loadPythonScript(info);
-            } else if ( info.suffix() == QString::fromUtf8(NATRON_PROJECT_FILE_EXT) ) {
+            } else if ( ( info.suffix() == QString::fromUtf8(NATRON_PROJECT_FILE_EXT) ) ||
+                        ( info.suffix() == QString::fromUtf8(NATRON_PROJECT_BINARY_FILE_EXT) ) ) {
                 if ( !_imp->_currentProject->loadProject( info.path(), info.fileName() ) ) {
                     throw std::invalid_argument( tr("Project file loading failed.").toStdString() );
                 }
@@ -904,6 +930,8 @@ AppInstance::createNodeFromPythonModule(Plugin* plugin,
 
         int appID = getAppID() + 1;
         std::stringstream ss;
+        ///PyPlugs registered from the registry cache were never imported, import the module before using it
+        ss << "import " << moduleName.toStdString() << "\n";
         ss << moduleName.toStdString();
         ss << ".createInstance(app" << appID;
         if (istoolsetScript) {
@@ -1227,6 +1255,16 @@ AppInstance::createNodeInternal(CreateNodeArgs& args)
 
             assert(ofxDesc);
             plugin->setOfxDesc(ofxDesc, ctx);
+        } else if ( plugin->isOfxPluginDeferred() ) {
+            // The plug-in was registered from the OpenFX registry cache but its binary could not be described
+            QString message = tr("Failed to create an instance of %1:").arg(argsPluginID) + QLatin1Char('\n') + tr("The OpenFX plug-in could not be loaded.");
+            if (!isSilentCreation) {
+                errorDialog(tr("Error while creating node").toStdString(), message.toStdString(), false);
+            } else {
+                std::cerr << message.toStdString() << std::endl;
+            }
+
+            return NodePtr();
         }
     }
 
@@ -1767,7 +1805,17 @@ AppInstance::startWritersRendering(bool doBlockingRender,
     }
 
 
-    bool renderInSeparateProcess = appPTR->getCurrentSettings()->isRenderInSeparatedProcessEnabled();
+    const bool isBlocking = appPTR->isBackground() || doBlockingRender;
+    bool renderInSeparateProcess;
+    if (isBlocking) {
+        ///A blocking render only uses separate processes to split the frame range: the processes are driven by the
+        ///event loop of the main thread. A background process started by a ProcessHandler never starts processes itself.
+        renderInSeparateProcess = !appPTR->isManagedBackgroundProcess() &&
+                                  appPTR->getCurrentSettings()->getNumberOfRenderProcesses() > 1 &&
+                                  QThread::currentThread() == qApp->thread();
+    } else {
+        renderInSeparateProcess = appPTR->getCurrentSettings()->isRenderInSeparatedProcessEnabled();
+    }
     QString savePath;
     if (renderInSeparateProcess) {
         getProject()->saveProject_imp(QString(), QString::fromUtf8("RENDER_SAVE.ntp"), true, false, &savePath);
@@ -1786,8 +1834,11 @@ AppInstance::startWritersRendering(bool doBlockingRender,
         _imp->getSequenceNameFromWriter(it->writer, &item.sequenceName);
         item.savePath = savePath;
 
-        if (renderInSeparateProcess) {
-            item.process = std::make_shared<ProcessHandler>(savePath, item.work.writer);
+        // Writers producing a single file cannot be split across processes
+        int nbProcesses = item.work.writer->isVideoWriter() ? 1 : appPTR->getCurrentSettings()->getNumberOfRenderProcesses();
+        if ( renderInSeparateProcess && (!isBlocking || nbProcesses > 1) ) {
+            item.process = std::make_shared<ProcessHandler>(savePath, item.work.writer, item.work.firstFrame, item.work.lastFrame,
+                                                            item.work.frameStep, item.work.useRenderStats, nbProcesses);
             QObject::connect( item.process.get(), SIGNAL(processFinished(int)), this, SLOT(onBackgroundRenderProcessFinished()) );
         } else {
             QObject::connect(item.work.writer->getRenderEngine().get(), SIGNAL(renderFinished(int)), this, SLOT(onQueuedRenderFinished(int)), Qt::UniqueConnection);
@@ -1806,7 +1857,17 @@ AppInstance::startWritersRendering(bool doBlockingRender,
         return;
     }
 
-    if (appPTR->isBackground() || doBlockingRender) {
+    if (isBlocking) {
+        ///Renders in separate processes need the event loop of this thread: run them one after another before the others
+        for (std::list<RenderQueueItem>::iterator it = itemsToQueue.begin(); it != itemsToQueue.end();) {
+            if (it->process) {
+                _imp->startRenderingFullSequence(true, *it);
+                it = itemsToQueue.erase(it);
+            } else {
+                ++it;
+            }
+        }
+
         //blocking call, we don't want this function to return pre-maturely, in which case it would kill the app
         QtConcurrent::blockingMap( itemsToQueue, [&](RenderQueueItem item) {
             _imp->startRenderingFullSequence(true, item);
@@ -1905,6 +1966,15 @@ AppInstancePrivate::startRenderingFullSequence(bool blocking,
                                                const RenderQueueItem& w)
 {
     if (blocking) {
+        if (w.process) {
+            ///The queued connection ensures the loop quits even if the process fails right away in startProcess()
+            QEventLoop loop;
+            QObject::connect( w.process.get(), SIGNAL(processFinished(int)), &loop, SLOT(quit()), Qt::QueuedConnection );
+            w.process->startProcess();
+            loop.exec();
+
+            return;
+        }
         BlockingBackgroundRender backgroundRender(w.work.writer);
         backgroundRender.blockingRender(w.work.useRenderStats, w.work.firstFrame, w.work.lastFrame, w.work.frameStep); //< doesn't return before rendering is finished
         return;
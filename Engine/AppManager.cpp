@@ -55,6 +55,7 @@
 #include <cstring> // for std::memcpy
 #include <sstream> // stringstream
 #include <locale>
+#include <algorithm> // std::max
 
 #include <QtCore/QtGlobal> // for Q_OS_*
 #if defined(Q_OS_LINUX)
@@ -87,7 +88,10 @@
 
 #include <QtCore/QDateTime>
 #include <QtCore/QDebug>
+#include <QtCore/QDataStream>
 #include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
 #include <QtCore/QTextCodec>
 #include <QtCore/QCoreApplication>
 #include <QtCore/QSettings>
@@ -134,6 +138,7 @@
 #include "Engine/StandardPaths.h"
 #include "Engine/TrackerNode.h"
 #include "Engine/ThreadPool.h"
+#include "Engine/Timer.h"
 #include "Engine/Utils.h"
 #include "Engine/ViewIdx.h"
 #include "Engine/ViewerInstance.h" // RenderStatsMap
@@ -313,6 +318,8 @@ StrUtils::ensureLastPathSeparator(QString& path)
 bool
 AppManager::loadFromArgs(const CLArgs& cl)
 {
+    _imp->startupProfilingEnabled = cl.isStartupProfilingEnabled();
+    _imp->startupTimer.reset(new TimeLapse);
 
 #ifdef DEBUG
 #if PY_MAJOR_VERSION >= 3
@@ -377,7 +384,9 @@ AppManager::loadFromArgs(const CLArgs& cl)
     }
 
     try {
+        TimeLapse phaseTimer;
         initPython(); // calls Py_InitializeEx(), which calls setlocale()
+        reportStartupPhase("Python initialization", phaseTimer.getTimeElapsedReset());
     } catch (const std::runtime_error& e) {
         std::cerr << e.what() << std::endl;
 
@@ -730,6 +739,7 @@ AppManager::loadInternal(const CLArgs& cl)
 # endif
 
 
+    TimeLapse settingsTimer;
     _imp->_settings = std::make_shared<Settings>();
     _imp->_settings->initializeKnobsPublic();
 
@@ -780,6 +790,8 @@ AppManager::loadInternal(const CLArgs& cl)
         }
     }
 
+    reportStartupPhase("Settings", settingsTimer.getTimeElapsedReset());
+
     ///basically show a splashScreen load fonts etc...
     return initGui(cl);
 } // loadInternal
@@ -959,6 +971,7 @@ AppManager::initGui(const CLArgs& cl)
 bool
 AppManager::loadInternalAfterInitGui(const CLArgs& cl)
 {
+    TimeLapse cachesTimer;
     try {
         size_t maxCacheRAM = _imp->_settings->getRamMaximumPercent() * getSystemTotalRAM();
         U64 viewerCacheSize = _imp->_settings->getMaximumViewerDiskCacheSize();
@@ -990,12 +1003,17 @@ AppManager::loadInternalAfterInitGui(const CLArgs& cl)
         _imp->restoreCaches();
     }
 
+    if ( cl.isPyPlugsCacheClearRequestedOnLaunch() ) {
+        clearPyPlugsRegistry();
+    }
+
     if (cl.isOpenFXCacheClearRequestedOnLaunch()) {
         setLoadingStatus( tr("Clearing the OpenFX Plugins cache...") );
         clearPluginsLoadedCache();
     } else {
         setLoadingStatus( tr("Loading plugin cache...") );
     }
+    reportStartupPhase("Caches", cachesTimer.getTimeElapsedReset());
 
 
     ///Set host properties after restoring settings since it depends on the host name.
@@ -1005,6 +1023,12 @@ AppManager::loadInternalAfterInitGui(const CLArgs& cl)
         // ignore
     }
 
+    // In background project auto-run only the plug-ins referenced by the project are needed:
+    // the PyPlugs are registered on demand, see ensurePyPlugsLoaded()
+    _imp->deferPyPlugsLoading = ( isBackground() && !cl.isInterpreterMode() &&
+                                  ( cl.getScriptFilename().endsWith( QString::fromUtf8("." NATRON_PROJECT_FILE_EXT) ) ||
+                                    cl.getScriptFilename().endsWith( QString::fromUtf8("." NATRON_PROJECT_BINARY_FILE_EXT) ) ) );
+
     /*loading all plugins*/
     try {
         loadAllPlugins();
@@ -1012,6 +1036,8 @@ AppManager::loadInternalAfterInitGui(const CLArgs& cl)
     } catch (std::logic_error&) {
         // ignore
     }
+    // From now on, deferred PyPlugs are registered as soon as they are needed
+    _imp->deferPyPlugsLoading = false;
 
     if ( isBackground() && !cl.getIPCPipeName().isEmpty() ) {
         _imp->initProcessInputChannel( cl.getIPCPipeName() );
@@ -1045,6 +1071,8 @@ AppManager::loadInternalAfterInitGui(const CLArgs& cl)
 
     AppInstancePtr mainInstance = newAppInstance(args, false);
 
+    printStartupProfile();
+
     hideSplashScreen();
 
     if (!mainInstance) {
@@ -1289,6 +1317,12 @@ AppManager::clearPluginsLoadedCache()
     _imp->ofxHost->clearPluginsLoadedCache();
 }
 
+void
+AppManager::ensureOFXPluginDescribed(const Plugin* plugin) const
+{
+    _imp->ofxHost->ensurePluginDescribed( plugin->getPluginID().toStdString(), plugin->getMajorVersion() );
+}
+
 void
 AppManager::clearAllCaches()
 {
@@ -1387,6 +1421,12 @@ AppManager::writeToOutputPipe(const QString & longMessage,
     return true;
 }
 
+bool
+AppManager::isManagedBackgroundProcess() const
+{
+    return _imp->_backgroundIPC.get() != 0;
+}
+
 void
 AppManager::setApplicationsCachesMaximumMemoryPercent(double p)
 {
@@ -1414,20 +1454,26 @@ AppManager::loadAllPlugins()
     assert( _imp->_plugins.empty() );
     assert( _imp->_formats.empty() );
 
+    TimeLapse phaseTimer;
+
     // Load plug-ins bundled into Natron
     loadBuiltinNodePlugins(&_imp->readerPlugins, &_imp->writerPlugins);
+    reportStartupPhase("Built-in plug-ins", phaseTimer.getTimeElapsedReset());
 
     // Load OpenFX plug-ins
     _imp->ofxHost->loadOFXPlugins( &_imp->readerPlugins, &_imp->writerPlugins);
+    reportStartupPhase("OpenFX plug-ins", phaseTimer.getTimeElapsedReset());
 
     // Load PyPlugs and init.py & initGui.py scripts
     // Should be done after settings are declared
     loadPythonGroups();
+    reportStartupPhase("Python scripts and PyPlugs", phaseTimer.getTimeElapsedReset());
 
     _imp->_settings->restorePluginSettings();
 
 
     onAllPluginsLoaded();
+    reportStartupPhase("Plug-in settings", phaseTimer.getTimeElapsedReset());
 }
 
 void
@@ -1944,8 +1990,178 @@ AppManager::loadPythonGroups()
         }
     }
 
+    if (_imp->deferPyPlugsLoading) {
+        QMutexLocker k(&_imp->deferredPyPlugsMutex);
+        _imp->deferredPyPlugs = allPlugins;
+        indexDeferredPyPlugs();
+
+        return;
+    }
+
+    loadPyPlugs(allPlugins);
+} // AppManager::loadPythonGroups
+
+/**
+ * @brief What loadPyPlugs() learnt about a Python file of the plug-ins search path. Files that did not change since
+ * are registered from the PyPlugs registry cache without importing their module.
+ **/
+struct PyPlugRegistryEntry
+{
+    qint64 lastModified;
+    qint64 size;
+    bool isPyPlug;
+    bool importsNatronGui;
+    QString pluginID, pluginLabel, iconFilePath, pluginGrouping, pluginDescription;
+    bool isToolset;
+    quint32 version;
+
+    PyPlugRegistryEntry()
+        : lastModified(0)
+        , size(0)
+        , isPyPlug(false)
+        , importsNatronGui(false)
+        , pluginID()
+        , pluginLabel()
+        , iconFilePath()
+        , pluginGrouping()
+        , pluginDescription()
+        , isToolset(false)
+        , version(1)
+    {
+    }
+};
+
+typedef std::map<QString, PyPlugRegistryEntry> PyPlugRegistry;
+
+// Bump whenever the layout of the PyPlugs registry cache changes
+#define NATRON_PYPLUGS_REGISTRY_VERSION 1
+
+static QString
+getPyPlugsRegistryFilePath()
+{
+    return appPTR->getDiskCacheLocation() + QString::fromUtf8("/PyPlugsRegistry_") +
+           QString::fromUtf8(NATRON_VERSION_STRING) + QString::fromUtf8(".bin");
+}
+
+static void
+readPyPlugsRegistry(PyPlugRegistry* registry)
+{
+    QFile file( getPyPlugsRegistryFilePath() );
+
+    if ( !file.open(QIODevice::ReadOnly) ) {
+        return;
+    }
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_4_8);
+
+    quint32 version = 0, nEntries = 0;
+    stream >> version >> nEntries;
+    if ( (stream.status() != QDataStream::Ok) || (version != NATRON_PYPLUGS_REGISTRY_VERSION) ) {
+        return;
+    }
+    for (quint32 i = 0; i < nEntries; ++i) {
+        QString filePath;
+        PyPlugRegistryEntry e;
+        stream >> filePath >> e.lastModified >> e.size >> e.isPyPlug >> e.importsNatronGui
+               >> e.pluginID >> e.pluginLabel >> e.iconFilePath >> e.pluginGrouping >> e.pluginDescription
+               >> e.isToolset >> e.version;
+        if (stream.status() != QDataStream::Ok) {
+            registry->clear();
+
+            return;
+        }
+        (*registry)[filePath] = e;
+    }
+}
+
+static void
+writePyPlugsRegistry(const PyPlugRegistry& registry)
+{
+    QString filePath = getPyPlugsRegistryFilePath();
+    QString tmpFileName = filePath + QString::fromUtf8(".tmp");
+    {
+        QFile file(tmpFileName);
+        if ( !file.open(QIODevice::WriteOnly | QIODevice::Truncate) ) {
+            return;
+        }
+        QDataStream stream(&file);
+        stream.setVersion(QDataStream::Qt_4_8);
+        stream << (quint32)NATRON_PYPLUGS_REGISTRY_VERSION << (quint32)registry.size();
+        for (PyPlugRegistry::const_iterator it = registry.begin(); it != registry.end(); ++it) {
+            const PyPlugRegistryEntry& e = it->second;
+            stream << it->first << e.lastModified << e.size << e.isPyPlug << e.importsNatronGui
+                   << e.pluginID << e.pluginLabel << e.iconFilePath << e.pluginGrouping << e.pluginDescription
+                   << e.isToolset << e.version;
+        }
+        if (stream.status() != QDataStream::Ok) {
+            file.close();
+            QFile::remove(tmpFileName);
+
+            return;
+        }
+    }
+    if ( QFile::exists(filePath) ) {
+        QFile::remove(filePath);
+    }
+    QFile::rename(tmpFileName, filePath);
+}
+
+void
+AppManager::clearPyPlugsRegistry()
+{
+    QString filePath = getPyPlugsRegistryFilePath();
+
+    if ( QFile::exists(filePath) ) {
+        QFile::remove(filePath);
+    }
+}
+
+void
+AppManager::indexDeferredPyPlugs()
+{
+    PyPlugRegistry registry;
+
+    readPyPlugsRegistry(&registry);
+
+    _imp->deferredPyPlugsByID.clear();
+    _imp->unindexedPyPlugs.clear();
+    Q_FOREACH(const QString &plugin, _imp->deferredPyPlugs) {
+        QFileInfo fileInfo(plugin);
+        PyPlugRegistry::const_iterator found = registry.find(plugin);
+        bool upToDate = ( found != registry.end() && found->second.lastModified == fileInfo.lastModified().toMSecsSinceEpoch() &&
+                          found->second.size == fileInfo.size() );
+        if (!upToDate) {
+            _imp->unindexedPyPlugs.push_back(plugin);
+        } else if (found->second.isPyPlug) {
+            _imp->deferredPyPlugsByID[found->second.pluginID.toLower()].push_back(plugin);
+        }
+    }
+}
+
+void
+AppManager::loadPyPlugs(const QStringList& allPlugins,
+                        bool keepOtherRegistryEntries)
+{
+#ifdef NATRON_RUN_WITHOUT_PYTHON
+
+    return;
+#endif
+    PythonGILLocker pgl;
+
     appPTR->setLoadingStatus( tr("Loading PyPlugs...") );
 
+    TimeLapse timer;
+    PyPlugRegistry registry;
+    readPyPlugsRegistry(&registry);
+
+    // Only the files that are still on the search path are kept in the registry, unless only some of them are loaded
+    PyPlugRegistry newRegistry;
+    if (keepOtherRegistryEntries) {
+        newRegistry = registry;
+    }
+    int nFromRegistry = 0, nImported = 0;
+    bool registryChanged = false;
+
     Q_FOREACH(const QString &plugin, allPlugins) {
         QString moduleName = plugin;
         QString modulePath;
@@ -1960,66 +2176,183 @@ AppManager::loadPythonGroups()
             moduleName = moduleName.remove(0, lastSlash + 1);
         }
 
+        QFileInfo fileInfo(plugin);
+        PyPlugRegistryEntry entry;
+        entry.lastModified = fileInfo.lastModified().toMSecsSinceEpoch();
+        entry.size = fileInfo.size();
+
+        PyPlugRegistry::const_iterator found = registry.find(plugin);
+        bool upToDate = found != registry.end() && found->second.lastModified == entry.lastModified && found->second.size == entry.size;
+        if (upToDate) {
+            entry = found->second;
+        } else {
+            registryChanged = true;
 
-        {
             // Open the file and check for a line that imports NatronGui, if so do not attempt to load the script.
             QFile file(plugin);
             if (!file.open(QIODevice::ReadOnly)) {
                 continue;
             }
             QTextStream ts(&file);
-            bool gotNatronGuiImport = false;
-            bool isPyPlug = false;
             while (!ts.atEnd()) {
                 QString line = ts.readLine();
                 if (line.startsWith(QString::fromUtf8("import %1").arg(QLatin1String(NATRON_GUI_PYTHON_MODULE_NAME))) ||
                     line.startsWith(QString::fromUtf8("from %1 import").arg(QLatin1String(NATRON_GUI_PYTHON_MODULE_NAME)))) {
-                    gotNatronGuiImport = true;
+                    entry.importsNatronGui = true;
                 }
                 // We have to find a way to tell PyPlugs from other python files.
                 // We could check if the file was created by Natron...
                 if (line.startsWith(QString::fromUtf8(NATRON_PYPLUG_GENERATED))) {
-                    isPyPlug = true;
+                    entry.isPyPlug = true;
                 }
                 // Or we could check if createInstance(app,group) is defined
                 if ( line.startsWith( QString::fromUtf8("def createInstance(") ) ) {
-                    isPyPlug = true;
+                    entry.isPyPlug = true;
                 }
                 // Or we could check if it implements getIsToolSet()
                 if ( line.startsWith( QString::fromUtf8("def getIsToolSet(") ) ) {
-                    isPyPlug = true;
+                    entry.isPyPlug = true;
                 }
                 // Or we could check for the magic line that is in the doc.
                 // See https://natron.readthedocs.io/en/master/devel/groups.html#creating-a-group-by-hand
                 // and https://natron.readthedocs.io/en/master/devel/groups.html#toolsets
                 if ( line.startsWith( QString::fromUtf8(NATRON_PYPLUG_MAGIC) ) ) {
-                    isPyPlug = true;
+                    entry.isPyPlug = true;
                 }
             }
-            if (appPTR->isBackground() && gotNatronGuiImport) {
-                continue;
+        }
+
+        if (appPTR->isBackground() && entry.importsNatronGui) {
+            // Never imported in background: keep it in the registry unless its description is still unknown
+            if (upToDate || !entry.isPyPlug) {
+                newRegistry[plugin] = entry;
             }
-            if (!isPyPlug) {
+            continue;
+        }
+        if (!entry.isPyPlug) {
+            newRegistry[plugin] = entry;
+            continue;
+        }
+
+        if (upToDate) {
+            ++nFromRegistry;
+        } else {
+            // Import the module to get its description
+            std::string pluginLabel, pluginID, pluginGrouping, iconFilePath, pluginDescription;
+            unsigned int version;
+            bool isToolset;
+            bool gotInfos = NATRON_PYTHON_NAMESPACE::getGroupInfos(modulePath.toStdString(), moduleName.toStdString(), &pluginID, &pluginLabel, &iconFilePath, &pluginGrouping, &pluginDescription, &isToolset, &version);
+            if (!gotInfos) {
+                // Do not remember failures, the module may import fine next time
                 continue;
             }
+            ++nImported;
+            entry.pluginID = QString::fromUtf8( pluginID.c_str() );
+            entry.pluginLabel = QString::fromUtf8( pluginLabel.c_str() );
+            entry.iconFilePath = QString::fromUtf8( iconFilePath.c_str() );
+            entry.pluginGrouping = QString::fromUtf8( pluginGrouping.c_str() );
+            entry.pluginDescription = QString::fromUtf8( pluginDescription.c_str() );
+            entry.isToolset = isToolset;
+            entry.version = version;
         }
+        newRegistry[plugin] = entry;
 
-        std::string pluginLabel, pluginID, pluginGrouping, iconFilePath, pluginDescription;
-        unsigned int version;
-        bool isToolset;
-        bool gotInfos = NATRON_PYTHON_NAMESPACE::getGroupInfos(modulePath.toStdString(), moduleName.toStdString(), &pluginID, &pluginLabel, &iconFilePath, &pluginGrouping, &pluginDescription, &isToolset, &version);
+        qDebug() << "Loading" << moduleName;
+        QStringList grouping = entry.pluginGrouping.split( QChar::fromLatin1('/') );
+        Plugin* p = registerPlugin(modulePath, grouping, entry.pluginID, entry.pluginLabel, entry.iconFilePath, QStringList(), false, false, 0, false, entry.version, 0, false);
 
+        p->setPythonModule(modulePath + moduleName);
+        p->setToolsetScript(entry.isToolset);
+    }
 
-        if (gotInfos) {
-            qDebug() << "Loading" << moduleName;
-            QStringList grouping = QString::fromUtf8( pluginGrouping.c_str() ).split( QChar::fromLatin1('/') );
-            Plugin* p = registerPlugin(modulePath, grouping, QString::fromUtf8( pluginID.c_str() ), QString::fromUtf8( pluginLabel.c_str() ), QString::fromUtf8( iconFilePath.c_str() ), QStringList(), false, false, 0, false, version, 0, false);
+    if ( registryChanged || ( newRegistry.size() != registry.size() ) ) {
+        writePyPlugsRegistry(newRegistry);
+    }
 
-            p->setPythonModule(modulePath + moduleName);
-            p->setToolsetScript(isToolset);
+    QString report = tr("PyPlugs: %1 registered from the registry cache, %2 imported in %3 s")
+                     .arg(nFromRegistry).arg(nImported).arg(timer.getTimeElapsedReset(), 0, 'f', 3);
+    if ( isStartupProfilingEnabled() ) {
+        std::cout << report.toStdString() << std::endl;
+    } else {
+        qDebug() << report;
+    }
+} // AppManager::loadPyPlugs
+
+bool
+AppManager::ensurePyPlugsLoaded(const QString& pluginID) const
+{
+    // The mutex is recursive: registering a PyPlug may look up other plug-ins
+    QMutexLocker k(&_imp->deferredPyPlugsMutex);
+
+    // Plug-ins are still being loaded at startup
+    if ( _imp->deferPyPlugsLoading || _imp->deferredPyPlugs.isEmpty() ) {
+        return false;
+    }
+    QStringList plugins;
+    if ( pluginID.isEmpty() ) {
+        plugins.swap(_imp->deferredPyPlugs);
+        _imp->deferredPyPlugsByID.clear();
+        _imp->unindexedPyPlugs.clear();
+    } else {
+        // Only the files that may define this ID are registered: the one known from the registry cache,
+        // otherwise the files that must be imported to know their ID
+        std::map<QString, QStringList>::iterator found = _imp->deferredPyPlugsByID.find( pluginID.toLower() );
+        if ( found != _imp->deferredPyPlugsByID.end() ) {
+            plugins = found->second;
+            _imp->deferredPyPlugsByID.erase(found);
+        } else {
+            plugins.swap(_imp->unindexedPyPlugs);
+        }
+        if ( plugins.isEmpty() ) {
+            return false;
+        }
+        Q_FOREACH(const QString &plugin, plugins) {
+            _imp->deferredPyPlugs.removeAll(plugin);
         }
     }
-} // AppManager::loadPythonGroups
+
+    const_cast<AppManager*>(this)->loadPyPlugs(plugins, !pluginID.isEmpty());
+    _imp->_settings->restorePluginSettings();
+
+    return true;
+}
+
+void
+AppManager::reportStartupPhase(const std::string& phase,
+                               double seconds)
+{
+    if (!_imp->startupProfilingEnabled) {
+        return;
+    }
+    _imp->startupPhases.push_back( std::make_pair(phase, seconds) );
+}
+
+bool
+AppManager::isStartupProfilingEnabled() const
+{
+    return _imp->startupProfilingEnabled;
+}
+
+void
+AppManager::printStartupProfile()
+{
+    if (!_imp->startupProfilingEnabled || !_imp->startupTimer) {
+        return;
+    }
+    double total = _imp->startupTimer->getTimeSinceCreation();
+    double profiled = 0.;
+
+    std::cout << "Startup profile:" << std::endl;
+    for (std::list<std::pair<std::string, double> >::const_iterator it = _imp->startupPhases.begin(); it != _imp->startupPhases.end(); ++it) {
+        std::cout << "    " << it->first << ": " << QString::number(it->second, 'f', 3).toStdString() << " s" << std::endl;
+        profiled += it->second;
+    }
+    std::cout << "    Other: " << QString::number(std::max(0., total - profiled), 'f', 3).toStdString() << " s" << std::endl;
+    std::cout << "    Total: " << QString::number(total, 'f', 3).toStdString() << " s" << std::endl;
+    _imp->startupPhases.clear();
+    ///The startup is over: any later call is a no-op
+    _imp->startupTimer.reset();
+}
 
 Plugin*
 AppManager::registerPlugin(const QString& resourcesPath,
@@ -2127,6 +2460,8 @@ AppManager::clearExceedingEntriesFromNodeCache()
 const PluginsMap&
 AppManager::getPluginsList() const
 {
+    ensurePyPlugsLoaded();
+
     return _imp->_plugins;
 }
 
@@ -2222,6 +2557,11 @@ AppManager::getPluginBinaryFromOldID(const QString & pluginId,
         }
     }
 
+    // The plug-in may be a PyPlug that was not registered yet
+    if ( ensurePyPlugsLoaded(pluginId) ) {
+        return getPluginBinaryFromOldID(pluginId, majorVersion, minorVersion);
+    }
+
     return 0;
 }
 
@@ -2294,6 +2634,10 @@ AppManager::getPluginBinary(const QString & pluginId,
         // else the highest version.
         return nextPlugin;
     }
+    // The plug-in may be a PyPlug that was not registered yet
+    if ( ensurePyPlugsLoaded(pluginId) ) {
+        return getPluginBinary(pluginId, majorVersion, minorVersion, convertToLowerCase);
+    }
     QString exc = QString::fromUtf8("Couldn't find a plugin attached to the ID %1, with a major version of %2")
                   .arg(pluginId)
                   .arg(majorVersion);
@@ -2482,6 +2826,12 @@ AppManager::getCachesTotalMemorySize() const
     return  _imp->_nodeCache->getMemoryCacheSize();
 }
 
+U64
+AppManager::getCachesMaximumMemorySize() const
+{
+    return  _imp->_nodeCache->getMaximumMemorySize();
+}
+
 U64
 AppManager::getCachesTotalDiskSize() const
 {
@@ -2928,6 +3278,8 @@ AppManager::onOFXDialogOnMainThreadReceived(OfxImageEffectInstance* instance,
 std::list<std::string>
 AppManager::getPluginIDs() const
 {
+    ensurePyPlugsLoaded();
+
     std::list<std::string> ret;
 
     for (PluginsMap::const_iterator it = _imp->_plugins.begin(); it != _imp->_plugins.end(); ++it) {
@@ -2941,6 +3293,8 @@ AppManager::getPluginIDs() const
 std::list<std::string>
 AppManager::getPluginIDs(const std::string& filter)
 {
+    ensurePyPlugsLoaded();
+
     QString qFilter = QString::fromUtf8( filter.c_str() );
     std::list<std::string> ret;
 
@@ -190,6 +190,28 @@ public:
                             bool convertToLowerCase) const WARN_UNUSED_RETURN;
     Plugin* getPluginBinaryFromOldID(const QString & pluginId, int majorVersion, int minorVersion) const WARN_UNUSED_RETURN;
 
+    /**
+     * @brief In background project auto-run, PyPlugs found at startup are only registered once a plug-in lookup
+     * fails or the full plug-in registry is requested. This registers the deferred PyPlugs that may have the given
+     * ID, or all of them if the ID is empty.
+     * @returns True if new plug-ins were registered.
+     **/
+    bool ensurePyPlugsLoaded(const QString& pluginID = QString()) const;
+
+    /**
+     * @brief Records the time spent in a startup phase. The phases are printed by printStartupProfile()
+     * when --startup-profile was passed on the command-line.
+     **/
+    void reportStartupPhase(const std::string& phase, double seconds);
+
+    bool isStartupProfilingEnabled() const WARN_UNUSED_RETURN;
+
+    /**
+     * @brief Ends the startup profile and prints it. Only the first call prints anything: background renders
+     * call it before the writers are launched so that the profile does not include the render itself.
+     **/
+    void printStartupProfile();
+
     /*Find a builtin format with the same resolution and aspect ratio*/
     Format findExistingFormat(int w, int h, double par = 1.0) const WARN_UNUSED_RETURN;
     const std::vector<Format> & getFormats() const WARN_UNUSED_RETURN;
@@ -219,6 +241,7 @@ public:
 
 
     U64 getCachesTotalMemorySize() const;
+    U64 getCachesMaximumMemorySize() const;
     U64 getCachesTotalDiskSize() const;
     CacheSignalEmitterPtr getOrActivateViewerCacheSignalEmitter() const;
 
@@ -272,6 +295,12 @@ public:
      **/
     bool writeToOutputPipe(const QString & longMessage, const QString & shortMessage, bool printIfNoChannel);
 
+    /**
+     * @brief Returns true if this process is a background render process started by a ProcessHandler
+     * of another process, i.e: it has an output pipe to write to.
+     **/
+    bool isManagedBackgroundProcess() const;
+
     /**
      * @brief Abort any processing on all AppInstance. It is called in some very rare cases
      * such as when changing the number of threads used by the application or when a background render
@@ -621,6 +650,16 @@ public Q_SLOTS:
 
     void clearPluginsLoadedCache();
 
+    /**
+     * @brief Loads the OpenFX description of the plug-in if it was registered from the OpenFX registry cache.
+     **/
+    void ensureOFXPluginDescribed(const Plugin* plugin) const;
+
+    /**
+     * @brief Removes the PyPlugs registry cache so that all PyPlugs modules are imported again at the next launch.
+     **/
+    void clearPyPlugsRegistry();
+
     void clearAllCaches();
 
     void wipeAndCreateDiskCacheStructure();
@@ -694,6 +733,10 @@ private:
 
     void loadPythonGroups();
 
+    void indexDeferredPyPlugs();
+
+    void loadPyPlugs(const QStringList& allPlugins, bool keepOtherRegistryEntries = false);
+
     void registerEngineMetaTypes() const;
 
     void loadAllPlugins();
@@ -74,6 +74,7 @@ GCC_DIAG_ON(unused-parameter)
 #include "Engine/RectDSerialization.h"
 #include "Engine/RectISerialization.h"
 #include "Engine/StandardPaths.h"
+#include "Engine/Timer.h"
 
 
 // Don't forget to update glad.h and glad.c as well when updating these
@@ -277,6 +278,14 @@ AppManagerPrivate::AppManagerPrivate()
     , openGLFunctionsMutex()
     , renderingContextPool()
     , openGLRenderers()
+    , startupProfilingEnabled(false)
+    , startupTimer()
+    , startupPhases()
+    , deferPyPlugsLoading(false)
+    , deferredPyPlugs()
+    , deferredPyPlugsByID()
+    , unindexedPyPlugs()
+    , deferredPyPlugsMutex(QMutex::Recursive)
 {
     setMaxCacheFiles();
 
@@ -29,13 +29,16 @@
 #include "Global/Macros.h"
 
 #include <list>
+#include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 #include <map>
 
 #include <QtCore/QtGlobal> // for Q_OS_*
 #include <QtCore/QMutex>
 #include <QtCore/QString>
+#include <QtCore/QStringList>
 #include <QtCore/QAtomicInt>
 #include <QtCore/QCoreApplication>
 
@@ -204,6 +207,19 @@ public:
 
     std::unique_ptr<GPUContextPool> renderingContextPool;
     std::list<OpenGLRendererInfo> openGLRenderers;
+
+    // Startup profiling, enabled with --startup-profile
+    bool startupProfilingEnabled;
+    std::unique_ptr<TimeLapse> startupTimer; // created when loading starts
+    std::list<std::pair<std::string, double> > startupPhases; // phase name, seconds
+
+    // PyPlugs found on disk whose registration is deferred until first needed, see AppManager::ensurePyPlugsLoaded()
+    bool deferPyPlugsLoading;
+    QStringList deferredPyPlugs;
+    std::map<QString, QStringList> deferredPyPlugsByID; // lower-case plug-in ID known from the PyPlugs registry cache, files
+    QStringList unindexedPyPlugs; // deferred files whose plug-in ID is only known once imported
+    mutable QMutex deferredPyPlugsMutex;
+
     std::unique_ptr<QCoreApplication> _qApp;
 
 public:
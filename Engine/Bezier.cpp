@@ -33,6 +33,7 @@
 #include <cassert>
 #include <stdexcept>
 
+#include <QtCore/QAtomicInt>
 #include <QtCore/QLineF>
 #include <QtCore/QDebug>
 
@@ -81,6 +82,13 @@
 // http://www.davidrevoy.com/article182/calibrating-wacom-stylus-pressure-on-krita
 #define ROTO_PRESSURE_LEVELS 512
 
+// Maximum distance in pixels (at the evaluated mipmap level) between a Bezier segment and its polygon
+// when the number of points per segment is computed automatically
+#define ROTO_BEZIER_FLATNESS_TOLERANCE 0.1
+
+// Maximum number of polygons cached by a Bezier before the cache is cleared
+#define ROTO_BEZIER_POLYGON_CACHE_MAX_ENTRIES 256
+
 #ifndef M_PI
 #define M_PI        3.14159265358979323846264338327950288   /* pi             */
 #endif
@@ -88,6 +96,7 @@
 
 NATRON_NAMESPACE_ENTER
 
+static QAtomicInt polygonCacheHits(0);
 
 static inline double
 lerp(double a,
@@ -770,19 +779,17 @@ bezierSegmentEval(bool useGuiCurves,
 #ifdef ROTO_BEZIER_EVAL_ITERATIVE
     if (nbPointsPerSegment == -1) {
         /*
-         * Approximate the necessary number of line segments, using http://antigrain.com/research/adaptive_bezier/
+         * Compute the number of line segments from the flatness of the segment rather than from its length
+         * (Wang's formula): with n uniform steps, the polygon stays within 3/4 * M / n^2 of the cubic, where M is the
+         * largest second difference of the control points. Straight segments thus only need 2 points.
          */
-        double dx1, dy1, dx2, dy2, dx3, dy3;
-        dx1 = p1.x - p0.x;
-        dy1 = p1.y - p0.y;
-        dx2 = p2.x - p1.x;
-        dy2 = p2.y - p1.y;
-        dx3 = p3.x - p2.x;
-        dy3 = p3.y - p2.y;
-        double length = std::sqrt(dx1 * dx1 + dy1 * dy1) +
-                        std::sqrt(dx2 * dx2 + dy2 * dy2) +
-                        std::sqrt(dx3 * dx3 + dy3 * dy3);
-        nbPointsPerSegment = (int)std::max(length * 0.25, 2.);
+        double ddx1 = p0.x - 2. * p1.x + p2.x;
+        double ddy1 = p0.y - 2. * p1.y + p2.y;
+        double ddx2 = p1.x - 2. * p2.x + p3.x;
+        double ddy2 = p1.y - 2. * p2.y + p3.y;
+        double m = std::sqrt( std::max(ddx1 * ddx1 + ddy1 * ddy1, ddx2 * ddx2 + ddy2 * ddy2) );
+        double nbSteps = std::ceil( std::sqrt(0.75 * m / ROTO_BEZIER_FLATNESS_TOLERANCE) );
+        nbPointsPerSegment = (int)std::min(std::max(nbSteps, 1.), 4096.) + 1;
     }
 
     double incr = 1. / (double)(nbPointsPerSegment - 1);
@@ -1003,6 +1010,14 @@ Bezier::dequeueGuiActions()
     return mustCopy;
 }
 
+bool
+Bezier::hasPendingGuiActions() const
+{
+    QMutexLocker k(&_imp->guiCopyMutex);
+
+    return _imp->mustCopyGui;
+}
+
 void
 Bezier::copyInternalPointsToGuiPoints()
 {
@@ -1016,6 +1031,7 @@ Bezier::copyInternalPointsToGuiPoints()
     }
     _imp->guiIsClockwiseOriented = _imp->isClockwiseOriented;
     _imp->guiIsClockwiseOrientedStatic = _imp->isClockwiseOrientedStatic;
+    _imp->invalidatePolygonCache();
 }
 
 bool
@@ -1028,11 +1044,16 @@ void
 Bezier::clearAllPoints()
 {
     removeAnimation();
-    QMutexLocker k(&itemMutex);
-    _imp->points.clear();
-    _imp->featherPoints.clear();
-    _imp->isClockwiseOriented.clear();
-    _imp->finished = false;
+    {
+        QMutexLocker k(&itemMutex);
+        _imp->points.clear();
+        _imp->featherPoints.clear();
+        _imp->isClockwiseOriented.clear();
+        _imp->finished = false;
+    }
+    ///removeAnimation() invalidated the polygon cache before the points were cleared: a render running meanwhile may
+    ///have cached polygons of the old points with the new cache age
+    incrementNodesAge();
 }
 
 void
@@ -2189,6 +2210,74 @@ Bezier::setPointAtIndex(bool feather,
     setPointAtIndexInternal(true, true, true, feather, false, index, time, x, y, lx, ly, rx, ry);
 }
 
+// Sets a keyframe on each point from 6 values per point: x, y, left x, left y, right x, right y
+static void
+setPointsPositionsAtTime(bool useGuiCurve,
+                         double time,
+                         const double* values,
+                         const BezierCPs& points)
+{
+    for (BezierCPs::const_iterator it = points.begin(); it != points.end(); ++it, values += 6) {
+        (*it)->setPositionAtTime(useGuiCurve, time, values[0], values[1]);
+        (*it)->setLeftBezierPointAtTime(useGuiCurve, time, values[2], values[3]);
+        (*it)->setRightBezierPointAtTime(useGuiCurve, time, values[4], values[5]);
+    }
+}
+
+void
+Bezier::setPointsAtTimes(const std::vector<double>& times,
+                         const std::vector<double>& points,
+                         const std::vector<double>& featherPoints)
+{
+    ///only called on the main-thread
+    assert( QThread::currentThread() == qApp->thread() );
+    bool useGuiCurve = !canSetInternalPoints();
+    std::list<double> keysSet;
+
+    {
+        QMutexLocker l(&itemMutex);
+        const std::size_t nbValuesPerTime = _imp->points.size() * 6;
+
+        if ( points.size() != times.size() * nbValuesPerTime ) {
+            throw std::invalid_argument("Bezier::setPointsAtTimes: The number of values does not match the number of times and control points.");
+        }
+        const bool setFeather = useFeatherPoints();
+        if ( setFeather && !featherPoints.empty() && ( featherPoints.size() != points.size() ) ) {
+            throw std::invalid_argument("Bezier::setPointsAtTimes: The number of feather values does not match the number of times and control points.");
+        }
+        if ( times.empty() || (nbValuesPerTime == 0) ) {
+            return;
+        }
+        if (useGuiCurve) {
+            _imp->setMustCopyGuiBezier(true);
+        }
+
+        const std::vector<double>& featherValues = featherPoints.empty() ? points : featherPoints;
+        for (std::size_t i = 0; i < times.size(); ++i) {
+            if ( !_imp->hasKeyframeAtTime(useGuiCurve, times[i]) ) {
+                keysSet.push_back(times[i]);
+            }
+            setPointsPositionsAtTime(useGuiCurve, times[i], &points[i * nbValuesPerTime], _imp->points);
+            if (setFeather) {
+                setPointsPositionsAtTime(useGuiCurve, times[i], &featherValues[i * nbValuesPerTime], _imp->featherPoints);
+            }
+        }
+    }
+
+    ///Everything setPointAtIndex does after each point is done once for the whole import
+    incrementNodesAge();
+    for (std::size_t i = 0; i < times.size(); ++i) {
+        refreshPolygonOrientation(useGuiCurve, times[i]);
+    }
+    if (!useGuiCurve) {
+        QMutexLocker k(&itemMutex);
+        copyInternalPointsToGuiPoints();
+    }
+    for (std::list<double>::iterator it = keysSet.begin(); it != keysSet.end(); ++it) {
+        Q_EMIT keyframeSet(*it);
+    }
+} // Bezier::setPointsAtTimes
+
 void
 Bezier::onTransformSet(double time)
 {
@@ -2394,6 +2483,9 @@ Bezier::setKeyframe(double time)
             }
         }
     }
+    // adding a keyframe changes the interpolation of the curves around it
+    _imp->invalidatePolygonCache();
+    getContext()->invalidateItemBounds(this);
     // _imp->setMustCopyGuiBezier(true);
     Q_EMIT keyframeSet(time);
 }
@@ -2644,6 +2736,93 @@ Bezier::evaluateAtTime_DeCasteljau(bool useGuiPoints,
                                          0, pointsSingleList, bbox);
 }
 
+BezierPolygonCacheEntryConstPtr
+BezierPrivate::getCachedPolygon(const BezierPolygonCacheKey& key,
+                                const Transform::Matrix3x3& transform,
+                                U64* age) const
+{
+    QMutexLocker k(&polygonCacheMutex);
+
+    *age = polygonCacheAge;
+    BezierPolygonCache::const_iterator found = polygonCache.find(key);
+    if ( found == polygonCache.end() ) {
+        return BezierPolygonCacheEntryConstPtr();
+    }
+    const Transform::Matrix3x3& m = found->second->transform;
+    if ( (m.a != transform.a) || (m.b != transform.b) || (m.c != transform.c) ||
+         (m.d != transform.d) || (m.e != transform.e) || (m.f != transform.f) ||
+         (m.g != transform.g) || (m.h != transform.h) || (m.i != transform.i) ) {
+        return BezierPolygonCacheEntryConstPtr();
+    }
+    polygonCacheHits.fetchAndAddRelaxed(1);
+
+    return found->second;
+}
+
+void
+BezierPrivate::insertCachedPolygon(const BezierPolygonCacheKey& key,
+                                   U64 age,
+                                   const BezierPolygonCacheEntryConstPtr& entry) const
+{
+    QMutexLocker k(&polygonCacheMutex);
+
+    if (age != polygonCacheAge) {
+        return;
+    }
+    if ( (polygonCache.size() >= ROTO_BEZIER_POLYGON_CACHE_MAX_ENTRIES) && ( polygonCache.find(key) == polygonCache.end() ) ) {
+        polygonCache.clear();
+    }
+    polygonCache[key] = entry;
+}
+
+void
+BezierPrivate::invalidatePolygonCache()
+{
+    QMutexLocker k(&polygonCacheMutex);
+
+    ++polygonCacheAge;
+    polygonCache.clear();
+}
+
+int
+Bezier::getPolygonCacheHits()
+{
+    return (int)polygonCacheHits;
+}
+
+void
+Bezier::resetPolygonCacheHits()
+{
+    polygonCacheHits.fetchAndStoreRelaxed(0);
+}
+
+void
+Bezier::incrementNodesAge()
+{
+    _imp->invalidatePolygonCache();
+    RotoDrawableItem::incrementNodesAge();
+}
+
+// Appends the cached polygon to the output of evaluateAtTime_DeCasteljau/evaluateFeatherPointsAtTime_DeCasteljau
+static void
+copyCachedPolygon(const BezierPolygonCacheEntry& entry,
+                  std::list<std::list<ParametricPoint> >* points,
+                  std::list<ParametricPoint >* pointsSingleList,
+                  RectD* bbox)
+{
+    if (points) {
+        points->insert( points->end(), entry.polygon.begin(), entry.polygon.end() );
+    } else {
+        assert(pointsSingleList);
+        for (std::list<std::list<ParametricPoint> >::const_iterator it = entry.polygon.begin(); it != entry.polygon.end(); ++it) {
+            pointsSingleList->insert( pointsSingleList->end(), it->begin(), it->end() );
+        }
+    }
+    if (bbox) {
+        bbox->merge(entry.bbox);
+    }
+}
+
 void
 Bezier::evaluateAtTime_DeCasteljau_internal(bool useGuiCurves,
                                             double time,
@@ -2661,14 +2840,34 @@ Bezier::evaluateAtTime_DeCasteljau_internal(bool useGuiCurves,
     Transform::Matrix3x3 transform;
 
     getTransformAtTime(time, &transform);
-    QMutexLocker l(&itemMutex);
-    deCastelJau(isOpenBezier(), useGuiCurves, _imp->points, time, mipmapLevel, _imp->finished,
+
+    BezierPolygonCacheKey key(eBezierPolygonCacheTypeShape, useGuiCurves, time, mipmapLevel,
 #ifdef ROTO_BEZIER_EVAL_ITERATIVE
-                nbPointsPerSegment,
+                              nbPointsPerSegment
 #else
-                errorScale,
+                              errorScale
 #endif
-                transform, points, pointsSingleList, bbox);
+                              );
+    U64 cacheAge;
+    BezierPolygonCacheEntryConstPtr cached = _imp->getCachedPolygon(key, transform, &cacheAge);
+    if (!cached) {
+        std::shared_ptr<BezierPolygonCacheEntry> entry = std::make_shared<BezierPolygonCacheEntry>();
+        entry->transform = transform;
+        entry->bbox.setupInfinity();
+        {
+            QMutexLocker l(&itemMutex);
+            deCastelJau(isOpenBezier(), useGuiCurves, _imp->points, time, mipmapLevel, _imp->finished,
+#ifdef ROTO_BEZIER_EVAL_ITERATIVE
+                        nbPointsPerSegment,
+#else
+                        errorScale,
+#endif
+                        transform, &entry->polygon, 0, &entry->bbox);
+        }
+        _imp->insertCachedPolygon(key, cacheAge, entry);
+        cached = entry;
+    }
+    copyCachedPolygon(*cached, points, pointsSingleList, bbox);
 }
 
 void
@@ -2725,8 +2924,51 @@ Bezier::evaluateFeatherPointsAtTime_DeCasteljau_internal(bool useGuiPoints,
 {
     assert((points && !pointsSingleList) || (!points && pointsSingleList));
     assert( useFeatherPoints() );
-    QMutexLocker l(&itemMutex);
 
+    Transform::Matrix3x3 transform;
+    getTransformAtTime(time, &transform);
+
+    BezierPolygonCacheKey key(evaluateIfEqual ? eBezierPolygonCacheTypeFeatherAll : eBezierPolygonCacheTypeFeather, useGuiPoints, time, mipmapLevel,
+#ifdef ROTO_BEZIER_EVAL_ITERATIVE
+                              nbPointsPerSegment
+#else
+                              errorScale
+#endif
+                              );
+    U64 cacheAge;
+    BezierPolygonCacheEntryConstPtr cached = _imp->getCachedPolygon(key, transform, &cacheAge);
+    if (!cached) {
+        std::shared_ptr<BezierPolygonCacheEntry> entry = std::make_shared<BezierPolygonCacheEntry>();
+        entry->transform = transform;
+        entry->bbox.setupInfinity();
+        evaluateFeatherPolygon(useGuiPoints, time, mipmapLevel,
+#ifdef ROTO_BEZIER_EVAL_ITERATIVE
+                               nbPointsPerSegment,
+#else
+                               errorScale,
+#endif
+                               evaluateIfEqual, transform, &entry->polygon, &entry->bbox);
+        _imp->insertCachedPolygon(key, cacheAge, entry);
+        cached = entry;
+    }
+    copyCachedPolygon(*cached, points, pointsSingleList, bbox);
+}
+
+void
+Bezier::evaluateFeatherPolygon(bool useGuiPoints,
+                               double time,
+                               unsigned int mipmapLevel,
+#ifdef ROTO_BEZIER_EVAL_ITERATIVE
+                               int nbPointsPerSegment,
+#else
+                               double errorScale,
+#endif
+                               bool evaluateIfEqual,
+                               const Transform::Matrix3x3& transform,
+                               std::list<std::list<ParametricPoint> >* points,
+                               RectD* bbox) const
+{
+    QMutexLocker l(&itemMutex);
 
     if ( _imp->points.empty() ) {
         return;
@@ -2741,9 +2983,6 @@ Bezier::evaluateFeatherPointsAtTime_DeCasteljau_internal(bool useGuiPoints,
         ++nextCp;
     }
 
-    Transform::Matrix3x3 transform;
-    getTransformAtTime(time, &transform);
-
     for (BezierCPs::const_iterator it = _imp->featherPoints.begin(); it != _imp->featherPoints.end();
          ++it) {
         if ( next == _imp->featherPoints.end() ) {
@@ -2758,39 +2997,22 @@ Bezier::evaluateFeatherPointsAtTime_DeCasteljau_internal(bool useGuiPoints,
         if ( !evaluateIfEqual && bezierSegmenEqual(useGuiPoints, time, ViewIdx(0), **itCp, **nextCp, **it, **next) ) {
             continue;
         }
-        if (points) {
-            std::list<ParametricPoint> segmentPoints;
-            bezierSegmentEval(useGuiPoints, *(*it), *(*next), time, ViewIdx(0),  mipmapLevel,
+        std::list<ParametricPoint> segmentPoints;
+        bezierSegmentEval(useGuiPoints, *(*it), *(*next), time, ViewIdx(0),  mipmapLevel,
 #ifdef ROTO_BEZIER_EVAL_ITERATIVE
-                              nbPointsPerSegment,
+                          nbPointsPerSegment,
 #else
-                              errorScale,
+                          errorScale,
 #endif
-                              transform, &segmentPoints, bbox);
+                          transform, &segmentPoints, bbox);
 
-            // If we are a closed bezier or we are not on the last segment, remove the last point so we don't add duplicates
-            if (!isOpenBezier() || next != _imp->featherPoints.end()) {
-                if (!segmentPoints.empty()) {
-                    segmentPoints.pop_back();
-                }
-            }
-            points->push_back(segmentPoints);
-        } else {
-            assert(pointsSingleList);
-            bezierSegmentEval(useGuiPoints, *(*it), *(*next), time, ViewIdx(0),  mipmapLevel,
-#ifdef ROTO_BEZIER_EVAL_ITERATIVE
-                              nbPointsPerSegment,
-#else
-                              errorScale,
-#endif
-                              transform, pointsSingleList, bbox);
-            // If we are a closed bezier or we are not on the last segment, remove the last point so we don't add duplicates
-            if (!isOpenBezier() || next != _imp->featherPoints.end()) {
-                if (!pointsSingleList->empty()) {
-                    pointsSingleList->pop_back();
-                }
+        // If we are a closed bezier or we are not on the last segment, remove the last point so we don't add duplicates
+        if (!isOpenBezier() || next != _imp->featherPoints.end()) {
+            if (!segmentPoints.empty()) {
+                segmentPoints.pop_back();
             }
         }
+        points->push_back(segmentPoints);
 
         // increment for next iteration
         if ( itCp != _imp->featherPoints.end() ) {
@@ -2803,8 +3025,7 @@ Bezier::evaluateFeatherPointsAtTime_DeCasteljau_internal(bool useGuiPoints,
             ++nextCp;
         }
     } // for(it)
-
-}
+} // Bezier::evaluateFeatherPolygon
 
 void
 Bezier::evaluateFeatherPointsAtTime_DeCasteljau(bool useGuiPoints,
@@ -2885,19 +3106,31 @@ Bezier::getBoundingBox(double time) const
 
     RectD bbox;
     bool bboxSet = false;
+    const bool isOpen = isOpenBezier();
     for (double t = startTime; t <= endTime; t += mbFrameStep) {
-        RectD subBbox; // a very empty bbox
-        subBbox.setupInfinity();
-
         Transform::Matrix3x3 transform;
         getTransformAtTime(t, &transform);
 
-        QMutexLocker l(&itemMutex);
-        bezierSegmentListBboxUpdate(false, _imp->points, _imp->finished, _imp->isOpenBezier, t, ViewIdx(0), 0, transform, &subBbox);
-
+        BezierPolygonCacheKey key(eBezierPolygonCacheTypeBbox, false, t, 0, 0.);
+        U64 cacheAge;
+        BezierPolygonCacheEntryConstPtr cached = _imp->getCachedPolygon(key, transform, &cacheAge);
+        if (!cached) {
+            std::shared_ptr<BezierPolygonCacheEntry> entry = std::make_shared<BezierPolygonCacheEntry>();
+            entry->transform = transform;
+            entry->bbox.setupInfinity(); // a very empty bbox
+            {
+                QMutexLocker l(&itemMutex);
+                bezierSegmentListBboxUpdate(false, _imp->points, _imp->finished, _imp->isOpenBezier, t, ViewIdx(0), 0, transform, &entry->bbox);
+                if (useFeatherPoints() && !_imp->isOpenBezier) {
+                    bezierSegmentListBboxUpdate(false, _imp->featherPoints, _imp->finished, _imp->isOpenBezier, t, ViewIdx(0), 0, transform, &entry->bbox);
+                }
+            }
+            _imp->insertCachedPolygon(key, cacheAge, entry);
+            cached = entry;
+        }
+        RectD subBbox = cached->bbox;
 
-        if (useFeatherPoints() && !_imp->isOpenBezier) {
-            bezierSegmentListBboxUpdate(false, _imp->featherPoints, _imp->finished, _imp->isOpenBezier, t, ViewIdx(0), 0, transform, &subBbox);
+        if (useFeatherPoints() && !isOpen) {
             // EDIT: Partial fix, just pad the BBOX by the feather distance. This might not be accurate but gives at least something
             // enclosing the real bbox and close enough
             double featherDistance = getFeatherDistance(t);
@@ -2905,7 +3138,7 @@ Bezier::getBoundingBox(double time) const
             subBbox.x2 += featherDistance;
             subBbox.y1 -= featherDistance;
             subBbox.y2 += featherDistance;
-        } else if (_imp->isOpenBezier) {
+        } else if (isOpen) {
             double brushSize = getBrushSizeKnob()->getValueAtTime(t);
             double halfBrushSize = brushSize / 2. + 1;
             subBbox.x1 -= halfBrushSize;
@@ -2924,6 +3157,38 @@ Bezier::getBoundingBox(double time) const
     return bbox;
 } // Bezier::getBoundingBox
 
+bool
+Bezier::getRenderDataAtTime(double time,
+                            unsigned int mipmapLevel,
+                            RotoShapeRenderData* data) const
+{
+    Transform::Matrix3x3 transform;
+
+    getTransformAtTime(time, &transform);
+
+    ///The feather distance is a knob of the item, not a property of the control points: it is part of the key
+    ///so that entries computed with another distance are not reused
+    BezierPolygonCacheKey key(eBezierPolygonCacheTypeRenderData, false, time, mipmapLevel, getFeatherDistance(time));
+    U64 cacheAge;
+    BezierPolygonCacheEntryConstPtr cached = _imp->getCachedPolygon(key, transform, &cacheAge);
+    if (cached) {
+        *data = *cached->renderData;
+    } else {
+        std::shared_ptr<RotoShapeRenderData> renderData = std::make_shared<RotoShapeRenderData>();
+        RotoContextPrivate::computeBezierRenderData(this, time, mipmapLevel, renderData.get());
+
+        std::shared_ptr<BezierPolygonCacheEntry> entry = std::make_shared<BezierPolygonCacheEntry>();
+        entry->transform = transform;
+        entry->renderData = renderData;
+        _imp->insertCachedPolygon(key, cacheAge, entry);
+        *data = *renderData;
+    }
+    ///The fall-off does not change the geometry
+    data->fallOff = getFeatherFallOff(time);
+
+    return cached.get() != 0;
+} // Bezier::getRenderDataAtTime
+
 const std::list<BezierCPPtr> &
 Bezier::getControlPoints() const
 {
@@ -3439,6 +3704,8 @@ Bezier::setKeyFrameInterpolation(KeyframeTypeEnum interp,
             ++fp;
         }
     }
+    _imp->invalidatePolygonCache();
+    getContext()->invalidateItemBounds(this);
 }
 
 void
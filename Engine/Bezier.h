@@ -32,6 +32,7 @@
 #include <set>
 #include <string>
 #include <utility>
+#include <vector>
 
 // clang-format off
 CLANG_DIAG_OFF(deprecated-declarations)
@@ -71,6 +72,7 @@ struct ParametricPoint
 };
 
 struct BezierPrivate;
+struct RotoShapeRenderData;
 class Bezier
     : public RotoDrawableItem
 {
@@ -275,6 +277,17 @@ public:
      **/
     void setPointAtIndex(bool feather, int index, double time, double x, double y, double lx, double ly, double rx, double ry);
 
+    /**
+     * @brief Sets a keyframe on all the control points at each of the given times at once, e.g. to import a shape
+     * animated elsewhere. For each time, points holds 6 values per control point in the order of the control points:
+     * x, y, left x, left y, right x, right y. featherPoints holds the same values for the feather points, or is empty
+     * in which case the feather points are set at the control points. Feather points are ignored for open beziers.
+     * Unlike setPointAtIndex, keyframes are set regardless of auto keying and ripple edit, and the shape is
+     * invalidated only once.
+     * @throws std::invalid_argument if the number of values does not match the number of times and control points.
+     **/
+    void setPointsAtTimes(const std::vector<double>& times, const std::vector<double>& points, const std::vector<double>& featherPoints);
+
 private:
 
     void setPointAtIndexInternal(bool setLeft, bool setRight, bool setPoint, bool feather, bool featherAndCp, int index, double time, double x, double y, double lx, double ly, double rx, double ry);
@@ -466,13 +479,35 @@ private:
                                                           std::list<ParametricPoint >* pointsSingleList,
                                                           RectD* bbox) const;
 
+    // Computes the polygon cached by evaluateFeatherPointsAtTime_DeCasteljau_internal, one list per segment
+    void evaluateFeatherPolygon(bool useGuiCurves,
+                                double time,
+                                unsigned int mipmapLevel,
+#ifdef ROTO_BEZIER_EVAL_ITERATIVE
+                                int nbPointsPerSegment,
+#else
+                                double errorScale,
+#endif
+                                bool evaluateIfEqual,
+                                const Transform::Matrix3x3& transform,
+                                std::list<std::list<ParametricPoint> >* points,
+                                RectD* bbox) const;
+
 public:
 
     /**
-     * @brief Returns the bounding box of the bezier. The last value computed by evaluateAtTime_DeCasteljau will be returned,
-     * otherwise if it has never been called, evaluateAtTime_DeCasteljau will be called to compute the bounding box.
+     * @brief Returns the bounding box of the bezier. The bbox of the control points at each motion blur sample
+     * is cached until the shape changes.
      **/
     virtual RectD getBoundingBox(double time) const OVERRIDE;
+
+    /**
+     * @brief Computes the geometry of the closed shape rendered by the native rasterizer at the given time.
+     * It is cached along with the polygons until the shape or its transform change, so that motion blur samples,
+     * viewer redraws and renders at the same time and scale reuse it. Returns true if it was found in the cache.
+     **/
+    bool getRenderDataAtTime(double time, unsigned int mipmapLevel, RotoShapeRenderData* data) const;
+
     static void bezierSegmentListBboxUpdate(bool useGuiCurves,
                                             const std::list<BezierCPPtr> & points,
                                             bool finished,
@@ -596,6 +631,12 @@ public:
 
     bool dequeueGuiActions();
 
+    /**
+     * @brief Returns true if the points were edited during a render and the changes were not copied to the internal
+     * curves yet by dequeueGuiActions().
+     **/
+    bool hasPendingGuiActions() const;
+
 private:
 
     virtual void onTransformSet(double time) OVERRIDE FINAL;
@@ -648,6 +689,19 @@ public:
 
     void setKeyFrameInterpolation(KeyframeTypeEnum interp, int index);
 
+    /**
+     * @brief Also invalidates the polygons cached by evaluateAtTime_DeCasteljau, evaluateFeatherPointsAtTime_DeCasteljau
+     * and getBoundingBox. Every edit of the shape is followed by a call to this function.
+     **/
+    virtual void incrementNodesAge() OVERRIDE FINAL;
+
+    /**
+     * @brief Returns the number of polygons (or bboxes) that were returned from the cache instead of being evaluated,
+     * across all Beziers since the last call to resetPolygonCacheHits()
+     **/
+    static int getPolygonCacheHits();
+    static void resetPolygonCacheHits();
+
 
 Q_SIGNALS:
 
@@ -56,6 +56,7 @@ public:
     QString filename;
     bool isPythonScript;
     QString defaultOnProjectLoadedScript;
+    QString saveAsFilePath;
     std::list<CLArgs::WriterArg> writers;
     std::list<CLArgs::ReaderArg> readers;
     std::list<std::string> pythonCommands;
@@ -64,12 +65,14 @@ public:
     bool useDefaultSettings;
     bool clearCacheOnLaunch;
     bool clearOpenFXCacheOnLaunch;
+    bool clearPyPlugsCacheOnLaunch;
     QString ipcPipe;
     int error;
     bool isInterpreterMode;
     std::list<std::pair<int, std::pair<int, int> > > frameRanges;
     bool rangeSet;
     bool enableRenderStats;
+    bool startupProfile;
     bool isEmpty;
     mutable QString imageFilename;
 #ifdef NATRON_USE_BREAKPAD
@@ -86,6 +89,7 @@ public:
         , filename()
         , isPythonScript(false)
         , defaultOnProjectLoadedScript()
+        , saveAsFilePath()
         , writers()
         , readers()
         , pythonCommands()
@@ -94,12 +98,14 @@ public:
         , useDefaultSettings(false)
         , clearCacheOnLaunch(false)
         , clearOpenFXCacheOnLaunch(false)
+        , clearPyPlugsCacheOnLaunch(false)
         , ipcPipe()
         , error(0)
         , isInterpreterMode(false)
         , frameRanges()
         , rangeSet(false)
         , enableRenderStats(false)
+        , startupProfile(false)
         , isEmpty(true)
         , imageFilename()
 #ifdef NATRON_USE_BREAKPAD
@@ -248,8 +254,10 @@ CLArgs::operator=(const CLArgs& other)
     _imp->filename = other._imp->filename;
     _imp->isPythonScript = other._imp->isPythonScript;
     _imp->defaultOnProjectLoadedScript = other._imp->defaultOnProjectLoadedScript;
+    _imp->saveAsFilePath = other._imp->saveAsFilePath;
     _imp->clearCacheOnLaunch = other._imp->clearCacheOnLaunch;
     _imp->clearOpenFXCacheOnLaunch = other._imp->clearOpenFXCacheOnLaunch;
+    _imp->clearPyPlugsCacheOnLaunch = other._imp->clearPyPlugsCacheOnLaunch;
     _imp->writers = other._imp->writers;
     _imp->readers = other._imp->readers;
     _imp->pythonCommands = other._imp->pythonCommands;
@@ -261,6 +269,7 @@ CLArgs::operator=(const CLArgs& other)
     _imp->frameRanges = other._imp->frameRanges;
     _imp->rangeSet = other._imp->rangeSet;
     _imp->enableRenderStats = other._imp->enableRenderStats;
+    _imp->startupProfile = other._imp->startupProfile;
     _imp->isEmpty = other._imp->isEmpty;
     _imp->imageFilename = other._imp->imageFilename;
     _imp->exportDocsPath = other._imp->exportDocsPath;
@@ -317,6 +326,12 @@ CLArgs::printUsage(const std::string& programName)
         "    Clears the image cache on startup.\n"
         "  --clear-openfx-cache\n"
         "    Clears the OpenFX plugins cache on startup.\n"
+        "  --clear-pyplugs-cache\n"
+        "    Clears the PyPlugs registry cache on startup: all PyPlugs are imported\n"
+        "    again to rebuild it.\n"
+        "  --startup-profile\n"
+        "    Prints the time spent in each startup phase (Python, settings, caches,\n"
+        "    plug-ins, project load, render start) once the application is ready.\n"
         "  --no-settings\n"
         "    When passed on the command-line, the %1 settings will not be restored\n"
         "    from the preferences file on disk so that %1 uses the default ones.\n"
@@ -364,6 +379,11 @@ CLArgs::printUsage(const std::string& programName)
         "    executing the callbacks onProjectLoaded and onProjectCreated.\n"
         "    The rules on the execution of Python scripts (see below) also apply to\n"
         "    this script.\n"
+        "  --save-as <project file path>\n"
+        "    Save the loaded project to the given file instead of rendering it and\n"
+        "    print the time it took. Projects are written in the binary format if the\n"
+        "    filename ends with .%2b, otherwise in the XML format. This converts\n"
+        "    projects between the two formats.\n"
         "  -s [ --render-stats]\n"
         "     Enable render statistics that will be produced for\n"
         "     each frame in form of a file located next to the image produced by\n"
@@ -501,6 +521,12 @@ CLArgs::isOpenFXCacheClearRequestedOnLaunch() const
     return _imp->clearOpenFXCacheOnLaunch;
 }
 
+bool
+CLArgs::isPyPlugsCacheClearRequestedOnLaunch() const
+{
+    return _imp->clearPyPlugsCacheOnLaunch;
+}
+
 
 bool
 CLArgs::isBackgroundMode() const
@@ -551,6 +577,12 @@ CLArgs::getDefaultOnProjectLoadedScript() const
     return _imp->defaultOnProjectLoadedScript;
 }
 
+const QString&
+CLArgs::getSaveAsFilePath() const
+{
+    return _imp->saveAsFilePath;
+}
+
 const QString&
 CLArgs::getIPCPipeName() const
 {
@@ -563,6 +595,12 @@ CLArgs::areRenderStatsEnabled() const
     return _imp->enableRenderStats;
 }
 
+bool
+CLArgs::isStartupProfilingEnabled() const
+{
+    return _imp->startupProfile;
+}
+
 bool
 CLArgs::isPythonScript() const
 {
@@ -827,6 +865,24 @@ CLArgsPrivate::parse()
         }
     }
 
+    {
+        QStringList::iterator it = hasToken( QString::fromUtf8("clear-pyplugs-cache"), QString() );
+        if ( it != args.end() ) {
+            it = args.erase(it);
+
+            clearPyPlugsCacheOnLaunch = true;
+        }
+    }
+
+    {
+        QStringList::iterator it = hasToken( QString::fromUtf8("startup-profile"), QString() );
+        if ( it != args.end() ) {
+            it = args.erase(it);
+
+            startupProfile = true;
+        }
+    }
+
     {
         QStringList::iterator it = hasToken( QString::fromUtf8("no-settings"), QString() );
         if ( it != args.end() ) {
@@ -1012,6 +1068,33 @@ CLArgsPrivate::parse()
         }
     }
 
+    {
+        QStringList::iterator it = hasToken( QString::fromUtf8("save-as"), QString() );
+        if ( it != args.end() ) {
+            it = args.erase(it);
+
+            if ( it == args.end() || it->startsWith( QChar::fromLatin1('-') ) ) {
+                std::cout << tr("--save-as specified, you must enter a project filename afterwards.").toStdString() << std::endl;
+                error = 1;
+
+                return;
+            }
+            saveAsFilePath = *it;
+            it = args.erase(it);
+
+#ifdef __NATRON_UNIX__
+            saveAsFilePath = AppManager::qt_tildeExpansion(saveAsFilePath);
+#endif
+            if ( !saveAsFilePath.endsWith( QString::fromUtf8("." NATRON_PROJECT_FILE_EXT), Qt::CaseInsensitive ) &&
+                 !saveAsFilePath.endsWith( QString::fromUtf8("." NATRON_PROJECT_BINARY_FILE_EXT), Qt::CaseInsensitive ) ) {
+                std::cout << tr("--save-as expects a project filename ending with .%1 or .%2.").arg( QString::fromUtf8(NATRON_PROJECT_FILE_EXT) ).arg( QString::fromUtf8(NATRON_PROJECT_BINARY_FILE_EXT) ).toStdString() << std::endl;
+                error = 1;
+
+                return;
+            }
+        }
+    }
+
     {
         QStringList::iterator it = hasToken( QString::fromUtf8("opengl"), QString() );
         if ( it != args.end() ) {
@@ -1263,6 +1346,9 @@ CLArgsPrivate::parse()
 
     {
         QStringList::iterator it = findFileNameWithExtension( QString::fromUtf8(NATRON_PROJECT_FILE_EXT) );
+        if ( it == args.end() ) {
+            it = findFileNameWithExtension( QString::fromUtf8(NATRON_PROJECT_BINARY_FILE_EXT) );
+        }
         if ( it == args.end() ) {
             it = findFileNameWithExtension( QString::fromUtf8("py") );
             if (it != args.end()) {
@@ -1301,10 +1387,12 @@ CLArgsPrivate::parse()
     qDebug() << "* Command-line parsing results:";
     qDebug() << "clearCacheOnLaunch:" << clearCacheOnLaunch;
     qDebug() << "clearOpenFXCacheOnLaunch:" << clearOpenFXCacheOnLaunch;
+    qDebug() << "clearPyPlugsCacheOnLaunch:" << clearPyPlugsCacheOnLaunch;
     qDebug() << "useDefaultSettings:" << useDefaultSettings;
     qDebug() << "isBackground:" << isBackground;
     qDebug() << "isInterpreterMode:" << isInterpreterMode;
     qDebug() << "enableRenderStats:" << enableRenderStats;
+    qDebug() << "startupProfile:" << startupProfile;
 #ifdef NATRON_USE_BREAKPAD
     qDebug() << "breakpadProcessPID:" << breakpadProcessPID;
     qDebug() << "breakpadProcessFilePath:" << breakpadProcessFilePath;
@@ -1315,6 +1403,7 @@ CLArgsPrivate::parse()
     qDebug() << "exportDocsPath:" << exportDocsPath;
     qDebug() << "ipcPipe:" << ipcPipe;
     qDebug() << "defaultOnProjectLoadedScript:" << defaultOnProjectLoadedScript;
+    qDebug() << "saveAsFilePath:" << saveAsFilePath;
     qDebug() << "settingCommands:";
     for (auto&& it: settingCommands) {
         qDebug() << QString::fromUtf8(it.c_str());
@@ -120,6 +120,8 @@ public:
 
     bool isOpenFXCacheClearRequestedOnLaunch() const;
 
+    bool isPyPlugsCacheClearRequestedOnLaunch() const;
+
     /*
      * @brief Has a Natron project or Python script been passed to the command line ?
      */
@@ -132,12 +134,15 @@ public:
      */
     const QString& getImageFilename() const;
     const QString& getDefaultOnProjectLoadedScript() const;
+    const QString& getSaveAsFilePath() const;
     const QString& getIPCPipeName() const;
 
     bool isPythonScript() const;
 
     bool areRenderStatsEnabled() const;
 
+    bool isStartupProfilingEnabled() const;
+
 #ifdef NATRON_USE_BREAKPAD
     const QString& getBreakpadProcessExecutableFilePath() const;
     qint64 getBreakpadProcessPID() const;
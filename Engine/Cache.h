@@ -33,6 +33,7 @@
 #include <fstream>
 #include <functional>
 #include <list>
+#include <map>
 #include <set>
 #include <cstddef>
 #include <utility>
@@ -294,7 +295,7 @@ private:
             }
 
             {
-                CleanRequest front;
+                std::list<CleanRequest> requests;
                 {
                     QMutexLocker k(&_requestQueueMutex);
                     if ( quit && _requestsQueues.empty() ) {
@@ -311,10 +312,28 @@ private:
                     }
 
                     assert( !_requestsQueues.empty() );
-                    front = _requestsQueues.front();
-                    _requestsQueues.pop_front();
+                    requests.swap(_requestsQueues);
+                }
+
+                ///Merge all pending requests so that the cache is traversed once for all of them, e.g: when
+                ///an edit changed the hash of many nodes. The most recent hash of a holder wins.
+                std::map<std::string, U64> holdersToClean, holdersToClear;
+                for (std::list<CleanRequest>::iterator it = requests.begin(); it != requests.end(); ++it) {
+                    if ( it->holderID.empty() ) {
+                        continue;
+                    }
+                    if (it->removeAll) {
+                        holdersToClear[it->holderID] = 0;
+                    } else {
+                        holdersToClean[it->holderID] = it->nodeHash;
+                    }
+                }
+                if ( !holdersToClear.empty() ) {
+                    cache->removeAllEntriesWithDifferentNodeHashForHoldersPrivate(holdersToClear, true);
+                }
+                if ( !holdersToClean.empty() ) {
+                    cache->removeAllEntriesWithDifferentNodeHashForHoldersPrivate(holdersToClean, false);
                 }
-                cache->removeAllEntriesWithDifferentNodeHashForHolderPrivate(front.holderID, front.nodeHash, front.removeAll);
             }
         }
     }
@@ -1575,7 +1594,9 @@ public:
                                          bool blocking)
     {
         if (blocking) {
-            removeAllEntriesWithDifferentNodeHashForHolderPrivate(holder->getCacheID(), 0, true);
+            std::map<std::string, U64> holdersHash;
+            holdersHash[holder->getCacheID()] = 0;
+            removeAllEntriesWithDifferentNodeHashForHoldersPrivate(holdersHash, true);
         } else {
             _cleanerThread.appendToQueue(holder->getCacheID(), 0, true);
         }
@@ -1620,9 +1641,8 @@ public:
 
 private:
 
-    virtual void removeAllEntriesWithDifferentNodeHashForHolderPrivate(const std::string & holderID,
-                                                                       U64 nodeHash,
-                                                                       bool removeAll) OVERRIDE FINAL
+    virtual void removeAllEntriesWithDifferentNodeHashForHoldersPrivate(const std::map<std::string, U64> & holdersHash,
+                                                                        bool removeAll) OVERRIDE FINAL
     {
         std::list<EntryTypePtr> toDelete;
         CacheContainer newMemCache, newDiskCache;
@@ -1634,8 +1654,9 @@ private:
                 if ( !entries.empty() ) {
                     const EntryTypePtr & front = entries.front();
 
-                    if ( (front->getKey().getCacheHolderID() == holderID) &&
-                         ( ( front->getKey().getTreeVersion() != nodeHash) || removeAll ) ) {
+                    std::map<std::string, U64>::const_iterator found = holdersHash.find( front->getKey().getCacheHolderID() );
+                    if ( ( found != holdersHash.end() ) &&
+                         ( ( front->getKey().getTreeVersion() != found->second) || removeAll ) ) {
                         for (typename std::list<EntryTypePtr>::const_iterator it = entries.begin(); it != entries.end(); ++it) {
                             toDelete.push_back(*it);
                         }
@@ -1651,8 +1672,9 @@ private:
                 if ( !entries.empty() ) {
                     const EntryTypePtr & front = entries.front();
 
-                    if ( (front->getKey().getCacheHolderID() == holderID) &&
-                         ( ( front->getKey().getTreeVersion() != nodeHash) || removeAll ) ) {
+                    std::map<std::string, U64>::const_iterator found = holdersHash.find( front->getKey().getCacheHolderID() );
+                    if ( ( found != holdersHash.end() ) &&
+                         ( ( front->getKey().getTreeVersion() != found->second) || removeAll ) ) {
                         for (typename std::list<EntryTypePtr>::const_iterator it = entries.begin(); it != entries.end(); ++it) {
                             toDelete.push_back(*it);
                         }
@@ -1674,7 +1696,7 @@ private:
             ///that the separate thread will delete
             toDelete.clear();
         }
-    } // removeAllEntriesWithDifferentNodeHashForHolderPrivate
+    } // removeAllEntriesWithDifferentNodeHashForHoldersPrivate
 
     bool getInternal(const typename EntryType::key_type & key,
                      std::list<EntryTypePtr>* returnValue) const
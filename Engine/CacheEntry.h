@@ -36,6 +36,7 @@
 #include <vector>
 #ifndef _WIN32
 #include <fstream>
+#include <map>
 #endif
 #include <sstream> // stringstream
 #include <algorithm>
@@ -210,10 +211,11 @@ public:
                                            double time, size_t size) const = 0;
 
     /**
-     * @brief Remove from the cache all entries that matches the holderID and have a different nodeHash than the given one.
+     * @brief Remove from the cache all entries whose holderID is in the given map and that have a different nodeHash
+     * than the one mapped to that holderID. All holders are handled in a single pass over the cache.
      * @param removeAll If true, remove even entries that match the nodeHash
      **/
-    virtual void removeAllEntriesWithDifferentNodeHashForHolderPrivate(const std::string& holderID, U64 nodeHash, bool removeAll) = 0;
+    virtual void removeAllEntriesWithDifferentNodeHashForHoldersPrivate(const std::map<std::string, U64>& holdersHash, bool removeAll) = 0;
 
     /**
      * @brief Relevant only for tiled caches. This will allocate the memory required for a tile in the cache and lock it.
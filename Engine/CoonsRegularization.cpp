@@ -52,9 +52,15 @@
 
 #include <limits>
 #include <cfloat>
+#include <cmath>
 #include <algorithm> // min, max
 #include <cassert>
+#include <functional>
 #include <stdexcept>
+#include <vector>
+
+#include <QtCore/QThreadPool>
+#include <QtConcurrentMap> // QtCore on Qt4, QtConcurrent on Qt5
 
 #include "Engine/Bezier.h"
 #include "Engine/BezierCP.h"
@@ -68,109 +74,131 @@
 #define M_PI_2      1.57079632679489661923132169163975144   /* pi/2           */
 #endif
 
+// regularizeAll() only uses the thread pool from that many patches
+#define COONS_REGULARIZATION_MIN_CONCURRENT_PATCHES 8
+
+// Splitting some self-intersecting patches never removes the degeneracy: stop splitting them after
+// that many recursive splits and keep the patch as is
+#define COONS_REGULARIZATION_MAX_SPLIT_DEPTH 8
+
 
 NATRON_NAMESPACE_ENTER
 
 
-static Point
-getPointAt(const BezierCPs& cps,
-           double time,
-           double t)
+NATRON_NAMESPACE_ANONYMOUS_ENTER
+
+/*
+   The control points of a patch, evaluated once at the regularization time: the splits and the
+   geometric tests below access them by index many times.
+ */
+struct PatchPoint
+{
+    Point p, left, right;
+
+    // the original control point, or NULL for a point created by a split
+    BezierCPPtr cp;
+};
+
+typedef std::vector<PatchPoint> PatchPoints;
+
+NATRON_NAMESPACE_ANONYMOUS_EXIT
+
+static void
+evaluatePatch(const BezierCPs& cps,
+              double time,
+              PatchPoints* points)
+{
+    points->resize( cps.size() );
+    std::size_t i = 0;
+    for (BezierCPs::const_iterator it = cps.begin(); it != cps.end(); ++it, ++i) {
+        PatchPoint& point = (*points)[i];
+        (*it)->getPositionAtTime(false, time, ViewIdx(0), &point.p.x, &point.p.y);
+        (*it)->getLeftBezierPointAtTime(false, time, ViewIdx(0), &point.left.x, &point.left.y);
+        (*it)->getRightBezierPointAtTime(false, time, ViewIdx(0), &point.right.x, &point.right.y);
+        point.cp = *it;
+    }
+}
+
+static BezierCPPtr
+makeBezierCPFromPoint(const Point& p,
+                      const Point& left,
+                      const Point& right)
+{
+    BezierCPPtr ret = std::make_shared<BezierCP>();
+
+    ret->setStaticPosition(false, p.x, p.y);
+    ret->setLeftBezierStaticPosition(false, left.x, left.y);
+    ret->setRightBezierStaticPosition(false, right.x, right.y);
+
+    return ret;
+}
+
+static void
+toBezierCPs(const PatchPoints& points,
+            BezierCPs* cps)
+{
+    for (PatchPoints::const_iterator it = points.begin(); it != points.end(); ++it) {
+        cps->push_back( it->cp ? it->cp : makeBezierCPFromPoint(it->p, it->left, it->right) );
+    }
+}
+
+// Index of the control point at or before t, after wrapping t in the patch
+static int
+getSegmentIndex(const PatchPoints& cps,
+                double* t)
 {
     int ncps = (int)cps.size();
 
     assert(ncps);
     if (!ncps) {
-        throw std::logic_error("getPointAt()");
+        throw std::logic_error("getSegmentIndex()");
     }
-    if (t < 0) {
-        t += ncps;
+    if (*t < 0) {
+        *t += ncps;
     }
-    int t_i = (int)std::floor(t) % ncps;
-    int t_i_plus_1 = t_i % ncps;
-    assert(t_i >= 0 && t_i < ncps && t_i_plus_1 >= 0 && t_i_plus_1 < ncps);
-    if (t == t_i) {
-        BezierCPs::const_iterator it = cps.begin();
-        std::advance(it, t_i);
-        Point ret;
-        (*it)->getPositionAtTime(false, time, ViewIdx(0), &ret.x, &ret.y);
+    int t_i = (int)std::floor(*t) % ncps;
+    assert(t_i >= 0 && t_i < ncps);
 
-        return ret;
-    } else if (t == t_i_plus_1) {
-        BezierCPs::const_iterator it = cps.begin();
-        std::advance(it, t_i_plus_1);
-        Point ret;
-        (*it)->getPositionAtTime(false, time, ViewIdx(0), &ret.x, &ret.y);
+    return t_i;
+}
 
-        return ret;
-    }
+static Point
+getPointAt(const PatchPoints& cps,
+           double t)
+{
+    int t_i = getSegmentIndex(cps, &t);
 
-    BezierCPs::const_iterator it = cps.begin();
-    std::advance(it, t_i);
-    BezierCPs::const_iterator next = it;
-    ++next;
-    if ( next == cps.end() ) {
-        next = cps.begin();
+    if (t == t_i) {
+        return cps[t_i].p;
     }
-    Point p0, p1, p2, p3;
-    (*it)->getPositionAtTime(false, time, ViewIdx(0), &p0.x, &p0.y);
-    (*it)->getRightBezierPointAtTime(false, time, ViewIdx(0), &p1.x, &p1.y);
-    (*next)->getLeftBezierPointAtTime(false, time, ViewIdx(0), &p2.x, &p2.y);
-    (*next)->getPositionAtTime(false, time, ViewIdx(0), &p3.x, &p3.y);
+
+    const PatchPoint& cur = cps[t_i];
+    const PatchPoint& next = cps[(t_i + 1) % cps.size()];
     Point ret;
-    Bezier::bezierPoint(p0, p1, p2, p3, t - t_i, &ret);
+    Bezier::bezierPoint(cur.p, cur.right, next.left, next.p, t - t_i, &ret);
 
     return ret;
 }
 
 static Point
-getLeftPointAt(const BezierCPs& cps,
-               double time,
+getLeftPointAt(const PatchPoints& cps,
                double t)
 {
-    int ncps = (int)cps.size();
+    int t_i = getSegmentIndex(cps, &t);
 
-    assert(ncps);
-    if (!ncps) {
-        throw std::logic_error("getLeftPointAt()");
-    }
-    if (t < 0) {
-        t += ncps;
-    }
-    int t_i = (int)std::floor(t) % ncps;
-    int t_i_plus_1 = t_i % ncps;
-    assert(t_i >= 0 && t_i < ncps && t_i_plus_1 >= 0 && t_i_plus_1 < ncps);
     if (t == t_i) {
-        BezierCPs::const_iterator it = cps.begin();
-        std::advance(it, t_i);
-        Point ret;
-        (*it)->getLeftBezierPointAtTime(false, time, ViewIdx(0), &ret.x, &ret.y);
-
-        return ret;
-    } else if (t == t_i_plus_1) {
-        BezierCPs::const_iterator it = cps.begin();
-        std::advance(it, t_i_plus_1);
-        Point ret;
-        (*it)->getLeftBezierPointAtTime(false, time, ViewIdx(0), &ret.x, &ret.y);
-
-        return ret;
+        return cps[t_i].left;
     }
 
-    BezierCPs::const_iterator it = cps.begin();
-    std::advance(it, t_i);
-    BezierCPs::const_iterator next = it;
-    ++next;
-    if ( next == cps.end() ) {
-        next = cps.begin();
-    }
+    const PatchPoint& cur = cps[t_i];
+    const PatchPoint& next = cps[(t_i + 1) % cps.size()];
 
     t = t - t_i;
 
-    Point a, b, c, ab, bc, abc;
-    Point ret;
-    (*it)->getPositionAtTime(false, time, ViewIdx(0), &a.x, &a.y);
-    (*it)->getRightBezierPointAtTime(false, time, ViewIdx(0), &b.x, &b.y);
-    (*next)->getLeftBezierPointAtTime(false, time, ViewIdx(0), &c.x, &c.y);
+    const Point& a = cur.p;
+    const Point& b = cur.right;
+    const Point& c = next.left;
+    Point ab, bc, abc;
     ab.x = (1. - t) * a.x + t * b.x;
     ab.y = (1. - t) * a.y + t * b.y;
 
@@ -180,62 +208,31 @@ getLeftPointAt(const BezierCPs& cps,
     abc.x = (1. - t) * ab.x + t * bc.x;
     abc.y = (1. - t) * ab.y + t * bc.y;
     if ( (abc.x == a.x) && (abc.y == a.y) ) {
-        (*it)->getLeftBezierPointAtTime(false, time, ViewIdx(0), &ret.x, &ret.y);
-
-        return ret;
+        return cur.left;
     } else {
         return abc;
     }
 } // getLeftPointAt
 
 static Point
-getRightPointAt(const BezierCPs& cps,
-                double time,
+getRightPointAt(const PatchPoints& cps,
                 double t)
 {
-    int ncps = cps.size();
+    int t_i = getSegmentIndex(cps, &t);
 
-    assert(ncps);
-    if (!ncps) {
-        throw std::logic_error("getRightPointAt()");
-    }
-    if (t < 0) {
-        t += ncps;
-    }
-    int t_i = (int)std::floor(t) % ncps;
-    int t_i_plus_1 = t_i % ncps;
-    assert(t_i >= 0 && t_i < ncps && t_i_plus_1 >= 0 && t_i_plus_1 < ncps);
     if (t == t_i) {
-        BezierCPs::const_iterator it = cps.begin();
-        std::advance(it, t_i);
-        Point ret;
-        (*it)->getRightBezierPointAtTime(false, time, ViewIdx(0), &ret.x, &ret.y);
-
-        return ret;
-    } else if (t == t_i_plus_1) {
-        BezierCPs::const_iterator it = cps.begin();
-        std::advance(it, t_i_plus_1);
-        Point ret;
-        (*it)->getRightBezierPointAtTime(false, time, ViewIdx(0), &ret.x, &ret.y);
-
-        return ret;
+        return cps[t_i].right;
     }
 
-    BezierCPs::const_iterator it = cps.begin();
-    std::advance(it, t_i);
-    BezierCPs::const_iterator next = it;
-    ++next;
-    if ( next == cps.end() ) {
-        next = cps.begin();
-    }
+    const PatchPoint& cur = cps[t_i];
+    const PatchPoint& next = cps[(t_i + 1) % cps.size()];
 
     t = t - t_i;
 
-    Point a, b, c, ab, bc, abc;
-    Point ret;
-    (*it)->getRightBezierPointAtTime(false, time, ViewIdx(0), &a.x, &a.y);
-    (*next)->getLeftBezierPointAtTime(false, time, ViewIdx(0), &b.x, &b.y);
-    (*next)->getPositionAtTime(false, time, ViewIdx(0), &c.x, &c.y);
+    const Point& a = cur.right;
+    const Point& b = next.left;
+    const Point& c = next.p;
+    Point ab, bc, abc;
     ab.x = (1. - t) * a.x + t * b.x;
     ab.y = (1. - t) * a.y + t * b.y;
 
@@ -245,9 +242,7 @@ getRightPointAt(const BezierCPs& cps,
     abc.x = (1. - t) * ab.x + t * bc.x;
     abc.y = (1. - t) * ab.y + t * bc.y;
     if ( (abc.x == c.x) && (abc.y == c.y) ) {
-        (*next)->getRightBezierPointAtTime(false, time, ViewIdx(0), &ret.x, &ret.y);
-
-        return ret;
+        return next.right;
     } else {
         return abc;
     }
@@ -268,18 +263,17 @@ norm(const Point& z0,
 }
 
 static Point
-predir(const BezierCPs& cps,
-       double time,
+predir(const PatchPoints& cps,
        double t)
 {
     //Compute the unit vector in the direction of the bysector angle
     Point dir;
     Point p1, p2, p2p1, p1p2;
 
-    p2 = getPointAt(cps, time, t);
-    p2p1 = getLeftPointAt(cps, time, t);
-    p1p2 = getRightPointAt(cps, time, t - 1);
-    p1 = getPointAt(cps, time, t - 1);
+    p2 = getPointAt(cps, t);
+    p2p1 = getLeftPointAt(cps, t);
+    p1p2 = getRightPointAt(cps, t - 1);
+    p1 = getPointAt(cps, t - 1);
     dir.x =  3. * (p2.x - p2p1.x);
     dir.y =  3. * (p2.y - p2p1.y);
 
@@ -320,17 +314,16 @@ predir(const BezierCPs& cps,
 }
 
 static Point
-postdir(const BezierCPs& cps,
-        double time,
+postdir(const PatchPoints& cps,
         double t)
 {
     Point dir;
     Point p2, p3, p2p3, p3p2;
 
-    p2 = getPointAt(cps, time, t);
-    p2p3 = getRightPointAt(cps, time, t);
-    p3 = getPointAt(cps, time, t + 1);
-    p3p2 = getLeftPointAt(cps, time, t + 1);
+    p2 = getPointAt(cps, t);
+    p2p3 = getRightPointAt(cps, t);
+    p3 = getPointAt(cps, t + 1);
+    p3p2 = getLeftPointAt(cps, t + 1);
     dir.x = 3. * (p2p3.x - p2.x);
     dir.y = 3. * (p2p3.y - p2.y);
     double epsilon = norm(p2, p2p3, p3p2, p3);
@@ -371,22 +364,21 @@ postdir(const BezierCPs& cps,
 }
 
 static Point
-dirVect(const BezierCPs& cps,
-        double time,
+dirVect(const PatchPoints& cps,
         double t,
         int sign)
 {
     Point ret;
 
     if (sign == 0) {
-        Point pre = predir(cps, time, t);
-        Point post = postdir(cps, time, t);
+        Point pre = predir(cps, t);
+        Point post = postdir(cps, t);
         ret.x = pre.x + post.x;
         ret.y = pre.y + post.y;
     } else if (sign < 0) {
-        ret = predir(cps, time, t);
+        ret = predir(cps, t);
     } else if (sign > 0) {
-        ret = postdir(cps, time, t);
+        ret = postdir(cps, t);
     }
 
     double norm = std::sqrt(ret.x * ret.x + ret.y * ret.y);
@@ -398,16 +390,15 @@ dirVect(const BezierCPs& cps,
 }
 
 static Point
-dirVect(const BezierCPs& cps,
-        double time,
+dirVect(const PatchPoints& cps,
         double t)
 {
     int t_i = std::floor(t);
 
     t -= t_i;
     if (t == 0) {
-        Point pre = predir(cps, time, t);
-        Point post = postdir(cps, time, t);
+        Point pre = predir(cps, t);
+        Point post = postdir(cps, t);
         Point ret;
         ret.x = pre.x + post.x;
         ret.y = pre.y + post.y;
@@ -422,10 +413,10 @@ dirVect(const BezierCPs& cps,
 
         return ret;
     }
-    Point z0 = getPointAt(cps, time, t_i);
-    Point c0 = getRightPointAt(cps, time, t_i);
-    Point c1 = getLeftPointAt(cps, time, t_i + 1);
-    Point z1 = getPointAt(cps, time, t_i + 1);
+    Point z0 = getPointAt(cps, t_i);
+    Point c0 = getRightPointAt(cps, t_i);
+    Point c1 = getLeftPointAt(cps, t_i + 1);
+    Point z1 = getPointAt(cps, t_i + 1);
     Point a, b, c;
     a.x = 3. * (z1.x - z0.x) + 9. * (c0.x - c1.x);
     a.y = 3. * (z1.y - z0.y) + 9. * (c0.y - c1.y);
@@ -468,26 +459,24 @@ dirVect(const BezierCPs& cps,
     return a;
 } // dirVect
 
-static BezierCPPtr
-makeBezierCPFromPoint(const Point& p,
-                      const Point& left,
-                      const Point& right)
+static PatchPoint
+makePatchPointAt(const PatchPoints& cps,
+                 double t)
 {
-    BezierCPPtr ret = std::make_shared<BezierCP>();
+    PatchPoint ret;
 
-    ret->setStaticPosition(false, p.x, p.y);
-    ret->setLeftBezierStaticPosition(false, left.x, left.y);
-    ret->setRightBezierStaticPosition(false, right.x, right.y);
+    ret.p = getPointAt(cps, t);
+    ret.left = getLeftPointAt(cps, t);
+    ret.right = getRightPointAt(cps, t);
 
     return ret;
 }
 
 static void
-findIntersection(const BezierCPs& cps,
-                 double time,
+findIntersection(const PatchPoints& cps,
                  const Point& p,
                  const Point& q,
-                 BezierCPPtr* newPoint,
+                 PatchPoint* newPoint,
                  int* before)
 {
     double fuzz = 1000. * std::numeric_limits<double>::epsilon();
@@ -495,23 +484,14 @@ findIntersection(const BezierCPs& cps,
     double dx = q.x - p.x;
     double dy = q.y - p.y;
     double det = p.y * q.x - p.x * q.y;
-    std::vector<std::pair<BezierCPPtr, std::pair<BezierCPs::const_iterator, BezierCPs::const_iterator> > > intersections;
-    BezierCPs::const_iterator s1 = cps.begin();
-    BezierCPs::const_iterator s2 = cps.begin();
-
-    ++s2;
-    int index = 0;
-    for (; s1 != cps.end(); ++s1, ++s2, ++index) {
-        if ( s2 == cps.end() ) {
-            s2 = cps.begin();
-        }
-
-        Point z0, z1, c0, c1;
-        (*s1)->getPositionAtTime(false, time, ViewIdx(0), &z0.x, &z0.y);
-        (*s1)->getRightBezierPointAtTime(false, time, ViewIdx(0), &c0.x, &c0.y);
-        (*s2)->getPositionAtTime(false, time, ViewIdx(0), &z1.x, &z1.y);
-        (*s2)->getLeftBezierPointAtTime(false, time, ViewIdx(0), &c1.x, &c1.y);
+    int ncps = (int)cps.size();
+    std::vector<std::pair<PatchPoint, int> > intersections;
 
+    for (int index = 0; index < ncps; ++index) {
+        const Point& z0 = cps[index].p;
+        const Point& c0 = cps[index].right;
+        const Point& z1 = cps[(index + 1) % ncps].p;
+        const Point& c1 = cps[(index + 1) % ncps].left;
 
         Point t3, t2, t1;
         t3.x = z1.x - z0.x + 3. * (c0.x - c1.x);
@@ -527,39 +507,34 @@ findIntersection(const BezierCPs& cps,
         double b = dy * t2.x - dx * t2.y;
         double c = dy * t1.x - dx * t1.y;
         double d = dy * z0.x - dx * z0.y + det;
-        std::vector<double> roots;
+        double roots[3];
+        int nRoots;
         if ( std::max(std::max(std::max(a * a, b * b), c * c), d * d) >
              fuzz2 * std::max(std::max(std::max(z0.x * z0.x + z0.y * z0.y, z1.x * z1.x + z1.y * z1.y),
                                        c0.x * c0.x + c0.y * c0.y),
                               c1.x * c1.x + c1.y * c1.y) ) {
-            double r[3];
             int order[3];
-            int nsols = Interpolation::solveCubic(d, c, b, a, r, order);
-            for (int i = 0; i < nsols; ++i) {
-                roots.push_back(r[i]);
-            }
+            nRoots = Interpolation::solveCubic(d, c, b, a, roots, order);
         } else {
-            roots.push_back(0);
+            roots[0] = 0;
+            nRoots = 1;
         }
 
-        for (std::size_t i = 0; i < roots.size(); ++i) {
+        for (int i = 0; i < nRoots; ++i) {
             if ( (roots[i] >= -fuzz) && (roots[i] <= 1. + fuzz) ) {
-                if (i + roots[i] >= roots.size() - fuzz) {
+                if (i + roots[i] >= nRoots - fuzz) {
                     roots[i] = 0;
                 }
-                Point interP = getPointAt(cps, time, roots[i] + index);
-                Point interLeft = getLeftPointAt(cps, time, roots[i] + index);
-                Point interRight = getRightPointAt(cps, time, roots[i] + index);
-                BezierCPPtr intersection = makeBezierCPFromPoint(interP, interLeft, interRight);
+                PatchPoint intersection = makePatchPointAt(cps, roots[i] + index);
+                const Point& interP = intersection.p;
                 double distToP = std::sqrt( (p.x - interP.x) * (p.x - interP.x) + (p.y - interP.y) * (p.y - interP.y) );
                 if (std::abs(distToP) < 1e-4) {
                     continue;
                 }
 
                 bool found = false;
-                for (std::vector<std::pair<BezierCPPtr, std::pair<BezierCPs::const_iterator, BezierCPs::const_iterator> > >::iterator it = intersections.begin(); it != intersections.end(); ++it) {
-                    Point other;
-                    it->first->getPositionAtTime(false, time, ViewIdx(0), &other.x, &other.y);
+                for (std::vector<std::pair<PatchPoint, int> >::iterator it = intersections.begin(); it != intersections.end(); ++it) {
+                    const Point& other = it->first.p;
                     double distSquared = (interP.x - other.x) * (interP.x - other.x) + (interP.y - other.y) * (interP.y - other.y);
                     if (distSquared <= fuzz2) {
                         found = true;
@@ -568,57 +543,58 @@ findIntersection(const BezierCPs& cps,
                 }
 
                 if (!found) {
-                    intersections.push_back( std::make_pair( intersection, std::make_pair(s1, s2) ) );
+                    intersections.push_back( std::make_pair(intersection, index) );
                 }
             }
         }
     }
 
-
-    assert(intersections.size() >= 1);
-    const std::pair<BezierCPPtr, std::pair<BezierCPs::const_iterator, BezierCPs::const_iterator> > & inter = intersections.front();
-    *newPoint = inter.first;
-    *before = std::distance(cps.begin(), inter.second.first);
+    // The line may not cross the patch again if it is self-intersecting
+    if ( intersections.empty() ) {
+        return;
+    }
+    *newPoint = intersections.front().first;
+    *before = intersections.front().second;
 } // findIntersection
 
+static void regularizeInternal(const PatchPoints &patch,
+                               int depth,
+                               std::vector<PatchPoints>* fixedPatch);
+
 static bool
-splitAt(const BezierCPs &cps,
-        double time,
+splitAt(const PatchPoints &cps,
         double t,
-        std::list<BezierCPs>* ret)
+        int depth,
+        std::vector<PatchPoints>* ret)
 {
-    Point dir = dirVect(cps, time, t);
+    Point dir = dirVect(cps, t);
 
     if ( (dir.x != 0.) || (dir.y != 0.) ) {
-        Point z = getPointAt(cps, time, t);
-        Point zLeft = getLeftPointAt(cps, time, t);
-        Point zRight = getRightPointAt(cps, time, t);
+        PatchPoint startingPoint = makePatchPointAt(cps, t);
+        const Point& z = startingPoint.p;
         Point q;
         q.x = z.x;
         q.y = z.y + dir.y;
-        BezierCPPtr newPoint;
+        PatchPoint newPoint;
         int pointIdx = -1;
-        findIntersection(cps, time, z, q, &newPoint, &pointIdx);
-        assert( pointIdx >= 0 && pointIdx < (int)cps.size() );
+        findIntersection(cps, z, q, &newPoint, &pointIdx);
+        if (pointIdx == -1) {
+            return false;
+        }
+        int ncps = (int)cps.size();
+        assert(pointIdx >= 0 && pointIdx < ncps);
 
         //Separate the original patch in 2 parts and call regularize again on each of them
-        BezierCPs firstPart, secondPart;
-        BezierCPs::const_iterator it = cps.begin();
-        std::advance( it, std::ceil(t) );
+        PatchPoints firstPart, secondPart;
+
         /*
-           "it" is now pointing to the next control point after the split point
+           "start" is the next control point after the split point
          */
-        BezierCPs::const_iterator start = it;
-        BezierCPs::const_iterator end = cps.begin();
+        int start = (int)std::ceil(t) % ncps;
         /*
            "end" is the control point before the intersection point
          */
-        if (pointIdx > 0) {
-            std::advance(end, pointIdx);
-        }
-
-
-        BezierCPPtr startingPoint = makeBezierCPFromPoint(z, zLeft, zRight);
+        int end = pointIdx;
 
         //Start by adding the split point (if it is not a control point)
         if (std::ceil(t) != t) {
@@ -627,44 +603,29 @@ splitAt(const BezierCPs &cps,
 
 
         //Add all control points until we reach the point before the intersection point
-        for (; it != end; ) {
-            firstPart.push_back(*it);
-
-            ++it;
-            if ( it == cps.end() ) {
-                it = cps.begin();
-            }
+        int it = start;
+        for (; it != end; it = (it + 1) % ncps) {
+            firstPart.push_back(cps[it]);
         }
-        firstPart.push_back(*end);
+        firstPart.push_back(cps[end]);
         //Add the intersection point
         firstPart.push_back(newPoint);
 
         //Make it go after the intersection point to start the second split
-        ++it;
-        if ( it == cps.end() ) {
-            it = cps.begin();
-        }
+        it = (it + 1) % ncps;
 
         //Add the intersection point as a starting point of the second split
         secondPart.push_back(newPoint);
 
         //Add control points until we find the starting point (i.e:  the control point after the original split point)
-        for (; it != start; ) {
-            secondPart.push_back(*it);
-            ++it;
-            if ( it == cps.end() ) {
-                it = cps.begin();
-            }
+        for (; it != start; it = (it + 1) % ncps) {
+            secondPart.push_back(cps[it]);
         }
         //Finally add the split point to finish the second split
         secondPart.push_back(startingPoint);
 
-        std::list<BezierCPs> regularizedFirst;
-        std::list<BezierCPs> regularizedSecond;
-        CoonsRegularization::regularize(firstPart, time, &regularizedFirst);
-        CoonsRegularization::regularize(secondPart, time, &regularizedSecond);
-        ret->insert( ret->begin(), regularizedFirst.begin(), regularizedFirst.end() );
-        ret->insert( ret->end(), regularizedSecond.begin(), regularizedSecond.end() );
+        regularizeInternal(firstPart, depth + 1, ret);
+        regularizeInternal(secondPart, depth + 1, ret);
 
         return true;
     }
@@ -677,10 +638,10 @@ splitAt(const BezierCPs &cps,
  * along the bysector angle and separate the patch.
  **/
 static bool
-checkAnglesAndSplitIfNeeded(const BezierCPs &cps,
-                            double time,
+checkAnglesAndSplitIfNeeded(const PatchPoints &cps,
                             int sign,
-                            std::list<BezierCPs>* ret)
+                            int depth,
+                            std::vector<PatchPoints>* ret)
 {
     int ncps = (int)cps.size();
 
@@ -688,12 +649,12 @@ checkAnglesAndSplitIfNeeded(const BezierCPs &cps,
 
 
     for (int i = 0; i < ncps; ++i) {
-        Point negativeDir = dirVect(cps, time, i, -1);
+        Point negativeDir = dirVect(cps, i, -1);
         negativeDir.y = -negativeDir.y;
-        Point positiveDir = dirVect(cps, time, i, 1);
+        Point positiveDir = dirVect(cps, i, 1);
         double py = negativeDir.x * positiveDir.y + negativeDir.y * positiveDir.x;
         if (py * sign < -1e-4) {
-            if ( splitAt(cps, time, i, ret) ) {
+            if ( splitAt(cps, i, depth, ret) ) {
                 return true;
             }
 
@@ -705,91 +666,59 @@ checkAnglesAndSplitIfNeeded(const BezierCPs &cps,
 }
 
 static void
-tensor(const BezierCPs& p,
-       double time,
+tensor(const PatchPoints& p,
        const Point* internal,
        Point ret[4][4])
 {
-    ret[0][0] = getPointAt(p, time, 0);
-    ret[0][1] = getLeftPointAt(p, time, 0);
-    ret[0][2] = getRightPointAt(p, time, 3);
-    ret[0][3] = getPointAt(p, time, 3);
+    ret[0][0] = getPointAt(p, 0);
+    ret[0][1] = getLeftPointAt(p, 0);
+    ret[0][2] = getRightPointAt(p, 3);
+    ret[0][3] = getPointAt(p, 3);
 
-    ret[1][0] = getRightPointAt(p, time, 0);
+    ret[1][0] = getRightPointAt(p, 0);
     ret[1][1] = internal[0];
     ret[1][2] = internal[3];
-    ret[1][3] = getLeftPointAt(p, time, 3);
+    ret[1][3] = getLeftPointAt(p, 3);
 
-    ret[2][0] = getLeftPointAt(p, time, 1);
+    ret[2][0] = getLeftPointAt(p, 1);
     ret[2][1] = internal[1];
     ret[2][2] = internal[2];
-    ret[2][3] = getRightPointAt(p, time, 2);
+    ret[2][3] = getRightPointAt(p, 2);
 
-    ret[3][0] = getPointAt(p, time, 1);
-    ret[3][1] = getRightPointAt(p, time, 1);
-    ret[3][2] = getLeftPointAt(p, time, 2);
-    ret[3][3] = getPointAt(p, time, 2);
+    ret[3][0] = getPointAt(p, 1);
+    ret[3][1] = getRightPointAt(p, 1);
+    ret[3][2] = getLeftPointAt(p, 2);
+    ret[3][3] = getPointAt(p, 2);
 }
 
 static void
-coonsPatch(const BezierCPs& p,
-           double time,
+coonsPatch(const PatchPoints& p,
            Point ret[4][4])
 {
     assert(p.size() >= 3);
     Point internal[4];
-    BezierCPs::const_iterator cur = p.begin();
-    BezierCPs::const_iterator prev = p.end();
-    --prev;
-    BezierCPs::const_iterator next = cur;
-    ++next;
-    BezierCPs::const_iterator nextNext = next;
-    ++nextNext;
-
-    for (int j = 0; j < 4; ++j,
-         ++prev, ++cur, ++next, ++nextNext) {
-        if ( cur == p.end() ) {
-            cur = p.begin();
-        }
-        if ( prev == p.end() ) {
-            prev = p.begin();
-        }
-        if ( next == p.end() ) {
-            next = p.begin();
-        }
-        if ( nextNext == p.end() ) {
-            nextNext = p.begin();
-        }
-
-        Point p1;
-        (*cur)->getPositionAtTime(false, time, ViewIdx(0), &p1.x, &p1.y);
-
-        Point p1left;
-        (*cur)->getLeftBezierPointAtTime(false, time, ViewIdx(0), &p1left.x, &p1left.y);
-
-        Point p1right;
-        (*cur)->getRightBezierPointAtTime(false, time, ViewIdx(0), &p1right.x, &p1right.y);
-
-        Point p0;
-        (*prev)->getPositionAtTime(false, time, ViewIdx(0), &p0.x, &p0.y);
-
-        Point p2;
-        (*next)->getPositionAtTime(false, time, ViewIdx(0), &p2.x, &p2.y);
-
-        Point p0left;
-        (*prev)->getLeftBezierPointAtTime(false, time, ViewIdx(0), &p0left.x, &p0left.y);
-
-        Point p2right;
-        (*next)->getRightBezierPointAtTime(false, time, ViewIdx(0), &p2right.x, &p2right.y);
-
-        Point p3;
-        (*nextNext)->getPositionAtTime(false, time, ViewIdx(0), &p3.x, &p3.y);
+    int ncps = (int)p.size();
+
+    for (int j = 0; j < 4; ++j) {
+        const PatchPoint& prev = p[(j + ncps - 1) % ncps];
+        const PatchPoint& cur = p[j % ncps];
+        const PatchPoint& next = p[(j + 1) % ncps];
+        const PatchPoint& nextNext = p[(j + 2) % ncps];
+
+        const Point& p1 = cur.p;
+        const Point& p1left = cur.left;
+        const Point& p1right = cur.right;
+        const Point& p0 = prev.p;
+        const Point& p2 = next.p;
+        const Point& p0left = prev.left;
+        const Point& p2right = next.right;
+        const Point& p3 = nextNext.p;
 
         internal[j].x = 1. / 9. * (-4. * p1.x + 6. * (p1left.x + p1right.x) - 2. * (p0.x + p2.x) + 3. * (p0left.x + p2right.x) - p3.x);
         internal[j].y = 1. / 9. * (-4. * p1.y + 6. * (p1left.y + p1right.y) - 2. * (p0.y + p2.y) + 3. * (p0left.y + p2right.y) - p3.y);
     }
 
-    return tensor(p, time, internal, ret);
+    return tensor(p, internal, ret);
 } // coonsPatch
 
 static
@@ -895,8 +824,7 @@ normal(const Point P[4][4],
 
 static
 Point
-findPointInside(const BezierCPs& cps,
-                double time)
+findPointInside(const PatchPoints& cps)
 {
     /*
        Given a simple polygon, find some point inside it. Here is a method based on the proof that
@@ -904,23 +832,20 @@ findPointInside(const BezierCPs& cps,
        a diagonal is interior to the polygon.
      */
     assert( !cps.empty() );
-    int i = 0;
-    for (BezierCPs::const_iterator it = cps.begin(); it != cps.end(); ++it, ++i) {
-        Point dir = dirVect(cps, time, i);
+    for (int i = 0; i < (int)cps.size(); ++i) {
+        Point dir = dirVect(cps, i);
         if ( (dir.x == 0.) && (dir.y == 0.) ) {
             continue;
         }
-        Point p;
-        (*it)->getPositionAtTime(false, time, ViewIdx(0), &p.x, &p.y);
+        const Point& p = cps[i].p;
         Point q;
         q.x = p.x;
         q.y = p.y + dir.y;
-        BezierCPPtr newPoint;
+        PatchPoint newPoint;
         int beforeIndex = -1;
-        findIntersection(cps, time, p, q, &newPoint, &beforeIndex);
-        if ( newPoint && (beforeIndex != -1) ) {
-            Point np;
-            newPoint->getPositionAtTime(false, time, ViewIdx(0), &np.x, &np.y);
+        findIntersection(cps, p, q, &newPoint, &beforeIndex);
+        if (beforeIndex != -1) {
+            const Point& np = newPoint.p;
             if ( (np.x != p.x) || (np.y != p.y) ) {
                 Point m;
                 m.x = 0.5 * (p.x + np.x);
@@ -930,10 +855,8 @@ findPointInside(const BezierCPs& cps,
             }
         }
     }
-    Point ret;
-    cps.front()->getPositionAtTime(false, time, ViewIdx(0), &ret.x, &ret.y);
 
-    return ret;
+    return cps.front().p;
 }
 
 static double
@@ -1345,8 +1268,7 @@ checkCurve(const Point& z0,
 // relative to the point z, or the largest odd integer if the point lies on
 // the path.
 static int
-computeWindingNumber(const BezierCPs& patch,
-                     double time,
+computeWindingNumber(const PatchPoints& patch,
                      const Point& z)
 {
     assert(patch.size() >= 3);
@@ -1354,21 +1276,12 @@ computeWindingNumber(const BezierCPs& patch,
     static const int undefined = std::numeric_limits<int>::max() % 2 ? std::numeric_limits<int>::max() : std::numeric_limits<int>::max() - 1;
     const unsigned maxdepth = DBL_MANT_DIG;
     int count = 0;
-    BezierCPs::const_iterator it = patch.begin();
-    BezierCPs::const_iterator next = it;
-    ++next;
-    for (; it != patch.end(); ++it, ++next) {
-        if ( next == patch.end() ) {
-            next = patch.begin();
-        }
-
-        Point p0, p1, p2, p3;
-        (*it)->getPositionAtTime(false, time, ViewIdx(0), &p0.x, &p0.y);
-        (*it)->getRightBezierPointAtTime(false, time, ViewIdx(0), &p1.x, &p1.y);
-        (*next)->getLeftBezierPointAtTime(false, time, ViewIdx(0), &p2.x, &p2.y);
-        (*next)->getPositionAtTime(false, time, ViewIdx(0), &p3.x, &p3.y);
+    int ncps = (int)patch.size();
+    for (int i = 0; i < ncps; ++i) {
+        const PatchPoint& cur = patch[i];
+        const PatchPoint& next = patch[(i + 1) % ncps];
 
-        if ( checkCurve(p0, p1, p2, p3, z, &count, maxdepth) ) {
+        if ( checkCurve(cur.p, cur.right, next.left, next.p, z, &count, maxdepth) ) {
             return undefined;
         }
     }
@@ -1376,18 +1289,18 @@ computeWindingNumber(const BezierCPs& patch,
     return count;
 }
 
-void
-CoonsRegularization::regularize(const BezierCPs &patch,
-                                double time,
-                                std::list<BezierCPs> *fixedPatch)
+static void
+regularizeInternal(const PatchPoints &patch,
+                   int depth,
+                   std::vector<PatchPoints>* fixedPatch)
 {
-    if (patch.size() < 3) {
+    if ( (patch.size() < 3) || (depth >= COONS_REGULARIZATION_MAX_SPLIT_DEPTH) ) {
         fixedPatch->push_back(patch);
 
         return;
     }
 
-    Point pointInside = findPointInside(patch, time);
+    Point pointInside = findPointInside(patch);
     int sign;
     {
         RectD bbox;
@@ -1395,23 +1308,24 @@ CoonsRegularization::regularize(const BezierCPs &patch,
         bbox.x2 = -std::numeric_limits<double>::infinity();
         bbox.y1 = std::numeric_limits<double>::infinity();
         bbox.y2 = -std::numeric_limits<double>::infinity();
-        Bezier::bezierSegmentListBboxUpdate(false, patch, true, false, time, ViewIdx(0), 0, Transform::Matrix3x3(), &bbox);
+        for (std::size_t i = 0; i < patch.size(); ++i) {
+            const PatchPoint& cur = patch[i];
+            const PatchPoint& next = patch[(i + 1) % patch.size()];
+            Bezier::bezierPointBboxUpdate(cur.p, cur.right, next.left, next.p, &bbox);
+        }
         if ( !bbox.contains(pointInside.x, pointInside.y) ) {
             sign = 0;
         } else {
-            int winding_number = computeWindingNumber(patch, time, pointInside);
+            int winding_number = computeWindingNumber(patch, pointInside);
             sign = (winding_number < 0) ? -1 : ( (winding_number > 0) ? 1 : 0 );
         }
     }
-    std::list<BezierCPs> splits;
-    if ( checkAnglesAndSplitIfNeeded(patch, time, sign, &splits) ) {
-        *fixedPatch = splits;
-
+    if ( checkAnglesAndSplitIfNeeded(patch, sign, depth, fixedPatch) ) {
         return;
     }
 
     Point P[4][4];
-    coonsPatch(patch, time, P);
+    coonsPatch(patch, P);
 
     //Check for degeneracy
     Point U[3][4];
@@ -1561,13 +1475,71 @@ CoonsRegularization::regularize(const BezierCPs &patch,
     }
 
     // Split at the worst boundary degeneracy.
-    if ( (M < 0) && splitAt(patch, time, cut, fixedPatch) ) {
+    if ( (M < 0) && splitAt(patch, cut, depth, fixedPatch) ) {
         return;
     }
 
 
     // Split arbitrarily to resolve any remaining (internal) degeneracy.
-    splitAt(patch, time, 0.5, fixedPatch);
-} // CoonsRegularization::regularize
+    if ( !splitAt(patch, 0.5, depth, fixedPatch) ) {
+        fixedPatch->push_back(patch);
+    }
+} // regularizeInternal
+
+void
+CoonsRegularization::regularize(const BezierCPs &patch,
+                                double time,
+                                std::list<BezierCPs> *fixedPatch)
+{
+    PatchPoints points;
+
+    evaluatePatch(patch, time, &points);
+
+    std::vector<PatchPoints> fixedPoints;
+    regularizeInternal(points, 0, &fixedPoints);
+    for (std::vector<PatchPoints>::const_iterator it = fixedPoints.begin(); it != fixedPoints.end(); ++it) {
+        fixedPatch->push_back( BezierCPs() );
+        toBezierCPs(*it, &fixedPatch->back());
+    }
+}
+
+void
+CoonsRegularization::regularizeAll(const std::list<BezierCPs>& coonsPatches,
+                                   double time,
+                                   std::list<BezierCPs>* fixedPatches)
+{
+    // Evaluate all the control points on this thread, the patches are then independent
+    std::vector<PatchPoints> points( coonsPatches.size() );
+    std::size_t i = 0;
+
+    for (std::list<BezierCPs>::const_iterator it = coonsPatches.begin(); it != coonsPatches.end(); ++it, ++i) {
+        evaluatePatch(*it, time, &points[i]);
+    }
+
+    std::vector<std::vector<PatchPoints> > fixedPoints( points.size() );
+    std::function<void (const int&)> regularizeFunctor = [&](const int& index) {
+        regularizeInternal(points[index], 0, &fixedPoints[index]);
+    };
+
+    if ( ( (int)points.size() < COONS_REGULARIZATION_MIN_CONCURRENT_PATCHES ) || (QThreadPool::globalInstance()->maxThreadCount() <= 1) ) {
+        for (std::size_t index = 0; index < points.size(); ++index) {
+            regularizeFunctor( (int)index );
+        }
+    } else {
+        std::vector<int> indices( points.size() );
+        for (std::size_t index = 0; index < indices.size(); ++index) {
+            indices[index] = (int)index;
+        }
+        QFuture<void> ret = QtConcurrent::map(indices, regularizeFunctor);
+        ret.waitForFinished();
+    }
+
+    for (std::size_t index = 0; index < fixedPoints.size(); ++index) {
+        for (std::vector<PatchPoints>::const_iterator it = fixedPoints[index].begin(); it != fixedPoints[index].end(); ++it) {
+            fixedPatches->push_back( BezierCPs() );
+            toBezierCPs(*it, &fixedPatches->back());
+        }
+    }
+} // CoonsRegularization::regularizeAll
 
 NATRON_NAMESPACE_EXIT
@@ -36,9 +36,21 @@
 NATRON_NAMESPACE_ENTER
 
 namespace CoonsRegularization {
+/**
+ * @brief Splits the Coons patch in patches without degeneracy, appended to fixedPatch.
+ * The control points are evaluated once at the given time.
+ **/
 void regularize(const std::list<BezierCPPtr>& coonsPatch,
                 double time,
                 std::list<std::list<BezierCPPtr> >* fixedPatch);
+
+/**
+ * @brief Same as regularize() for independent patches, which are regularized concurrently.
+ * The patches of fixedPatches are in the order of coonsPatches.
+ **/
+void regularizeAll(const std::list<std::list<BezierCPPtr> >& coonsPatches,
+                   double time,
+                   std::list<std::list<BezierCPPtr> >* fixedPatches);
 } // namespace CoonsRegularization
 
 NATRON_NAMESPACE_EXIT
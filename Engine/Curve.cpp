@@ -27,9 +27,12 @@
 
 #include <algorithm>
 #include <cassert>
+#include <cmath>
 #include <limits>
 #include <stdexcept>
 
+#include <QtCore/QAtomicInt>
+
 #include "Engine/AppManager.h"
 
 #include "Engine/CurvePrivate.h"
@@ -40,9 +43,20 @@
 
 NATRON_NAMESPACE_ENTER
 
+// A curve is sampled once it has been evaluated that many times at frames or sub-frames since its last change
+#define NATRON_CURVE_SAMPLE_TABLE_MIN_EVALUATIONS 256
+
+// Number of samples per frame used when the curve is mostly evaluated at sub-frames (e.g. for motion blur).
+// This must be a power of 2, so that sample times are exactly representable.
+#define NATRON_CURVE_SAMPLE_TABLE_SUBFRAMES 8
+
+// Maximum number of samples of a table: curves with a wider keyframes range are never sampled
+#define NATRON_CURVE_SAMPLE_TABLE_MAX_SAMPLES 65536
 
 NATRON_NAMESPACE_ANONYMOUS_ENTER
 
+static QAtomicInt sampleTablesEnabled(1);
+
 struct KeyFrameCloner
 {
     KeyFrame operator()(const KeyFrame & kf) const
@@ -301,6 +315,7 @@ Curve::setPeriodic(bool periodic)
     QMutexLocker k(&_imp->_lock);
     _imp->isPeriodic = periodic;
     _imp->keyFrames.clear();
+    invalidateSampleTable();
 }
 
 bool
@@ -321,6 +336,7 @@ Curve::clearKeyFrames()
     QMutexLocker l(&_imp->_lock);
 
     _imp->keyFrames.clear();
+    invalidateSampleTable();
 }
 
 bool
@@ -441,6 +457,7 @@ Curve::addKeyFrame(KeyFrame key)
 std::pair<KeyFrameSet::iterator, bool> Curve::addKeyFrameNoUpdate(const KeyFrame & cp)
 {
     // PRIVATE - should not lock
+    invalidateSampleTable();
     if (!_imp->isParametric) { //< if keyframes are clamped to integers
         std::pair<KeyFrameSet::iterator, bool> newKey = _imp->keyFrames.insert(cp);
         // keyframe at this time exists, erase and insert again
@@ -889,6 +906,12 @@ double
 Curve::getValueAt(double t,
                   bool doClamp) const
 {
+    double ret;
+
+    if ( getValueFromSampleTable(t, doClamp, &ret) ) {
+        return ret;
+    }
+
     QMutexLocker l(&_imp->_lock);
 
     if ( _imp->keyFrames.empty() ) {
@@ -911,49 +934,67 @@ Curve::getValueAt(double t,
     } else
 #endif
     {
-        // even when there is only one keyframe, there may be tangents!
-        //if (_imp->keyFrames.size() == 1) {
-        //    //if there's only 1 keyframe, don't bother interpolating
-        //    return (*_imp->keyFrames.begin()).getValue();
-        //}
-        double tcur, tnext;
-        double vcurDerivRight, vnextDerivLeft, vcur, vnext;
-        KeyframeTypeEnum interp, interpNext;
-        KeyFrame k(t, 0.);
-        // find the first keyframe with time greater than t
-        KeyFrameSet::const_iterator itup;
-        itup = _imp->keyFrames.upper_bound(k);
-        interParams(_imp->keyFrames,
-                    _imp->isPeriodic,
-                    _imp->xMin,
-                    _imp->xMax,
-                    &t,
-                    itup,
-                    &tcur,
-                    &vcur,
-                    &vcurDerivRight,
-                    &interp,
-                    &tnext,
-                    &vnext,
-                    &vnextDerivLeft,
-                    &interpNext);
-
-        v = Interpolation::interpolate(tcur, vcur,
-                                       vcurDerivRight,
-                                       vnextDerivLeft,
-                                       tnext, vnext,
-                                       t,
-                                       interp,
-                                       interpNext);
+        v = interpolateValueAt(t);
 #ifdef NATRON_CURVE_USE_CACHE
         _imp->resultCache[t] = v;
 #endif
     }
 
+    onValueEvaluated(t);
+
     if ( doClamp && mustClamp() ) {
         v = clampValueToCurveYRange(v);
     }
 
+    return roundValueToCurveType(v);
+} // getValueAt
+
+double
+Curve::interpolateValueAt(double t) const
+{
+    // PRIVATE - should not lock
+    assert( !_imp->keyFrames.empty() );
+
+    // even when there is only one keyframe, there may be tangents!
+    //if (_imp->keyFrames.size() == 1) {
+    //    //if there's only 1 keyframe, don't bother interpolating
+    //    return (*_imp->keyFrames.begin()).getValue();
+    //}
+    double tcur, tnext;
+    double vcurDerivRight, vnextDerivLeft, vcur, vnext;
+    KeyframeTypeEnum interp, interpNext;
+    KeyFrame k(t, 0.);
+    // find the first keyframe with time greater than t
+    KeyFrameSet::const_iterator itup;
+    itup = _imp->keyFrames.upper_bound(k);
+    interParams(_imp->keyFrames,
+                _imp->isPeriodic,
+                _imp->xMin,
+                _imp->xMax,
+                &t,
+                itup,
+                &tcur,
+                &vcur,
+                &vcurDerivRight,
+                &interp,
+                &tnext,
+                &vnext,
+                &vnextDerivLeft,
+                &interpNext);
+
+    return Interpolation::interpolate(tcur, vcur,
+                                      vcurDerivRight,
+                                      vnextDerivLeft,
+                                      tnext, vnext,
+                                      t,
+                                      interp,
+                                      interpNext);
+}
+
+double
+Curve::roundValueToCurveType(double v) const
+{
+    // PRIVATE - should not lock
     switch (_imp->type) {
     case CurvePrivate::eCurveTypeString:
     case CurvePrivate::eCurveTypeInt:
@@ -969,7 +1010,7 @@ Curve::getValueAt(double t,
 
         return v;
     }
-} // getValueAt
+}
 
 double
 Curve::getDerivativeAt(double t) const
@@ -1185,6 +1226,13 @@ Curve::YRange Curve::getCurveYRange() const
 {
     QMutexLocker l(&_imp->_lock);
 
+    return getCurveYRange_internal();
+}
+
+Curve::YRange
+Curve::getCurveYRange_internal() const
+{
+    // PRIVATE - should not lock
     if ( !mustClamp() ) {
         return YRange( -std::numeric_limits<double>::infinity(), std::numeric_limits<double>::infinity() );
     }
@@ -1249,6 +1297,7 @@ Curve::setXRange(double a,
 
     _imp->xMin = a;
     _imp->xMax = b;
+    invalidateSampleTable();
 }
 
 std::pair<double, double> Curve::getXRange() const
@@ -1274,6 +1323,31 @@ Curve::getKeyFrames_mt_safe() const
     return _imp->keyFrames;
 }
 
+KeyFrameSet
+Curve::getKeyFramesFromIndex_mt_safe(int firstIndex) const
+{
+    QMutexLocker l(&_imp->_lock);
+    KeyFrameSet ret;
+    int nKeys = (int)_imp->keyFrames.size();
+
+    firstIndex = std::max(firstIndex, 0);
+    if (firstIndex >= nKeys) {
+        return ret;
+    }
+    KeyFrameSet::const_iterator it;
+    if (firstIndex > nKeys / 2) {
+        it = _imp->keyFrames.end();
+        std::advance(it, firstIndex - nKeys);
+    } else {
+        it = _imp->keyFrames.begin();
+        std::advance(it, firstIndex);
+    }
+    // the keyframes are sorted, so each one is inserted at the end in constant time
+    ret.insert( it, _imp->keyFrames.end() );
+
+    return ret;
+}
+
 KeyFrameSet::iterator
 Curve::setKeyFrameValueAndTimeNoUpdate(double value,
                                        double time,
@@ -1814,6 +1888,7 @@ Curve::setYRange(double yMin,
 
     _imp->yMin = yMin;
     _imp->yMax = yMax;
+    invalidateSampleTable();
 }
 
 bool
@@ -1833,8 +1908,128 @@ Curve::onCurveChanged()
 #ifdef NATRON_CURVE_USE_CACHE
     _imp->resultCache.clear();
 #endif
+    invalidateSampleTable();
+}
+
+void
+Curve::invalidateSampleTable()
+{
+    // PRIVATE - should not lock
+    if ( std::atomic_load(&_imp->sampleTable) ) {
+        std::atomic_store( &_imp->sampleTable, CurveSampleTableConstPtr() );
+    }
+    _imp->frameEvaluations = 0;
+    _imp->subFrameEvaluations = 0;
+    _imp->sampleTableTooLarge = false;
+}
+
+void
+Curve::setSampleTablesEnabled(bool enabled)
+{
+    sampleTablesEnabled.fetchAndStoreRelease(enabled ? 1 : 0);
+}
+
+bool
+Curve::isSampleTablesEnabled()
+{
+    return (int)sampleTablesEnabled != 0;
 }
 
+bool
+Curve::hasSampleTable() const
+{
+    return (bool)std::atomic_load(&_imp->sampleTable);
+}
+
+bool
+Curve::getValueFromSampleTable(double t,
+                               bool doClamp,
+                               double* ret) const
+{
+    if ( !isSampleTablesEnabled() ) {
+        return false;
+    }
+    CurveSampleTableConstPtr table = std::atomic_load(&_imp->sampleTable);
+    if (!table) {
+        return false;
+    }
+    // Only exact sample times are answered from the table, so that the result is
+    // bit-identical to the interpolated value
+    double s = (t - table->firstTime) * table->samplesPerFrame;
+    if ( (s < 0.) || ( s >= (double)table->values.size() ) || (std::floor(s) != s) ) {
+        return false;
+    }
+    double v = table->values[(std::size_t)s];
+
+    if ( doClamp && table->mustClamp ) {
+        // the owner of a curve never changes, and the knob range does not depend on the curve lock
+        YRange minmax = _imp->owner ? getCurveYRange_internal() : YRange(table->yMin, table->yMax);
+        if (v > minmax.max) {
+            v = minmax.max;
+        } else if (v < minmax.min) {
+            v = minmax.min;
+        }
+    }
+    *ret = roundValueToCurveType(v);
+
+    return true;
+}
+
+void
+Curve::onValueEvaluated(double t) const
+{
+    // PRIVATE - should not lock
+    if ( _imp->sampleTableTooLarge || _imp->isParametric || !isSampleTablesEnabled() ) {
+        return;
+    }
+    if ( std::atomic_load(&_imp->sampleTable) ) {
+        // The curve is already sampled, t is outside of the table
+        return;
+    }
+    if (std::floor(t) == t) {
+        ++_imp->frameEvaluations;
+    } else if (std::floor(t * NATRON_CURVE_SAMPLE_TABLE_SUBFRAMES) == t * NATRON_CURVE_SAMPLE_TABLE_SUBFRAMES) {
+        ++_imp->subFrameEvaluations;
+    } else {
+        return;
+    }
+    if (_imp->frameEvaluations + _imp->subFrameEvaluations < NATRON_CURVE_SAMPLE_TABLE_MIN_EVALUATIONS) {
+        return;
+    }
+
+    assert( !_imp->keyFrames.empty() );
+    double firstTime = std::floor( _imp->keyFrames.begin()->getTime() ) - 1.;
+    double lastTime = std::ceil( _imp->keyFrames.rbegin()->getTime() ) + 1.;
+    if (_imp->isPeriodic) {
+        firstTime = std::max(firstTime, std::floor(_imp->xMin));
+        lastTime = std::min(lastTime, std::ceil(_imp->xMax));
+    }
+    // Sample sub-frames only if a significant part of the evaluations are done at sub-frames
+    int samplesPerFrame = (_imp->subFrameEvaluations * 4 >= _imp->frameEvaluations + _imp->subFrameEvaluations) ? NATRON_CURVE_SAMPLE_TABLE_SUBFRAMES : 1;
+    double nFrames = lastTime - firstTime + 1.;
+    while ( (samplesPerFrame > 1) && (nFrames * samplesPerFrame > NATRON_CURVE_SAMPLE_TABLE_MAX_SAMPLES) ) {
+        samplesPerFrame /= 2;
+    }
+    if ( !(nFrames * samplesPerFrame <= NATRON_CURVE_SAMPLE_TABLE_MAX_SAMPLES) ) {
+        _imp->sampleTableTooLarge = true;
+
+        return;
+    }
+
+    std::shared_ptr<CurveSampleTable> table = std::make_shared<CurveSampleTable>();
+    table->firstTime = firstTime;
+    table->samplesPerFrame = samplesPerFrame;
+    table->mustClamp = mustClamp();
+    table->yMin = _imp->yMin;
+    table->yMax = _imp->yMax;
+    std::size_t nSamples = (std::size_t)(nFrames * samplesPerFrame);
+    table->values.resize(nSamples);
+    for (std::size_t i = 0; i < nSamples; ++i) {
+        table->values[i] = interpolateValueAt(firstTime + (double)i / samplesPerFrame);
+    }
+    std::atomic_store( &_imp->sampleTable, CurveSampleTableConstPtr(table) );
+} // onValueEvaluated
+
 void
 Curve::setKeyframesInternal(const KeyFrameSet& keys, bool refreshDerivatives)
 {
@@ -257,6 +257,13 @@ public:
 
     KeyFrameSet getKeyFrames_mt_safe() const WARN_UNUSED_RETURN;
 
+    /**
+     * @brief Returns the keyframes from the given index to the last one. Unlike getKeyFrames_mt_safe() this does not
+     * copy the whole curve, and the first keyframe is looked up from the end of the curve when it is closer:
+     * this is used while painting to fetch the few points appended to a long stroke.
+     **/
+    KeyFrameSet getKeyFramesFromIndex_mt_safe(int firstIndex) const WARN_UNUSED_RETURN;
+
     void clearKeyFrames();
 
     /**
@@ -352,6 +359,19 @@ public:
 
     void setKeyframes(const KeyFrameSet& keys, bool refreshDerivatives);
 
+    /**
+     * @brief Curves which are evaluated many times at frames or sub-frames (e.g. by render threads) are sampled
+     * over their keyframes range, and these samples are then returned by getValueAt() without locking the curve.
+     * The samples are invalidated whenever the curve changes. This is enabled by default.
+     **/
+    static void setSampleTablesEnabled(bool enabled);
+    static bool isSampleTablesEnabled();
+
+    /**
+     * @brief Returns true if the curve is currently sampled, see setSampleTablesEnabled()
+     **/
+    bool hasSampleTable() const;
+
 private:
     friend class ::boost::serialization::access;
     template<class Archive>
@@ -368,6 +388,19 @@ private:
 
     double clampValueToCurveYRange(double v) const WARN_UNUSED_RETURN;
 
+    ///Interpolates the keyframes at the given time, without clamping nor rounding
+    double interpolateValueAt(double t) const WARN_UNUSED_RETURN;
+
+    double roundValueToCurveType(double v) const WARN_UNUSED_RETURN;
+
+    ///Lock-free: returns true if t is a sample time of the sample table
+    bool getValueFromSampleTable(double t, bool doClamp, double* ret) const;
+
+    ///Counts evaluations and samples the curve when it is evaluated often enough
+    void onValueEvaluated(double t) const;
+
+    void invalidateSampleTable();
+
     void setKeyframesInternal(const KeyFrameSet& keys, bool refreshDerivatives);
 
     ///returns an iterator to the new keyframe in the keyframe set and
@@ -28,6 +28,9 @@
 
 #include "Global/Macros.h"
 
+#include <memory>
+#include <vector>
+
 #include <QtCore/QMutex>
 #if QT_VERSION >= QT_VERSION_CHECK(5, 14, 0)
 #include <QtCore/QRecursiveMutex>
@@ -43,6 +46,21 @@
 
 NATRON_NAMESPACE_ENTER
 
+/**
+ * @brief Values of a curve sampled at regular times over its keyframes range, before clamping.
+ * The table is immutable once published, so that render threads may read it without locking the curve.
+ **/
+struct CurveSampleTable
+{
+    double firstTime;
+    int samplesPerFrame; //< a power of 2, so that the sample times are exact
+    bool mustClamp;
+    double yMin, yMax; //< the Y range of curves which are not owned by a knob
+    std::vector<double> values;
+};
+
+typedef std::shared_ptr<const CurveSampleTable> CurveSampleTableConstPtr;
+
 struct CurvePrivate
 {
     enum CurveTypeEnum
@@ -74,6 +92,16 @@ struct CurvePrivate
     bool isParametric;
     bool isPeriodic;
 
+    ///Only accessed with std::atomic_load/std::atomic_store, NULL until the curve is evaluated often enough
+    CurveSampleTableConstPtr sampleTable;
+
+    ///Evaluations at frames and sub-frames since the curve last changed, protected by _lock
+    int frameEvaluations;
+    int subFrameEvaluations;
+
+    ///True if the keyframes range is too large to be sampled, protected by _lock
+    bool sampleTableTooLarge;
+
     CurvePrivate()
         : keyFrames()
 #ifdef NATRON_CURVE_USE_CACHE
@@ -93,6 +121,10 @@ struct CurvePrivate
 #endif
         , isParametric(false)
         , isPeriodic(false)
+        , sampleTable()
+        , frameEvaluations(0)
+        , subFrameEvaluations(0)
+        , sampleTableTooLarge(false)
     {
     }
 
@@ -118,6 +150,11 @@ struct CurvePrivate
         yMin = other.yMin;
         yMax = other.yMax;
         isPeriodic = other.isPeriodic;
+        // the samples of the other curve are not copied, they are recomputed if needed
+        std::atomic_store( &sampleTable, CurveSampleTableConstPtr() );
+        frameEvaluations = 0;
+        subFrameEvaluations = 0;
+        sampleTableTooLarge = false;
     }
 
     
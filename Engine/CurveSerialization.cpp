@@ -28,6 +28,15 @@
 #include <cassert>
 #include <stdexcept>
 
+GCC_DIAG_UNUSED_LOCAL_TYPEDEFS_OFF
+// clang-format off
+GCC_DIAG_OFF(unused-parameter)
+#include <boost/archive/binary_iarchive.hpp>
+#include <boost/archive/binary_oarchive.hpp>
+GCC_DIAG_UNUSED_LOCAL_TYPEDEFS_ON
+GCC_DIAG_ON(unused-parameter)
+// clang-format on
+
 // explicit template instantiations
 
 NATRON_NAMESPACE_ENTER
@@ -36,4 +45,8 @@ template void Curve::serialize<boost::archive::xml_iarchive>(boost::archive::xml
                                                              const unsigned int file_version);
 template void Curve::serialize<boost::archive::xml_oarchive>(boost::archive::xml_oarchive & ar,
                                                              const unsigned int file_version);
+template void Curve::serialize<boost::archive::binary_iarchive>(boost::archive::binary_iarchive & ar,
+                                                                const unsigned int file_version);
+template void Curve::serialize<boost::archive::binary_oarchive>(boost::archive::binary_oarchive & ar,
+                                                                const unsigned int file_version);
 NATRON_NAMESPACE_EXIT
@@ -318,6 +318,12 @@ EffectInstance::setParallelRenderArgsTLS(double time,
     args->tilesSupported = getNode()->getCurrentSupportTiles();
     args->stats = stats;
     args->openGLContext = glContext;
+    // Record the knob values once for the whole frame so that the render threads do not
+    // have to evaluate curves and expressions under the knobs mutexes for every tile.
+    // The main thread reads the gui values of the knobs, which may differ from the render values.
+    if ( !isAnalysis && ( QThread::currentThread() != qApp->thread() ) ) {
+        args->knobValues = std::make_shared<KnobValuesSnapshot>( time, view, getKnobs() );
+    }
     argsList.push_back(args);
 }
 
@@ -511,6 +517,27 @@ EffectInstance::aborted() const
                                    treeRoot);
 } // EffectInstance::aborted
 
+bool
+EffectInstance::isCurrentThreadRenderAborted()
+{
+    AbortableThread* isAbortableThread = dynamic_cast<AbortableThread*>( QThread::currentThread() );
+
+    if (!isAbortableThread) {
+        return false;
+    }
+
+    bool isRenderUserInteraction;
+    AbortableRenderInfoPtr abortInfo;
+    EffectInstancePtr treeRoot;
+    if ( !isAbortableThread->getAbortInfo(&isRenderUserInteraction, &abortInfo, &treeRoot) ) {
+        return false;
+    }
+
+    return Implementation::aborted(isRenderUserInteraction,
+                                   abortInfo,
+                                   treeRoot);
+}
+
 bool
 EffectInstance::shouldCacheOutput(bool isFrameVaryingOrAnimated,
                                   double time,
@@ -2234,6 +2261,11 @@ EffectInstance::Implementation::tiledRenderingFunctor(const RectToRender & rectT
         return eRenderingFunctorRetOK;
     }
 
+    ///Abort checkpoint: do not start rendering a new tile if the render was aborted in the meantime
+    if ( _publicInterface->aborted() ) {
+        return eRenderingFunctorRetAborted;
+    }
+
 
     ///This RAII struct controls the lifetime of the validArgs Flag in tls->currentRenderArgs
     Implementation::ScopedRenderArgs scopedArgs(tls,
@@ -2891,6 +2923,10 @@ EffectInstance::Implementation::renderHandler(const EffectTLSDataPtr& tls,
         }
     } // for (std::map<ImagePlaneDesc,PlaneToRender>::const_iterator it = outputPlanes.begin(); it != outputPlanes.end(); ++it) {
 
+    ///The conversions and downscaling above stop early if the render was aborted: do not mark the rectangle as rendered
+    if ( _publicInterface->aborted() ) {
+        return eRenderingFunctorRetAborted;
+    }
 
     return eRenderingFunctorRetOK;
 } // tiledRenderingFunctor
@@ -5174,6 +5210,27 @@ EffectInstance::getCurrentTime() const
     return app->getTimeLine()->currentFrame();
 }
 
+const KnobValuesSnapshot*
+EffectInstance::getKnobValuesSnapshotTLS(double* currentTime,
+                                         ViewIdx* currentView) const
+{
+    EffectTLSDataPtr tls = _imp->tlsData->getTLSData();
+
+    if ( !tls || tls->frameArgs.empty() ) {
+        return 0;
+    }
+    const ParallelRenderArgsPtr& args = tls->frameArgs.back();
+    if (!args->knobValues) {
+        return 0;
+    }
+    // Same as getCurrentTime() and getCurrentView()
+    *currentTime = tls->currentRenderArgs.validArgs ? tls->currentRenderArgs.time : args->time;
+    *currentView = tls->currentRenderArgs.validArgs ? tls->currentRenderArgs.view : args->view;
+
+    // The snapshot is owned by the TLS of the current thread, which outlives the caller
+    return args->knobValues.get();
+}
+
 ViewIdx
 EffectInstance::getCurrentView() const
 {
@@ -856,6 +856,7 @@ public:
     virtual void abortAnyEvaluation(bool keepOldestRender = true) OVERRIDE FINAL;
     virtual double getCurrentTime() const OVERRIDE WARN_UNUSED_RETURN;
     virtual ViewIdx getCurrentView() const OVERRIDE WARN_UNUSED_RETURN;
+    virtual const KnobValuesSnapshot* getKnobValuesSnapshotTLS(double* currentTime, ViewIdx* currentView) const OVERRIDE FINAL WARN_UNUSED_RETURN;
     virtual bool getCanTransform() const
     {
         return false;
@@ -1050,6 +1051,13 @@ public:
        in the engine function.*/
     bool aborted() const WARN_UNUSED_RETURN;
 
+    /**
+     * @brief Same as aborted() but only relies on the abort info set on the calling thread, so that host code
+     * that does not know which effect is rendering (multi-thread suite, roto rasterization...) can use it as an abort checkpoint.
+     * Returns false if the calling thread is not running an abortable render.
+     **/
+    static bool isCurrentThreadRenderAborted() WARN_UNUSED_RETURN;
+
 
     /** @brief Returns the image computed by the input 'inputNb' at the given time and scale for the given view.
      * @param dontUpscale If the image is retrieved is downscaled but the plug-in doesn't support the user of
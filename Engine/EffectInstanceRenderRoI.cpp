@@ -606,9 +606,23 @@ EffectInstance::renderRoI(const RenderRoIArgs & args,
             getFrameRange_public(nodeHash, &firstFrame, &lastFrame);
 
             EffectInstancePtr inputEffectIdentity = getInput(inputNbIdentity);
+
+            // If the request pass collapsed a chain of pass-through nodes upstream, render directly from the end of the chain
+            int nbPassThroughNodesElided = 0;
+            if ( requestPassData && requestPassData->globalData.passThroughTarget && (requestPassData->globalData.identityInputNb == inputNbIdentity) ) {
+                inputEffectIdentity = requestPassData->globalData.passThroughTarget;
+                inputTimeIdentity = requestPassData->globalData.passThroughTargetTime;
+                inputIdentityView = requestPassData->globalData.passThroughTargetView;
+                nbPassThroughNodesElided = requestPassData->globalData.nbPassThroughNodesElided;
+            }
+
             if (inputEffectIdentity) {
                 if ( frameArgs->stats && frameArgs->stats->isInDepthProfilingEnabled() ) {
-                    frameArgs->stats->setNodeIdentity( getNode(), inputEffectIdentity->getNode() );
+                    if (nbPassThroughNodesElided > 0) {
+                        frameArgs->stats->setNodePassThroughCollapsed( getNode(), inputEffectIdentity->getNode(), nbPassThroughNodesElided );
+                    } else {
+                        frameArgs->stats->setNodeIdentity( getNode(), inputEffectIdentity->getNode() );
+                    }
                 }
 
 
@@ -1819,6 +1833,11 @@ EffectInstance::renderRoI(const RenderRoIArgs & args,
 
     assert( !outputPlanes->empty() );
 
+    ///The downscaled and converted planes may be incomplete if the render was aborted while computing them
+    if ( aborted() ) {
+        return eRenderRoIRetCodeAborted;
+    }
+
     return eRenderRoIRetCodeOk;
 } // renderRoI
 
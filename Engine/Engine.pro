@@ -115,6 +115,7 @@ SOURCES += \
     Interpolation.cpp \
     JoinViewsNode.cpp \
     Knob.cpp \
+    KnobExpression.cpp \
     KnobFactory.cpp \
     KnobFile.cpp \
     KnobSerialization.cpp \
@@ -181,6 +182,10 @@ SOURCES += \
     RotoLayer.cpp \
     RotoPaint.cpp \
     RotoPaintInteract.cpp \
+    RotoRenderBands.cpp \
+    RotoShapeRasterizer.cpp \
+    RotoSpatialIndex.cpp \
+    RotoStrokeStamper.cpp \
     RotoSmear.cpp \
     RotoStrokeItem.cpp \
     RotoUndoCommand.cpp \
@@ -278,6 +283,7 @@ HEADERS += \
     JoinViewsNode.h \
     KeyHelper.h \
     Knob.h \
+    KnobExpression.h \
     KnobFactory.h \
     KnobFile.h \
     KnobGuiI.h \
@@ -357,7 +363,11 @@ HEADERS += \
     RotoLayerSerialization.h \
     RotoPaint.h \
     RotoPaintInteract.h \
+    RotoRenderBands.h \
     RotoPoint.h \
+    RotoShapeRasterizer.h \
+    RotoSpatialIndex.h \
+    RotoStrokeStamper.h \
     RotoSmear.h \
     RotoStrokeItem.h \
     RotoStrokeItemSerialization.h \
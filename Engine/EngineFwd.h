@@ -39,6 +39,8 @@ namespace boost {
 namespace archive {
 class xml_iarchive;
 class xml_oarchive;
+class binary_iarchive;
+class binary_oarchive;
 }
 namespace serialization {
 class access;
@@ -190,9 +192,11 @@ class KnobSignalSlotHandler;
 class KnobString;
 class KnobTLSData;
 class KnobTable;
+class KnobValuesSnapshot;
 class LibraryBinary;
 class LogEntry;
 class MemoryFile;
+class NativeKnobExpression;
 class Node;
 class NodeCollection;
 class NodeFrameRequest;
@@ -379,7 +383,9 @@ typedef std::shared_ptr<KnobSignalSlotHandler> KnobSignalSlotHandlerPtr;
 typedef std::shared_ptr<KnobString> KnobStringPtr;
 typedef std::shared_ptr<KnobTLSData> KnobTLSDataPtr;
 typedef std::shared_ptr<KnobTable> KnobTablePtr;
+typedef std::shared_ptr<const KnobValuesSnapshot> KnobValuesSnapshotConstPtr;
 typedef std::shared_ptr<MemoryFile> MemoryFilePtr;
+typedef std::shared_ptr<NativeKnobExpression> NativeKnobExpressionPtr;
 typedef std::shared_ptr<Node> NodePtr;
 typedef std::shared_ptr<NodeCollection> NodeCollectionPtr;
 typedef std::shared_ptr<NodeFrameRequest> NodeFrameRequestPtr;
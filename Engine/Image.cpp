@@ -33,6 +33,7 @@
 #include <QtCore/QDebug>
 
 #include "Engine/AppManager.h"
+#include "Engine/EffectInstance.h"
 #include "Engine/ViewIdx.h"
 #include "Engine/GPUContextPool.h"
 #include "Engine/OSGLContext.h"
@@ -1784,6 +1785,15 @@ Image::getRowElements() const
     return getComponentsCount() * _bounds.width();
 }
 
+// Number of rows processed between two abort checkpoints
+#define NATRON_IMAGE_ABORT_CHECK_ROWS 16
+
+bool
+Image::isRenderAbortedAtRow(int rowIndex)
+{
+    return (rowIndex % NATRON_IMAGE_ABORT_CHECK_ROWS == 0) && EffectInstance::isCurrentThreadRenderAborted();
+}
+
 // code proofread and fixed by @devernay on 4/12/2014
 template <typename PIX, int maxValue>
 void
@@ -1853,6 +1863,9 @@ Image::halveRoIForDepth(const RectI & roi,
     char* const dstBmData       = dstBmPixels - (dstBmBounds.x1 + dstBmRowSize * dstBmBounds.y1);
 
     for (int y = dstRoI.y1; y < dstRoI.y2; ++y) {
+        if ( isRenderAbortedAtRow(y - dstRoI.y1) ) {
+            return;
+        }
         const PIX* const srcLineStart    = srcData + y * 2 * srcRowSize;
         PIX* const dstLineStart          = dstData + y     * dstRowSize;
         const char* const srcBmLineStart = srcBmData + y * 2 * srcBmRowSize;
@@ -2208,6 +2221,9 @@ Image::upscaleMipmapForDepth(const RectI & roi,
     int yi = srcRoi.y1;
     int ycount; // how many lines should be filled
     for (int yo = dstRoi.y1; yo < dstRoi.y2; ++yi, src += srcRowSize, yo += ycount, dst += ycount * dstRowSize) {
+        if ( isRenderAbortedAtRow(yi - srcRoi.y1) ) {
+            return;
+        }
         const PIX * const srcLineStart = src;
         PIX * const dstLineBatchStart = dst;
         ycount = scale - (yo - yi * scale); // how many lines should be filled
@@ -1019,6 +1019,13 @@ private:
 
     bool checkForNaNsNoLock(const RectI& roi) const WARN_UNUSED_RETURN;
 
+    /**
+     * @brief Abort checkpoint of the row loops of the conversion and mipmapping functions: every few rows, returns true
+     * if the render of the calling thread was aborted. The output is then left incomplete and the caller must not
+     * report it as rendered.
+     **/
+    static bool isRenderAbortedAtRow(int rowIndex) WARN_UNUSED_RETURN;
+
 private:
     ImageBitDepthEnum _bitDepth;
     int _depthBytesSize;
@@ -161,6 +161,9 @@ Image::convertToFormatInternal_sameComps(const RectI & renderWindow,
         return;
     }
     for (int y = 0; y < intersection.height(); ++y) {
+        if ( isRenderAbortedAtRow(y) ) {
+            return;
+        }
         // coverity[dont_call]
         int start = rand() % intersection.width();
         const SRCPIX* srcPixels = (const SRCPIX*)srcImg.pixelAt(intersection.x1 + start, intersection.y1 + y);
@@ -307,6 +310,9 @@ Image::convertToFormatInternalForColorSpace(const RectI & renderWindow,
     bool dstLutOp = useColorspaces && dstLut != nullptr;
 
     for (int y = 0; y < renderWindow.height(); ++y) {
+        if ( isRenderAbortedAtRow(y) ) {
+            return;
+        }
         ///Start of the line for error diffusion
         // coverity[dont_call]
         int start = rand() % renderWindow.width();
@@ -28,6 +28,7 @@
 
 #include <algorithm> // min, max
 #include <cassert>
+#include <cmath>
 #include <stdexcept>
 #include <sstream> // stringstream
 #include <cctype> // isspace
@@ -47,6 +48,7 @@
 #include "Engine/DockablePanelI.h"
 #include "Engine/Hash64.h"
 #include "Engine/KnobFile.h"
+#include "Engine/KnobExpression.h"
 #include "Engine/KnobGuiI.h"
 #include "Engine/KnobSerialization.h"
 #include "Engine/KnobTypes.h"
@@ -370,10 +372,15 @@ struct Expr
     ///The list of pair<knob, dimension> dpendencies for an expression
     std::list<std::pair<KnobIWPtr, int> > dependencies;
 
-    //PyObject* code;
+    ///The Python function defined for the expression by validateExpression, called directly
+    ///instead of interpreting a script for each evaluation (new ref)
+    PyObject* function;
+
+    ///Set if the expression can be evaluated without Python
+    NativeKnobExpressionPtr native;
 
     Expr()
-        : expression(), originalExpression(), exprInvalid(), hasRet(false) /*, code(0)*/ {}
+        : expression(), originalExpression(), exprInvalid(), hasRet(false), function(0), native() {}
 };
 
 struct KnobHelperPrivate
@@ -579,6 +586,16 @@ KnobHelper::KnobHelper(KnobHolder* holder,
 
 KnobHelper::~KnobHelper()
 {
+    if ( !Py_IsInitialized() ) {
+        return;
+    }
+    for (std::size_t i = 0; i < _imp->expressions.size(); ++i) {
+        if (_imp->expressions[i].function) {
+            PythonGILLocker pgl;
+            Py_DECREF(_imp->expressions[i].function);
+            _imp->expressions[i].function = 0;
+        }
+    }
 }
 
 void
@@ -2855,6 +2872,12 @@ KnobHelper::setExpressionInternal(int dimension,
         }
     }
 
+    PyObject* function = 0;
+    NativeKnobExpressionPtr native;
+    if ( exprInvalid.empty() ) {
+        compileExpression(expression, exprCpy, dimension, hasRetVariable, &function, &native);
+    }
+
     //Set internal fields
 
     {
@@ -2863,9 +2886,8 @@ KnobHelper::setExpressionInternal(int dimension,
         _imp->expressions[dimension].expression = exprCpy;
         _imp->expressions[dimension].originalExpression = expression;
         _imp->expressions[dimension].exprInvalid = exprInvalid;
-
-        ///This may throw an exception upon failure
-        //NATRON_PYTHON_NAMESPACE::compilePyScript(exprCpy, &_imp->expressions[dimension].code);
+        _imp->expressions[dimension].function = function;
+        _imp->expressions[dimension].native = native;
     }
 
     if ( getHolder() ) {
@@ -2887,6 +2909,95 @@ KnobHelper::setExpressionInternal(int dimension,
     expressionChanged(dimension);
 } // KnobHelper::setExpressionInternal
 
+void
+KnobHelper::compileExpression(const std::string& expression,
+                              const std::string& funcExecScript,
+                              int dimension,
+                              bool hasRetVariable,
+                              PyObject** function,
+                              NativeKnobExpressionPtr* native)
+{
+    // funcExecScript is "ret = <fully qualified name of the expression function>"
+    std::size_t foundEqual = funcExecScript.find('=');
+    if (foundEqual != std::string::npos) {
+        std::string funcName = funcExecScript.substr(foundEqual + 1);
+        std::size_t firstChar = funcName.find_first_not_of(' ');
+        if (firstChar != std::string::npos) {
+            funcName.erase(0, firstChar);
+        }
+        bool isDefined = false;
+        PyObject* obj = NATRON_PYTHON_NAMESPACE::getAttrRecursive(funcName, NATRON_PYTHON_NAMESPACE::getMainModule(), &isDefined);
+        if (isDefined && obj) {
+            if ( PyCallable_Check(obj) ) {
+                *function = obj;
+            } else {
+                Py_DECREF(obj);
+            }
+        }
+    }
+
+    // Only single-line expressions of numeric parameters may be evaluated natively
+    if ( hasRetVariable || !*function || !isTypePOD() || dynamic_cast<KnobStringBase*>(this) ) {
+        return;
+    }
+    NativeKnobExpressionPtr compiled = NativeKnobExpression::compile(expression, shared_from_this(), dimension);
+    if (!compiled) {
+        return;
+    }
+
+    // Make sure the native evaluator agrees with Python before using it
+    double time = getCurrentTime();
+    ViewIdx view = getCurrentView();
+    double nativeValue;
+    PyObject* pyRet;
+    {
+        EXPR_RECURSION_LEVEL();
+        if ( !compiled->evaluate(time, view, &nativeValue) ) {
+            return;
+        }
+        pyRet = PyObject_CallFunction(*function, (char*)"di", time, (int)view);
+    }
+    if (!pyRet) {
+        PyErr_Clear();
+
+        return;
+    }
+    double pyValue = PyFloat_AsDouble(pyRet);
+    Py_DECREF(pyRet);
+    if ( PyErr_Occurred() ) {
+        PyErr_Clear();
+
+        return;
+    }
+    if ( std::abs(nativeValue - pyValue) > 1e-9 * std::max( 1., std::abs(pyValue) ) ) {
+#ifdef DEBUG
+        qDebug() << getName().c_str() << ": the expression" << expression.c_str() << "is evaluated to" << nativeValue << "natively instead of" << pyValue;
+#endif
+
+        return;
+    }
+    *native = compiled;
+} // KnobHelper::compileExpression
+
+bool
+KnobHelper::evaluateNativeExpression(double time,
+                                     ViewIdx view,
+                                     int dimension,
+                                     double* ret) const
+{
+    NativeKnobExpressionPtr native;
+    {
+        QMutexLocker k(&_imp->expressionMutex);
+        native = _imp->expressions[dimension].native;
+    }
+    if ( !native || !native->evaluate(time, view, ret) ) {
+        return false;
+    }
+    NativeKnobExpression::recordEvaluation(NativeKnobExpression::eEvaluationPathNative);
+
+    return true;
+}
+
 void
 KnobHelper::replaceNodeNameInExpression(int dimension,
                                         const std::string& oldName,
@@ -2955,8 +3066,9 @@ KnobHelper::clearExpression(int dimension,
         _imp->expressions[dimension].expression.clear();
         _imp->expressions[dimension].originalExpression.clear();
         _imp->expressions[dimension].exprInvalid.clear();
-        //Py_XDECREF(_imp->expressions[dimension].code); //< new ref
-        //_imp->expressions[dimension].code = 0;
+        Py_XDECREF(_imp->expressions[dimension].function); //< new ref
+        _imp->expressions[dimension].function = 0;
+        _imp->expressions[dimension].native.reset();
     }
     KnobIPtr thisShared = shared_from_this();
     {
@@ -3076,10 +3188,32 @@ KnobHelper::executeExpression(double time,
                               std::string* error) const
 {
     std::string expr;
+    PyObject* function;
     {
         QMutexLocker k(&_imp->expressionMutex);
         expr = _imp->expressions[dimension].expression;
+        function = _imp->expressions[dimension].function;
+        Py_XINCREF(function);
+    }
+
+    if (function) {
+        // Call the function compiled when the expression was set rather than interpreting a new script
+        NativeKnobExpression::recordEvaluation(NativeKnobExpression::eEvaluationPathCompiled);
+        PyErr_Clear();
+        *ret = PyObject_CallFunction(function, (char*)"di", time, (int)view);
+        Py_DECREF(function);
+        if (!*ret) {
+            if ( catchErrors(NATRON_PYTHON_NAMESPACE::getMainModule(), error) ) {
+                *error = "The expression did not return a value";
+            }
+
+            return false;
+        }
+
+        return true;
     }
+
+    NativeKnobExpression::recordEvaluation(NativeKnobExpression::eEvaluationPathInterpreted);
     std::stringstream ss;
 
     ss << expr << '(' << time << ", " <<  view << ")\n";
@@ -1631,6 +1631,21 @@ protected:
     /// The Python GIL must be held before calling this, so the the PyObject remains valid.
     bool executeExpression(double time, ViewIdx view, int dimension, PyObject** ret, std::string* error) const;
 
+    /**
+     * @brief Evaluates the expression without Python if it was compiled by NativeKnobExpression.
+     * The GIL is not needed. Returns false if Python must evaluate the expression.
+     **/
+    bool evaluateNativeExpression(double time, ViewIdx view, int dimension, double* ret) const;
+
+private:
+
+    /**
+     * @brief Fetches the Python function defined by validateExpression and compiles the expression natively
+     * if possible. The Python GIL must be held.
+     **/
+    void compileExpression(const std::string& expression, const std::string& funcExecScript, int dimension, bool hasRetVariable,
+                           PyObject** function, NativeKnobExpressionPtr* native);
+
 public:
 
     /// The return value must be Py_DECRREF
@@ -2109,6 +2124,12 @@ public:
 
     bool getValueFromCurve(double time, ViewSpec view, int dimension, bool useGuiCurve, bool byPassMaster, bool clamp, T* ret);
 
+    /*
+     * @brief Lock-free read of the value recorded by the render thread snapshot of the holder.
+     * If time is NULL, the current time of the holder is used.
+     */
+    bool getValueFromRenderSnapshot(const double* time, ViewSpec view, int dimension, bool clamp, T* ret) const;
+
 protected:
 
     virtual void resetExtraToDefaultValue(int /*dimension*/) {}
@@ -2699,6 +2720,17 @@ public:
         return ViewIdx(0);
     }
 
+    /**
+     * @brief Returns the knob values recorded for the frame being rendered by the current thread, or NULL.
+     * If a snapshot is returned, currentTime and currentView are set to the values getCurrentTime()
+     * and getCurrentView() would return.
+     **/
+    virtual const KnobValuesSnapshot* getKnobValuesSnapshotTLS(double* /*currentTime*/,
+                                                               ViewIdx* /*currentView*/) const
+    {
+        return 0;
+    }
+
     int getPageIndex(const KnobPage* page) const;
 
 
@@ -0,0 +1,958 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <https://natrongithub.github.io/>,
+ * (C) 2018-2023 The Natron developers
+ * (C) 2013-2018 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "KnobExpression.h"
+
+#include <algorithm> // min, max
+#include <cassert>
+#include <cctype> // isdigit, isalpha
+#include <cmath>
+#include <limits>
+#include <locale>
+#include <sstream>
+
+#include <QtCore/QAtomicInt>
+#include <QtCore/QThreadStorage>
+
+#include "Engine/EffectInstance.h"
+#include "Engine/Knob.h"
+#include "Engine/KnobTypes.h"
+#include "Engine/Node.h"
+#include "Engine/NodeGroup.h"
+
+// Expressions needing a deeper evaluation stack are left to Python
+#define NATRON_NATIVE_EXPRESSION_MAX_STACK_DEPTH 32
+
+// Expressions reading parameters that are themselves driven by expressions nest evaluations,
+// chains deeper than this are left to Python
+#define NATRON_NATIVE_EXPRESSION_MAX_RECURSION_DEPTH 64
+
+NATRON_NAMESPACE_ENTER
+
+static QAtomicInt nativeEvaluationsCount;
+static QAtomicInt compiledEvaluationsCount;
+static QAtomicInt interpretedEvaluationsCount;
+
+///Number of native evaluations nested on the current thread
+static QThreadStorage<int> nativeEvaluationDepth;
+
+typedef double (*UnaryFunction)(double);
+typedef double (*BinaryFunction)(double, double);
+
+enum NativeOpcodeEnum
+{
+    eNativeOpConstant = 0,
+    eNativeOpFrame,
+    eNativeOpView,
+    eNativeOpAdd,
+    eNativeOpSubtract,
+    eNativeOpMultiply,
+    eNativeOpDivide,
+    eNativeOpFloorDivide,
+    eNativeOpModulo,
+    eNativeOpPower,
+    eNativeOpNegate,
+    eNativeOpUnaryFunction,
+    eNativeOpBinaryFunction,
+    eNativeOpMin,
+    eNativeOpMax,
+    eNativeOpKnobValue,
+    eNativeOpKnobValueAtTime,
+    eNativeOpKnobCurve
+};
+
+struct NativeKnobExpression::Instruction
+{
+    NativeOpcodeEnum op;
+    double constant;
+    UnaryFunction unaryFunction;
+    BinaryFunction binaryFunction;
+
+    ///Number of arguments of min and max
+    int nArgs;
+
+    ///The parameter read by the knob opcodes: the weak pointer keeps track of its lifetime,
+    ///only one of the typed pointers is set
+    KnobIWPtr knob;
+    KnobIntBase* intKnob;
+    KnobDoubleBase* doubleKnob;
+    KnobBoolBase* boolKnob;
+    int dimension;
+
+    explicit Instruction(NativeOpcodeEnum op_)
+        : op(op_)
+        , constant(0.)
+        , unaryFunction(0)
+        , binaryFunction(0)
+        , nArgs(0)
+        , knob()
+        , intKnob(0)
+        , doubleKnob(0)
+        , boolKnob(0)
+        , dimension(0)
+    {
+    }
+};
+
+NATRON_NAMESPACE_ANONYMOUS_ENTER
+
+// The math module functions and the builtins understood by the native evaluator.
+// Domain errors yield NaN or infinity, which makes the evaluation fall back to Python so that
+// the error is reported the same way as before.
+double nativeSin(double x) { return std::sin(x); }
+double nativeCos(double x) { return std::cos(x); }
+double nativeTan(double x) { return std::tan(x); }
+double nativeAsin(double x) { return std::asin(x); }
+double nativeAcos(double x) { return std::acos(x); }
+double nativeAtan(double x) { return std::atan(x); }
+double nativeSinh(double x) { return std::sinh(x); }
+double nativeCosh(double x) { return std::cosh(x); }
+double nativeTanh(double x) { return std::tanh(x); }
+double nativeExp(double x) { return std::exp(x); }
+double nativeLog(double x) { return std::log(x); }
+double nativeLog10(double x) { return std::log10(x); }
+double nativeSqrt(double x) { return std::sqrt(x); }
+double nativeFabs(double x) { return std::fabs(x); }
+double nativeFloor(double x) { return std::floor(x); }
+double nativeCeil(double x) { return std::ceil(x); }
+double nativeTrunc(double x) { return x < 0. ? std::ceil(x) : std::floor(x); }
+double nativeDegrees(double x) { return x * 180. / M_PI; }
+double nativeRadians(double x) { return x * M_PI / 180.; }
+double nativeAtan2(double y, double x) { return std::atan2(y, x); }
+double nativePow(double x, double y) { return std::pow(x, y); }
+double nativeFmod(double x, double y) { return y == 0. ? std::numeric_limits<double>::quiet_NaN() : std::fmod(x, y); }
+double nativeHypot(double x, double y) { return std::sqrt(x * x + y * y); }
+double nativeLogBase(double x, double base) { return std::log(x) / std::log(base); }
+
+struct UnaryFunctionEntry
+{
+    const char* name;
+    UnaryFunction func;
+};
+
+struct BinaryFunctionEntry
+{
+    const char* name;
+    BinaryFunction func;
+};
+
+const UnaryFunctionEntry unaryFunctions[] = {
+    { "sin", nativeSin },
+    { "cos", nativeCos },
+    { "tan", nativeTan },
+    { "asin", nativeAsin },
+    { "acos", nativeAcos },
+    { "atan", nativeAtan },
+    { "sinh", nativeSinh },
+    { "cosh", nativeCosh },
+    { "tanh", nativeTanh },
+    { "exp", nativeExp },
+    { "log", nativeLog },
+    { "log10", nativeLog10 },
+    { "sqrt", nativeSqrt },
+    { "fabs", nativeFabs },
+    { "abs", nativeFabs },
+    { "floor", nativeFloor },
+    { "ceil", nativeCeil },
+    { "trunc", nativeTrunc },
+    { "degrees", nativeDegrees },
+    { "radians", nativeRadians },
+    { 0, 0 }
+};
+
+const BinaryFunctionEntry binaryFunctions[] = {
+    { "atan2", nativeAtan2 },
+    { "pow", nativePow },
+    { "fmod", nativeFmod },
+    { "hypot", nativeHypot },
+    { "log", nativeLogBase },
+    { 0, 0 }
+};
+
+UnaryFunction
+findUnaryFunction(const std::string& name)
+{
+    for (int i = 0; unaryFunctions[i].name; ++i) {
+        if (name == unaryFunctions[i].name) {
+            return unaryFunctions[i].func;
+        }
+    }
+
+    return 0;
+}
+
+BinaryFunction
+findBinaryFunction(const std::string& name)
+{
+    for (int i = 0; binaryFunctions[i].name; ++i) {
+        if (name == binaryFunctions[i].name) {
+            return binaryFunctions[i].func;
+        }
+    }
+
+    return 0;
+}
+
+bool
+isMathName(const std::string& name)
+{
+    return findUnaryFunction(name) || findBinaryFunction(name) || name == "min" || name == "max";
+}
+
+/**
+ * @brief Recursive descent parser of the Python subset understood by NativeKnobExpression.
+ * Every parse function returns false as soon as something is not supported.
+ **/
+class NativeExpressionParser
+{
+    enum TokenTypeEnum
+    {
+        eTokenEnd = 0,
+        eTokenNumber,
+        eTokenIdentifier,
+        eTokenOperator
+    };
+
+    struct Token
+    {
+        TokenTypeEnum type;
+        std::string text;
+        double number;
+    };
+
+    typedef NativeKnobExpression::Instruction Instruction;
+
+public:
+
+    NativeExpressionParser(const KnobIPtr& knob,
+                           int dimension,
+                           std::vector<Instruction>* program)
+        : _knob(knob)
+        , _dimension(dimension)
+        , _program(program)
+        , _tokens()
+        , _pos(0)
+        , _depth(0)
+    {
+        KnobHolder* holder = knob->getHolder();
+        EffectInstance* effect = dynamic_cast<EffectInstance*>(holder);
+        if (effect) {
+            _node = effect->getNode();
+            if (_node) {
+                _group = _node->getGroup();
+            }
+        }
+    }
+
+    bool parse(const std::string& expression)
+    {
+        if ( !_node || !_group || !tokenize(expression) ) {
+            return false;
+        }
+        if ( !parseSum() ) {
+            return false;
+        }
+
+        return peek().type == eTokenEnd && _depth == 1;
+    }
+
+private:
+
+    bool tokenize(const std::string& expression)
+    {
+        std::size_t i = 0;
+        const std::size_t n = expression.size();
+
+        while (i < n) {
+            char c = expression[i];
+            if ( (c == ' ') || (c == '\t') ) {
+                ++i;
+                continue;
+            }
+            Token t;
+            t.number = 0.;
+            if ( std::isdigit( (unsigned char)c ) || ( (c == '.') && ( i + 1 < n ) && std::isdigit( (unsigned char)expression[i + 1] ) ) ) {
+                std::size_t start = i;
+                while ( i < n && std::isdigit( (unsigned char)expression[i] ) ) {
+                    ++i;
+                }
+                if ( (i < n) && (expression[i] == '.') ) {
+                    ++i;
+                    while ( i < n && std::isdigit( (unsigned char)expression[i] ) ) {
+                        ++i;
+                    }
+                }
+                if ( (i < n) && ( (expression[i] == 'e') || (expression[i] == 'E') ) ) {
+                    ++i;
+                    if ( (i < n) && ( (expression[i] == '+') || (expression[i] == '-') ) ) {
+                        ++i;
+                    }
+                    if ( (i >= n) || !std::isdigit( (unsigned char)expression[i] ) ) {
+                        return false;
+                    }
+                    while ( i < n && std::isdigit( (unsigned char)expression[i] ) ) {
+                        ++i;
+                    }
+                }
+                // Hexadecimal, complex, underscore separated... literals are left to Python
+                if ( (i < n) && ( std::isalnum( (unsigned char)expression[i] ) || (expression[i] == '_') || (expression[i] == '.') ) ) {
+                    return false;
+                }
+                // Do not depend on the current locale to read the decimal separator
+                std::istringstream ss( expression.substr(start, i - start) );
+                ss.imbue( std::locale::classic() );
+                ss >> t.number;
+                if ( ss.fail() ) {
+                    return false;
+                }
+                t.type = eTokenNumber;
+            } else if ( std::isalpha( (unsigned char)c ) || (c == '_') ) {
+                std::size_t start = i;
+                while ( i < n && ( std::isalnum( (unsigned char)expression[i] ) || (expression[i] == '_') ) ) {
+                    ++i;
+                }
+                t.type = eTokenIdentifier;
+                t.text = expression.substr(start, i - start);
+            } else {
+                t.type = eTokenOperator;
+                if ( (i + 1 < n) && ( ( (c == '*') && (expression[i + 1] == '*') ) || ( (c == '/') && (expression[i + 1] == '/') ) ) ) {
+                    t.text = expression.substr(i, 2);
+                    i += 2;
+                } else if ( (c == '+') || (c == '-') || (c == '*') || (c == '/') || (c == '%') ||
+                            (c == '(') || (c == ')') || (c == ',') || (c == '.') ) {
+                    t.text = std::string(1, c);
+                    ++i;
+                } else {
+                    // Comparisons, subscripts, strings... are left to Python
+                    return false;
+                }
+            }
+            _tokens.push_back(t);
+        }
+
+        return true;
+    } // tokenize
+
+    const Token& peek() const
+    {
+        static const Token endToken = { eTokenEnd, std::string(), 0. };
+
+        return _pos < _tokens.size() ? _tokens[_pos] : endToken;
+    }
+
+    bool acceptOperator(const char* op)
+    {
+        const Token& t = peek();
+
+        if ( (t.type == eTokenOperator) && (t.text == op) ) {
+            ++_pos;
+
+            return true;
+        }
+
+        return false;
+    }
+
+    bool acceptIdentifier(std::string* name)
+    {
+        const Token& t = peek();
+
+        if (t.type != eTokenIdentifier) {
+            return false;
+        }
+        *name = t.text;
+        ++_pos;
+
+        return true;
+    }
+
+    /// Appends an instruction and keeps track of the depth of the evaluation stack
+    bool push(const Instruction& instr,
+              int stackDelta)
+    {
+        _program->push_back(instr);
+        _depth += stackDelta;
+        assert(_depth >= 1);
+
+        return _depth <= NATRON_NATIVE_EXPRESSION_MAX_STACK_DEPTH;
+    }
+
+    bool pushConstant(double value)
+    {
+        Instruction instr(eNativeOpConstant);
+
+        instr.constant = value;
+
+        return push(instr, 1);
+    }
+
+    // sum := term (('+'|'-') term)*
+    bool parseSum()
+    {
+        if ( !parseTerm() ) {
+            return false;
+        }
+        for (;;) {
+            NativeOpcodeEnum op;
+            if ( acceptOperator("+") ) {
+                op = eNativeOpAdd;
+            } else if ( acceptOperator("-") ) {
+                op = eNativeOpSubtract;
+            } else {
+                return true;
+            }
+            if ( !parseTerm() || !push(Instruction(op), -1) ) {
+                return false;
+            }
+        }
+    }
+
+    // term := unary (('*'|'/'|'//'|'%') unary)*
+    bool parseTerm()
+    {
+        if ( !parseUnary() ) {
+            return false;
+        }
+        for (;;) {
+            NativeOpcodeEnum op;
+            if ( acceptOperator("*") ) {
+                op = eNativeOpMultiply;
+            } else if ( acceptOperator("//") ) {
+                op = eNativeOpFloorDivide;
+            } else if ( acceptOperator("/") ) {
+#if PY_MAJOR_VERSION < 3
+                // Python 2 divides integers with a floor division, the operand types are not known here
+                return false;
+#endif
+                op = eNativeOpDivide;
+            } else if ( acceptOperator("%") ) {
+                op = eNativeOpModulo;
+            } else {
+                return true;
+            }
+            if ( !parseUnary() || !push(Instruction(op), -1) ) {
+                return false;
+            }
+        }
+    }
+
+    // unary := ('-'|'+') unary | power
+    bool parseUnary()
+    {
+        if ( acceptOperator("-") ) {
+            return parseUnary() && push(Instruction(eNativeOpNegate), 0);
+        } else if ( acceptOperator("+") ) {
+            return parseUnary();
+        }
+
+        return parsePower();
+    }
+
+    // power := primary ['**' unary]
+    bool parsePower()
+    {
+        if ( !parsePrimary() ) {
+            return false;
+        }
+        if ( acceptOperator("**") ) {
+            return parseUnary() && push(Instruction(eNativeOpPower), -1);
+        }
+
+        return true;
+    }
+
+    bool parsePrimary()
+    {
+        const Token& t = peek();
+
+        if (t.type == eTokenNumber) {
+            ++_pos;
+
+            return pushConstant(t.number);
+        }
+        if ( acceptOperator("(") ) {
+            return parseSum() && acceptOperator(")");
+        }
+
+        std::string name;
+        if ( !acceptIdentifier(&name) ) {
+            return false;
+        }
+
+        // These are defined after the nodes of the group in the expression function
+        if (name == "thisParam") {
+            return parseParameterAttribute(_knob);
+        } else if (name == "thisNode") {
+            return parseNodeAttribute(_node);
+        } else if (name == "dimension") {
+            return pushConstant(_dimension);
+        } else if (name == "curve") {
+            return acceptOperator("(") && parseParameterFunction(_knob, name);
+        }
+
+        // A node of the group shadows everything else
+        NodePtr node = _group->getNodeByName(name);
+        if (node) {
+            if ( !node->isActivated() || node->getParentMultiInstance() ) {
+                return false;
+            }
+
+            return parseNodeAttribute(node);
+        }
+
+        if (name == "frame") {
+            return push(Instruction(eNativeOpFrame), 1);
+        } else if (name == "view") {
+            return push(Instruction(eNativeOpView), 1);
+        } else if (name == "pi") {
+            return pushConstant(M_PI);
+        } else if (name == "e") {
+            return pushConstant(M_E);
+        } else if (name == "True") {
+            return pushConstant(1.);
+        } else if (name == "False") {
+            return pushConstant(0.);
+        } else if (name == "math") {
+            if ( !acceptOperator(".") || !acceptIdentifier(&name) || (name == "abs") || (name == "min") || (name == "max") ) {
+                return false;
+            }
+            if (name == "pi") {
+                return pushConstant(M_PI);
+            } else if (name == "e") {
+                return pushConstant(M_E);
+            }
+        }
+        if ( isMathName(name) && acceptOperator("(") ) {
+            return parseMathFunction(name);
+        }
+
+        return false;
+    } // parsePrimary
+
+    /// Parses comma separated arguments up to the closing parenthesis
+    bool parseArguments(int* nArgs)
+    {
+        *nArgs = 0;
+        if ( acceptOperator(")") ) {
+            return true;
+        }
+        do {
+            if ( !parseSum() ) {
+                return false;
+            }
+            ++*nArgs;
+        } while ( acceptOperator(",") );
+
+        return acceptOperator(")");
+    }
+
+    bool parseMathFunction(const std::string& name)
+    {
+        int nArgs;
+
+        if ( !parseArguments(&nArgs) ) {
+            return false;
+        }
+        if ( (name == "min") || (name == "max") ) {
+            // min/max of an iterable are left to Python
+            if (nArgs < 2) {
+                return false;
+            }
+            Instruction instr(name == "min" ? eNativeOpMin : eNativeOpMax);
+            instr.nArgs = nArgs;
+
+            return push(instr, 1 - nArgs);
+        } else if (nArgs == 1) {
+            Instruction instr(eNativeOpUnaryFunction);
+            instr.unaryFunction = findUnaryFunction(name);
+
+            return instr.unaryFunction && push(instr, 0);
+        } else if (nArgs == 2) {
+            Instruction instr(eNativeOpBinaryFunction);
+            instr.binaryFunction = findBinaryFunction(name);
+
+            return instr.binaryFunction && push(instr, -1);
+        }
+
+        return false;
+    }
+
+    // node.param.function(...)
+    bool parseNodeAttribute(const NodePtr& node)
+    {
+        std::string paramName;
+
+        if ( !acceptOperator(".") || !acceptIdentifier(&paramName) ) {
+            return false;
+        }
+        EffectInstancePtr effect = node->getEffectInstance();
+        if (!effect) {
+            return false;
+        }
+        // Children of a group are also attributes of the group node
+        NodeGroup* isGroup = dynamic_cast<NodeGroup*>( effect.get() );
+        if ( isGroup && isGroup->getNodeByName(paramName) ) {
+            return false;
+        }
+        KnobIPtr param = effect->getKnobByName(paramName);
+        if (!param) {
+            return false;
+        }
+
+        return parseParameterAttribute(param);
+    }
+
+    // param.function(...)
+    bool parseParameterAttribute(const KnobIPtr& param)
+    {
+        std::string function;
+
+        if ( !acceptOperator(".") || !acceptIdentifier(&function) || !acceptOperator("(") ) {
+            return false;
+        }
+
+        return parseParameterFunction(param, function);
+    }
+
+    /// The dimension argument must be known at compile time
+    bool parseDimensionArgument(const KnobIPtr& param,
+                                int* dimension)
+    {
+        const Token& t = peek();
+
+        if ( (t.type == eTokenNumber) && ( t.number == std::floor(t.number) ) ) {
+            *dimension = (int)t.number;
+        } else if ( (t.type == eTokenIdentifier) && (t.text == "dimension") ) {
+            *dimension = _dimension;
+        } else {
+            return false;
+        }
+        ++_pos;
+
+        return *dimension >= 0 && *dimension < param->getDimension();
+    }
+
+    /// Called after the opening parenthesis of the function call
+    bool parseParameterFunction(const KnobIPtr& param,
+                                const std::string& function)
+    {
+        Instruction instr(eNativeOpKnobValue);
+
+        instr.knob = param;
+        instr.intKnob = dynamic_cast<KnobIntBase*>( param.get() );
+        instr.doubleKnob = dynamic_cast<KnobDoubleBase*>( param.get() );
+        instr.boolKnob = dynamic_cast<KnobBoolBase*>( param.get() );
+        if ( !instr.intKnob && !instr.doubleKnob && !instr.boolKnob ) {
+            return false;
+        }
+
+        int stackDelta = 1;
+        if (function == "get") {
+            // Only the parameters with a single value return a number, others return a tuple
+            bool getIsScalar = ( ( dynamic_cast<KnobInt*>( param.get() ) || dynamic_cast<KnobDouble*>( param.get() ) ) && param->getDimension() == 1 ) ||
+                               dynamic_cast<KnobBool*>( param.get() ) || dynamic_cast<KnobChoice*>( param.get() );
+            if (!getIsScalar) {
+                return false;
+            }
+            if ( !acceptOperator(")") ) {
+                if ( !parseSum() || !acceptOperator(")") ) {
+                    return false;
+                }
+                instr.op = eNativeOpKnobValueAtTime;
+                stackDelta = 0;
+            }
+        } else if (function == "getValue") {
+            if ( !acceptOperator(")") ) {
+                if ( !parseDimensionArgument(param, &instr.dimension) || !acceptOperator(")") ) {
+                    return false;
+                }
+            }
+        } else if ( (function == "getValueAtTime") || (function == "curve") ) {
+            if ( !parseSum() ) {
+                return false;
+            }
+            if ( acceptOperator(",") && !parseDimensionArgument(param, &instr.dimension) ) {
+                return false;
+            }
+            if ( !acceptOperator(")") ) {
+                return false;
+            }
+            instr.op = function == "curve" ? eNativeOpKnobCurve : eNativeOpKnobValueAtTime;
+            stackDelta = 0;
+        } else {
+            return false;
+        }
+
+        return push(instr, stackDelta);
+    } // parseParameterFunction
+
+    KnobIPtr _knob;
+    int _dimension;
+    NodePtr _node;
+    NodeCollectionPtr _group;
+    std::vector<Instruction>* _program;
+    std::vector<Token> _tokens;
+    std::size_t _pos;
+    int _depth;
+};
+
+bool
+getKnobValue(const NativeKnobExpression::Instruction& instr,
+             bool atTime,
+             double time,
+             double* value)
+{
+    // Make sure the parameter was not deleted since the expression was compiled
+    KnobIPtr knob = instr.knob.lock();
+
+    if (!knob) {
+        return false;
+    }
+
+    // The parameter is already evaluating its expression on this thread: the expressions reference
+    // each other. Let Python evaluate it, it breaks the cycle the same way.
+    const KnobHelper* helper = instr.intKnob ? static_cast<const KnobHelper*>(instr.intKnob) :
+                               instr.doubleKnob ? static_cast<const KnobHelper*>(instr.doubleKnob) :
+                               static_cast<const KnobHelper*>(instr.boolKnob);
+    assert(helper);
+    if (helper->getExpressionRecursionLevel() > 0) {
+        return false;
+    }
+
+    if (instr.intKnob) {
+        *value = atTime ? instr.intKnob->getValueAtTime(time, instr.dimension) : instr.intKnob->getValue(instr.dimension);
+    } else if (instr.doubleKnob) {
+        *value = atTime ? instr.doubleKnob->getValueAtTime(time, instr.dimension) : instr.doubleKnob->getValue(instr.dimension);
+    } else {
+        assert(instr.boolKnob);
+        *value = ( atTime ? instr.boolKnob->getValueAtTime(time, instr.dimension) : instr.boolKnob->getValue(instr.dimension) ) ? 1. : 0.;
+    }
+
+    return true;
+}
+
+class NativeEvaluationDepth_RAII
+{
+public:
+
+    NativeEvaluationDepth_RAII()
+    {
+        ++nativeEvaluationDepth.localData();
+    }
+
+    ~NativeEvaluationDepth_RAII()
+    {
+        --nativeEvaluationDepth.localData();
+    }
+
+    bool isTooDeep() const
+    {
+        return nativeEvaluationDepth.localData() > NATRON_NATIVE_EXPRESSION_MAX_RECURSION_DEPTH;
+    }
+};
+
+NATRON_NAMESPACE_ANONYMOUS_EXIT
+
+NativeKnobExpression::NativeKnobExpression()
+    : _program()
+{
+}
+
+NativeKnobExpression::~NativeKnobExpression()
+{
+}
+
+NativeKnobExpressionPtr
+NativeKnobExpression::compile(const std::string& expression,
+                              const KnobIPtr& knob,
+                              int dimension)
+{
+    if ( !knob || expression.empty() ) {
+        return NativeKnobExpressionPtr();
+    }
+    NativeKnobExpressionPtr ret( new NativeKnobExpression() );
+    NativeExpressionParser parser(knob, dimension, &ret->_program);
+    if ( !parser.parse(expression) ) {
+        return NativeKnobExpressionPtr();
+    }
+
+    return ret;
+}
+
+bool
+NativeKnobExpression::evaluate(double time,
+                               ViewIdx view,
+                               double* ret) const
+{
+    NativeEvaluationDepth_RAII depth;
+    if ( depth.isTooDeep() ) {
+        return false;
+    }
+
+    double stack[NATRON_NATIVE_EXPRESSION_MAX_STACK_DEPTH];
+    int top = 0; // number of values on the stack
+
+    for (std::vector<Instruction>::const_iterator it = _program.begin(); it != _program.end(); ++it) {
+        switch (it->op) {
+        case eNativeOpConstant:
+            stack[top++] = it->constant;
+            break;
+        case eNativeOpFrame:
+            stack[top++] = time;
+            break;
+        case eNativeOpView:
+            stack[top++] = (double)view.value();
+            break;
+        case eNativeOpAdd:
+            --top;
+            stack[top - 1] += stack[top];
+            break;
+        case eNativeOpSubtract:
+            --top;
+            stack[top - 1] -= stack[top];
+            break;
+        case eNativeOpMultiply:
+            --top;
+            stack[top - 1] *= stack[top];
+            break;
+        case eNativeOpDivide:
+            --top;
+            if (stack[top] == 0.) {
+                return false;
+            }
+            stack[top - 1] /= stack[top];
+            break;
+        case eNativeOpFloorDivide:
+            --top;
+            if (stack[top] == 0.) {
+                return false;
+            }
+            stack[top - 1] = std::floor(stack[top - 1] / stack[top]);
+            break;
+        case eNativeOpModulo: {
+            --top;
+            if (stack[top] == 0.) {
+                return false;
+            }
+            // The result of the Python modulo has the sign of the divisor
+            double r = std::fmod(stack[top - 1], stack[top]);
+            if ( (r != 0.) && ( (r < 0.) != (stack[top] < 0.) ) ) {
+                r += stack[top];
+            }
+            stack[top - 1] = r;
+            break;
+        }
+        case eNativeOpPower:
+            --top;
+            stack[top - 1] = std::pow(stack[top - 1], stack[top]);
+            break;
+        case eNativeOpNegate:
+            stack[top - 1] = -stack[top - 1];
+            break;
+        case eNativeOpUnaryFunction:
+            stack[top - 1] = it->unaryFunction(stack[top - 1]);
+            break;
+        case eNativeOpBinaryFunction:
+            --top;
+            stack[top - 1] = it->binaryFunction(stack[top - 1], stack[top]);
+            break;
+        case eNativeOpMin:
+        case eNativeOpMax: {
+            int first = top - it->nArgs;
+            double r = stack[first];
+            for (int i = first + 1; i < top; ++i) {
+                r = it->op == eNativeOpMin ? std::min(r, stack[i]) : std::max(r, stack[i]);
+            }
+            top = first + 1;
+            stack[first] = r;
+            break;
+        }
+        case eNativeOpKnobValue:
+            if ( !getKnobValue(*it, false, 0., &stack[top]) ) {
+                return false;
+            }
+            ++top;
+            break;
+        case eNativeOpKnobValueAtTime:
+            if ( !getKnobValue(*it, true, stack[top - 1], &stack[top - 1]) ) {
+                return false;
+            }
+            break;
+        case eNativeOpKnobCurve: {
+            KnobIPtr knob = it->knob.lock();
+            if (!knob) {
+                return false;
+            }
+            stack[top - 1] = knob->getRawCurveValueAt(stack[top - 1], ViewSpec::current(), it->dimension);
+            break;
+        }
+        } // switch
+    }
+    assert(top == 1);
+
+    // Let Python report math domain errors and overflows
+    if ( (top != 1) || !std::isfinite(stack[0]) ) {
+        return false;
+    }
+    *ret = stack[0];
+
+    return true;
+} // NativeKnobExpression::evaluate
+
+void
+NativeKnobExpression::recordEvaluation(EvaluationPathEnum path)
+{
+    switch (path) {
+    case eEvaluationPathNative:
+        nativeEvaluationsCount.fetchAndAddRelaxed(1);
+        break;
+    case eEvaluationPathCompiled:
+        compiledEvaluationsCount.fetchAndAddRelaxed(1);
+        break;
+    case eEvaluationPathInterpreted:
+        interpretedEvaluationsCount.fetchAndAddRelaxed(1);
+        break;
+    }
+}
+
+NativeKnobExpression::Stats
+NativeKnobExpression::getStats(bool reset)
+{
+    Stats ret;
+
+    if (reset) {
+        ret.nativeEvaluations = nativeEvaluationsCount.fetchAndStoreRelaxed(0);
+        ret.compiledEvaluations = compiledEvaluationsCount.fetchAndStoreRelaxed(0);
+        ret.interpretedEvaluations = interpretedEvaluationsCount.fetchAndStoreRelaxed(0);
+    } else {
+        ret.nativeEvaluations = nativeEvaluationsCount.fetchAndAddRelaxed(0);
+        ret.compiledEvaluations = compiledEvaluationsCount.fetchAndAddRelaxed(0);
+        ret.interpretedEvaluations = interpretedEvaluationsCount.fetchAndAddRelaxed(0);
+    }
+
+    return ret;
+}
+
+NATRON_NAMESPACE_EXIT
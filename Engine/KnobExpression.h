@@ -0,0 +1,111 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <https://natrongithub.github.io/>,
+ * (C) 2018-2023 The Natron developers
+ * (C) 2013-2018 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+#ifndef NATRON_ENGINE_KNOBEXPRESSION_H
+#define NATRON_ENGINE_KNOBEXPRESSION_H
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "Global/Macros.h"
+
+#include <string>
+#include <vector>
+
+#include "Global/GlobalDefines.h"
+#include "Engine/ViewIdx.h"
+#include "Engine/EngineFwd.h"
+
+NATRON_NAMESPACE_ENTER
+
+/**
+ * @brief A single-line knob expression compiled to a small stack program that is evaluated
+ * without the Python interpreter, hence without holding the GIL.
+ * Only a subset of Python is understood: numbers, arithmetic operators, parenthesis, the
+ * frame, view and dimension variables, the functions of the math module, abs, min, max,
+ * curve() and the get(), getValue(), getValueAtTime() and curve() functions of numeric
+ * parameters of thisNode, thisParam or of a node of the same group.
+ * Anything else is left to Python.
+ **/
+class NativeKnobExpression
+{
+public:
+
+    enum EvaluationPathEnum
+    {
+        // Evaluated by NativeKnobExpression
+        eEvaluationPathNative = 0,
+
+        // The Python function of the expression was called directly
+        eEvaluationPathCompiled,
+
+        // The expression was run through the Python interpreter
+        eEvaluationPathInterpreted
+    };
+
+    struct Stats
+    {
+        int nativeEvaluations;
+        int compiledEvaluations;
+        int interpretedEvaluations;
+    };
+
+    /**
+     * @brief Compiles the expression set on the given dimension of the knob.
+     * The parameters referenced by the expression are resolved now, so this must be called again
+     * whenever the expression is set. Returns NULL if the expression cannot be evaluated natively.
+     **/
+    static NativeKnobExpressionPtr compile(const std::string& expression,
+                                           const KnobIPtr& knob,
+                                           int dimension);
+
+    /**
+     * @brief Evaluates the expression. Returns false if the result could not be computed
+     * (e.g: a division by zero or a parameter that was deleted), in which case Python should
+     * evaluate the expression to report the error.
+     * This also fails when the expression reads a parameter whose expression is being evaluated on
+     * this thread (expressions referencing each other) or when too many evaluations are nested.
+     * This is thread-safe and does not lock the Python GIL.
+     **/
+    bool evaluate(double time, ViewIdx view, double* ret) const;
+
+    static void recordEvaluation(EvaluationPathEnum path);
+
+    /**
+     * @brief Returns the number of expression evaluations that took each path since the last reset.
+     **/
+    static Stats getStats(bool reset);
+
+    struct Instruction;
+
+    ~NativeKnobExpression();
+
+private:
+
+    NativeKnobExpression();
+
+    std::vector<Instruction> _program;
+};
+
+NATRON_NAMESPACE_EXIT
+
+#endif // NATRON_ENGINE_KNOBEXPRESSION_H
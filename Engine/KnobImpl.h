@@ -412,6 +412,21 @@ hashFunction(unsigned int a)
     return a;
 }
 
+template <typename T>
+inline T
+nativeExpressionResultToType(double value)
+{
+    return (T)value;
+}
+
+template <>
+inline std::string
+nativeExpressionResultToType(double /*value*/)
+{
+    // expressions of string parameters are never compiled natively
+    return std::string();
+}
+
 template <typename T>
 bool
 Knob<T>::evaluateExpression(const std::string& expr,
@@ -440,6 +455,14 @@ Knob<T>::evaluateExpression(double time,
                             T* value,
                             std::string* error)
 {
+    // Common expressions are evaluated without locking the GIL
+    double nativeValue;
+    if ( evaluateNativeExpression(time, view, dimension, &nativeValue) ) {
+        *value = nativeExpressionResultToType<T>(nativeValue);
+
+        return true;
+    }
+
     PythonGILLocker pgl;
     PyObject *ret;
 
@@ -462,6 +485,11 @@ Knob<T>::evaluateExpression_pod(double time,
                                 double* value,
                                 std::string* error)
 {
+    // Common expressions are evaluated without locking the GIL
+    if ( evaluateNativeExpression(time, view, dimension, value) ) {
+        return true;
+    }
+
     PythonGILLocker pgl;
     PyObject *ret;
 
@@ -725,6 +753,14 @@ Knob<T>::getValue(int dimension,
     if ( ( dimension >= (int)_values.size() ) || (dimension < 0) ) {
         return T();
     }
+    if (!useGuiValues) {
+        // Render threads read the values recorded when the frame render started
+        T ret;
+        if ( getValueFromRenderSnapshot(0, view, dimension, clamp, &ret) ) {
+            return ret;
+        }
+    }
+
     std::string hasExpr = getExpression(dimension);
     if ( !hasExpr.empty() ) {
         T ret;
@@ -831,6 +867,46 @@ KnobStringBase::getValueFromCurve(double time,
     return false;
 }
 
+template <typename T>
+bool
+Knob<T>::getValueFromRenderSnapshot(const double* time,
+                                    ViewSpec view,
+                                    int dimension,
+                                    bool clamp,
+                                    T* ret) const
+{
+    KnobHolder* holder = getHolder();
+
+    if (!holder) {
+        return false;
+    }
+    double currentTime;
+    ViewIdx currentView;
+    const KnobValuesSnapshot* snapshot = holder->getKnobValuesSnapshotTLS(&currentTime, &currentView);
+    if (!snapshot) {
+        return false;
+    }
+    double value;
+    if ( !snapshot->getValue(this, time ? *time : currentTime, view.isCurrent() ? currentView : ViewIdx( view.value() ), dimension, clamp, &value) ) {
+        return false;
+    }
+    *ret = (T)value;
+
+    return true;
+}
+
+template <>
+bool
+KnobStringBase::getValueFromRenderSnapshot(const double* /*time*/,
+                                              ViewSpec /*view*/,
+                                              int /*dimension*/,
+                                              bool /*clamp*/,
+                                              std::string* /*ret*/) const
+{
+    // strings are not recorded in the snapshot
+    return false;
+}
+
 template<typename T>
 T
 Knob<T>::getValueAtTime(double time,
@@ -845,6 +921,14 @@ Knob<T>::getValueAtTime(double time,
     }
 
     bool useGuiValues = QThread::currentThread() == qApp->thread();
+    if (!useGuiValues && !byPassMaster) {
+        // Render threads read the values recorded when the frame render started
+        T ret;
+        if ( getValueFromRenderSnapshot(&time, view, dimension, clamp, &ret) ) {
+            return ret;
+        }
+    }
+
     std::string hasExpr = getExpression(dimension);
     if ( !hasExpr.empty() ) {
         T ret;
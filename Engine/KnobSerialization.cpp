@@ -57,6 +57,18 @@ ValueSerialization::ValueSerialization()
 , _master()
 , _expression()
 , _exprHasRetVar(false)
+, _enabled(true)
+, _hasAnimation(false)
+, _curve()
+, _hasMaster(false)
+, _intValue(0)
+, _intDefault(0)
+, _boolValue(false)
+, _boolDefault(false)
+, _doubleValue(0.)
+, _doubleDefault(0.)
+, _stringValue()
+, _stringDefault()
 {
 
 }
@@ -70,6 +82,18 @@ ValueSerialization::ValueSerialization(KnobSerializationBase* serialization,
     , _master()
     , _expression()
     , _exprHasRetVar(false)
+    , _enabled(true)
+    , _hasAnimation(false)
+    , _curve()
+    , _hasMaster(false)
+    , _intValue(0)
+    , _intDefault(0)
+    , _boolValue(false)
+    , _boolDefault(false)
+    , _doubleValue(0.)
+    , _doubleDefault(0.)
+    , _stringValue()
+    , _stringDefault()
 {
 }
 
@@ -93,6 +117,18 @@ ValueSerialization::ValueSerialization(const KnobIPtr & knob,
     , _master()
     , _expression()
     , _exprHasRetVar(false)
+    , _enabled(true)
+    , _hasAnimation(false)
+    , _curve()
+    , _hasMaster(false)
+    , _intValue(0)
+    , _intDefault(0)
+    , _boolValue(false)
+    , _boolDefault(false)
+    , _doubleValue(0.)
+    , _doubleDefault(0.)
+    , _stringValue()
+    , _stringDefault()
 {
     initForSave(knob, dimension, exprHasRetVar, expr);
 }
@@ -129,6 +165,30 @@ ValueSerialization::initForSave(const KnobIPtr & knob,
     } else {
         _master.masterDimension = -1;
     }
+    _hasMaster = knob->isSlave(dimension);
+    _enabled = knob->isEnabled(dimension);
+    _hasAnimation = knob->isAnimated(dimension);
+    if (_hasAnimation) {
+        _curve.clone( *knob->getCurve(ViewIdx(0), dimension, true) );
+    }
+
+    KnobIntBase* isInt = dynamic_cast<KnobIntBase*>( knob.get() );
+    KnobBoolBase* isBool = dynamic_cast<KnobBoolBase*>( knob.get() );
+    KnobDoubleBase* isDouble = dynamic_cast<KnobDoubleBase*>( knob.get() );
+    KnobStringBase* isString = dynamic_cast<KnobStringBase*>( knob.get() );
+    if (isInt) {
+        _intValue = isInt->getValue(dimension);
+        _intDefault = isInt->getDefaultValue(dimension);
+    } else if (isBool) {
+        _boolValue = isBool->getValue(dimension);
+        _boolDefault = isBool->getDefaultValue(dimension);
+    } else if (isDouble) {
+        _doubleValue = isDouble->getValue(dimension);
+        _doubleDefault = isDouble->getDefaultValue(dimension);
+    } else if (isString) {
+        _stringValue = isString->getValue(dimension);
+        _stringDefault = isString->getDefaultValue(dimension);
+    }
 
 }
 
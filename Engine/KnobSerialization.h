@@ -255,6 +255,17 @@ struct ValueSerialization
     std::string _expression;
     bool _exprHasRetVar;
 
+    ///The state of the knob captured by initForSave(), so that the serialization can be written
+    ///away from the knob, e.g. by the auto-save thread while the user keeps editing
+    bool _enabled;
+    bool _hasAnimation;
+    Curve _curve;
+    bool _hasMaster;
+    int _intValue, _intDefault;
+    bool _boolValue, _boolDefault;
+    double _doubleValue, _doubleDefault;
+    std::string _stringValue, _stringDefault;
+
     ValueSerialization();
 
     ///Load
@@ -292,48 +303,43 @@ struct ValueSerialization
         KnobGroup* isGrp = dynamic_cast<KnobGroup*>( _knob.get() );
         KnobSeparator* isSep = dynamic_cast<KnobSeparator*>( _knob.get() );
         KnobButton* btn = dynamic_cast<KnobButton*>( _knob.get() );
-        bool enabled = _knob->isEnabled(_dimension);
+        bool enabled = _enabled;
         ar & ::boost::serialization::make_nvp("Enabled", enabled);
-        bool hasAnimation = _knob->isAnimated(_dimension);
+        bool hasAnimation = _hasAnimation;
         ar & ::boost::serialization::make_nvp("HasAnimation", hasAnimation);
 
         if (hasAnimation) {
-            ar & ::boost::serialization::make_nvp( "Curve", *( _knob->getCurve(ViewIdx(0), _dimension, true) ) );
+            ar & ::boost::serialization::make_nvp("Curve", _curve);
         }
 
         if (isInt && !isChoice) {
-            int v = isInt->getValue(_dimension);
-            int defV = isInt->getDefaultValue(_dimension);
+            int v = _intValue;
+            int defV = _intDefault;
             ar & ::boost::serialization::make_nvp("Value", v);
             ar & ::boost::serialization::make_nvp("Default", defV);
         } else if (isBool && !isPage && !isGrp && !isSep && !btn) {
-            bool v = isBool->getValue(_dimension);
-            bool defV = isBool->getDefaultValue(_dimension);
+            bool v = _boolValue;
+            bool defV = _boolDefault;
             ar & ::boost::serialization::make_nvp("Value", v);
             ar & ::boost::serialization::make_nvp("Default", defV);
         } else if (isDouble && !isParametric) {
-            double v = isDouble->getValue(_dimension);
-            double defV = isDouble->getDefaultValue(_dimension);
+            double v = _doubleValue;
+            double defV = _doubleDefault;
             ar & ::boost::serialization::make_nvp("Value", v);
             ar & ::boost::serialization::make_nvp("Default", defV);
         } else if (isChoice) {
-            int v = isChoice->getValue(_dimension);
-            int defV = isChoice->getDefaultValue(_dimension);
-            std::vector<ChoiceOption> entries = isChoice->getEntries_mt_safe();
-            std::string label;
-            if ( ( v < (int)entries.size() ) && (v >= 0) ) {
-                label = entries[v].id;
-            }
+            int v = _intValue;
+            int defV = _intDefault;
             ar & ::boost::serialization::make_nvp("Value", v);
             ar & ::boost::serialization::make_nvp("Default", defV);
         } else if (isString) {
-            std::string v = isString->getValue(_dimension);
-            std::string defV = isString->getDefaultValue(_dimension);
+            std::string v = _stringValue;
+            std::string defV = _stringDefault;
             ar & ::boost::serialization::make_nvp("Value", v);
             ar & ::boost::serialization::make_nvp("Default", defV);
         }
 
-        bool hasMaster = _knob->isSlave(_dimension);
+        bool hasMaster = _hasMaster;
         ar & ::boost::serialization::make_nvp("HasMaster", hasMaster);
         if (hasMaster) {
             ar & ::boost::serialization::make_nvp("Master", _master);
@@ -512,6 +518,9 @@ class KnobSerialization
     bool _masterIsAlias;
     std::vector<std::pair<std::string, bool> > _expressions; //< used when deserializing, we can't restore it before all knobs have been restored.
     std::list<Curve > parametricCurves;
+    std::map<int, std::string> _stringAnimation; //< used when serializing
+    std::string _name; //< used when serializing
+    bool _secret; //< used when serializing
     mutable TypeExtraData* _extraData;
     bool _isUserKnob;
     std::string _label;
@@ -540,27 +549,25 @@ private:
         AnimatingKnobStringHelper* isString = dynamic_cast<AnimatingKnobStringHelper*>( _knob.get() );
         KnobParametric* isParametric = dynamic_cast<KnobParametric*>( _knob.get() );
         KnobDouble* isDouble = dynamic_cast<KnobDouble*>( _knob.get() );
-        std::string name = _knob->getName();
+        std::string name = _name;
         ar & ::boost::serialization::make_nvp("Name", name);
         ar & ::boost::serialization::make_nvp("Type", _typeName);
         ar & ::boost::serialization::make_nvp("Dimension", _dimension);
-        bool secret = _knob->getIsSecret();
+        bool secret = _secret;
         ar & ::boost::serialization::make_nvp("Secret", secret);
         ar & ::boost::serialization::make_nvp("MasterIsAlias", _masterIsAlias);
 
         assert((int)_values.size() == _dimension);
-        for (int i = 0; i < _knob->getDimension(); ++i) {
+        for (int i = 0; i < _dimension; ++i) {
             ar & ::boost::serialization::make_nvp("item", _values[i]);
         }
 
         ////restore extra datas
         if (isParametric) {
-            std::list<Curve > curves;
-            isParametric->saveParametricCurves(&curves);
+            std::list<Curve > curves = parametricCurves;
             ar & ::boost::serialization::make_nvp("ParametricCurves", curves);
         } else if (isString) {
-            std::map<int, std::string> extraDatas;
-            isString->getAnimation().save(&extraDatas);
+            std::map<int, std::string> extraDatas = _stringAnimation;
             ar & ::boost::serialization::make_nvp("StringsAnimation", extraDatas);
         }
         ChoiceExtraData* cdata = dynamic_cast<ChoiceExtraData*>(_extraData);
@@ -601,8 +608,8 @@ private:
                 }
             }
 
-            if ( isDouble && (isDouble->getDimension() == 2) ) {
-                bool useOverlay = isDouble->getHasHostOverlayHandle();
+            if ( isDouble && (_dimension == 2) ) {
+                bool useOverlay = _useHostOverlay;
                 ar & ::boost::serialization::make_nvp("HasOverlayHandle", useOverlay);
             }
         }
@@ -802,6 +809,7 @@ public:
         : _knob()
         , _dimension(0)
         , _masterIsAlias(false)
+        , _secret(false)
         , _extraData(NULL)
         , _isUserKnob(false)
         , _label()
@@ -824,6 +832,9 @@ public:
     {
         _knob = knob;
 
+        ///Everything written by save() is captured here: the serialization does not read the knob afterwards
+        _name = knob->getName();
+        _secret = knob->getIsSecret();
         _typeName = knob->typeName();
         _dimension = knob->getDimension();
 
@@ -847,6 +858,18 @@ public:
         _animationEnabled = knob->isAnimationEnabled();
         _tooltip = knob->getHintToolTip();
 
+        KnobParametric* isParametric = dynamic_cast<KnobParametric*>( _knob.get() );
+        AnimatingKnobStringHelper* isAnimatedString = dynamic_cast<AnimatingKnobStringHelper*>( _knob.get() );
+        if (isParametric) {
+            isParametric->saveParametricCurves(&parametricCurves);
+        } else if (isAnimatedString) {
+            isAnimatedString->getAnimation().save(&_stringAnimation);
+        }
+        KnobDouble* isDoubleWithOverlay = dynamic_cast<KnobDouble*>( _knob.get() );
+        if ( isDoubleWithOverlay && (_dimension == 2) ) {
+            _useHostOverlay = isDoubleWithOverlay->getHasHostOverlayHandle();
+        }
+
         KnobChoice* isChoice = dynamic_cast<KnobChoice*>( _knob.get() );
         if (isChoice) {
             ChoiceExtraData* extraData = new ChoiceExtraData;
@@ -921,6 +944,7 @@ public:
         , _dimension(0)
         , _masters()
         , _masterIsAlias(false)
+        , _secret(false)
         , _extraData(NULL)
         , _isUserKnob(false)
         , _label()
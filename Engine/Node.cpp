@@ -168,6 +168,7 @@ Node::Node(const AppInstancePtr& app,
     QObject::connect( this, SIGNAL(pluginMemoryUsageChanged(qint64)), appPTR, SLOT(onNodeMemoryRegistered(qint64)) );
     QObject::connect( this, SIGNAL(mustDequeueActions()), this, SLOT(dequeueActions()) );
     QObject::connect( this, SIGNAL(mustComputeHashOnMainThread()), this, SLOT(doComputeHashOnMainThread()) );
+    QObject::connect( this, SIGNAL(hashChangedOffMainThread()), this, SLOT(onHashChanged()), Qt::QueuedConnection );
     QObject::connect(this, SIGNAL(refreshIdentityStateRequested()), this, SLOT(onRefreshIdentityStateRequestReceived()), Qt::QueuedConnection);
 
     if (plugin && plugin->getPluginID().startsWith(QLatin1String("com.FXHOME.HitFilm"))) {
@@ -767,6 +768,21 @@ Node::getChildrenMultiInstance(NodesList* children) const
 U64
 Node::getHashValue() const
 {
+    {
+        QReadLocker l(&_imp->knobsAgeMutex);
+        if (!_imp->hashDirty) {
+            return _imp->hash.value();
+        }
+    }
+
+    Node* self = const_cast<Node*>(this);
+    if ( QThread::currentThread() == qApp->thread() ) {
+        ignore_result( self->computeHashInternal() );
+    } else if ( self->updateHashValue() ) {
+        ///The actions cache and the image cache must be cleaned up on the main-thread
+        Q_EMIT self->hashChangedOffMainThread();
+    }
+
     QReadLocker l(&_imp->knobsAgeMutex);
 
     return _imp->hash.value();
@@ -781,15 +797,23 @@ Node::getCacheID() const
 }
 
 bool
-Node::computeHashInternal()
+Node::updateHashValue()
 {
     if (!_imp->effect) {
         return false;
     }
-    ///Always called in the main thread
-    assert( QThread::currentThread() == qApp->thread() );
-    if (!_imp->inputsInitialized) {
-        qDebug() << "Node::computeHash(): inputs not initialized";
+
+    ///Resolve the inputs first so that they are not recomputed while our lock is held
+    {
+        RotoDrawableItemPtr attachedStroke = _imp->paintStroke.lock();
+        NodePtr attachedStrokeContextNode = attachedStroke ? attachedStroke->getContext()->getNode() : NodePtr();
+        int nInputs = getNInputs();
+        for (int i = 0; i < nInputs; ++i) {
+            NodePtr input = getInput(i);
+            if ( input && (input != attachedStrokeContextNode) ) {
+                ignore_result( input->getHashValue() );
+            }
+        }
     }
 
     U64 oldHash, newHash;
@@ -800,6 +824,7 @@ Node::computeHashInternal()
 
         ///reset the hash value
         _imp->hash.reset();
+        _imp->hashDirty = false;
 
         ///append the effect's own age
         _imp->hash.append(_imp->knobsAge);
@@ -851,7 +876,7 @@ Node::computeHashInternal()
         //        }
 
         ///Also append the effect's label to distinguish 2 instances with the same parameters
-        Hash64_appendQString( &_imp->hash, QString::fromUtf8( getScriptName().c_str() ) );
+        Hash64_appendQString( &_imp->hash, QString::fromUtf8( getScriptName_mt_safe().c_str() ) );
 
         ///Also append the project's creation time in the hash because 2 projects opened concurrently
         ///could reproduce the same (especially simple graphs like Viewer-Reader)
@@ -861,37 +886,77 @@ Node::computeHashInternal()
         _imp->hash.computeHash();
 
         newHash = _imp->hash.value();
+        ++_imp->hashRecomputationsCount;
     } // QWriteLocker l(&_imp->knobsAgeMutex);
-    bool hashChanged = oldHash != newHash;
+
+    return oldHash != newHash;
+} // Node::updateHashValue
+
+bool
+Node::computeHashInternal()
+{
+    if (!_imp->effect) {
+        return false;
+    }
+    ///Always called in the main thread
+    assert( QThread::currentThread() == qApp->thread() );
+    if (!_imp->inputsInitialized) {
+        qDebug() << "Node::computeHash(): inputs not initialized";
+    }
+
+    bool hashChanged = updateHashValue();
 
     if (hashChanged) {
-        _imp->effect->onNodeHashChanged(newHash);
-        if ( _imp->nodeCreated && !getApp()->getProject()->isProjectClosing() ) {
-            /*
-             * We changed the node hash. That means all cache entries for this node with a different hash
-             * are impossible to re-create again. Just discard them all. This is done in a separate thread.
-             */
-            removeAllImagesFromCacheWithMatchingIDAndDifferentKey(newHash);
-        }
+        onHashChanged();
     }
 
     return hashChanged;
 } // Node::computeHashInternal
 
+///Clears what depended on the previous hash, always on the main-thread
 void
-Node::computeHashRecursive(std::list<Node*>& marked)
+Node::onHashChanged()
 {
-    if ( std::find(marked.begin(), marked.end(), this) != marked.end() ) {
+    assert( QThread::currentThread() == qApp->thread() );
+    if (!_imp->effect) {
         return;
     }
+    U64 newHash;
+    {
+        QReadLocker l(&_imp->knobsAgeMutex);
+        newHash = _imp->hash.value();
+    }
+    _imp->effect->onNodeHashChanged(newHash);
+    if ( _imp->nodeCreated && !getApp()->getProject()->isProjectClosing() ) {
+        /*
+         * We changed the node hash. That means all cache entries for this node with a different hash
+         * are impossible to re-create again. Just discard them all. This is done in a separate thread.
+         */
+        removeAllImagesFromCacheWithMatchingIDAndDifferentKey(newHash);
+    }
+}
 
-    bool hasChanged = computeHashInternal();
-    marked.push_back(this);
-    if (!hasChanged) {
-        //Nothing changed, no need to recurse on outputs
+void
+Node::invalidateHashRecursive(std::list<Node*>& marked)
+{
+    if ( std::find(marked.begin(), marked.end(), this) != marked.end() ) {
         return;
     }
+    marked.push_back(this);
 
+    {
+        QWriteLocker l(&_imp->knobsAgeMutex);
+        if (_imp->hashDirty) {
+            ///A dirty hash is never used to compute the hash of the outputs, they are already dirty
+            return;
+        }
+        _imp->hashDirty = true;
+        ++_imp->hashInvalidationsCount;
+    }
+
+    if (!_imp->effect) {
+        return;
+    }
 
     bool isRotoPaint = _imp->effect->isRotoPaintNode();
 
@@ -906,18 +971,28 @@ Node::computeHashRecursive(std::list<Node*>& marked)
         if ( isRotoPaint && attachedStroke && (attachedStroke->getContext()->getNode().get() == this) ) {
             continue;
         }
-        (*it)->computeHashRecursive(marked);
+        (*it)->invalidateHashRecursive(marked);
     }
 
 
-    ///If the node has a rotopaint tree, compute the hash of the nodes in the tree
+    ///If the node has a rotopaint tree, invalidate the hash of the nodes in the tree
     if (_imp->rotoContext) {
         NodesList allItems;
         _imp->rotoContext->getRotoPaintTreeNodes(&allItems);
         for (NodesList::iterator it = allItems.begin(); it != allItems.end(); ++it) {
-            (*it)->computeHashRecursive(marked);
+            (*it)->invalidateHashRecursive(marked);
         }
     }
+} // Node::invalidateHashRecursive
+
+void
+Node::getHashCounters(U64* invalidations,
+                      U64* recomputations) const
+{
+    QReadLocker l(&_imp->knobsAgeMutex);
+
+    *invalidations = _imp->hashInvalidationsCount;
+    *recomputations = _imp->hashRecomputationsCount;
 }
 
 void
@@ -973,8 +1048,9 @@ Node::computeHash()
 
         return;
     }
+    ///Only flag the hashes downstream, they are recomputed by getHashValue() when a render or a cache lookup needs them
     std::list<Node*> marked;
-    computeHashRecursive(marked);
+    invalidateHashRecursive(marked);
 } // computeHash
 
 
@@ -4916,7 +4992,7 @@ Node::onEffectKnobValueChanged(KnobI* what,
             for (NodesList::iterator it = nodes.begin(); it != nodes.end(); ++it) {
                 //This will not trigger a hash recomputation
                 (*it)->incrementKnobsAge_internal();
-                (*it)->computeHashRecursive(markedNodes);
+                (*it)->invalidateHashRecursive(markedNodes);
             }
         }
     } else if ( what == _imp->nodeLabelKnob.lock().get() ) {
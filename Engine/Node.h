@@ -223,6 +223,12 @@ public:
      **/
     U64 getHashValue() const;
 
+    /**
+     * @brief Returns how many times the hash of this node was flagged dirty by an edit upstream
+     * and how many times it was actually recomputed since the node was created.
+     **/
+    void getHashCounters(U64* invalidations, U64* recomputations) const;
+
     virtual std::string getCacheID() const OVERRIDE FINAL;
 
     /**
@@ -1333,7 +1339,10 @@ private:
 
     bool setStreamWarningInternal(StreamWarningEnum warning, const QString& message);
 
-    void computeHashRecursive(std::list<Node*>& marked);
+    /**
+     * @brief Flags the hash of this node and of all nodes downstream as dirty, without recomputing them.
+     **/
+    void invalidateHashRecursive(std::list<Node*>& marked);
 
     /**
      * @brief Refreshes the node hash depending on its context (knobs age, inputs etc...)
@@ -1341,6 +1350,12 @@ private:
      **/
     bool computeHashInternal() WARN_UNUSED_RETURN;
 
+    /**
+     * @brief Recomputes the hash value only, the inputs hash are resolved first. Thread-safe.
+     * @return True if the hash has changed, false otherwise
+     **/
+    bool updateHashValue() WARN_UNUSED_RETURN;
+
     void refreshCreatedViews(KnobI* knob, bool silent);
 
     void refreshInputRelatedDataRecursiveInternal(std::set<Node*>& markedNodes);
@@ -1411,6 +1426,8 @@ public Q_SLOTS:
 
     void doComputeHashOnMainThread();
 
+    void onHashChanged();
+
 Q_SIGNALS:
 
     void rightClickMenuKnobPopulated();
@@ -1427,6 +1444,8 @@ Q_SIGNALS:
 
     void mustComputeHashOnMainThread();
 
+    void hashChangedOffMainThread();
+
     void settingsPanelClosed(bool);
 
     void knobsAgeChanged(U64 age);
@@ -1499,8 +1518,8 @@ Q_SIGNALS:
 protected:
 
     /**
-     * @brief Recompute the hash value of this node and notify all the clone effects that the values they store in their
-     * knobs is dirty and that they should refresh it by cloning the live instance.
+     * @brief Invalidates the hash value of this node and of all nodes downstream.
+     * Hashes are recomputed on demand by getHashValue(), or at the latest on the next event loop iteration.
      **/
     void computeHash();
 
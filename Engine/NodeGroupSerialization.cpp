@@ -26,8 +26,21 @@
 #include "NodeGroupSerialization.h"
 
 #include <cassert>
+#include <iostream>
+#include <sstream>
 #include <stdexcept>
 
+#if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
+GCC_DIAG_UNUSED_LOCAL_TYPEDEFS_OFF
+// clang-format off
+GCC_DIAG_OFF(unused-parameter)
+#include <boost/archive/binary_iarchive.hpp>
+#include <boost/archive/binary_oarchive.hpp>
+GCC_DIAG_UNUSED_LOCAL_TYPEDEFS_ON
+GCC_DIAG_ON(unused-parameter)
+// clang-format on
+#endif
+
 #include <QtCore/QDateTime>
 #include <QtCore/QFileInfo>
 
@@ -60,6 +73,41 @@ NodeCollectionSerialization::initialize(const NodeCollection& group)
     }
 }
 
+std::string
+NodeCollectionSerialization::saveNodeSection(const NodeSerialization& node)
+{
+    std::ostringstream ss;
+    {
+        ///The section is self-contained: it carries its own class versions but no archive header
+        boost::archive::binary_oarchive oArchive(ss, boost::archive::no_header);
+        oArchive << boost::serialization::make_nvp("item", node);
+    }
+
+    return ss.str();
+}
+
+bool
+NodeCollectionSerialization::loadNodeSection(const std::string& section,
+                                             NodeSerialization* node)
+{
+    assert(node);
+    try {
+        std::istringstream ss(section);
+        boost::archive::binary_iarchive iArchive(ss, boost::archive::no_header);
+        iArchive >> boost::serialization::make_nvp("item", *node);
+    } catch (const std::exception& e) {
+        std::cerr << tr("Skipping a damaged node in the project file: %1").arg( QString::fromUtf8( e.what() ) ).toStdString() << std::endl;
+
+        return false;
+    } catch (...) {
+        std::cerr << tr("Skipping a damaged node in the project file").toStdString() << std::endl;
+
+        return false;
+    }
+
+    return true;
+}
+
 static QString lookForFileRecursively(const QString& dirPath, const QString& filenameUnPathed)
 {
     QDir d(dirPath);
@@ -36,6 +36,7 @@ GCC_DIAG_OFF(unused-parameter)
 #include <boost/archive/xml_iarchive.hpp>
 #include <boost/archive/xml_oarchive.hpp>
 #include <boost/serialization/list.hpp>
+#include <boost/serialization/string.hpp>
 #include <boost/serialization/split_member.hpp>
 #include <boost/serialization/version.hpp>
 GCC_DIAG_UNUSED_LOCAL_TYPEDEFS_ON
@@ -62,6 +63,28 @@ CLANG_DIAG_ON(uninitialized)
 
 NATRON_NAMESPACE_ENTER
 
+/**
+ * @brief True for the archives used by the binary project format (NATRON_PROJECT_BINARY_FILE_EXT).
+ * In these archives each node is written as its own length-prefixed section.
+ **/
+template<class Archive>
+struct IsBinaryProjectArchive
+{
+    static const bool value = false;
+};
+
+template<>
+struct IsBinaryProjectArchive<boost::archive::binary_iarchive>
+{
+    static const bool value = true;
+};
+
+template<>
+struct IsBinaryProjectArchive<boost::archive::binary_oarchive>
+{
+    static const bool value = true;
+};
+
 class NodeCollectionSerialization
 {
     Q_DECLARE_TR_FUNCTIONS(NodeCollection)
@@ -110,7 +133,12 @@ private:
         for (std::list<NodeSerializationPtr>::const_iterator it = _serializedNodes.begin();
              it != _serializedNodes.end();
              ++it) {
-            ar & ::boost::serialization::make_nvp("item", **it);
+            if (IsBinaryProjectArchive<Archive>::value) {
+                std::string section = saveNodeSection(**it);
+                ar & ::boost::serialization::make_nvp("item", section);
+            } else {
+                ar & ::boost::serialization::make_nvp("item", **it);
+            }
         }
     }
 
@@ -121,13 +149,27 @@ private:
         int nodesCount;
         ar & ::boost::serialization::make_nvp("NodesCount", nodesCount);
 
+        ///Sections are parsed in order on the loading thread: parsing a section creates the knobs of its node,
+        ///so there is no decoding step free of object creation that could run concurrently
         for (int i = 0; i < nodesCount; ++i) {
             NodeSerializationPtr s = std::make_shared<NodeSerialization>();
-            ar & ::boost::serialization::make_nvp("item", *s);
+            if (IsBinaryProjectArchive<Archive>::value) {
+                std::string section;
+                ar & ::boost::serialization::make_nvp("item", section);
+                ///A damaged section only loses that node, the length prefix lets us skip to the next one
+                if ( !loadNodeSection(section, s.get()) ) {
+                    continue;
+                }
+            } else {
+                ar & ::boost::serialization::make_nvp("item", *s);
+            }
             _serializedNodes.push_back(s);
         }
     }
 
+    static std::string saveNodeSection(const NodeSerialization& node);
+    static bool loadNodeSection(const std::string& section, NodeSerialization* node);
+
     BOOST_SERIALIZATION_SPLIT_MEMBER()
 };
 
@@ -180,6 +180,9 @@ public:
 #endif
         , knobsAge(0)
         , knobsAgeMutex()
+        , hashDirty(false)
+        , hashInvalidationsCount(0)
+        , hashRecomputationsCount(0)
         , masterNodeMutex()
         , masterNode()
         , nodeLinks()
@@ -367,7 +370,10 @@ public:
     //only 1 clone can render at any time
     U64 knobsAge; //< the age of the knobs in this effect. It gets incremented every times the effect has its evaluate() function called.
     mutable QReadWriteLock knobsAgeMutex; //< protects knobsAge and hash
-    Hash64 hash; //< recomputed every time knobsAge is changed.
+    Hash64 hash; //< recomputed lazily after knobsAge or the inputs changed, see getHashValue()
+    bool hashDirty; //< true when hash must be recomputed before being used, protected by knobsAgeMutex
+    U64 hashInvalidationsCount; //< how many times hashDirty was set, protected by knobsAgeMutex
+    U64 hashRecomputationsCount; //< how many times hash was recomputed, protected by knobsAgeMutex
     mutable QMutex masterNodeMutex; //< protects masterNode and nodeLinks
     NodeWPtr masterNode; //< this points to the master when the node is a clone
     KnobLinkList nodeLinks; //< these point to the parents of the params links
@@ -33,7 +33,10 @@
 #include <stdexcept> // std::exception
 #include <cctype> // tolower
 #include <algorithm> // transform, min, max
+#include <map>
 #include <string>
+#include <utility> // pair
+#include <vector>
 #include <cstring> // for std::memcpy, std::memset, std::strcmp
 
 CLANG_DIAG_OFF(deprecated)
@@ -41,7 +44,10 @@ CLANG_DIAG_OFF(uninitialized)
 // clang-format off
 CLANG_DIAG_OFF(deprecated-register) //'register' storage class specifier is deprecated
 #include <QtCore/QDateTime>
+#include <QtCore/QDataStream>
 #include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
 #include <QtCore/QMutex>
 #include <QtCore/QThreadPool>
 #include <QtCore/QCoreApplication>
@@ -114,6 +120,10 @@ CLANG_DIAG_ON(unknown-pragmas)
 //An effect may not use more than this amount of threads
 #define NATRON_MULTI_THREAD_SUITE_MAX_NUM_CPU 4
 
+//Header of the OpenFX registry cache, bump the version whenever its layout changes
+#define NATRON_OFX_REGISTRY_MAGIC 0x4E4F4652 // "NOFR"
+#define NATRON_OFX_REGISTRY_VERSION 2
+
 NATRON_NAMESPACE_ENTER
 // to disambiguate with the global-scope ::OfxHost
 
@@ -147,6 +157,42 @@ string_format(const std::string fmt,
     return str;
 }
 
+/**
+ * @brief Time stamp of a plug-in binary found in a bundle of the plug-ins search path: the registry cache
+ * is valid only if these did not change since it was written.
+ **/
+struct OFXBinaryStamp
+{
+    QString filePath;
+    qint64 lastModified;
+    qint64 size;
+
+    bool operator==(const OFXBinaryStamp& other) const
+    {
+        return filePath == other.filePath && lastModified == other.lastModified && size == other.size;
+    }
+
+    bool operator!=(const OFXBinaryStamp& other) const
+    {
+        return !(*this == other);
+    }
+
+    bool operator<(const OFXBinaryStamp& other) const
+    {
+        return filePath < other.filePath;
+    }
+};
+
+/**
+ * @brief A plug-in registered from the registry cache: its binary is only loaded when the plug-in is used.
+ **/
+struct OFXDeferredPlugin
+{
+    Plugin* plugin;
+    std::string binaryFilePath;
+    std::string bundlePath;
+};
+
 struct OfxHostPrivate
 {
     OFX::Host::ImageEffect::PluginCachePtr imageEffectPluginCache;
@@ -159,6 +205,10 @@ struct OfxHostPrivate
     std::string loadingPluginID; // ID of the plugin being loaded
     int loadingPluginVersionMajor;
     int loadingPluginVersionMinor;
+    std::vector<OFXBinaryStamp> binariesStamps; // plug-in binaries found in the search path, sorted by path
+    std::map<std::pair<std::string, int>, OFXDeferredPlugin> deferredPlugins; // plug-ins registered from the registry cache and not described yet, by ID and major version
+    std::list<OFX::Host::PluginBinary*> describedBinaries; // binaries loaded to describe deferred plug-ins, owned by the host
+    QMutex pluginsDescriptionMutex; // protects deferredPlugins and describedBinaries
 
     OfxHostPrivate()
         : imageEffectPluginCache()
@@ -170,6 +220,10 @@ struct OfxHostPrivate
         , loadingPluginID()
         , loadingPluginVersionMajor(0)
         , loadingPluginVersionMinor(0)
+        , binariesStamps()
+        , deferredPlugins()
+        , describedBinaries()
+        , pluginsDescriptionMutex()
     {
     }
 };
@@ -184,6 +238,9 @@ OfxHost::~OfxHost()
 {
     //Clean up, to be polite.
     OFX::Host::PluginCache::clearPluginCache();
+    for (std::list<OFX::Host::PluginBinary*>::iterator it = _imp->describedBinaries.begin(); it != _imp->describedBinaries.end(); ++it) {
+        delete *it;
+    }
 
 #ifdef MULTI_THREAD_SUITE_USES_THREAD_SAFE_MUTEX_ALLOCATION
     delete _imp->pluginsMutexesLock;
@@ -772,6 +829,17 @@ getCacheFilePath()
     return ofxCacheFilePath;
 }
 
+///Return the binary registry cache, next to the xml cache so that it is cleared along with it
+static QString
+getRegistryFilePath()
+{
+    QString ofxCacheFilePath = getCacheFilePath();
+
+    ofxCacheFilePath.chop(4); // ".xml"
+
+    return ofxCacheFilePath + QString::fromUtf8(".registry");
+}
+
 
 static void
 getPluginShortcuts(const OFX::Host::ImageEffect::Descriptor& desc, std::list<PluginActionShortcut>* shortcuts)
@@ -842,6 +910,303 @@ getPluginShortcuts(const OFX::Host::ImageEffect::Descriptor& desc, std::list<Plu
     }
 }
 
+///Stamps the binaries of the bundles found in the given directory, the same way the OpenFX plug-in cache
+///scans it: the bundles are not walked, only the binary of each architecture is looked for
+static void
+appendOFXBundlesStamps(const QString& dirPath,
+                       std::vector<OFXBinaryStamp>* stamps)
+{
+    QDir dir(dirPath);
+    QFileInfoList entries = dir.entryInfoList(QDir::Dirs | QDir::NoDotAndDotDot);
+
+    for (QFileInfoList::const_iterator it = entries.begin(); it != entries.end(); ++it) {
+        QString name = it->fileName();
+        if ( !name.endsWith( QString::fromUtf8(".ofx.bundle") ) ) {
+            appendOFXBundlesStamps(it->absoluteFilePath(), stamps);
+            continue;
+        }
+        // <bundle>/Contents/<architecture>/<name without .bundle>
+        QString binaryName = name.left(name.size() - 7);
+        QDir contents( it->absoluteFilePath() + QString::fromUtf8("/Contents") );
+        QStringList architectures = contents.entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+        for (QStringList::const_iterator arch = architectures.begin(); arch != architectures.end(); ++arch) {
+            QFileInfo info( contents.absolutePath() + QLatin1Char('/') + *arch + QLatin1Char('/') + binaryName );
+            if ( !info.exists() ) {
+                continue;
+            }
+            OFXBinaryStamp stamp;
+            stamp.filePath = info.absoluteFilePath();
+            stamp.lastModified = info.lastModified().toMSecsSinceEpoch();
+            stamp.size = info.size();
+            stamps->push_back(stamp);
+        }
+    }
+}
+
+static void
+getOFXBinariesStamps(const std::list<std::string>& pluginPath,
+                     std::vector<OFXBinaryStamp>* stamps)
+{
+    // This only stats the binaries, they are not opened
+    for (std::list<std::string>::const_iterator it = pluginPath.begin(); it != pluginPath.end(); ++it) {
+        appendOFXBundlesStamps(QString::fromUtf8( it->c_str() ), stamps);
+    }
+    std::sort( stamps->begin(), stamps->end() );
+}
+
+/**
+ * @brief Everything needed to register an OpenFX plug-in in the application without its OpenFX description.
+ * These are stored in the OpenFX registry cache.
+ **/
+struct OFXPluginRegistryEntry
+{
+    QString pluginID;
+    QString pluginLabel;
+    QString binaryFilePath; // loaded when the plug-in is first used
+    QString bundlePath;
+    QString resourcesPath;
+    QString iconFilePath;
+    QStringList grouping;
+    QStringList groupIconsFilePath;
+    int versionMajor;
+    int versionMinor;
+    bool isReader;
+    bool isWriter;
+    bool isDeprecated;
+    bool isRenderUnsafe;
+    int openGLSupport; // PluginOpenGLRenderSupport
+    std::list<PluginActionShortcut> shortcuts;
+    std::vector<std::string> formats; // extensions supported by readers and writers
+    double evaluation;
+
+    OFXPluginRegistryEntry()
+        : pluginID()
+        , pluginLabel()
+        , binaryFilePath()
+        , bundlePath()
+        , resourcesPath()
+        , iconFilePath()
+        , grouping()
+        , groupIconsFilePath()
+        , versionMajor(0)
+        , versionMinor(0)
+        , isReader(false)
+        , isWriter(false)
+        , isDeprecated(false)
+        , isRenderUnsafe(false)
+        , openGLSupport(ePluginOpenGLRenderSupportNone)
+        , shortcuts()
+        , formats()
+        , evaluation(0.)
+    {
+    }
+};
+
+static QDataStream&
+operator<<(QDataStream& stream,
+           const OFXPluginRegistryEntry& entry)
+{
+    stream << entry.pluginID << entry.pluginLabel << entry.binaryFilePath << entry.bundlePath << entry.resourcesPath << entry.iconFilePath
+           << entry.grouping << entry.groupIconsFilePath
+           << (qint32)entry.versionMajor << (qint32)entry.versionMinor
+           << entry.isReader << entry.isWriter << entry.isDeprecated << entry.isRenderUnsafe
+           << (qint32)entry.openGLSupport;
+    stream << (quint32)entry.shortcuts.size();
+    for (std::list<PluginActionShortcut>::const_iterator it = entry.shortcuts.begin(); it != entry.shortcuts.end(); ++it) {
+        stream << QString::fromUtf8( it->actionID.c_str() ) << QString::fromUtf8( it->actionLabel.c_str() )
+               << (qint32)it->key << (qint32)it->modifiers;
+    }
+    stream << (quint32)entry.formats.size();
+    for (std::size_t i = 0; i < entry.formats.size(); ++i) {
+        stream << QString::fromUtf8( entry.formats[i].c_str() );
+    }
+    stream << entry.evaluation;
+
+    return stream;
+}
+
+static QDataStream&
+operator>>(QDataStream& stream,
+           OFXPluginRegistryEntry& entry)
+{
+    qint32 versionMajor, versionMinor, openGLSupport;
+
+    stream >> entry.pluginID >> entry.pluginLabel >> entry.binaryFilePath >> entry.bundlePath >> entry.resourcesPath >> entry.iconFilePath
+           >> entry.grouping >> entry.groupIconsFilePath
+           >> versionMajor >> versionMinor
+           >> entry.isReader >> entry.isWriter >> entry.isDeprecated >> entry.isRenderUnsafe
+           >> openGLSupport;
+    entry.versionMajor = versionMajor;
+    entry.versionMinor = versionMinor;
+    entry.openGLSupport = openGLSupport;
+
+    quint32 nShortcuts = 0;
+    stream >> nShortcuts;
+    for (quint32 i = 0; i < nShortcuts && stream.status() == QDataStream::Ok; ++i) {
+        QString actionID, actionLabel;
+        qint32 key, modifiers;
+        stream >> actionID >> actionLabel >> key >> modifiers;
+        entry.shortcuts.push_back( PluginActionShortcut( actionID.toStdString(), actionLabel.toStdString(), (Key)key, KeyboardModifiers( QFlag(modifiers) ) ) );
+    }
+
+    quint32 nFormats = 0;
+    stream >> nFormats;
+    for (quint32 i = 0; i < nFormats && stream.status() == QDataStream::Ok; ++i) {
+        QString format;
+        stream >> format;
+        entry.formats.push_back( format.toStdString() );
+    }
+    stream >> entry.evaluation;
+
+    return stream;
+}
+
+static void
+makeRegistryEntry(OFX::Host::ImageEffect::ImageEffectPlugin* p,
+                  OFXPluginRegistryEntry* entry)
+{
+    std::string openfxId = p->getIdentifier();
+    const std::string & grouping = p->getDescriptor().getPluginGrouping();
+    const std::string & bundlePath = p->getBinary()->getBundlePath();
+    std::string pluginLabel = OfxEffectInstance::makePluginLabel( p->getDescriptor().getShortLabel(),
+                                                                  p->getDescriptor().getLabel(),
+                                                                  p->getDescriptor().getLongLabel() );
+    QStringList groups = OfxEffectInstance::makePluginGrouping(p->getIdentifier(),
+                                                               p->getVersionMajor(), p->getVersionMinor(),
+                                                               pluginLabel, grouping);
+    for (int i = 0; i < groups.size(); ++i) {
+        groups[i] = groups[i].trimmed();
+    }
+
+    const std::string resourcesPathStr(bundlePath + "/Contents/Resources/");
+    QString resourcesPath = QString::fromUtf8( resourcesPathStr.c_str() );
+    QString iconFileName;
+    std::string pngIcon;
+    try {
+        // kOfxPropIcon is normally only defined for parameter desctriptors
+        // (see <http://openfx.sourceforge.net/Documentation/1.3/ofxProgrammingReference.html#ParameterProperties>)
+        // but let's assume it may also be defained on the plugin descriptor.
+        pngIcon = p->getDescriptor().getProps().getStringProperty(kOfxPropIcon, 1); // dimension 1 is PNG icon
+    } catch (OFX::Host::Property::Exception) {
+    }
+
+    if ( pngIcon.empty() ) {
+        // no icon defined by kOfxPropIcon, use the default value
+        pngIcon = openfxId + ".png";
+    }
+    iconFileName.append(resourcesPath);
+    iconFileName.append( QString::fromUtf8( pngIcon.c_str() ) );
+    QString groupIconFilename;
+    if (groups.size() > 0) {
+        groupIconFilename = resourcesPath;
+        // the plugin grouping has no descriptor, just try the default filename.
+        groupIconFilename.append(groups[0]);
+        groupIconFilename.append( QString::fromUtf8(".png") );
+    } else {
+        //Use default Misc group when the plug-in doesn't belong to a group
+        groups.push_back( QString::fromUtf8(PLUGIN_GROUP_DEFAULT) );
+    }
+    QStringList groupIcons;
+    groupIcons << groupIconFilename;
+    for (int i = 1; i < groups.size(); ++i) {
+        QString groupIconPath = resourcesPath;
+        for (int j = 0; j <= i; ++j) {
+            groupIconPath += groups[j];
+            if (j < i) {
+                groupIconPath += QLatin1Char('/');
+            } else {
+                groupIconPath.append( QString::fromUtf8(".png") );
+            }
+        }
+        groupIcons << groupIconPath;
+    }
+
+    const std::set<std::string> & contexts = p->getContexts();
+
+    entry->pluginID = QString::fromUtf8( openfxId.c_str() );
+    entry->pluginLabel = QString::fromUtf8( pluginLabel.c_str() );
+    entry->binaryFilePath = QString::fromUtf8( p->getBinary()->getFilePath().c_str() );
+    entry->bundlePath = QString::fromUtf8( bundlePath.c_str() );
+    entry->resourcesPath = resourcesPath;
+    entry->iconFilePath = iconFileName;
+    entry->grouping = groups;
+    entry->groupIconsFilePath = groupIcons;
+    entry->versionMajor = p->getVersionMajor();
+    entry->versionMinor = p->getVersionMinor();
+    entry->isReader = contexts.find(kOfxImageEffectContextReader) != contexts.end();
+    entry->isWriter = contexts.find(kOfxImageEffectContextWriter) != contexts.end();
+    entry->isDeprecated = p->getDescriptor().isDeprecated();
+    entry->isRenderUnsafe = p->getDescriptor().getRenderThreadSafety() == kOfxImageEffectRenderUnsafe;
+
+    PluginOpenGLRenderSupport glSupport = ePluginOpenGLRenderSupportNone;
+    {
+        const std::string& str = p->getDescriptor().getProps().getStringProperty(kOfxImageEffectPropOpenGLRenderSupported);
+        if (str == "false") {
+            glSupport = ePluginOpenGLRenderSupportNone;
+        } else if (str == "needed") {
+            glSupport = ePluginOpenGLRenderSupportNeeded;
+        } else if (str == "true") {
+            glSupport = ePluginOpenGLRenderSupportYes;
+        }
+    }
+    entry->openGLSupport = glSupport;
+
+    getPluginShortcuts(p->getDescriptor(), &entry->shortcuts);
+
+    ///if this plugin's descriptor has the kTuttleOfxImageEffectPropSupportedExtensions property,
+    ///use it to fill the readersMap and writersMap
+    int formatsCount = p->getDescriptor().getProps().getDimension(kTuttleOfxImageEffectPropSupportedExtensions);
+    entry->formats.resize(formatsCount);
+    for (int k = 0; k < formatsCount; ++k) {
+        entry->formats[k] = p->getDescriptor().getProps().getStringProperty(kTuttleOfxImageEffectPropSupportedExtensions, k);
+        std::transform(entry->formats[k].begin(), entry->formats[k].end(), entry->formats[k].begin(), ::tolower);
+    }
+
+    entry->evaluation = p->getDescriptor().getProps().getDoubleProperty(kTuttleOfxImageEffectPropEvaluation);
+} // makeRegistryEntry
+
+static Plugin*
+registerOFXPlugin(const OFXPluginRegistryEntry& entry,
+                  IOPluginsMap* readersMap,
+                  IOPluginsMap* writersMap)
+{
+    std::string openfxId = entry.pluginID.toStdString();
+    Plugin* natronPlugin = appPTR->registerPlugin( entry.resourcesPath,
+                                                   entry.grouping,
+                                                   entry.pluginID,
+                                                   entry.pluginLabel,
+                                                   entry.iconFilePath,
+                                                   entry.groupIconsFilePath,
+                                                   entry.isReader,
+                                                   entry.isWriter,
+                                                   new LibraryBinary(LibraryBinary::eLibraryTypeBuiltin),
+                                                   entry.isRenderUnsafe,
+                                                   entry.versionMajor, entry.versionMinor, entry.isDeprecated );
+    bool isInternalOnly = openfxId == PLUGINID_OFX_ROTO;
+    if (isInternalOnly) {
+        natronPlugin->setForInternalUseOnly(true);
+    }
+
+    natronPlugin->setOpenGLRenderSupport( (PluginOpenGLRenderSupport)entry.openGLSupport );
+    natronPlugin->setShorcuts(entry.shortcuts);
+
+    if (!entry.isDeprecated && entry.isReader && !entry.formats.empty() && readersMap) {
+        ///we're safe to assume that this plugin is a reader
+        for (std::size_t k = 0; k < entry.formats.size(); ++k) {
+            IOPluginSetForFormat& evalForFormat = (*readersMap)[entry.formats[k]];
+            evalForFormat.insert( IOPluginEvaluation(openfxId, entry.evaluation) );
+        }
+    } else if (!entry.isDeprecated && entry.isWriter && !entry.formats.empty() && writersMap) {
+        ///we're safe to assume that this plugin is a writer.
+        for (std::size_t k = 0; k < entry.formats.size(); ++k) {
+            IOPluginSetForFormat& evalForFormat = (*writersMap)[entry.formats[k]];
+            evalForFormat.insert( IOPluginEvaluation(openfxId, entry.evaluation) );
+        }
+    }
+
+    return natronPlugin;
+} // registerOFXPlugin
+
 static inline
 QDebug operator<<(QDebug dbg, const std::list<std::string> &l)
 {
@@ -904,6 +1269,56 @@ OfxHost::loadOFXPlugins(IOPluginsMap* readersMap,
         // ignore
     }
 
+    qDebug() << "Load OFX Plugins: plugin path is" << pluginCache->getPluginPath();
+
+    // If no plug-in binary changed since the registry cache was written, register the plug-ins from it:
+    // their OpenFX descriptions are only read the first time one of them is used.
+    _imp->binariesStamps.clear();
+    getOFXBinariesStamps(pluginCache->getPluginPath(), &_imp->binariesStamps);
+    if ( readOFXRegistry(readersMap, writersMap) ) {
+        qDebug() << "Load OFX Plugins: registered from the registry cache, descriptions are deferred";
+        qDebug() << "Load OFX Plugins... done!";
+
+        return;
+    }
+
+    describeOFXPlugins();
+
+    /*Filling node name list and plugin grouping*/
+    typedef std::map<OFX::Host::ImageEffect::MajorPlugin, OFX::Host::ImageEffect::ImageEffectPlugin *> PMap;
+    const PMap& ofxPlugins =
+        _imp->imageEffectPluginCache->getPluginsByIDMajor();
+    std::list<OFXPluginRegistryEntry> registry;
+
+    for (PMap::const_iterator it = ofxPlugins.begin();
+         it != ofxPlugins.end(); ++it) {
+        OFX::Host::ImageEffect::ImageEffectPlugin* p = it->second;
+        assert(p);
+        if (p->getContexts().size() == 0) {
+            continue;
+        }
+        assert( p->getBinary() );
+        if ( !p->getBinary() ) {
+            continue;
+        }
+
+        registry.push_back( OFXPluginRegistryEntry() );
+        makeRegistryEntry( p, &registry.back() );
+
+        Plugin* natronPlugin = registerOFXPlugin(registry.back(), readersMap, writersMap);
+        natronPlugin->setOfxPlugin(p);
+    }
+
+    writeOFXRegistry(registry);
+    qDebug() << "Load OFX Plugins... done!";
+} // loadOFXPlugins
+
+void
+OfxHost::describeOFXPlugins()
+{
+    OFX::Host::PluginCache* pluginCache = OFX::Host::PluginCache::getPluginCache();
+    assert(pluginCache);
+
     // The cache location depends on the OS.
     // On OSX, it will be ~/Library/Caches/<organization>/<application>/OFXLoadCache/
     //on Linux ~/.cache/<organization>/<application>/OFXLoadCache/
@@ -927,8 +1342,7 @@ OfxHost::loadOFXPlugins(IOPluginsMap* readersMap,
             }
         }
     }
-    
-    qDebug() << "Load OFX Plugins: plugin path is" << pluginCache->getPluginPath();
+
     qDebug() << "Load OFX Plugins: scan plugins...";
     pluginCache->scanPluginFiles();
     qDebug() << "Load OFX Plugins: scan plugins... done!";
@@ -941,148 +1355,175 @@ OfxHost::loadOFXPlugins(IOPluginsMap* readersMap,
         writeOFXCache();
         qDebug() << "Load OFX Plugins: writing cache file... done!";
     }
+} // describeOFXPlugins
 
-    /*Filling node name list and plugin grouping*/
-    typedef std::map<OFX::Host::ImageEffect::MajorPlugin, OFX::Host::ImageEffect::ImageEffectPlugin *> PMap;
-    const PMap& ofxPlugins =
-        _imp->imageEffectPluginCache->getPluginsByIDMajor();
+void
+OfxHost::ensurePluginDescribed(const std::string& pluginID,
+                               int versionMajor)
+{
+    QMutexLocker k(&_imp->pluginsDescriptionMutex);
+    std::map<std::pair<std::string, int>, OFXDeferredPlugin>::iterator found = _imp->deferredPlugins.find( std::make_pair(pluginID, versionMajor) );
 
+    if ( found == _imp->deferredPlugins.end() ) {
+        return;
+    }
+    OFXDeferredPlugin requested = found->second;
+    _imp->deferredPlugins.erase(found);
 
-    for (PMap::const_iterator it = ofxPlugins.begin();
-         it != ofxPlugins.end(); ++it) {
-        OFX::Host::ImageEffect::ImageEffectPlugin* p = it->second;
-        assert(p);
-        if (p->getContexts().size() == 0) {
-            continue;
-        }
-        assert( p->getBinary() );
-        if ( !p->getBinary() ) {
-            continue;
-        }
+    // Only load the binary of the plug-in: the other plug-ins it contains are described along
+    qDebug() << "Load OFX Plugins: describing" << requested.binaryFilePath.c_str();
+    OFX::Host::PluginCache* pluginCache = OFX::Host::PluginCache::getPluginCache();
+    assert(pluginCache);
+    OFX::Host::PluginBinary* binary = 0;
+    try {
+        binary = new OFX::Host::PluginBinary(requested.binaryFilePath, requested.bundlePath, pluginCache);
+    } catch (const std::exception& e) {
+        appPTR->writeToErrorLog_mt_safe( QLatin1String("OpenFX"), QDateTime::currentDateTime(),
+                                         tr("Failure to load %1: %2").arg( QString::fromUtf8( requested.binaryFilePath.c_str() ) ).arg( QString::fromUtf8( e.what() ) ) );
+    }
+    _imp->loadingPluginID.clear(); // finished loading plugins
+    if (binary) {
+        _imp->describedBinaries.push_back(binary);
+        for (int i = 0; i < binary->getNPlugins(); ++i) {
+            OFX::Host::Plugin& plug = binary->getPlugin(i);
+            OFX::Host::APICache::PluginAPICacheI* api = plug.getApiHandler();
+            std::string reason;
+            if ( !api || !api->pluginSupported(&plug, reason) ) {
+                continue;
+            }
+            api->loadFromPlugin(&plug);
+            api->confirmPlugin(&plug);
 
-        std::string openfxId = p->getIdentifier();
-        const std::string & grouping = p->getDescriptor().getPluginGrouping();
-        const std::string & bundlePath = p->getBinary()->getBundlePath();
-        std::string pluginLabel = OfxEffectInstance::makePluginLabel( p->getDescriptor().getShortLabel(),
-                                                                      p->getDescriptor().getLabel(),
-                                                                      p->getDescriptor().getLongLabel() );
-        QStringList groups = OfxEffectInstance::makePluginGrouping(p->getIdentifier(),
-                                                                   p->getVersionMajor(), p->getVersionMinor(),
-                                                                   pluginLabel, grouping);
-        for (int i = 0; i < groups.size(); ++i) {
-            groups[i] = groups[i].trimmed();
+            OFX::Host::ImageEffect::ImageEffectPlugin* p = dynamic_cast<OFX::Host::ImageEffect::ImageEffectPlugin*>(&plug);
+            if ( !p || p->getContexts().empty() ) {
+                continue;
+            }
+            std::pair<std::string, int> key( p->getIdentifier(), p->getVersionMajor() );
+            if ( key == std::make_pair(pluginID, versionMajor) ) {
+                requested.plugin->setOfxPlugin(p);
+                continue;
+            }
+            std::map<std::pair<std::string, int>, OFXDeferredPlugin>::iterator other = _imp->deferredPlugins.find(key);
+            if ( other != _imp->deferredPlugins.end() ) {
+                other->second.plugin->setOfxPlugin(p);
+                other->second.plugin->setOfxPluginDeferred(false);
+                _imp->deferredPlugins.erase(other);
+            }
         }
+    }
 
-        const std::string resourcesPathStr(bundlePath + "/Contents/Resources/");
-        QString resourcesPath = QString::fromUtf8( resourcesPathStr.c_str() );
-        QString iconFileName;
-        std::string pngIcon;
-        try {
-            // kOfxPropIcon is normally only defined for parameter desctriptors
-            // (see <http://openfx.sourceforge.net/Documentation/1.3/ofxProgrammingReference.html#ParameterProperties>)
-            // but let's assume it may also be defained on the plugin descriptor.
-            pngIcon = p->getDescriptor().getProps().getStringProperty(kOfxPropIcon, 1); // dimension 1 is PNG icon
-        } catch (OFX::Host::Property::Exception) {
-        }
+    // If the binary did not describe it, creating the plug-in reports that it could not be loaded
+    requested.plugin->setOfxPluginDeferred(false);
+} // ensurePluginDescribed
 
-        if ( pngIcon.empty() ) {
-            // no icon defined by kOfxPropIcon, use the default value
-            pngIcon = openfxId + ".png";
-        }
-        iconFileName.append(resourcesPath);
-        iconFileName.append( QString::fromUtf8( pngIcon.c_str() ) );
-        QString groupIconFilename;
-        if (groups.size() > 0) {
-            groupIconFilename = resourcesPath;
-            // the plugin grouping has no descriptor, just try the default filename.
-            groupIconFilename.append(groups[0]);
-            groupIconFilename.append( QString::fromUtf8(".png") );
-        } else {
-            //Use default Misc group when the plug-in doesn't belong to a group
-            groups.push_back( QString::fromUtf8(PLUGIN_GROUP_DEFAULT) );
-        }
-        QStringList groupIcons;
-        groupIcons << groupIconFilename;
-        for (int i = 1; i < groups.size(); ++i) {
-            QString groupIconPath = resourcesPath;
-            for (int j = 0; j <= i; ++j) {
-                groupIconPath += groups[j];
-                if (j < i) {
-                    groupIconPath += QLatin1Char('/');
-                } else {
-                    groupIconPath.append( QString::fromUtf8(".png") );
-                }
-            }
-            groupIcons << groupIconPath;
-        }
+bool
+OfxHost::readOFXRegistry(IOPluginsMap* readersMap,
+                         IOPluginsMap* writersMap)
+{
+    QFile file( getRegistryFilePath() );
+
+    if ( !file.open(QIODevice::ReadOnly) ) {
+        return false;
+    }
+    qint64 fileSize = file.size();
+    uchar* data = file.map(0, fileSize);
+    if (!data) {
+        return false;
+    }
 
-        const std::set<std::string> & contexts = p->getContexts();
-        std::set<std::string>::const_iterator foundReader = contexts.find(kOfxImageEffectContextReader);
-        std::set<std::string>::const_iterator foundWriter = contexts.find(kOfxImageEffectContextWriter);
-        const bool isDeprecated = p->getDescriptor().isDeprecated();
-        Plugin* natronPlugin = appPTR->registerPlugin( resourcesPath,
-                                                       groups,
-                                                       QString::fromUtf8( openfxId.c_str() ),
-                                                       QString::fromUtf8( pluginLabel.c_str() ),
-                                                       iconFileName,
-                                                       groupIcons,
-                                                       foundReader != contexts.end(),
-                                                       foundWriter != contexts.end(),
-                                                       new LibraryBinary(LibraryBinary::eLibraryTypeBuiltin),
-                                                       p->getDescriptor().getRenderThreadSafety() == kOfxImageEffectRenderUnsafe,
-                                                       p->getVersionMajor(), p->getVersionMinor(), isDeprecated );
-        bool isInternalOnly = openfxId == PLUGINID_OFX_ROTO;
-        if (isInternalOnly) {
-            natronPlugin->setForInternalUseOnly(true);
+    // Read the entries straight from the mapped file
+    QByteArray bytes = QByteArray::fromRawData(reinterpret_cast<const char*>(data), (int)fileSize);
+    QDataStream stream(bytes);
+    stream.setVersion(QDataStream::Qt_4_8);
+
+    quint32 magic = 0, version = 0;
+    QString cacheVersion;
+    stream >> magic >> version >> cacheVersion;
+    bool valid = stream.status() == QDataStream::Ok && magic == NATRON_OFX_REGISTRY_MAGIC && version == NATRON_OFX_REGISTRY_VERSION &&
+                 cacheVersion == QString::fromUtf8(NATRON_APPLICATION_NAME "OFXCachev1");
+
+    // The registry is stale if any plug-in binary was added, removed or modified
+    if (valid) {
+        quint32 nStamps = 0;
+        stream >> nStamps;
+        valid = stream.status() == QDataStream::Ok && nStamps == _imp->binariesStamps.size();
+        for (quint32 i = 0; valid && i < nStamps; ++i) {
+            OFXBinaryStamp stamp;
+            stream >> stamp.filePath >> stamp.lastModified >> stamp.size;
+            valid = stream.status() == QDataStream::Ok && stamp == _imp->binariesStamps[i];
         }
+    }
 
-        PluginOpenGLRenderSupport glSupport = ePluginOpenGLRenderSupportNone;
-        {
-            const std::string& str = p->getDescriptor().getProps().getStringProperty(kOfxImageEffectPropOpenGLRenderSupported);
-            if (str == "false") {
-                glSupport = ePluginOpenGLRenderSupportNone;
-            } else if (str == "needed") {
-                glSupport = ePluginOpenGLRenderSupportNeeded;
-            } else if (str == "true") {
-                glSupport = ePluginOpenGLRenderSupportYes;
-            }
+    std::list<OFXPluginRegistryEntry> registry;
+    if (valid) {
+        quint32 nEntries = 0;
+        stream >> nEntries;
+        for (quint32 i = 0; i < nEntries && stream.status() == QDataStream::Ok; ++i) {
+            registry.push_back( OFXPluginRegistryEntry() );
+            stream >> registry.back();
         }
-        natronPlugin->setOpenGLRenderSupport(glSupport);
+        valid = stream.status() == QDataStream::Ok && registry.size() == nEntries;
+    }
+    file.unmap(data);
 
-        natronPlugin->setOfxPlugin(p);
+    if (!valid) {
+        qDebug() << "Load OFX Plugins: the registry cache is out of date";
 
-        std::list<PluginActionShortcut> shortcuts;
-        getPluginShortcuts(p->getDescriptor(), &shortcuts);
-        natronPlugin->setShorcuts(shortcuts);
-
-        ///if this plugin's descriptor has the kTuttleOfxImageEffectPropSupportedExtensions property,
-        ///use it to fill the readersMap and writersMap
-        int formatsCount = p->getDescriptor().getProps().getDimension(kTuttleOfxImageEffectPropSupportedExtensions);
-        std::vector<std::string> formats(formatsCount);
-        for (int k = 0; k < formatsCount; ++k) {
-            formats[k] = p->getDescriptor().getProps().getStringProperty(kTuttleOfxImageEffectPropSupportedExtensions, k);
-            std::transform(formats[k].begin(), formats[k].end(), formats[k].begin(), ::tolower);
-        }
+        return false;
+    }
 
-        double evaluation = p->getDescriptor().getProps().getDoubleProperty(kTuttleOfxImageEffectPropEvaluation);
+    QMutexLocker k(&_imp->pluginsDescriptionMutex);
+    _imp->deferredPlugins.clear();
+    for (std::list<OFXPluginRegistryEntry>::const_iterator it = registry.begin(); it != registry.end(); ++it) {
+        Plugin* natronPlugin = registerOFXPlugin(*it, readersMap, writersMap);
+        natronPlugin->setOfxPluginDeferred(true);
+        OFXDeferredPlugin& deferred = _imp->deferredPlugins[std::make_pair(it->pluginID.toStdString(), it->versionMajor)];
+        deferred.plugin = natronPlugin;
+        deferred.binaryFilePath = it->binaryFilePath.toStdString();
+        deferred.bundlePath = it->bundlePath.toStdString();
+    }
 
+    return true;
+} // readOFXRegistry
 
-        if (!isDeprecated && ( foundReader != contexts.end() ) && (formatsCount > 0) && readersMap) {
-            ///we're safe to assume that this plugin is a reader
-            for (std::size_t k = 0; k < formats.size(); ++k) {
-                IOPluginSetForFormat& evalForFormat = (*readersMap)[formats[k]];
-                evalForFormat.insert( IOPluginEvaluation(openfxId, evaluation) );
-            }
-        } else if (!isDeprecated && ( foundWriter != contexts.end() ) && (formatsCount > 0) && writersMap) {
-            ///we're safe to assume that this plugin is a writer.
-            for (std::size_t k = 0; k < formats.size(); ++k) {
-                IOPluginSetForFormat& evalForFormat = (*writersMap)[formats[k]];
-                evalForFormat.insert( IOPluginEvaluation(openfxId, evaluation) );
-            }
+void
+OfxHost::writeOFXRegistry(const std::list<OFXPluginRegistryEntry>& registry)
+{
+    QString ofxCachePath = getOFXCacheDirPath();
+    QDir().mkpath(ofxCachePath);
+    QString registryFilePath = getRegistryFilePath();
+    QString tmpFileName = registryFilePath + QString::fromUtf8(".tmp");
+
+    {
+        QFile file(tmpFileName);
+        if ( !file.open(QIODevice::WriteOnly | QIODevice::Truncate) ) {
+            return;
+        }
+        QDataStream stream(&file);
+        stream.setVersion(QDataStream::Qt_4_8);
+        stream << (quint32)NATRON_OFX_REGISTRY_MAGIC << (quint32)NATRON_OFX_REGISTRY_VERSION
+               << QString::fromUtf8(NATRON_APPLICATION_NAME "OFXCachev1");
+        stream << (quint32)_imp->binariesStamps.size();
+        for (std::size_t i = 0; i < _imp->binariesStamps.size(); ++i) {
+            const OFXBinaryStamp& stamp = _imp->binariesStamps[i];
+            stream << stamp.filePath << stamp.lastModified << stamp.size;
+        }
+        stream << (quint32)registry.size();
+        for (std::list<OFXPluginRegistryEntry>::const_iterator it = registry.begin(); it != registry.end(); ++it) {
+            stream << *it;
+        }
+        if (stream.status() != QDataStream::Ok) {
+            file.close();
+            QFile::remove(tmpFileName);
+
+            return;
         }
     }
-    qDebug() << "Load OFX Plugins... done!";
-} // loadOFXPlugins
+    if ( QFile::exists(registryFilePath) ) {
+        QFile::remove(registryFilePath);
+    }
+    QFile::rename(tmpFileName, registryFilePath);
+} // writeOFXRegistry
 
 void
 OfxHost::writeOFXCache()
@@ -1232,16 +1673,21 @@ threadFunctionWrapper(OfxThreadFunctionV1 func,
     }
 
     OfxStatus ret = kOfxStatOK;
-    try {
+    // Abort checkpoint: the result of an aborted render is discarded, do not start the work of this thread
+    if ( EffectInstance::isCurrentThreadRenderAborted() ) {
+        ret = kOfxStatFailed;
+    } else {
+        try {
 #ifdef DEBUG
-        // Uncomment if using plugins that generate FP exceptions
-        boost_adaptbx::floating_point::exception_trapping trap(0);
+            // Uncomment if using plugins that generate FP exceptions
+            boost_adaptbx::floating_point::exception_trapping trap(0);
 #endif
-        func(threadIndex, threadMax, customArg);
-    } catch (const std::bad_alloc & ba) {
-        ret =  kOfxStatErrMemory;
-    } catch (...) {
-        ret =  kOfxStatFailed;
+            func(threadIndex, threadMax, customArg);
+        } catch (const std::bad_alloc & ba) {
+            ret =  kOfxStatErrMemory;
+        } catch (...) {
+            ret =  kOfxStatFailed;
+        }
     }
 
     ///reset back the index otherwise it could mess up the indexes if the same thread is re-used
@@ -1291,12 +1737,15 @@ public:
         appPTR->getAppTLS()->softCopy(_spawnerThread, this);
 
         assert(*_stat == kOfxStatFailed);
-        try {
-            _func(_threadIndex, _threadMax, _customArg);
-            *_stat = kOfxStatOK;
-        } catch (const std::bad_alloc & ba) {
-            *_stat = kOfxStatErrMemory;
-        } catch (...) {
+        // Abort checkpoint: leave the status to kOfxStatFailed if the render was aborted before this thread started
+        if ( !EffectInstance::isCurrentThreadRenderAborted() ) {
+            try {
+                _func(_threadIndex, _threadMax, _customArg);
+                *_stat = kOfxStatOK;
+            } catch (const std::bad_alloc & ba) {
+                *_stat = kOfxStatErrMemory;
+            } catch (...) {
+            }
         }
 
         ///reset back the index otherwise it could mess up the indexes if the same thread is re-used
@@ -1347,6 +1796,10 @@ OfxHost::multiThread(OfxThreadFunctionV1 func,
     if ( (nThreads == 1) || (maxConcurrentThread <= 1) || (appPTR->getCurrentSettings()->getNumberOfThreads() == -1) ) {
         try {
             for (unsigned int i = 0; i < nThreads; ++i) {
+                // Abort checkpoint between the chunks of work
+                if ( EffectInstance::isCurrentThreadRenderAborted() ) {
+                    return kOfxStatFailed;
+                }
                 func(i, nThreads, customArg);
             }
 
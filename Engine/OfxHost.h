@@ -55,6 +55,7 @@ CLANG_DIAG_ON(unknown-pragmas)
 NATRON_NAMESPACE_ENTER
 
 struct OfxHostPrivate;
+struct OFXPluginRegistryEntry;
 class OfxHost
     : public OFX::Host::ImageEffect::Host
       , private OFX::Host::Property::GetHook
@@ -159,6 +160,13 @@ public:
 
     void clearPluginsLoadedCache();
 
+    /**
+     * @brief When the plug-ins were registered from the registry cache, their OpenFX descriptions
+     * are only loaded the first time each of them is used. This loads the binary of the given plug-in
+     * and describes the plug-ins it contains, if it was not done yet.
+     **/
+    void ensurePluginDescribed(const std::string& pluginID, int versionMajor);
+
     void setThreadAsActionCaller(OfxImageEffectInstance* instance, bool actionCaller);
 
     OFX::Host::ImageEffect::Descriptor* getPluginContextAndDescribe(OFX::Host::ImageEffect::ImageEffectPlugin* plugin,
@@ -193,6 +201,14 @@ private:
        the OFX plugin cache. (called by the destructor) */
     void writeOFXCache();
 
+    /*Reads the OFX plugin cache and scans the plugins directories to describe all plugins*/
+    void describeOFXPlugins();
+
+    /*Registers the plugins from the binary registry cache if no plugin binary changed since it was written*/
+    bool readOFXRegistry(IOPluginsMap* readersMap, IOPluginsMap* writersMap);
+
+    void writeOFXRegistry(const std::list<OFXPluginRegistryEntry>& registry);
+
     // get the virtuals for viewport size, pixel scale, background colour
     const std::string &getStringProperty(const std::string &name, int n) const OFX_EXCEPTION_SPEC OVERRIDE;
     std::unique_ptr<OfxHostPrivate> _imp;
@@ -436,12 +436,24 @@ OutputEffectInstance::reportStats(int time,
     for (std::map<NodePtr, NodeRenderStats >::const_iterator it = stats.begin(); it != stats.end(); ++it) {
         ofile << "------------------------------- " << it->first->getScriptName_mt_safe() << "------------------------------- " << std::endl;
         ofile << "Time spent rendering: " << Timer::printAsTime(it->second.getTotalTimeSpentRendering(), false).toStdString() << std::endl;
+        int nbShapes, nbShapesCached;
+        double shapesTime;
+        it->second.getShapeGeometryInfos(&nbShapes, &nbShapesCached, &shapesTime);
+        if (nbShapes > 0) {
+            ofile << "Time spent computing shapes geometry: " << Timer::printAsTime(shapesTime, false).toStdString()
+                  << " (" << nbShapesCached << " of " << nbShapes << " cached)" << std::endl;
+        }
         const RectD & rod = it->second.getRoD();
         ofile << "Region of definition: x1 = " << rod.x1  << " y1 = " << rod.y1 << " x2 = " << rod.x2 << " y2 = " << rod.y2 << std::endl;
         ofile << "Is Identity to Effect? ";
         NodePtr identity = it->second.getInputImageIdentity();
         if (identity) {
-            ofile << "Yes, to " << identity->getScriptName_mt_safe() << std::endl;
+            ofile << "Yes, to " << identity->getScriptName_mt_safe();
+            int nbElided = it->second.getNbPassThroughNodesElided();
+            if (nbElided > 0) {
+                ofile << " (collapsed " << nbElided << " pass-through node(s))";
+            }
+            ofile << std::endl;
         } else {
             ofile << "No" << std::endl;
         }
@@ -39,6 +39,7 @@
 #include <QtCore/QWaitCondition>
 #include <QtCore/QCoreApplication>
 #include <QtCore/QString>
+#include <QtCore/QStringList>
 #include <QtCore/QThreadPool>
 #include <QtCore/QDebug>
 #include <QtCore/QTextStream>
@@ -53,6 +54,7 @@
 #include "Engine/AppInstance.h"
 #include "Engine/EffectInstance.h"
 #include "Engine/Image.h"
+#include "Engine/KnobExpression.h"
 #include "Engine/KnobFile.h"
 #include "Engine/Node.h"
 #include "Engine/OpenGLViewerI.h"
@@ -155,6 +157,13 @@ struct ProducedFrameCompareAgeLess
 
 typedef std::set<ProducedFrame, ProducedFrameCompareAgeLess> ProducedFrameSet;
 
+///The memory reserved for a frame being rendered by a render thread
+struct AdmittedFrameMemory
+{
+    U64 bytes;
+    bool fromRequestPass; // false while bytes is the running estimate reserved when the frame was picked
+};
+
 class OutputSchedulerThreadExecMTArgs
     : public GenericThreadExecOnMainThreadArgs
 {
@@ -219,6 +228,13 @@ struct OutputSchedulerThreadPrivate
     ///Render threads wait in this condition and the scheduler wake them when it needs to render some frames
     QWaitCondition framesToRenderNotEmptyCond;
 
+    ///Memory admission control, protected by framesToRenderMutex.
+    ///For each render thread currently rendering a frame, the memory reserved for that frame
+    std::map<RenderThreadTask*, AdmittedFrameMemory> admittedFramesMemory;
+
+    ///Estimated peak memory of a frame (all views), computed from the request pass of the previous frames. 0 if not known yet
+    U64 frameMemoryEstimate;
+
 #endif
 
     ///Work queue filled by the scheduler thread when in playback/render on disk
@@ -268,6 +284,8 @@ struct OutputSchedulerThreadPrivate
         , allRenderThreadsQuitCond()
         , framesToRender()
         , framesToRenderNotEmptyCond()
+        , admittedFramesMemory()
+        , frameMemoryEstimate(0)
 #endif
         , framesToRenderMutex()
         , lastFramePushedIndex(0)
@@ -474,6 +492,52 @@ struct OutputSchedulerThreadPrivate
     }
 
 #ifndef NATRON_PLAYBACK_USES_THREAD_POOL
+    /**
+     * @brief Release the memory reserved by the frame rendered by the given thread and wake-up threads that may
+     * be waiting for memory to start rendering.
+     **/
+    void releaseFrameMemory(RenderThreadTask* thread)
+    {
+        ///Private, shouldn't lock
+        assert( !framesToRenderMutex.tryLock() );
+        std::map<RenderThreadTask*, AdmittedFrameMemory>::iterator found = admittedFramesMemory.find(thread);
+        if ( found != admittedFramesMemory.end() ) {
+            if (found->second.fromRequestPass) {
+                ///Increases were followed as soon as the views were requested, decrease the estimate slowly
+                ///so that a single cheap frame does not let too many expensive frames in at once
+                if (found->second.bytes < frameMemoryEstimate) {
+                    frameMemoryEstimate = (frameMemoryEstimate * 3 + found->second.bytes) / 4;
+                }
+            }
+            admittedFramesMemory.erase(found);
+            framesToRenderNotEmptyCond.wakeAll();
+        }
+    }
+
+    /**
+     * @brief Returns true if a new frame can be started without the projected peak memory of all frames
+     * being rendered exceeding the cache memory budget.
+     **/
+    bool canAdmitFrame() const
+    {
+        ///Private, shouldn't lock
+        assert( !framesToRenderMutex.tryLock() );
+
+        U64 reservedMemory = 0;
+        for (std::map<RenderThreadTask*, AdmittedFrameMemory>::const_iterator it = admittedFramesMemory.begin(); it != admittedFramesMemory.end(); ++it) {
+            reservedMemory += it->second.bytes;
+        }
+
+        ///While the estimate is not known, admit as many frames as there may be parallel renders
+        int maxParallelRenders = appPTR->getCurrentSettings()->getNumberOfParallelRenders();
+        if (maxParallelRenders == 0) {
+            maxParallelRenders = appPTR->getHardwareIdealThreadCount();
+        }
+
+        return OutputSchedulerThread::canAdmitFrame( admittedFramesMemory.size(), reservedMemory, frameMemoryEstimate,
+                                                     appPTR->getCachesMaximumMemorySize(), (std::size_t)std::max(1, maxParallelRenders) );
+    }
+
     void removeQuitRenderThreadsInternal()
     {
         for (;; ) {
@@ -820,11 +884,16 @@ OutputSchedulerThread::pickFrameToRender(RenderThreadTask* thread,
     }
 
 
+    const bool admissionControl = useMemoryAdmissionControl();
     bool gotFrame = false;
     int frame = -1;
     {
         QMutexLocker l(&_imp->framesToRenderMutex);
-        while ( _imp->framesToRender.empty() && !thread->mustQuit() ) {
+
+        ///The frame previously rendered by this thread is done, release its memory
+        _imp->releaseFrameMemory(thread);
+
+        while ( ( _imp->framesToRender.empty() || (admissionControl && !_imp->canAdmitFrame()) ) && !thread->mustQuit() ) {
             ///Notify that we're no longer doing work
             thread->notifyIsRunning(false);
 
@@ -839,6 +908,13 @@ OutputSchedulerThread::pickFrameToRender(RenderThreadTask* thread,
 
             _imp->framesToRender.pop_front();
 
+            if (admissionControl) {
+                ///Reserve the estimated memory until the request pass of this frame tells us more precisely
+                AdmittedFrameMemory& reserved = _imp->admittedFramesMemory[thread];
+                reserved.bytes = _imp->frameMemoryEstimate;
+                reserved.fromRequestPass = false;
+            }
+
             gotFrame = true;
         }
     }
@@ -867,8 +943,48 @@ OutputSchedulerThread::pickFrameToRender(RenderThreadTask* thread,
     }
 } // OutputSchedulerThread::pickFrameToRender
 
+void
+OutputSchedulerThread::notifyFrameMemoryEstimate(RenderThreadTask* thread,
+                                                 U64 estimatedBytes)
+{
+    QMutexLocker l(&_imp->framesToRenderMutex);
+    std::map<RenderThreadTask*, AdmittedFrameMemory>::iterator found = _imp->admittedFramesMemory.find(thread);
+
+    if ( found == _imp->admittedFramesMemory.end() ) {
+        return;
+    }
+
+    ///This is called once per view of the frame: the first request pass replaces the reservation made when the frame
+    ///was picked, the following ones add the memory of their view
+    if (found->second.fromRequestPass) {
+        found->second.bytes += estimatedBytes;
+    } else {
+        found->second.bytes = estimatedBytes;
+        found->second.fromRequestPass = true;
+    }
+
+    ///Follow increases of the peak memory immediately, decreases are applied when the frame is done
+    U64& estimate = _imp->frameMemoryEstimate;
+    if (found->second.bytes > estimate) {
+        estimate = found->second.bytes;
+    }
+#ifdef TRACE_SCHEDULER
+    qDebug() << "Parallel Render Thread: Frame memory estimate:" << estimatedBytes << "bytes, frame total:" << found->second.bytes << "bytes, running estimate:" << estimate << "bytes";
+#endif
+
+    ///The estimate may have changed, let threads waiting for memory re-evaluate
+    _imp->framesToRenderNotEmptyCond.wakeAll();
+}
+
 #else // NATRON_PLAYBACK_USES_THREAD_POOL
 
+void
+OutputSchedulerThread::notifyFrameMemoryEstimate(RenderThreadTask* /*thread*/,
+                                                 U64 /*estimatedBytes*/)
+{
+    // Tasks are started by the scheduler directly when using the thread pool, no admission control
+}
+
 void
 OutputSchedulerThread::startTasksFromLastStartedFrame()
 {
@@ -984,6 +1100,28 @@ OutputSchedulerThread::startTasks(int startingFrame)
 
 #endif //NATRON_PLAYBACK_USES_THREAD_POOL
 
+bool
+OutputSchedulerThread::canAdmitFrame(std::size_t nFramesRendering,
+                                     U64 reservedMemory,
+                                     U64 frameMemoryEstimate,
+                                     U64 memoryBudget,
+                                     std::size_t maxFramesWithUnknownEstimate)
+{
+    // Always let at least one frame render, otherwise a single frame bigger than the budget would stall the render
+    if (nFramesRendering == 0) {
+        return true;
+    }
+
+    // We do not know how much a frame needs, either because no request pass was done yet or because
+    // the frames do not allocate any image: bound the number of frames started blindly
+    if (frameMemoryEstimate == 0) {
+        return nFramesRendering < maxFramesWithUnknownEstimate;
+    }
+
+    // The images already in the cache are not subtracted from the budget: they are evicted as the frames allocate theirs
+    return reservedMemory + frameMemoryEstimate <= memoryBudget;
+}
+
 
 void
 OutputSchedulerThread::onThreadSpawnsTimerTriggered()
@@ -1009,6 +1147,12 @@ OutputSchedulerThread::onThreadSpawnsTimerTriggered()
 void
 OutputSchedulerThread::notifyThreadAboutToQuit(RenderThreadTask* thread)
 {
+#ifndef NATRON_PLAYBACK_USES_THREAD_POOL
+    {
+        QMutexLocker k(&_imp->framesToRenderMutex);
+        _imp->releaseFrameMemory(thread);
+    }
+#endif
     QMutexLocker l(&_imp->renderThreadsMutex);
     RenderThreads::iterator found = _imp->getRunnableIterator(thread);
 
@@ -1189,6 +1333,18 @@ OutputSchedulerThread::stopRender()
 
     bool wasAborted = isBeingAborted();
 
+    {
+        NativeKnobExpression::Stats exprStats = NativeKnobExpression::getStats(true);
+#ifdef DEBUG
+        if (exprStats.nativeEvaluations || exprStats.compiledEvaluations || exprStats.interpretedEvaluations) {
+            qDebug() << "Expressions evaluated natively:" << exprStats.nativeEvaluations
+                     << "by their Python function:" << exprStats.compiledEvaluations
+                     << "by the Python interpreter:" << exprStats.interpretedEvaluations;
+        }
+#else
+        Q_UNUSED(exprStats);
+#endif
+    }
 
     ///Notify everyone that the render is finished
     _imp->engine->s_renderFinished(wasAborted ? 1 : 0);
@@ -1566,6 +1722,24 @@ OutputSchedulerThread::notifyFrameRendered(int frame,
         std::map<NodePtr, NodeRenderStats > statResults = stats->getStats(&timeSpentForFrame);
         if ( !statResults.empty() ) {
             effect->reportStats(frame, viewIndex, timeSpentForFrame, statResults);
+
+            ///Send the statistics of each node to the ProcessHandler managing this process, if any, so that
+            ///it can merge the statistics of all the processes rendering the frame range
+            if ( appPTR->isManagedBackgroundProcess() ) {
+                for (std::map<NodePtr, NodeRenderStats >::const_iterator it = statResults.begin(); it != statResults.end(); ++it) {
+                    int nbCacheMisses, nbCacheHits, nbCacheHitButDownscaledImages;
+                    it->second.getCacheAccessInfos(&nbCacheMisses, &nbCacheHits, &nbCacheHitButDownscaledImages);
+                    QStringList fields;
+                    fields << QString::fromUtf8( it->first->getScriptName_mt_safe().c_str() )
+                           << QString::number(it->second.getTotalTimeSpentRendering(), 'g', 10)
+                           << QString::number(nbCacheMisses)
+                           << QString::number(nbCacheHits)
+                           << QString::number(nbCacheHitButDownscaledImages)
+                           << QString::number( (int)it->second.getRenderedRectangles().size() )
+                           << QString::number(it->second.getInputImageIdentity() ? 1 : 0);
+                    appPTR->writeToOutputPipe( QString(), QString::fromUtf8(kNodeRenderStatsStringShort) + fields.join( QLatin1String(";") ), false );
+                }
+            }
         }
     }
 
@@ -2140,6 +2314,11 @@ DefaultScheduler::DefaultScheduler(RenderEngine* engine,
     , _effect(effect)
     , _currentTimeMutex()
     , _currentTime(0)
+    , _pipelineTimingsMutex()
+    , _reportPipelineTimings(false)
+    , _renderStageTime(0.)
+    , _encodeStageTime(0.)
+    , _nbPipelinedFrames(0)
 {
     engine->setPlaybackMode(ePlaybackModeOnce);
 }
@@ -2148,6 +2327,68 @@ DefaultScheduler::~DefaultScheduler()
 {
 }
 
+bool
+DefaultScheduler::isEncodePipelined() const
+{
+    OutputEffectInstancePtr effect = _effect.lock();
+
+    if (!effect) {
+        return false;
+    }
+
+    // WriteNode::getSequentialPreference() returns the preference of the embedded writer
+    SequentialPreferenceEnum pref = effect->getSequentialPreference();
+
+    return (pref == eSequentialPreferenceOnlySequential) || (pref == eSequentialPreferencePreferSequential);
+}
+
+void
+DefaultScheduler::notifyRenderStageTime(double seconds)
+{
+    QMutexLocker k(&_pipelineTimingsMutex);
+
+    _renderStageTime += seconds;
+}
+
+NATRON_NAMESPACE_ANONYMOUS_ENTER
+
+/**
+ * @brief Estimates the peak memory needed to render a frame from the request pass: each node of the tree
+ * produces an image covering its final RoI at the mapped scale for each frame/view it is requested at.
+ * We assume 4 components since the request pass does not know the planes yet, which errs on the safe side.
+ **/
+U64
+estimateFrameMemoryFootprint(const FrameRequestMap& request)
+{
+    U64 ret = 0;
+
+    for (FrameRequestMap::const_iterator it = request.begin(); it != request.end(); ++it) {
+        if (!it->first || !it->second) {
+            continue;
+        }
+        EffectInstancePtr effect = it->first->getEffectInstance();
+        if (!effect) {
+            continue;
+        }
+        const U64 pixelSize = 4 * getSizeOfForBitDepth( effect->getBitDepth(-1) );
+        const double par = effect->getAspectRatio(-1);
+        for (NodeFrameViewRequestData::const_iterator it2 = it->second->frames.begin(); it2 != it->second->frames.end(); ++it2) {
+            const FrameViewRequest& fv = it2->second;
+            if ( fv.globalData.isIdentity || fv.finalData.finalRoi.isNull() ) {
+                // Identity nodes do not allocate any image
+                continue;
+            }
+            RectI pixelRoI = fv.finalData.finalRoi.toPixelEnclosing(it->second->mappedScale, par);
+            ret += (U64)pixelRoI.area() * pixelSize;
+        }
+    }
+
+    return ret;
+}
+
+NATRON_NAMESPACE_ANONYMOUS_EXIT
+
+
 class DefaultRenderFrameRunnable
     : public RenderThreadTask
 {
@@ -2252,7 +2493,6 @@ private:
             // it comes from Natron itself. All exceptions from plugins are already caught
             // by the HostSupport library.
             EffectInstancePtr activeInputToRender;
-            //if (renderDirectly) {
             activeInputToRender = output;
             WriteNode* isWriteNode = dynamic_cast<WriteNode*>( output.get() );
             if (isWriteNode) {
@@ -2262,12 +2502,15 @@ private:
                 }
             }
             assert(activeInputToRender);
-            NodePtr activeInputNode = activeInputToRender->getNode();
             U64 activeInputToRenderHash = isWriteNode ? isWriteNode->getHash() : activeInputToRender->getHash();
             const double par = activeInputToRender->getAspectRatio(-1);
             const bool isRenderDueToRenderInteraction = false;
             const bool isSequentialRender = true;
 
+            ///For sequential writers, only render the input of the writer here: the scheduler thread encodes frames in order
+            DefaultScheduler* defaultScheduler = dynamic_cast<DefaultScheduler*>(_imp->scheduler);
+            const bool encodePipelined = defaultScheduler && defaultScheduler->isEncodePipelined();
+
             for (std::size_t view = 0; view < viewsToRender.size(); ++view) {
                 StatusEnum stat = activeInputToRender->getRegionOfDefinition_public(activeInputToRenderHash, time, scale, viewsToRender[view], &rod, &isProjectFormat);
                 if (stat == eStatusFailed) {
@@ -2301,9 +2544,37 @@ private:
                 }
                 const RectI renderWindow = rod.toPixelEnclosing(scale, par);
 
+                EffectInstancePtr effectToRender = activeInputToRender;
+                RectD renderRoD = rod;
+                if (encodePipelined) {
+                    effectToRender = activeInputToRender->getInput(0);
+                    if (!effectToRender) {
+                        _imp->scheduler->notifyRenderFailure("The writer is not connected to any input");
+
+                        return;
+                    }
+
+                    // Render what the writer needs from its input, the writer itself is rendered in DefaultScheduler::processFrame
+                    components.clear();
+                    EffectInstance::ComponentsNeededMap::iterator foundInput = neededComps.find(0);
+                    if ( foundInput != neededComps.end() ) {
+                        components.insert( components.end(), foundInput->second.begin(), foundInput->second.end() );
+                    }
+                    imageDepth = activeInputToRender->getBitDepth(0);
+
+                    bool inputIsProjectFormat;
+                    stat = effectToRender->getRegionOfDefinition_public(effectToRender->getHash(), time, scale, viewsToRender[view], &renderRoD, &inputIsProjectFormat);
+                    if (stat == eStatusFailed) {
+                        _imp->scheduler->notifyRenderFailure("Error caught while rendering");
+
+                        return;
+                    }
+                }
+                NodePtr nodeToRender = effectToRender->getNode();
+
                 AbortableRenderInfoPtr abortInfo = AbortableRenderInfo::create(true, 0);
                 if (isAbortableThread) {
-                    isAbortableThread->setAbortInfo(isRenderDueToRenderInteraction, abortInfo, activeInputToRender);
+                    isAbortableThread->setAbortInfo(isRenderDueToRenderInteraction, abortInfo, effectToRender);
                 }
 
                 ParallelRenderArgsSetter frameRenderArgs(time,
@@ -2311,7 +2582,7 @@ private:
                                                          isRenderDueToRenderInteraction,  // is this render due to user interaction ?
                                                          isSequentialRender,
                                                          abortInfo, //abortInfo
-                                                         activeInputNode, // viewer requester
+                                                         nodeToRender, // viewer requester
                                                          0, //texture index
                                                          output->getApp()->getTimeLine().get(),
                                                          NodePtr(),
@@ -2321,15 +2592,16 @@ private:
 
                 {
                     FrameRequestMap request;
-                    stat = EffectInstance::computeRequestPass(time, viewsToRender[view], mipmapLevel, rod, activeInputNode, request);
+                    stat = EffectInstance::computeRequestPass(time, viewsToRender[view], mipmapLevel, rod, nodeToRender, request);
                     if (stat == eStatusFailed) {
                         _imp->scheduler->notifyRenderFailure("Error caught while rendering");
 
                         return;
                     }
                     frameRenderArgs.updateNodesRequest(request);
+                    _imp->scheduler->notifyFrameMemoryEstimate( this, estimateFrameMemoryFootprint(request) );
                 }
-                RenderingFlagSetter flagIsRendering( activeInputToRender->getNode() );
+                RenderingFlagSetter flagIsRendering(nodeToRender);
                 std::map<ImagePlaneDesc, ImagePtr> planes;
                 std::unique_ptr<EffectInstance::RenderRoIArgs> renderArgs( new EffectInstance::RenderRoIArgs(time, //< the time at which to render
                                                                                                                scale, //< the scale at which to render
@@ -2337,15 +2609,16 @@ private:
                                                                                                                viewsToRender[view], //< the view to render
                                                                                                                false,
                                                                                                                renderWindow, //< the region of interest (in pixel coordinates)
-                                                                                                               rod, // < any precomputed rod ? in canonical coordinates
+                                                                                                               renderRoD, // < any precomputed rod ? in canonical coordinates
                                                                                                                components,
                                                                                                                imageDepth,
                                                                                                                false,
-                                                                                                               activeInputToRender.get(),
+                                                                                                               effectToRender.get(),
                                                                                                                eStorageModeRAM,
                                                                                                                time) );
                 EffectInstance::RenderRoIRetCode retCode;
-                retCode = activeInputToRender->renderRoI(*renderArgs, &planes);
+                TimeLapse renderStageTimer;
+                retCode = effectToRender->renderRoI(*renderArgs, &planes);
                 if (retCode != EffectInstance::eRenderRoIRetCodeOk) {
                     if (retCode == EffectInstance::eRenderRoIRetCodeAborted) {
                         _imp->scheduler->notifyRenderFailure("Render aborted");
@@ -2356,14 +2629,20 @@ private:
                     return;
                 }
 
-                ///If we need sequential rendering, pass the image to the output scheduler that will ensure the sequential ordering
-                /*if (!renderDirectly) {
-                    for (std::map<ImagePlaneDesc,ImagePtr>::iterator it = planes.begin(); it != planes.end(); ++it) {
-                        _imp->scheduler->appendToBuffer(time, viewsToRender[view], stats, std::dynamic_pointer_cast<BufferableObject>(it->second));
+                if (encodePipelined) {
+                    ///Pass the image to the output scheduler that will encode frames in order.
+                    ///Sequential writers only write one plane, see DefaultScheduler::processFrame
+                    defaultScheduler->notifyRenderStageTime( renderStageTimer.getTimeSinceCreation() );
+                    ///The scheduler thread waits for each frame in order: a frame that is not appended would block it forever
+                    if ( planes.empty() ) {
+                        _imp->scheduler->notifyRenderFailure("Error caught while rendering");
+
+                        return;
                     }
-                   } else {*/
-                _imp->scheduler->notifyFrameRendered(time, viewsToRender[view], viewsToRender, stats, eSchedulingPolicyFFA);
-                //}
+                    _imp->scheduler->appendToBuffer( time, viewsToRender[view], stats, std::dynamic_pointer_cast<BufferableObject>(planes.begin()->second) );
+                } else {
+                    _imp->scheduler->notifyFrameRendered(time, viewsToRender[view], viewsToRender, stats, eSchedulingPolicyFFA);
+                }
             }
         } catch (const std::exception& e) {
             _imp->scheduler->notifyRenderFailure( std::string("Error while rendering: ") + e.what() );
@@ -2404,8 +2683,16 @@ DefaultScheduler::processFrame(const BufferedFrames& frames)
     //Only consider the first frame, we shouldn't have multiple view here anyway.
     const BufferedFrame& frame = frames.front();
 
-    OutputEffectInstancePtr effect = _effect.lock();
-    U64 hash = effect->getHash();
+    OutputEffectInstancePtr output = _effect.lock();
+    EffectInstancePtr effect = output;
+    WriteNode* isWriteNode = dynamic_cast<WriteNode*>( output.get() );
+    if (isWriteNode) {
+        NodePtr embeddedWriter = isWriteNode->getEmbeddedWriter();
+        if (embeddedWriter) {
+            effect = embeddedWriter->getEffectInstance();
+        }
+    }
+    U64 hash = isWriteNode ? isWriteNode->getHash() : effect->getHash();
     bool isProjectFormat;
     std::list<ImagePlaneDesc> components;
 
@@ -2465,6 +2752,7 @@ DefaultScheduler::processFrame(const BufferedFrames& frames)
                                                                                                        eStorageModeRAM,
                                                                                                        frame.time,
                                                                                                        inputImages) );
+        TimeLapse encodeStageTimer;
         try {
             std::map<ImagePlaneDesc, ImagePtr> planes;
             EffectInstance::RenderRoIRetCode retCode;
@@ -2475,6 +2763,12 @@ DefaultScheduler::processFrame(const BufferedFrames& frames)
         } catch (const std::exception& e) {
             notifyRenderFailure( e.what() );
         }
+
+        {
+            QMutexLocker k(&_pipelineTimingsMutex);
+            _encodeStageTime += encodeStageTimer.getTimeSinceCreation();
+            ++_nbPipelinedFrames;
+        }
     }
 } // DefaultScheduler::processFrame
 
@@ -2527,12 +2821,8 @@ DefaultScheduler::handleRenderFailure(const std::string& errorMessage)
 SchedulingPolicyEnum
 DefaultScheduler::getSchedulingPolicy() const
 {
-    /*SequentialPreferenceEnum sequentiallity = _effect.lock()->getSequentialPreference();
-       if (sequentiallity == eSequentialPreferenceNotSequential) {*/
-    return eSchedulingPolicyFFA;
-    /*} else {
-        return eSchedulingPolicyOrdered;
-       }*/
+    // Sequential writers encode frames in order on the scheduler thread while render threads render ahead
+    return isEncodePipelined() ? eSchedulingPolicyOrdered : eSchedulingPolicyFFA;
 }
 
 void
@@ -2549,6 +2839,12 @@ DefaultScheduler::aboutToStartRender()
             _currentTime  = args->lastFrame;
         }
     }
+    {
+        QMutexLocker k(&_pipelineTimingsMutex);
+        _reportPipelineTimings = args->enableRenderStats;
+        _renderStageTime = _encodeStageTime = 0.;
+        _nbPipelinedFrames = 0;
+    }
     bool isBackGround = appPTR->isBackground();
 
     if (!isBackGround) {
@@ -2616,6 +2912,14 @@ DefaultScheduler::onRenderStopped(bool aborted)
         effect->setKnobsFrozen(false);
     }
 
+    {
+        QMutexLocker k(&_pipelineTimingsMutex);
+        if ( isBackGround && _reportPipelineTimings && (_nbPipelinedFrames > 0) ) {
+            std::cout << effect->getScriptName_mt_safe() << " ==> " << _nbPipelinedFrames << " frames encoded, render stage: "
+                      << _renderStageTime << " s (summed over render threads), encode stage: " << _encodeStageTime << " s" << std::endl;
+        }
+    }
+
     {
         QString longText = QString::fromUtf8( effect->getScriptName_mt_safe().c_str() ) + tr(" ==> Rendering finished");
         appPTR->writeToOutputPipe(longText, QString::fromUtf8(kRenderingFinishedStringShort), true);
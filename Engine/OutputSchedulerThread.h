@@ -298,6 +298,28 @@ public:
     int pickFrameToRender(RenderThreadTask* thread, bool* enableRenderStats, std::vector<ViewIdx>* viewsToRender);
 #endif
 
+    /**
+     * @brief Called by render-threads once the request pass of a view of a frame is done with the estimated peak memory
+     * (in bytes) needed by the images of the tree for that view. The views of a frame add up to the memory reserved by the frame,
+     * which is used to update the estimate used to admit the next frames to render, see useMemoryAdmissionControl()
+     **/
+    void notifyFrameMemoryEstimate(RenderThreadTask* thread, U64 estimatedBytes);
+
+    /**
+     * @brief Returns true if a new frame may start rendering, see useMemoryAdmissionControl().
+     * @param nFramesRendering The number of frames currently rendering
+     * @param reservedMemory The memory reserved by the frames currently rendering
+     * @param frameMemoryEstimate The estimated memory of a frame, 0 if not known yet
+     * @param memoryBudget The cache memory budget. Images already in the cache can be evicted, so this is the maximum
+     * size of the caches and not the memory left in them.
+     * @param maxFramesWithUnknownEstimate The maximum number of frames rendering at once while the estimate is not known
+     **/
+    static bool canAdmitFrame(std::size_t nFramesRendering,
+                              U64 reservedMemory,
+                              U64 frameMemoryEstimate,
+                              U64 memoryBudget,
+                              std::size_t maxFramesWithUnknownEstimate) WARN_UNUSED_RETURN;
+
     /**
      * @brief Called by the render-threads when mustQuit() is true on the thread
      **/
@@ -354,6 +376,12 @@ protected:
      **/
     virtual bool isFPSRegulationNeeded() const { return false; }
 
+    /**
+     * @brief If true, a render thread will only start a new frame if the memory estimated for it, added to the memory
+     * reserved by the frames currently rendering, fits in the cache memory budget. At least one frame is always admitted.
+     **/
+    virtual bool useMemoryAdmissionControl() const { return false; }
+
     /**
      * @brief Must return the frame range to render. For the viewer this is what is indicated on the global timeline,
      * for writers this is its internal timeline.
@@ -478,6 +506,18 @@ public:
 
     virtual ~DefaultScheduler();
 
+    /**
+     * @brief Returns true if the output is a sequential writer (e.g: a video encoder). In that case, render threads only render
+     * the input of the writer and append the images to a bounded reorder buffer. The scheduler thread then encodes them in order
+     * in processFrame(), so that a slow encode never stalls the render threads.
+     **/
+    bool isEncodePipelined() const;
+
+    /**
+     * @brief Called by render threads when the input of a pipelined writer was rendered for a frame
+     **/
+    void notifyRenderStageTime(double seconds);
+
 private:
 
     virtual void processFrame(const BufferedFrames& frames) OVERRIDE FINAL;
@@ -494,11 +534,19 @@ private:
 
     virtual void handleRenderFailure(const std::string& errorMessage) OVERRIDE FINAL;
     virtual SchedulingPolicyEnum getSchedulingPolicy() const OVERRIDE FINAL;
+    virtual bool useMemoryAdmissionControl() const OVERRIDE FINAL WARN_UNUSED_RETURN { return true; }
     virtual void aboutToStartRender() OVERRIDE FINAL;
     virtual void onRenderStopped(bool aborted) OVERRIDE FINAL;
     OutputEffectInstanceWPtr _effect;
     mutable QMutex _currentTimeMutex;
     int _currentTime;
+
+    // Time spent in each stage of the render/encode pipeline, reported when the render stops with render stats enabled
+    mutable QMutex _pipelineTimingsMutex;
+    bool _reportPipelineTimings;
+    double _renderStageTime;
+    double _encodeStageTime;
+    int _nbPipelinedFrames;
 };
 
 
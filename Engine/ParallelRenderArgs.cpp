@@ -27,6 +27,7 @@
 
 #include <cassert>
 #include <stdexcept>
+#include <algorithm> // min, max
 
 #include "Engine/AbortableRenderInfo.h"
 #include "Engine/AppManager.h"
@@ -536,6 +537,85 @@ EffectInstance::getInputsRoIsFunctor(bool useTransforms,
     return eStatusOK;
 } // EffectInstance::getInputsRoIsFunctor
 
+/**
+ * @brief Returns true if the render of the given frame/view of node only forwards the image of one of its inputs
+ * without any modification, i.e: it can be skipped entirely during the render.
+ **/
+static bool
+isPassThroughFrameView(const NodePtr& node,
+                       const FrameViewRequest& fvRequest)
+{
+    const FrameViewRequestGlobalData& data = fvRequest.globalData;
+
+    // -2 is identity of itself at another time/view: this still goes through renderRoI on the same node
+    if ( !data.isIdentity || (data.identityInputNb < 0) ) {
+        return false;
+    }
+
+    // A node with a channel selector on its identity input may request different planes upstream,
+    // see the identity handling in renderRoI
+    if ( node->getChannelSelectorKnob(data.identityInputNb) ) {
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Once all nodes were requested, resolve chains of pass-through nodes for each frame/view so that
+ * the head of the chain can render directly from the first node that actually produces an image.
+ **/
+static void
+collapsePassThroughChains(FrameRequestMap& requests)
+{
+    for (FrameRequestMap::iterator it = requests.begin(); it != requests.end(); ++it) {
+        EffectInstancePtr effect = it->first->getEffectInstance();
+        if (!effect) {
+            continue;
+        }
+        for (NodeFrameViewRequestData::iterator it2 = it->second->frames.begin(); it2 != it->second->frames.end(); ++it2) {
+            FrameViewRequestGlobalData& data = it2->second.globalData;
+            if ( !isPassThroughFrameView(it->first, it2->second) ) {
+                continue;
+            }
+
+            EffectInstancePtr target = effect->getInput(data.identityInputNb);
+            double targetTime = data.inputIdentityTime;
+            ViewIdx targetView = data.identityView;
+            int nbElided = 0;
+
+            // The number of nodes in the request bounds the walk in case the graph has a cycle
+            while ( target && ( nbElided < (int)requests.size() ) ) {
+                NodePtr targetNode = target->getNode();
+                FrameRequestMap::const_iterator foundTarget = requests.find(targetNode);
+                if ( foundTarget == requests.end() ) {
+                    break;
+                }
+                const FrameViewRequest* targetRequest = foundTarget->second->getFrameViewRequest(targetTime, targetView);
+                if ( !targetRequest || !isPassThroughFrameView(targetNode, *targetRequest) ) {
+                    break;
+                }
+                EffectInstancePtr next = target->getInput(targetRequest->globalData.identityInputNb);
+                if (!next) {
+                    // Identity on a disconnected input: let renderRoI produce the black image
+                    break;
+                }
+                targetTime = targetRequest->globalData.inputIdentityTime;
+                targetView = targetRequest->globalData.identityView;
+                target = next;
+                ++nbElided;
+            }
+
+            if ( (nbElided > 0) && target ) {
+                data.passThroughTarget = target;
+                data.passThroughTargetTime = targetTime;
+                data.passThroughTargetView = targetView;
+                data.nbPassThroughNodesElided = nbElided;
+            }
+        }
+    }
+} // collapsePassThroughChains
+
 StatusEnum
 EffectInstance::computeRequestPass(double time,
                                    ViewIdx view,
@@ -559,6 +639,8 @@ EffectInstance::computeRequestPass(double time,
         return stat;
     }
 
+    collapsePassThroughChains(request);
+
     //For all frame/view pair and for each node, compute the final roi as being the bounding box of all successive requests
     /*for (FrameRequestMap::iterator it = request.begin(); it != request.end(); ++it) {
         for (NodeFrameViewRequestData::iterator it2 = it->second->frames.begin(); it2 != it->second->frames.end(); ++it2) {
@@ -886,6 +968,7 @@ ParallelRenderArgs::ParallelRenderArgs()
     , visitsCount(0)
     , rotoPaintNodes()
     , stats()
+    , knobValues()
     , openGLContext()
     , textureIndex(0)
     , currentThreadSafety(eRenderSafetyInstanceSafe)
@@ -900,6 +983,68 @@ ParallelRenderArgs::ParallelRenderArgs()
 {
 }
 
+KnobValuesSnapshot::KnobValuesSnapshot(double time,
+                                       ViewIdx view,
+                                       const KnobsVec& knobs)
+    : _time(time)
+    , _view(view)
+    , _values()
+{
+    for (KnobsVec::const_iterator it = knobs.begin(); it != knobs.end(); ++it) {
+        KnobI* knob = it->get();
+        KnobIntBase* isInt = dynamic_cast<KnobIntBase*>(knob);
+        KnobBoolBase* isBool = dynamic_cast<KnobBoolBase*>(knob);
+        KnobDoubleBase* isDouble = dynamic_cast<KnobDoubleBase*>(knob);
+        if (!isInt && !isBool && !isDouble) {
+            // Strings and other non numeric knobs are always read through the knob
+            continue;
+        }
+        int nDims = knob->getDimension();
+        std::vector<DimensionValue>& dimValues = _values[knob];
+        dimValues.resize(nDims);
+        for (int i = 0; i < nDims; ++i) {
+            DimensionValue& v = dimValues[i];
+            // Clamping is done here rather than by the knob so that expressions are evaluated only once
+            if (isInt) {
+                v.value = isInt->getValueAtTime(time, i, view, false);
+                v.clampedValue = std::max( (double)isInt->getMinimum(i), std::min( (double)isInt->getMaximum(i), v.value ) );
+            } else if (isDouble) {
+                v.value = isDouble->getValueAtTime(time, i, view, false);
+                v.clampedValue = std::max( isDouble->getMinimum(i), std::min( isDouble->getMaximum(i), v.value ) );
+            } else {
+                v.value = isBool->getValueAtTime(time, i, view, false);
+                v.clampedValue = v.value;
+            }
+            v.timeInvariant = !knob->isAnimated(i, view) && knob->getExpression(i).empty() && !knob->getMaster(i).second;
+        }
+    }
+}
+
+bool
+KnobValuesSnapshot::getValue(const KnobI* knob,
+                             double time,
+                             ViewIdx view,
+                             int dimension,
+                             bool clamp,
+                             double* value) const
+{
+    if (view != _view) {
+        return false;
+    }
+    KnobValuesMap::const_iterator found = _values.find(knob);
+
+    if ( ( found == _values.end() ) || (dimension < 0) || ( dimension >= (int)found->second.size() ) ) {
+        return false;
+    }
+    const DimensionValue& v = found->second[dimension];
+    if ( !v.timeInvariant && (time != _time) ) {
+        return false;
+    }
+    *value = clamp ? v.clampedValue : v.value;
+
+    return true;
+}
+
 bool
 ParallelRenderArgs::isCurrentFrameRenderNotAbortable() const
 {
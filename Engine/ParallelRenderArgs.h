@@ -31,6 +31,7 @@
 #include <set>
 #include <map>
 #include <list>
+#include <vector>
 
 #include "Global/GlobalDefines.h"
 
@@ -65,6 +66,56 @@ typedef std::shared_ptr<InputMatrixMap> InputMatrixMapPtr;
 
 class NodeFrameRequest;
 
+/**
+ * @brief Immutable copy of the values of the numeric knobs of an effect, taken once
+ * when the ParallelRenderArgs of a frame are set on the thread starting the render.
+ * Render threads (and the OpenFX parameter suites) read knob values from it without
+ * locking and without evaluating curves or expressions again for every tile.
+ * Values are recorded for the view of the frame, and values that depend on time only at the
+ * time of the frame: any other view or time falls back to the regular code path of the knob.
+ **/
+class KnobValuesSnapshot
+{
+    struct DimensionValue
+    {
+        double value;
+        double clampedValue;
+
+        ///True if the value does not depend on time (no animation, expression or master)
+        bool timeInvariant;
+    };
+
+    typedef std::map<const KnobI*, std::vector<DimensionValue> > KnobValuesMap;
+
+public:
+
+    KnobValuesSnapshot(double time,
+                       ViewIdx view,
+                       const KnobsVec& knobs);
+
+    /**
+     * @brief Returns in value the value of the given knob dimension at the given time and view
+     * if it was recorded in the snapshot. This is lock-free and may be called from any thread.
+     **/
+    bool getValue(const KnobI* knob,
+                  double time,
+                  ViewIdx view,
+                  int dimension,
+                  bool clamp,
+                  double* value) const;
+
+    double getTime() const
+    {
+        return _time;
+    }
+
+private:
+
+    double _time;
+    ViewIdx _view;
+    KnobValuesMap _values;
+};
+
 /**
  * @brief Thread-local arguments given to render a frame by the tree.
  * This is different than the RenderArgs because it is not local to a
@@ -114,6 +165,9 @@ public:
     ///Various stats local to the render of a frame
     RenderStatsPtr stats;
 
+    ///Values of the knobs of the effect at the time of the frame, may be NULL
+    KnobValuesSnapshotConstPtr knobValues;
+
     ///The OpenGL context to use for the render of this frame
     OSGLContextWPtr openGLContext;
 
@@ -178,6 +232,31 @@ struct FrameViewRequestGlobalData
     int identityInputNb;
     ViewIdx identityView;
     double inputIdentityTime;
+
+    ///Pass-through elision, set once the whole tree has been requested:
+    ///if this node is the head of a chain of pass-through nodes (Dots, disabled nodes, identity effects...)
+    ///this is the effect at the end of the chain, so that renderRoI can jump directly to it.
+    EffectInstancePtr passThroughTarget;
+    double passThroughTargetTime;
+    ViewIdx passThroughTargetView;
+    int nbPassThroughNodesElided;
+
+    FrameViewRequestGlobalData()
+        : transforms()
+        , reroutesMap()
+        , frameViewsNeeded()
+        , rod()
+        , isProjectFormat(false)
+        , isIdentity(false)
+        , identityInputNb(-1)
+        , identityView(0)
+        , inputIdentityTime(0.)
+        , passThroughTarget()
+        , passThroughTargetTime(0.)
+        , passThroughTargetView(0)
+        , nbPassThroughNodesElided(0)
+    {
+    }
 };
 
 struct FrameViewRequestFinalData
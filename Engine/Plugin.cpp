@@ -247,15 +247,45 @@ Plugin::getPythonModuleNameAndPath(QString* moduleName,
 void
 Plugin::setOfxPlugin(OFX::Host::ImageEffect::ImageEffectPlugin* p)
 {
+    QMutexLocker k(&_ofxPluginMutex);
+
     _ofxPlugin = p;
 }
 
 OFX::Host::ImageEffect::ImageEffectPlugin*
 Plugin::getOfxPlugin() const
 {
+    {
+        QMutexLocker k(&_ofxPluginMutex);
+        if (_ofxPlugin || !_ofxPluginDeferred) {
+            return _ofxPlugin;
+        }
+    }
+
+    // Do not hold the lock while describing: this sets the OpenFX plug-in of the deferred plug-ins of the same binary
+    appPTR->ensureOFXPluginDescribed(this);
+
+    QMutexLocker k(&_ofxPluginMutex);
+
     return _ofxPlugin;
 }
 
+void
+Plugin::setOfxPluginDeferred(bool deferred)
+{
+    QMutexLocker k(&_ofxPluginMutex);
+
+    _ofxPluginDeferred = deferred;
+}
+
+bool
+Plugin::isOfxPluginDeferred() const
+{
+    QMutexLocker k(&_ofxPluginMutex);
+
+    return _ofxPluginDeferred;
+}
+
 OFX::Host::ImageEffect::Descriptor*
 Plugin::getOfxDesc(ContextEnum* ctx) const
 {
@@ -34,6 +34,7 @@
 #include <list>
 #include <QtCore/QString>
 #include <QtCore/QStringList>
+#include <QtCore/QMutex>
 #if QT_VERSION >= QT_VERSION_CHECK(5, 14, 0)
 #include <QtCore/QRecursiveMutex>
 #endif
@@ -179,6 +180,8 @@ class Plugin
     int _majorVersion;
     int _minorVersion;
     NATRON_ENUM::ContextEnum _ofxContext;
+    bool _ofxPluginDeferred; //< registered from the OpenFX registry cache, the OpenFX description is not loaded yet
+    mutable QMutex _ofxPluginMutex; //< protects _ofxPlugin and _ofxPluginDeferred, set from any thread once the descriptions are loaded
     mutable bool _hasShortcutSet; //< to speed up the keypress event of Nodegraph, this is used to find out quickly whether it has a shortcut or not.
     bool _isReader, _isWriter;
 
@@ -220,6 +223,8 @@ public:
         , _majorVersion(0)
         , _minorVersion(0)
         , _ofxContext(eContextNone)
+        , _ofxPluginDeferred(false)
+        , _ofxPluginMutex()
         , _hasShortcutSet(false)
         , _isReader(false)
         , _isWriter(false)
@@ -266,6 +271,8 @@ public:
         , _majorVersion(majorVersion)
         , _minorVersion(minorVersion)
         , _ofxContext(eContextNone)
+        , _ofxPluginDeferred(false)
+        , _ofxPluginMutex()
         , _hasShortcutSet(false)
         , _isReader(isReader)
         , _isWriter(isWriter)
@@ -367,7 +374,16 @@ public:
 
     void setOfxPlugin(OFX::Host::ImageEffect::ImageEffectPlugin* p);
 
+    /**
+     * @brief Returns the OpenFX plug-in. If the plug-in was registered from the OpenFX registry cache,
+     * this loads the OpenFX plug-ins descriptions first.
+     **/
     OFX::Host::ImageEffect::ImageEffectPlugin* getOfxPlugin() const;
+
+    void setOfxPluginDeferred(bool deferred);
+
+    bool isOfxPluginDeferred() const;
+
     OFX::Host::ImageEffect::Descriptor* getOfxDesc(NATRON_ENUM::ContextEnum* ctx) const;
 
     void setOfxDesc(OFX::Host::ImageEffect::Descriptor* desc, NATRON_ENUM::ContextEnum ctx);
@@ -25,7 +25,9 @@
 
 #include "ProcessHandler.h"
 
+#include <algorithm> // min, max
 #include <cassert>
+#include <iostream>
 #include <stdexcept>
 
 #include <QtCore/QtGlobal> // for Q_OS_*
@@ -46,23 +48,21 @@
 #include "Engine/AppManager.h"
 #include "Engine/Node.h"
 #include "Engine/OutputEffectInstance.h"
+#include "Engine/Timer.h"
+
+// When the frame range is split across several processes, number of chunks per process
+#define NATRON_RENDER_CHUNKS_PER_PROCESS 3
 
 NATRON_NAMESPACE_ENTER
 
-ProcessHandler::ProcessHandler(const QString & projectPath,
-                               OutputEffectInstance* writer)
-    : _process(new QProcess)
-    , _writer(writer)
-    , _ipcServer(0)
-    , _bgProcessOutputSocket(0)
-    , _bgProcessInputSocket(0)
-    , _earlyCancel(false)
-    , _processLog()
-    , _processArgs()
+NATRON_NAMESPACE_ANONYMOUS_ENTER
+
+/**
+ * @brief Returns the name of a new local server used for IPC with a background process
+ **/
+QString
+createIPCServerName()
 {
-    ///setup the server used to listen the output of the background process
-    _ipcServer = new QLocalServer();
-    QObject::connect( _ipcServer, SIGNAL(newConnection()), this, SLOT(onNewConnectionPending()) );
     QString tmpFileName;
 #if defined(Q_OS_WIN)
     tmpFileName += QString::fromUtf8("//./pipe");
@@ -92,48 +92,200 @@ ProcessHandler::ProcessHandler(const QString & projectPath,
         tmpf.remove();
 #endif
     }
-    _ipcServer->listen(tmpFileName);
 
+    return tmpFileName;
+}
 
-    _processArgs << QString::fromUtf8("-b") << QString::fromUtf8("-w") << QString::fromUtf8( writer->getScriptName_mt_safe().c_str() );
-    _processArgs << QString::fromUtf8("--IPCpipe") <<  tmpFileName;
-    _processArgs << projectPath;
+/**
+ * @brief Returns the frame range argument passed to a background process rendering the frames firstFrame to lastFrame.
+ * tryParseFrameRange() splits a range on '-', so a negative frame cannot be the bound of a "first-last:step" range:
+ * negative frames are passed as single frames of a comma-separated list of ranges instead.
+ **/
+QString
+createFrameRangeArg(int firstFrame,
+                    int lastFrame,
+                    int frameStep)
+{
+    QStringList ranges;
+    int frame = firstFrame;
 
-    ///connect the useful slots of the process
-    QObject::connect( _process, SIGNAL(readyReadStandardOutput()), this, SLOT(onStandardOutputBytesWritten()) );
-    QObject::connect( _process, SIGNAL(readyReadStandardError()), this, SLOT(onStandardErrorBytesWritten()) );
-    QObject::connect( _process, SIGNAL(error(QProcess::ProcessError)), this, SLOT(onProcessError(QProcess::ProcessError)) );
-    QObject::connect( _process, SIGNAL(finished(int,QProcess::ExitStatus)), this, SLOT(onProcessEnd(int,QProcess::ExitStatus)) );
+    for (; frame <= lastFrame && frame < 0; frame += frameStep) {
+        ranges.push_back( QString::number(frame) );
+    }
+    if (frame <= lastFrame) {
+        ranges.push_back( QString::fromUtf8("%1-%2:%3").arg(frame).arg(lastFrame).arg(frameStep) );
+    }
 
+    return ranges.join( QString::fromUtf8(",") );
+}
 
-    ///start the process
-    _processLog.push_back( tr("Starting background rendering: %1 %2")
-                           .arg( QCoreApplication::applicationFilePath() )
-                           .arg( _processArgs.join( QString::fromUtf8(" ") ) ) );
+NATRON_NAMESPACE_ANONYMOUS_EXIT
+
+ProcessHandler::ProcessHandler(const QString & projectPath,
+                               OutputEffectInstance* writer,
+                               int firstFrame,
+                               int lastFrame,
+                               int frameStep,
+                               bool enableRenderStats,
+                               int nbProcesses)
+    : _writer(writer)
+    , _projectPath(projectPath)
+    , _workers()
+    , _pendingChunks()
+    , _frameStep( std::max(1, frameStep) )
+    , _nbProcesses( std::max(1, nbProcesses) )
+    , _splitFrameRange(false)
+    , _enableRenderStats(enableRenderStats)
+    , _nbTotalFrames(0)
+    , _nbFramesRendered(0)
+    , _returnCode(0)
+    , _canceled(false)
+    , _renderTimer()
+    , _statsProcessesTime(0.)
+    , _statsMinFrameTime(-1.)
+    , _statsMaxFrameTime(-1.)
+    , _statsPerNode()
+    , _processLog()
+{
+    if ( (_nbProcesses > 1) && (lastFrame >= firstFrame) ) {
+        _nbTotalFrames = (lastFrame - firstFrame) / _frameStep + 1;
+
+        ///Split the frame range in more chunks than processes so that a process finishing its chunk early
+        ///picks up the next pending chunk instead of waiting for the slowest process.
+        const int nbChunks = std::min(_nbTotalFrames, _nbProcesses * NATRON_RENDER_CHUNKS_PER_PROCESS);
+        if (nbChunks > 1) {
+            _splitFrameRange = true;
+            _nbProcesses = std::min(_nbProcesses, nbChunks);
+            int chunkFirstFrameIndex = 0;
+            for (int i = 0; i < nbChunks; ++i) {
+                int nbFramesInChunk = _nbTotalFrames / nbChunks + (i < _nbTotalFrames % nbChunks ? 1 : 0);
+                int chunkFirst = firstFrame + chunkFirstFrameIndex * _frameStep;
+                int chunkLast = chunkFirst + (nbFramesInChunk - 1) * _frameStep;
+                _pendingChunks.push_back( std::make_pair(chunkFirst, chunkLast) );
+                chunkFirstFrameIndex += nbFramesInChunk;
+            }
+        }
+    }
+
+    if (!_splitFrameRange) {
+        _nbProcesses = 1;
+        _workers.push_back( createWorker(0, 0) );
+    }
 }
 
 ProcessHandler::~ProcessHandler()
 {
     Q_EMIT deleted();
 
-    if (_ipcServer) {
-        _ipcServer->close();
-        delete _ipcServer;
+    for (WorkerList::iterator it = _workers.begin(); it != _workers.end(); ++it) {
+        destroyWorker(*it);
+    }
+}
+
+ProcessHandler::Worker*
+ProcessHandler::createWorker(int firstFrame,
+                             int lastFrame)
+{
+    Worker* worker = new Worker;
+
+    worker->process = new QProcess;
+    worker->bgProcessOutputSocket = 0;
+    worker->bgProcessInputSocket = 0;
+    worker->earlyCancel = false;
+    worker->firstFrame = firstFrame;
+    worker->lastFrame = lastFrame;
+    worker->nbFramesRendered = 0;
+    worker->startTime = 0.;
+    worker->lastFrameTime = 0.;
+    worker->finished = false;
+
+    ///setup the server used to listen the output of the background process
+    worker->ipcServer = new QLocalServer();
+    QObject::connect( worker->ipcServer, SIGNAL(newConnection()), this, SLOT(onNewConnectionPending()) );
+    QString serverName = createIPCServerName();
+    worker->ipcServer->listen(serverName);
+
+    worker->processArgs << QString::fromUtf8("-b") << QString::fromUtf8("-w") << QString::fromUtf8( _writer->getScriptName_mt_safe().c_str() );
+    if (_enableRenderStats) {
+        worker->processArgs << QString::fromUtf8("-s");
+    }
+    worker->processArgs << QString::fromUtf8("--IPCpipe") <<  serverName;
+    if (_splitFrameRange) {
+        worker->processArgs << createFrameRangeArg(firstFrame, lastFrame, _frameStep);
+    }
+    worker->processArgs << _projectPath;
+
+    ///connect the useful slots of the process
+    QObject::connect( worker->process, SIGNAL(readyReadStandardOutput()), this, SLOT(onStandardOutputBytesWritten()) );
+    QObject::connect( worker->process, SIGNAL(readyReadStandardError()), this, SLOT(onStandardErrorBytesWritten()) );
+    QObject::connect( worker->process, SIGNAL(error(QProcess::ProcessError)), this, SLOT(onProcessError(QProcess::ProcessError)) );
+    QObject::connect( worker->process, SIGNAL(finished(int,QProcess::ExitStatus)), this, SLOT(onProcessEnd(int,QProcess::ExitStatus)) );
+
+
+    ///start the process
+    _processLog.push_back( tr("Starting background rendering: %1 %2\n")
+                           .arg( QCoreApplication::applicationFilePath() )
+                           .arg( worker->processArgs.join( QString::fromUtf8(" ") ) ) );
+
+    return worker;
+}
+
+void
+ProcessHandler::destroyWorker(Worker* worker)
+{
+    if (worker->ipcServer) {
+        worker->ipcServer->close();
+        worker->ipcServer->deleteLater();
+    }
+    if (worker->bgProcessInputSocket) {
+        worker->bgProcessInputSocket->close();
+        worker->bgProcessInputSocket->deleteLater();
     }
-    if (_bgProcessInputSocket) {
-        _bgProcessInputSocket->close();
-        delete _bgProcessInputSocket;
+    if (worker->process) {
+        worker->process->close();
+        worker->process->deleteLater();
+    }
+    delete worker;
+}
+
+ProcessHandler::Worker*
+ProcessHandler::findWorker(QObject* object) const
+{
+    if (!object) {
+        return 0;
     }
-    if (_process) {
-        _process->close();
-        delete _process;
+    for (WorkerList::const_iterator it = _workers.begin(); it != _workers.end(); ++it) {
+        Worker* w = *it;
+        if ( (object == w->process) || (object == w->ipcServer) || (object == w->bgProcessOutputSocket) || (object == w->bgProcessInputSocket) ) {
+            return w;
+        }
     }
+
+    return 0;
+}
+
+void
+ProcessHandler::startWorker(Worker* worker)
+{
+    assert(_renderTimer);
+    worker->startTime = worker->lastFrameTime = _renderTimer->getTimeSinceCreation();
+    worker->process->start(QCoreApplication::applicationFilePath(), worker->processArgs);
 }
 
 void
 ProcessHandler::startProcess()
 {
-    _process->start(QCoreApplication::applicationFilePath(), _processArgs);
+    _renderTimer.reset(new TimeLapse);
+    if (_splitFrameRange) {
+        for (int i = 0; i < _nbProcesses && !_pendingChunks.empty(); ++i) {
+            std::pair<int, int> chunk = _pendingChunks.front();
+            _pendingChunks.pop_front();
+            _workers.push_back( createWorker(chunk.first, chunk.second) );
+        }
+    }
+    for (WorkerList::iterator it = _workers.begin(); it != _workers.end(); ++it) {
+        startWorker(*it);
+    }
 }
 
 const QString &
@@ -145,14 +297,16 @@ ProcessHandler::getProcessLog() const
 void
 ProcessHandler::onNewConnectionPending()
 {
+    Worker* worker = findWorker( sender() );
+
     ///accept only 1 connection!
-    if (_bgProcessOutputSocket) {
+    if (!worker || worker->bgProcessOutputSocket) {
         return;
     }
 
-    _bgProcessOutputSocket = _ipcServer->nextPendingConnection();
+    worker->bgProcessOutputSocket = worker->ipcServer->nextPendingConnection();
 
-    QObject::connect( _bgProcessOutputSocket, SIGNAL(readyRead()), this, SLOT(onDataWrittenToSocket()) );
+    QObject::connect( worker->bgProcessOutputSocket, SIGNAL(readyRead()), this, SLOT(onDataWrittenToSocket()) );
 }
 
 void
@@ -161,9 +315,30 @@ ProcessHandler::onDataWrittenToSocket()
     ///always running in the main thread
     assert( QThread::currentThread() == qApp->thread() );
 
-    QString str = QString::fromUtf8( _bgProcessOutputSocket->readLine() );
-    while ( str.endsWith( QLatin1Char('\n') ) ) {
-        str.chop(1);
+    Worker* worker = findWorker( sender() );
+    if (!worker) {
+        return;
+    }
+
+    ///readyRead() is not emitted again for lines that were already received: read all of them
+    while ( worker->bgProcessOutputSocket->canReadLine() ) {
+        QString str = QString::fromUtf8( worker->bgProcessOutputSocket->readLine() );
+        while ( str.endsWith( QLatin1Char('\n') ) ) {
+            str.chop(1);
+        }
+        onMessageReceived(worker, str);
+    }
+}
+
+void
+ProcessHandler::onMessageReceived(Worker* worker,
+                                  QString str)
+{
+    if ( str.startsWith( QString::fromUtf8(kNodeRenderStatsStringShort) ) ) {
+        ///Sent for each node after each frame, do not flood the log with it
+        mergeNodeRenderStats( str.mid( QString::fromUtf8(kNodeRenderStatsStringShort).size() ) );
+
+        return;
     }
     _processLog.append( QString::fromUtf8("Message received: ") + str + QLatin1Char('\n') );
     if ( str.startsWith( QString::fromUtf8(kFrameRenderedStringShort) ) ) {
@@ -178,33 +353,125 @@ ProcessHandler::onDataWrittenToSocket()
             str = str.mid(0, foundProgress);
         }
         if ( !str.isEmpty() ) {
+            ++worker->nbFramesRendered;
+            ++_nbFramesRendered;
+
+            ///The time of the first frame of a process also accounts for the process startup and the project loading
+            double now = _renderTimer ? _renderTimer->getTimeSinceCreation() : 0.;
+            double frameTime = now - worker->lastFrameTime;
+            worker->lastFrameTime = now;
+            if ( (_statsMinFrameTime < 0) || (frameTime < _statsMinFrameTime) ) {
+                _statsMinFrameTime = frameTime;
+            }
+            if (frameTime > _statsMaxFrameTime) {
+                _statsMaxFrameTime = frameTime;
+            }
+            if (_splitFrameRange) {
+                ///Each process only knows about its own chunk: report the progress over the whole frame range
+                progressPercent = (double)_nbFramesRendered / _nbTotalFrames;
+            }
             //The report does not have extended timer infos
             Q_EMIT frameRendered(str.toInt(), progressPercent);
+
+            if ( appPTR->isBackground() ) {
+                std::cout << tr("%1 ==> Frame: %2, Progress: %3%")
+                             .arg( QString::fromUtf8( _writer->getScriptName_mt_safe().c_str() ) )
+                             .arg(str)
+                             .arg( QString::number(progressPercent * 100, 'f', 1) ).toStdString() << std::endl;
+            }
         }
     } else if ( str.startsWith( QString::fromUtf8(kRenderingFinishedStringShort) ) ) {
         ///don't do anything
     } else if ( str.startsWith( QString::fromUtf8(kBgProcessServerCreatedShort) ) ) {
         str = str.remove( QString::fromUtf8(kBgProcessServerCreatedShort) );
         ///the bg process wants us to create the pipe for its input
-        if (!_bgProcessInputSocket) {
-            _bgProcessInputSocket = new QLocalSocket();
-            QObject::connect( _bgProcessInputSocket, SIGNAL(connected()), this, SLOT(onInputPipeConnectionMade()) );
-            _bgProcessInputSocket->connectToServer(str, QLocalSocket::ReadWrite);
+        if (!worker->bgProcessInputSocket) {
+            worker->bgProcessInputSocket = new QLocalSocket();
+            QObject::connect( worker->bgProcessInputSocket, SIGNAL(connected()), this, SLOT(onInputPipeConnectionMade()) );
+            worker->bgProcessInputSocket->connectToServer(str, QLocalSocket::ReadWrite);
         }
     } else if ( str.startsWith( QString::fromUtf8(kRenderingStartedShort) ) ) {
         ///if the user pressed cancel prior to the pipe being created, wait for it to be created and send the abort
         ///message right away
-        if (_earlyCancel) {
-            _bgProcessInputSocket->waitForConnected(5000);
-            _earlyCancel = false;
-            onProcessCanceled();
+        if (worker->earlyCancel) {
+            worker->bgProcessInputSocket->waitForConnected(5000);
+            worker->earlyCancel = false;
+            cancelWorker(worker);
         }
     } else {
         _processLog.append( QString::fromUtf8("Error: Unable to interpret message.\n") );
         throw std::runtime_error("ProcessHandler::onDataWrittenToSocket() received erroneous message");
     }
+} // ProcessHandler::onMessageReceived
+
+void
+ProcessHandler::mergeNodeRenderStats(const QString & message)
+{
+    QStringList fields = message.split( QLatin1Char(';') );
+
+    if (fields.size() != 7) {
+        _processLog.append( QString::fromUtf8("Error: Unable to interpret render statistics: ") + message + QLatin1Char('\n') );
+
+        return;
+    }
+
+    MergedNodeRenderStats& stats = _statsPerNode[fields[0].toStdString()];
+    ++stats.nbFrames;
+    stats.timeSpent += fields[1].toDouble();
+    stats.nbCacheMisses += fields[2].toInt();
+    stats.nbCacheHits += fields[3].toInt();
+    stats.nbCacheHitButDownscaledImages += fields[4].toInt();
+    stats.nbRectanglesRendered += fields[5].toInt();
+    stats.nbIdentityFrames += fields[6].toInt();
 }
 
+void
+ProcessHandler::appendMergedRenderStats()
+{
+    QString report;
+
+    if ( _splitFrameRange && _renderTimer ) {
+        ///Merge the statistics of all processes into a single report for the whole frame range
+        QString avgFrameTime = _nbFramesRendered > 0 ? Timer::printAsTime(_statsProcessesTime / _nbFramesRendered, false) : tr("unknown");
+        QString minFrameTime = _statsMinFrameTime >= 0 ? Timer::printAsTime(_statsMinFrameTime, false) : tr("unknown");
+        QString maxFrameTime = _statsMaxFrameTime >= 0 ? Timer::printAsTime(_statsMaxFrameTime, false) : tr("unknown");
+        report.append( tr("Render statistics of the %1 process(es):\n"
+                          "Frames rendered: %2 out of %3\n"
+                          "Time spent (wall clock time, up to %4 processes at once): %5\n"
+                          "Time spent by all processes: %6\n"
+                          "Average time per frame: %7\n"
+                          "Fastest frame: %8, slowest frame: %9\n")
+                       .arg( (int)_workers.size() ).arg(_nbFramesRendered).arg(_nbTotalFrames).arg(_nbProcesses)
+                       .arg( Timer::printAsTime(_renderTimer->getTimeSinceCreation(), false) )
+                       .arg( Timer::printAsTime(_statsProcessesTime, false) )
+                       .arg(avgFrameTime).arg(minFrameTime).arg(maxFrameTime) );
+    }
+
+    if ( !_statsPerNode.empty() ) {
+        report.append( tr("Render statistics per node, merged over all processes:\n") );
+        for (std::map<std::string, MergedNodeRenderStats>::const_iterator it = _statsPerNode.begin(); it != _statsPerNode.end(); ++it) {
+            const MergedNodeRenderStats& stats = it->second;
+            report.append( tr("%1: %2 frame(s), time spent rendering: %3 (%4 per frame), "
+                              "cache hits: %5 (%6 downscaled), cache misses: %7, rectangles rendered: %8, identity on %9 frame(s)\n")
+                           .arg( QString::fromUtf8( it->first.c_str() ) )
+                           .arg(stats.nbFrames)
+                           .arg( Timer::printAsTime(stats.timeSpent, false) )
+                           .arg( Timer::printAsTime(stats.timeSpent / stats.nbFrames, false) )
+                           .arg(stats.nbCacheHits).arg(stats.nbCacheHitButDownscaledImages).arg(stats.nbCacheMisses)
+                           .arg(stats.nbRectanglesRendered).arg(stats.nbIdentityFrames) );
+        }
+    }
+
+    if ( report.isEmpty() ) {
+        return;
+    }
+    _processLog.append(report);
+    if ( appPTR->isBackground() ) {
+        std::cout << report.toStdString();
+        std::cout.flush();
+    }
+} // ProcessHandler::appendMergedRenderStats
+
 void
 ProcessHandler::onInputPipeConnectionMade()
 {
@@ -217,7 +484,11 @@ ProcessHandler::onInputPipeConnectionMade()
 void
 ProcessHandler::onStandardOutputBytesWritten()
 {
-    QString str = QString::fromUtf8( _process->readAllStandardOutput().data() );
+    Worker* worker = findWorker( sender() );
+    if (!worker) {
+        return;
+    }
+    QString str = QString::fromUtf8( worker->process->readAllStandardOutput().data() );
 
 #ifdef DEBUG
     qDebug() << "Message(stdout):" << str;
@@ -228,12 +499,34 @@ ProcessHandler::onStandardOutputBytesWritten()
 void
 ProcessHandler::onStandardErrorBytesWritten()
 {
-    QString str = QString::fromUtf8( _process->readAllStandardError().data() );
+    Worker* worker = findWorker( sender() );
+    if (!worker) {
+        return;
+    }
+    QString str = QString::fromUtf8( worker->process->readAllStandardError().data() );
 
 #ifdef DEBUG
     qDebug() << "Message(stderr):" << str;
 #endif
     _processLog.append(QString::fromUtf8("Error(stderr): ") + str);
+    if ( appPTR->isBackground() ) {
+        ///There is no dialog to show the log on the command line
+        std::cerr << str.toStdString();
+    }
+}
+
+void
+ProcessHandler::cancelWorker(Worker* worker)
+{
+    if (worker->finished) {
+        return;
+    }
+    if (!worker->bgProcessInputSocket) {
+        worker->earlyCancel = true;
+    } else {
+        worker->bgProcessInputSocket->write( ( QString::fromUtf8(kAbortRenderingStringShort) + QLatin1Char('\n') ).toUtf8() );
+        worker->bgProcessInputSocket->flush();
+    }
 }
 
 void
@@ -241,11 +534,10 @@ ProcessHandler::onProcessCanceled()
 {
     Q_EMIT processCanceled();
 
-    if (!_bgProcessInputSocket) {
-        _earlyCancel = true;
-    } else {
-        _bgProcessInputSocket->write( ( QString::fromUtf8(kAbortRenderingStringShort) + QLatin1Char('\n') ).toUtf8() );
-        _bgProcessInputSocket->flush();
+    _canceled = true;
+    _pendingChunks.clear();
+    for (WorkerList::iterator it = _workers.begin(); it != _workers.end(); ++it) {
+        cancelWorker(*it);
     }
 }
 
@@ -254,6 +546,12 @@ ProcessHandler::onProcessError(QProcess::ProcessError err)
 {
     if (err == QProcess::FailedToStart) {
         Dialogs::errorDialog( _writer->getScriptName(), tr("The render process failed to start.").toStdString() );
+
+        // The finished() signal is not emitted if the process failed to start
+        Worker* worker = findWorker( sender() );
+        if (worker) {
+            onWorkerFinished(worker, 1);
+        }
     } else if (err == QProcess::Crashed) {
         //@TODO: find out a way to get the backtrace
     }
@@ -270,9 +568,57 @@ ProcessHandler::onProcessEnd(int exitCode,
     } else if (exitCode == 1) {
         returnCode = 1;
     }
-    Q_EMIT processFinished(returnCode);
+
+    Worker* worker = findWorker( sender() );
+    if (worker) {
+        onWorkerFinished(worker, returnCode);
+    }
 }
 
+void
+ProcessHandler::onWorkerFinished(Worker* worker,
+                                 int returnCode)
+{
+    if (worker->finished) {
+        return;
+    }
+    worker->finished = true;
+    _returnCode = std::max(_returnCode, returnCode);
+
+    if (_renderTimer) {
+        _statsProcessesTime += _renderTimer->getTimeSinceCreation() - worker->startTime;
+    }
+    if ( _splitFrameRange && (returnCode != 0) ) {
+        _processLog.append( tr("The process rendering frames %1 to %2 failed with return code %3 after rendering %4 frame(s)\n")
+                            .arg(worker->firstFrame).arg(worker->lastFrame).arg(returnCode).arg(worker->nbFramesRendered) );
+    }
+
+    if (returnCode != 0) {
+        ///Do not render the remaining chunks if a process failed, the render would be incomplete anyway
+        _pendingChunks.clear();
+        for (WorkerList::iterator it = _workers.begin(); it != _workers.end(); ++it) {
+            cancelWorker(*it);
+        }
+    } else if ( !_canceled && !_pendingChunks.empty() ) {
+        ///Rebalance: this process is done, start a new one on the next pending chunk
+        std::pair<int, int> chunk = _pendingChunks.front();
+        _pendingChunks.pop_front();
+        Worker* newWorker = createWorker(chunk.first, chunk.second);
+        _workers.push_back(newWorker);
+        startWorker(newWorker);
+    }
+
+    for (WorkerList::iterator it = _workers.begin(); it != _workers.end(); ++it) {
+        if ( !(*it)->finished ) {
+            return;
+        }
+    }
+
+    appendMergedRenderStats();
+
+    Q_EMIT processFinished(_returnCode);
+} // ProcessHandler::onWorkerFinished
+
 ProcessInputChannel::ProcessInputChannel(const QString & mainProcessServerName)
     : QThread()
     , _mainProcessServerName(mainProcessServerName)
@@ -28,6 +28,12 @@
 
 #include "Global/Macros.h"
 
+#include <list>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+
 CLANG_DIAG_OFF(deprecated)
 #include <QtCore/QProcess>
 #include <QtCore/QThread>
@@ -85,27 +91,78 @@ class ProcessHandler
 {
     Q_OBJECT
 
-    QProcess* _process; //< the process executing the render
+    /**
+     * @brief A background process started by the handler. When the frame range is split across several processes,
+     * each worker renders a chunk of frames and a new worker is started on the next pending chunk when it finishes,
+     * so that workers finishing early pick up more work.
+     **/
+    struct Worker
+    {
+        QProcess* process; //< the process executing the render
+        QLocalServer* ipcServer; //< the server for IPC with the background process
+        QLocalSocket* bgProcessOutputSocket; //< the socket where data is output by the process
+
+        //the socket where data is read by the process
+        //note that this socket is initialized only when the background process sends the message
+        //kBgProcessServerCreatedShort, meaning it created its server for the input pipe and we can actually open it.
+        QLocalSocket* bgProcessInputSocket;
+        bool earlyCancel; //< true if the user pressed cancel but the bgProcessInput socket was not created yet
+        QStringList processArgs;
+        int firstFrame, lastFrame; //< the chunk rendered by this worker, only meaningful if the frame range is split
+        int nbFramesRendered;
+        double startTime; //< time at which the process was started, relative to the render timer
+        double lastFrameTime; //< time at which the process last reported a rendered frame, relative to the render timer
+        bool finished;
+    };
+
+    typedef std::list<Worker*> WorkerList;
+
+    /**
+     * @brief Render statistics of a node merged over all the frames rendered by all the processes
+     **/
+    struct MergedNodeRenderStats
+    {
+        int nbFrames;
+        double timeSpent;
+        int nbCacheMisses, nbCacheHits, nbCacheHitButDownscaledImages;
+        int nbRectanglesRendered;
+        int nbIdentityFrames;
+    };
+
     OutputEffectInstance* _writer; //< pointer to the writer that will render in the bg process
-    QLocalServer* _ipcServer; //< the server for IPC with the background process
-    QLocalSocket* _bgProcessOutputSocket; //< the socket where data is output by the process
-
-    //the socket where data is read by the process
-    //note that this socket is initialized only when the background process sends the message
-    //kBgProcessServerCreatedShort, meaning it created its server for the input pipe and we can actually open it.
-    QLocalSocket* _bgProcessInputSocket;
-    bool _earlyCancel; //< true if the user pressed cancel but the _bgProcessInput socket was not created yet
+    QString _projectPath;
+    WorkerList _workers;
+    std::list<std::pair<int, int> > _pendingChunks; //< chunks of the frame range not rendered yet
+    int _frameStep;
+    int _nbProcesses; //< maximum number of processes running at the same time
+    bool _splitFrameRange; //< if false, a single process renders the frame range of the writer
+    bool _enableRenderStats;
+    int _nbTotalFrames, _nbFramesRendered;
+    int _returnCode;
+    bool _canceled;
+    std::unique_ptr<TimeLapse> _renderTimer;
+
+    // Render statistics merged over all processes, only meaningful if the frame range is split
+    double _statsProcessesTime; //< sum of the time spent by each process
+    double _statsMinFrameTime, _statsMaxFrameTime; //< fastest and slowest frame of all processes, -1 if none
+    std::map<std::string, MergedNodeRenderStats> _statsPerNode; //< sent by the processes if render stats are enabled
     QString _processLog; //< used to record the log of the process
-    QStringList _processArgs;
 
 public:
 
     /**
      * @brief Starts a new process which will load the project specified by "projectPath".
      * The process will render using the effect specified by writer.
+     * If nbProcesses is greater than 1, the frame range [firstFrame, lastFrame] is split in chunks rendered by at most
+     * nbProcesses processes concurrently. Progress is reported for the whole frame range.
      **/
     ProcessHandler(const QString & projectPath,
-                   OutputEffectInstance* writer);
+                   OutputEffectInstance* writer,
+                   int firstFrame = 0,
+                   int lastFrame = 0,
+                   int frameStep = 1,
+                   bool enableRenderStats = false,
+                   int nbProcesses = 1);
 
     virtual ~ProcessHandler();
 
@@ -166,6 +223,39 @@ public Q_SLOTS:
      **/
     void startProcess();
 
+private:
+
+    Worker* createWorker(int firstFrame, int lastFrame);
+
+    void startWorker(Worker* worker);
+
+    Worker* findWorker(QObject* object) const;
+
+    /**
+     * @brief Handles a single line written by the background process of the worker to its output pipe.
+     **/
+    void onMessageReceived(Worker* worker, QString str);
+
+    /**
+     * @brief Merges the statistics of a node for one frame, as sent by a background process, into _statsPerNode.
+     **/
+    void mergeNodeRenderStats(const QString & message);
+
+    /**
+     * @brief Appends to the log the render statistics merged over all the processes.
+     **/
+    void appendMergedRenderStats();
+
+    void cancelWorker(Worker* worker);
+
+    /**
+     * @brief Called when a worker process is done: starts a worker on the next pending chunk, or notifies
+     * that the render is finished if it was the last worker running.
+     **/
+    void onWorkerFinished(Worker* worker, int returnCode);
+
+    void destroyWorker(Worker* worker);
+
 Q_SIGNALS:
 
     void deleted();
@@ -32,6 +32,8 @@
 #include <cstdlib> // strtoul
 #include <cerrno> // errno
 #include <cassert>
+#include <cstring> // memcpy
+#include <sstream>
 #include <stdexcept>
 
 #ifdef __NATRON_WIN32__
@@ -58,6 +60,15 @@
 
 #include <ofxhXml.h> // OFX::XML::escape
 
+GCC_DIAG_UNUSED_LOCAL_TYPEDEFS_OFF
+// clang-format off
+GCC_DIAG_OFF(unused-parameter)
+#include <boost/archive/binary_iarchive.hpp>
+#include <boost/archive/binary_oarchive.hpp>
+GCC_DIAG_UNUSED_LOCAL_TYPEDEFS_ON
+GCC_DIAG_ON(unused-parameter)
+// clang-format on
+
 #include "Global/StrUtils.h"
 #include "Global/FStreamsSupport.h"
 #ifdef DEBUG
@@ -81,6 +92,7 @@
 #include "Engine/RotoLayer.h"
 #include "Engine/Settings.h"
 #include "Engine/StandardPaths.h"
+#include "Engine/Timer.h"
 #include "Engine/ViewerInstance.h"
 #include "Engine/ViewIdx.h"
 
@@ -271,6 +283,72 @@ Project::loadProject(const QString & path,
     return true;
 } // loadProject
 
+///Binary projects start with these 4 bytes followed by the format version as a little-endian 32-bit integer
+#define NATRON_PROJECT_BINARY_MAGIC "NTPB"
+#define NATRON_PROJECT_BINARY_FORMAT_VERSION 1
+
+static bool
+isBinaryProjectFileName(const QString& fileName)
+{
+    return fileName.endsWith( QString::fromUtf8("." NATRON_PROJECT_BINARY_FILE_EXT), Qt::CaseInsensitive );
+}
+
+static void
+writeBinaryProjectHeader(std::ostream& os)
+{
+    os.write(NATRON_PROJECT_BINARY_MAGIC, 4);
+    unsigned int version = NATRON_PROJECT_BINARY_FORMAT_VERSION;
+    char versionBytes[4];
+    for (int i = 0; i < 4; ++i) {
+        versionBytes[i] = (char)( (version >> (8 * i)) & 0xff );
+    }
+    os.write(versionBytes, 4);
+}
+
+/**
+ * @brief Returns true and skips the header if the stream holds a binary project,
+ * otherwise rewinds the stream so that it can be read as XML.
+ **/
+static bool
+readBinaryProjectHeader(std::istream& is)
+{
+    char header[8];
+
+    is.read(header, 8);
+    if ( !is || (std::string(header, 4) != NATRON_PROJECT_BINARY_MAGIC) ) {
+        is.clear();
+        is.seekg(0);
+
+        return false;
+    }
+    unsigned int version = 0;
+    for (int i = 0; i < 4; ++i) {
+        version |= (unsigned int)( (unsigned char)header[4 + i] ) << (8 * i);
+    }
+    if (version > NATRON_PROJECT_BINARY_FORMAT_VERSION) {
+        throw std::runtime_error( Project::tr("This binary project uses format version %1 which is not supported by this version of %2.").arg(version).arg( QString::fromUtf8(NATRON_APPLICATION_NAME) ).toStdString() );
+    }
+
+    return true;
+}
+
+static void
+printProjectLoadPhases(const std::list<std::pair<std::string, double> >& phases)
+{
+    if ( phases.empty() ) {
+        return;
+    }
+    QString report = Project::tr("Project load phases:");
+    for (std::list<std::pair<std::string, double> >::const_iterator it = phases.begin(); it != phases.end(); ++it) {
+        report += QString::fromUtf8("\n    %1: %2 s").arg( QString::fromUtf8( it->first.c_str() ) ).arg(it->second, 0, 'f', 3);
+    }
+    if ( appPTR->isStartupProfilingEnabled() ) {
+        std::cout << report.toStdString() << std::endl;
+    } else {
+        qDebug() << report;
+    }
+}
+
 bool
 Project::loadProjectInternal(const QString & path,
                              const QString & name,
@@ -288,7 +366,7 @@ Project::loadProjectInternal(const QString & path,
 
     bool ret = false;
     FStreamsSupport::ifstream ifile;
-    FStreamsSupport::open( &ifile, filePath.toStdString() );
+    FStreamsSupport::open( &ifile, filePath.toStdString(), std::ios_base::in | std::ios_base::binary );
     if (!ifile) {
         throw std::runtime_error( tr("Failed to open %1").arg(filePath).toStdString() );
     }
@@ -316,20 +394,48 @@ Project::loadProjectInternal(const QString & path,
 
     LoadProjectSplashScreen_RAII __raii_splashscreen__(getApp(), name);
 
+    _imp->loadPhases.clear();
     try {
         bool bgProject;
-        boost::archive::xml_iarchive iArchive(ifile);
-        {
-            FlagSetter __raii_loadingProjectInternal__(true, &_imp->isLoadingProjectInternal, &_imp->isLoadingProjectMutex);
+        if ( readBinaryProjectHeader(ifile) ) {
+            boost::archive::binary_iarchive iArchive(ifile);
+            {
+                FlagSetter __raii_loadingProjectInternal__(true, &_imp->isLoadingProjectInternal, &_imp->isLoadingProjectMutex);
+
+                TimeLapse parseTimer;
+                iArchive >> boost::serialization::make_nvp("Background_project", bgProject);
+                ProjectSerialization projectSerializationObj( getApp() );
+                iArchive >> boost::serialization::make_nvp("Project", projectSerializationObj);
+                _imp->loadPhases.push_back( std::make_pair( "Parsing", parseTimer.getTimeSinceCreation() ) );
+                ret = load(projectSerializationObj, name, path, mustSave);
+            } // __raii_loadingProjectInternal__
 
-            iArchive >> boost::serialization::make_nvp("Background_project", bgProject);
-            ProjectSerialization projectSerializationObj( getApp() );
-            iArchive >> boost::serialization::make_nvp("Project", projectSerializationObj);
-            ret = load(projectSerializationObj, name, path, mustSave);
-        } // __raii_loadingProjectInternal__
+            if (!bgProject) {
+                ///The GUI layout is only serializable to XML, it is embedded as an XML document
+                std::string guiLayout;
+                iArchive >> boost::serialization::make_nvp("Gui_layout", guiLayout);
+                if ( !guiLayout.empty() ) {
+                    std::istringstream guiStream(guiLayout);
+                    boost::archive::xml_iarchive guiArchive(guiStream);
+                    getApp()->loadProjectGui(isAutoSave, guiArchive);
+                }
+            }
+        } else {
+            boost::archive::xml_iarchive iArchive(ifile);
+            {
+                FlagSetter __raii_loadingProjectInternal__(true, &_imp->isLoadingProjectInternal, &_imp->isLoadingProjectMutex);
+
+                TimeLapse parseTimer;
+                iArchive >> boost::serialization::make_nvp("Background_project", bgProject);
+                ProjectSerialization projectSerializationObj( getApp() );
+                iArchive >> boost::serialization::make_nvp("Project", projectSerializationObj);
+                _imp->loadPhases.push_back( std::make_pair( "Parsing", parseTimer.getTimeSinceCreation() ) );
+                ret = load(projectSerializationObj, name, path, mustSave);
+            } // __raii_loadingProjectInternal__
 
-        if (!bgProject) {
-            getApp()->loadProjectGui(isAutoSave, iArchive);
+            if (!bgProject) {
+                getApp()->loadProjectGui(isAutoSave, iArchive);
+            }
         }
     } catch (const std::exception &e) {
         const ProjectBeingLoadedInfo& pInfo = getApp()->getProjectBeingLoadedInfo();
@@ -351,6 +457,8 @@ Project::loadProjectInternal(const QString & path,
         throw std::runtime_error( tr("Unrecognized or damaged project file").toStdString() );
     }
 
+    printProjectLoadPhases(_imp->loadPhases);
+
     Format f;
     getProjectDefaultFormat(&f);
     Q_EMIT formatChanged(f);
@@ -416,7 +524,8 @@ Project::saveProject_imp(const QString & path,
                          const QString & name,
                          bool autoS,
                          bool updateProjectProperties,
-                         QString* newFilePath)
+                         QString* newFilePath,
+                         const std::string* content)
 {
     {
         QMutexLocker l(&_imp->isLoadingProjectMutex);
@@ -454,7 +563,7 @@ Project::saveProject_imp(const QString & path,
                 removeLastAutosave();
             }
 
-            ret = saveProjectInternal(path, name, true, updateProjectProperties);
+            ret = saveProjectInternal(path, name, true, updateProjectProperties, content);
         }
     } catch (const std::exception & e) {
         if (!autoS) {
@@ -546,7 +655,8 @@ QString
 Project::saveProjectInternal(const QString & path,
                              const QString & name,
                              bool autoSave,
-                             bool updateProjectProperties)
+                             bool updateProjectProperties,
+                             const std::string* content)
 {
     bool isRenderSave = name.contains( QString::fromUtf8("RENDER_SAVE") );
     QDateTime time = QDateTime::currentDateTime();
@@ -598,9 +708,12 @@ Project::saveProjectInternal(const QString & path,
     StrUtils::ensureLastPathSeparator(tmpFilename);
     tmpFilename.append( QString::number( time.toMSecsSinceEpoch() ) );
 
+    ///Autosave snapshots are always binary, the loader recognizes either format
+    const bool binaryProject = content || isBinaryProjectFileName(name);
+
     {
         FStreamsSupport::ofstream ofile;
-        FStreamsSupport::open( &ofile, tmpFilename.toStdString() );
+        FStreamsSupport::open( &ofile, tmpFilename.toStdString(), binaryProject ? (std::ios_base::out | std::ios_base::binary) : std::ios_base::out );
         if (!ofile) {
             throw std::runtime_error( tr("Failed to open file ").toStdString() + tmpFilename.toStdString() );
         }
@@ -616,17 +729,15 @@ Project::saveProjectInternal(const QString & path,
         }
 
         try {
-            boost::archive::xml_oarchive oArchive(ofile);
-            bool bgProject = getApp()->isBackground();
-            oArchive << boost::serialization::make_nvp("Background_project", bgProject);
-            ProjectSerialization projectSerializationObj( getApp() );
-            save(&projectSerializationObj);
-            oArchive << boost::serialization::make_nvp("Project", projectSerializationObj);
-            if (!bgProject) {
-                AppInstancePtr app = getApp();
-                if (app) {
-                    app->saveProjectGui(oArchive);
+            if (content) {
+                ofile.write( content->data(), content->size() );
+                if (!ofile) {
+                    throw std::runtime_error( tr("Failed to write file ").toStdString() + tmpFilename.toStdString() );
                 }
+            } else {
+                ProjectSerialization projectSerializationObj( getApp() );
+                save(&projectSerializationObj);
+                writeProjectArchive(ofile, binaryProject, projectSerializationObj);
             }
         } catch (...) {
             if (!autoSave && updateProjectProperties) {
@@ -703,6 +814,133 @@ Project::saveProjectInternal(const QString & path,
     return filePath;
 } // saveProjectInternal
 
+std::string
+Project::saveProjectGuiLayout()
+{
+    std::ostringstream guiStream;
+    AppInstancePtr app = getApp();
+
+    if (app) {
+        boost::archive::xml_oarchive guiArchive(guiStream);
+        app->saveProjectGui(guiArchive);
+    } // guiArchive must be destroyed to close the XML document
+
+    return guiStream.str();
+}
+
+void
+Project::writeProjectArchive(std::ostream& os,
+                             bool binaryProject,
+                             const ProjectSerialization& projectSerializationObj,
+                             const std::string* guiLayout)
+{
+    bool bgProject = getApp()->isBackground();
+
+    if (binaryProject) {
+        writeBinaryProjectHeader(os);
+        boost::archive::binary_oarchive oArchive(os);
+        oArchive << boost::serialization::make_nvp("Background_project", bgProject);
+        oArchive << boost::serialization::make_nvp("Project", projectSerializationObj);
+        if (!bgProject) {
+            std::string layout = guiLayout ? *guiLayout : saveProjectGuiLayout();
+            oArchive << boost::serialization::make_nvp("Gui_layout", layout);
+        }
+    } else {
+        ///The XML format nests the GUI layout in the project archive, it cannot be given beforehand
+        assert(!guiLayout);
+        boost::archive::xml_oarchive oArchive(os);
+        oArchive << boost::serialization::make_nvp("Background_project", bgProject);
+        oArchive << boost::serialization::make_nvp("Project", projectSerializationObj);
+        if (!bgProject) {
+            AppInstancePtr app = getApp();
+            if (app) {
+                app->saveProjectGui(oArchive);
+            }
+        }
+    }
+}
+
+static void
+appendBytesToHash(const char* data,
+                  std::size_t size,
+                  Hash64* hash)
+{
+    std::size_t nWords = size / sizeof(U64);
+
+    for (std::size_t i = 0; i < nWords; ++i) {
+        U64 word;
+        memcpy(&word, data + i * sizeof(U64), sizeof(U64));
+        hash->append<U64>(word);
+    }
+    for (std::size_t i = nWords * sizeof(U64); i < size; ++i) {
+        hash->append<char>(data[i]);
+    }
+}
+
+std::shared_ptr<ProjectSerialization>
+Project::takeAutoSaveSnapshot(std::string* guiLayout)
+{
+    std::shared_ptr<ProjectSerialization> snapshot = std::make_shared<ProjectSerialization>( getApp() );
+    try {
+        save( snapshot.get() );
+        *guiLayout = saveProjectGuiLayout();
+    } catch (const std::exception& e) {
+        qDebug() << "Auto-save failure: " << e.what();
+
+        return std::shared_ptr<ProjectSerialization>();
+    }
+
+    return snapshot;
+}
+
+void
+Project::writeAutoSaveSnapshot(const QString& path,
+                               const QString& name,
+                               const std::shared_ptr<ProjectSerialization>& snapshot,
+                               const std::string& guiLayout)
+{
+    ///The project is serialized once, the same bytes are hashed and written
+    std::string content;
+    std::streamoff timeOffset;
+    try {
+        std::ostringstream ss(std::ios_base::out | std::ios_base::binary);
+        snapshot->recordTimelineTimeOffset(&ss);
+        writeProjectArchive(ss, true, *snapshot, &guiLayout);
+        snapshot->recordTimelineTimeOffset(0);
+        content = ss.str();
+        timeOffset = snapshot->getTimelineTimeOffset();
+    } catch (const std::exception& e) {
+        qDebug() << "Auto-save failure: " << e.what();
+
+        return;
+    }
+
+    ///Moving in the timeline alone does not need a new auto-save: skip the timeline time in the hash
+    Hash64 contentHash;
+    std::size_t timeBegin = content.size(), timeEnd = content.size();
+    if ( (timeOffset >= 0) && ( (std::size_t)timeOffset + sizeof(SequenceTime) <= content.size() ) ) {
+        timeBegin = (std::size_t)timeOffset;
+        timeEnd = timeBegin + sizeof(SequenceTime);
+    }
+    appendBytesToHash(content.data(), timeBegin, &contentHash);
+    appendBytesToHash(content.data() + timeEnd, content.size() - timeEnd, &contentHash);
+    contentHash.append<U64>( (U64)content.size() );
+    contentHash.computeHash();
+
+    {
+        QMutexLocker l(&_imp->projectLock);
+        ///Nothing changed since the last auto-save and it is still there: don't write it again
+        if ( (contentHash.value() == _imp->lastAutoSaveHash) && QFile::exists(_imp->lastAutoSaveFilePath) ) {
+            return;
+        }
+    }
+
+    if ( saveProject_imp(path, name, true, true, 0, &content) ) {
+        QMutexLocker l(&_imp->projectLock);
+        _imp->lastAutoSaveHash = contentHash.value();
+    }
+} // Project::writeAutoSaveSnapshot
+
 void
 Project::autoSave()
 {
@@ -713,7 +951,11 @@ Project::autoSave()
 
     QString path = QString::fromUtf8( _imp->getProjectPath().c_str() );
     QString name = QString::fromUtf8( _imp->getProjectFilename().c_str() );
-    saveProject_imp(path, name, true, true, 0);
+    std::string guiLayout;
+    std::shared_ptr<ProjectSerialization> snapshot = takeAutoSaveSnapshot(&guiLayout);
+    if (snapshot) {
+        writeAutoSaveSnapshot(path, name, snapshot, guiLayout);
+    }
 }
 
 void
@@ -754,9 +996,29 @@ Project::onAutoSaveTimerTriggered()
     bool canAutoSave = !hasNodeRendering() && !getApp()->isShowingDialog();
 
     if (canAutoSave) {
+        ///Snapshot the project here, where nothing can modify it: the knob values are copied in the serialization,
+        ///which is then written by a separate thread while the user keeps editing
+        TimeLapse pauseTimer;
+        QString path = QString::fromUtf8( _imp->getProjectPath().c_str() );
+        QString name = QString::fromUtf8( _imp->getProjectFilename().c_str() );
+        std::string guiLayout;
+        std::shared_ptr<ProjectSerialization> snapshot = takeAutoSaveSnapshot(&guiLayout);
+        if (!snapshot) {
+            return;
+        }
+        double pause = pauseTimer.getTimeSinceCreation();
+#ifdef DEBUG
+        bool reportPause = true;
+#else
+        bool reportPause = pause > 0.04; // longer than a frame at 25 fps
+#endif
+        if (reportPause) {
+            qDebug() << "Auto-save snapshot paused the main thread for" << pause * 1000. << "ms";
+        }
+
         std::shared_ptr<QFutureWatcher<void> > watcher = std::make_shared<QFutureWatcher<void> >();
         QObject::connect( watcher.get(), SIGNAL(finished()), this, SLOT(onAutoSaveFutureFinished()) );
-        watcher->setFuture( QtConcurrent::run(this, &Project::autoSave) );
+        watcher->setFuture( QtConcurrent::run(this, &Project::writeAutoSaveSnapshot, path, name, snapshot, guiLayout) );
         _imp->autoSaveFutures.push_back(watcher);
     } else {
         ///If the auto-save failed because a render is in progress, try every 2 seconds to auto-save.
@@ -791,7 +1053,7 @@ Project::findAutoSaveForProject(const QString& projectPath,
     Q_FOREACH(const QString &entry, entries) {
         QString ntpExt( QLatin1Char('.') );
 
-        ntpExt.append( QString::fromUtf8(NATRON_PROJECT_FILE_EXT) );
+        ntpExt.append( QString::fromUtf8( isBinaryProjectFileName(projectName) ? NATRON_PROJECT_BINARY_FILE_EXT : NATRON_PROJECT_FILE_EXT ) );
         QString searchStr(ntpExt);
         QString autosaveSuffix( QString::fromUtf8(".autosave") );
         searchStr.append(autosaveSuffix);
@@ -1907,8 +2169,10 @@ Project::clearAutoSavesDir()
         QString searchStr( QLatin1Char('.') );
         searchStr.append( QString::fromUtf8(NATRON_PROJECT_FILE_EXT) );
         searchStr.append( QLatin1Char('.') );
-        int suffixPos = entry.indexOf(searchStr);
-        if (suffixPos != -1) {
+        QString binarySearchStr( QLatin1Char('.') );
+        binarySearchStr.append( QString::fromUtf8(NATRON_PROJECT_BINARY_FILE_EXT) );
+        binarySearchStr.append( QLatin1Char('.') );
+        if ( (entry.indexOf(searchStr) != -1) || (entry.indexOf(binarySearchStr) != -1) ) {
             QString dirToRemove = savesDir.path();
             if ( !dirToRemove.endsWith( QLatin1Char('/') ) ) {
                 dirToRemove += QLatin1Char('/');
@@ -28,7 +28,10 @@
 
 #include "Global/Macros.h"
 
+#include <iosfwd>
 #include <map>
+#include <memory>
+#include <string>
 #include <vector>
 
 CLANG_DIAG_OFF(deprecated)
@@ -95,7 +98,11 @@ public:
     bool saveProject(const QString & path, const QString & name, QString* newFilePath);
 
 
-    bool saveProject_imp(const QString & path, const QString & name, bool autoSave, bool updateProjectProperties, QString* newFilePath = 0);
+    /**
+     * @param content If not NULL, the content of the file as produced by writeProjectArchive() beforehand,
+     * it is written as is without accessing the project.
+     **/
+    bool saveProject_imp(const QString & path, const QString & name, bool autoSave, bool updateProjectProperties, QString* newFilePath = 0, const std::string* content = 0);
 
     /**
      * @brief Same as saveProject except that it will save the project in a temporary file
@@ -380,7 +387,32 @@ private:
     bool loadProjectInternal(const QString & path, const QString & name, bool isAutoSave,
                              bool isUntitledAutosave, bool* mustSave);
 
-    QString saveProjectInternal(const QString & path, const QString & name, bool autosave, bool updateProjectProperties);
+    QString saveProjectInternal(const QString & path, const QString & name, bool autosave, bool updateProjectProperties, const std::string* content = 0);
+
+    /**
+     * @brief Writes the given project serialization and the GUI layout to the given stream, in the binary format if binaryProject is true.
+     * @param guiLayout If not NULL, the GUI layout made by saveProjectGuiLayout() beforehand. Only binary archives can use it.
+     **/
+    void writeProjectArchive(std::ostream& os, bool binaryProject, const ProjectSerialization& projectSerializationObj, const std::string* guiLayout = 0);
+
+    /**
+     * @brief Returns the GUI layout as the XML document embedded in binary projects. Must be called on the main-thread.
+     **/
+    std::string saveProjectGuiLayout();
+
+    /**
+     * @brief Copies the project and its GUI layout for an auto-save, see writeAutoSaveSnapshot(). Must be called on the main-thread.
+     * @returns NULL if the project could not be serialized
+     **/
+    std::shared_ptr<ProjectSerialization> takeAutoSaveSnapshot(std::string* guiLayout);
+
+    /**
+     * @brief Writes an auto-save of the snapshot taken on the main-thread by takeAutoSaveSnapshot().
+     * The snapshot does not read the project, so this may run on a separate thread. Nothing is written if the content
+     * did not change since the last auto-save, regardless of the timeline position.
+     **/
+    void writeAutoSaveSnapshot(const QString& path, const QString& name,
+                               const std::shared_ptr<ProjectSerialization>& snapshot, const std::string& guiLayout);
 
 
 
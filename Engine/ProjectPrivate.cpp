@@ -50,6 +50,7 @@
 #include "Engine/RotoLayer.h"
 #include "Engine/Settings.h"
 #include "Engine/TimeLine.h"
+#include "Engine/Timer.h"
 #include "Engine/ViewerInstance.h"
 
 
@@ -58,6 +59,8 @@ NATRON_NAMESPACE_ENTER
 ProjectPrivate::ProjectPrivate(Project* project)
     : _publicInterface(project)
     , projectLock()
+    , lastAutoSaveFilePath()
+    , lastAutoSaveHash(0)
     , hasProjectBeenSavedByUser(false)
     , ageSinceLastSave( QDateTime::currentDateTime() )
     , lastAutoSave()
@@ -93,6 +96,7 @@ ProjectPrivate::ProjectPrivate(Project* project)
     , isLoadingProjectMutex()
     , isLoadingProject(false)
     , isLoadingProjectInternal(false)
+    , loadPhases()
     , isSavingProjectMutex()
     , isSavingProject(false)
     , autoSaveTimer( new QTimer() )
@@ -112,6 +116,7 @@ ProjectPrivate::restoreFromSerialization(const ProjectSerialization & obj,
     /*1st OFF RESTORE THE PROJECT KNOBS*/
     bool ok;
     std::vector<std::string> linksErrors;
+    TimeLapse phaseTimer;
     {
         CreatingNodeTreeFlag_RAII creatingNodeTreeFlag( _publicInterface->getApp() );
 
@@ -203,6 +208,8 @@ ProjectPrivate::restoreFromSerialization(const ProjectSerialization & obj,
         timeline->seekFrame(obj.getCurrentTime(), false, 0, eTimelineChangeReasonOtherSeek);
 
 
+        loadPhases.push_back( std::make_pair( "Project settings", phaseTimer.getTimeElapsedReset() ) );
+
         /// 3) Restore the nodes
 
         std::map<std::string, bool> processedModules;
@@ -214,6 +221,7 @@ ProjectPrivate::restoreFromSerialization(const ProjectSerialization & obj,
                 break;
             }
         }
+        loadPhases.push_back( std::make_pair( "Nodes creation, knobs and connections", phaseTimer.getTimeElapsedReset() ) );
 
         // restore the Knob links stored in the Knobs during NodeCollectionSerialization::restoreFromSerialization()
         NodesList allNodes;
@@ -232,10 +240,13 @@ ProjectPrivate::restoreFromSerialization(const ProjectSerialization & obj,
             }
         }
 
+        loadPhases.push_back( std::make_pair( "Links and expressions", phaseTimer.getTimeElapsedReset() ) );
+
         _publicInterface->getApp()->updateProjectLoadStatus( tr("Restoring graph stream preferences...") );
     } // CreatingNodeTreeFlag_RAII creatingNodeTreeFlag(_publicInterface->getApp());
 
     _publicInterface->forceComputeInputDependentDataOnAllTrees();
+    loadPhases.push_back( std::make_pair( "Graph stream preferences", phaseTimer.getTimeElapsedReset() ) );
 
     QDateTime time = QDateTime::currentDateTime();
     autoSetProjectFormat = false;
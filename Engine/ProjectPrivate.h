@@ -30,6 +30,8 @@
 
 #include <map>
 #include <list>
+#include <string>
+#include <utility>
 
 CLANG_DIAG_OFF(deprecated)
 CLANG_DIAG_OFF(uninitialized)
@@ -62,6 +64,7 @@ public:
     Project* _publicInterface;
     mutable QMutex projectLock; //< protects the whole project
     QString lastAutoSaveFilePath; //< absolute file path of the last auto-save file
+    U64 lastAutoSaveHash; //< hash of the content of the last auto-save file, 0 if unknown
     bool hasProjectBeenSavedByUser; //< has this project ever been saved by the user?
     QDateTime ageSinceLastSave; //< the last time the user saved
     QDateTime lastAutoSave; //< the last time since autosave
@@ -106,6 +109,7 @@ public:
     mutable QMutex isLoadingProjectMutex;
     bool isLoadingProject; //< true when the project is loading
     bool isLoadingProjectInternal; //< true when loading the internal project (not gui)
+    std::list<std::pair<std::string, double> > loadPhases; //< seconds spent in each phase of the last project load, only used on the main-thread
     mutable QMutex isSavingProjectMutex;
     bool isSavingProject; //< true when the project is saving
     std::shared_ptr<QTimer> autoSaveTimer;
@@ -28,6 +28,7 @@
 
 #include "Global/Macros.h"
 
+#include <ostream>
 #include <stdexcept>
 
 #if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
@@ -105,6 +106,8 @@ class ProjectSerialization
     qint64 _creationDate;
     AppInstanceWPtr _app;
     unsigned int _version;
+    std::ostream* _timelineTimeStream; //< if not NULL, save() records where it writes the timeline time in this stream
+    mutable std::streamoff _timelineTimeOffset;
 
     ProjectBeingLoadedInfo _projectLoadedInfo;
 
@@ -115,6 +118,8 @@ public:
         , _creationDate(0)
         , _app(app)
         , _version(0)
+        , _timelineTimeStream(0)
+        , _timelineTimeOffset(-1)
     {
     }
 
@@ -139,6 +144,24 @@ public:
         return _timelineCurrent;
     }
 
+    /**
+     * @brief When the serialization is next saved to a binary archive writing to the given stream, the offset in the stream
+     * of the timeline time is recorded, see getTimelineTimeOffset(). Auto-saves use it to ignore the timeline position.
+     **/
+    void recordTimelineTimeOffset(std::ostream* os)
+    {
+        _timelineTimeStream = os;
+        _timelineTimeOffset = -1;
+    }
+
+    /**
+     * @brief Returns the offset recorded by recordTimelineTimeOffset(), or -1 if unknown.
+     **/
+    std::streamoff getTimelineTimeOffset() const
+    {
+        return _timelineTimeOffset;
+    }
+
     const std::list<KnobSerializationPtr  > & getProjectKnobsValues() const
     {
         return _projectKnobs;
@@ -213,6 +236,9 @@ public:
             ar & ::boost::serialization::make_nvp( "item", *(*it) );
         }
         ar & ::boost::serialization::make_nvp("AdditionalFormats", _additionalFormats);
+        if (_timelineTimeStream) {
+            _timelineTimeOffset = _timelineTimeStream->tellp();
+        }
         ar & ::boost::serialization::make_nvp("Timeline_current_time", _timelineCurrent);
         ar & ::boost::serialization::make_nvp("CreationDate", _creationDate);
     }
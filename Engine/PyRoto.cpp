@@ -289,6 +289,14 @@ BezierCurve::setFeatherPointAtIndex(int index,
     _bezier->setPointAtIndex(true, index, time, x, y, lx, ly, rx, ry);
 }
 
+void
+BezierCurve::setPointsAtTimes(const std::vector<double>& times,
+                              const std::vector<double>& points,
+                              const std::vector<double>& featherPoints)
+{
+    _bezier->setPointsAtTimes(times, points, featherPoints);
+}
+
 int
 BezierCurve::getNumControlPoints() const
 {
@@ -29,6 +29,7 @@
 #include "Global/Macros.h"
 
 #include <list>
+#include <vector>
 
 #include "Engine/MergingEnum.h"
 #include "Engine/PyParameter.h"
@@ -127,6 +128,8 @@ public:
 
     void setFeatherPointAtIndex(int index, double time, double x, double y, double lx, double ly, double rx, double ry);
 
+    void setPointsAtTimes(const std::vector<double>& times, const std::vector<double>& points, const std::vector<double>& featherPoints);
+
     int getNumControlPoints() const;
 
     void getKeyframes(std::list<double>* keys) const;
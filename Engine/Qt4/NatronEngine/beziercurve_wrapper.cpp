@@ -1699,6 +1699,64 @@ static PyObject* Sbk_BezierCurveFunc_setPointAtIndex(PyObject* self, PyObject* a
         return 0;
 }
 
+static PyObject* Sbk_BezierCurveFunc_setPointsAtTimes(PyObject* self, PyObject* args)
+{
+    ::BezierCurve* cppSelf = 0;
+    SBK_UNUSED(cppSelf)
+    if (!Shiboken::Object::isValid(self))
+        return 0;
+    cppSelf = ((::BezierCurve*)Shiboken::Conversions::cppPointer(SbkNatronEngineTypes[SBK_BEZIERCURVE_IDX], (SbkObject*)self));
+    int overloadId = -1;
+    PythonToCppFunc pythonToCpp[] = { 0, 0, 0 };
+    SBK_UNUSED(pythonToCpp)
+    int numArgs = PyTuple_GET_SIZE(args);
+    PyObject* pyArgs[] = {0, 0, 0};
+
+    // invalid argument lengths
+
+
+    if (!PyArg_UnpackTuple(args, "setPointsAtTimes", 3, 3, &(pyArgs[0]), &(pyArgs[1]), &(pyArgs[2])))
+        return 0;
+
+
+    // Overloaded function decisor
+    // 0: setPointsAtTimes(std::vector<double>,std::vector<double>,std::vector<double>)
+    if (numArgs == 3
+        && (pythonToCpp[0] = Shiboken::Conversions::isPythonToCppConvertible(SbkNatronEngineTypeConverters[SBK_NATRONENGINE_STD_VECTOR_DOUBLE_IDX], (pyArgs[0])))
+        && (pythonToCpp[1] = Shiboken::Conversions::isPythonToCppConvertible(SbkNatronEngineTypeConverters[SBK_NATRONENGINE_STD_VECTOR_DOUBLE_IDX], (pyArgs[1])))
+        && (pythonToCpp[2] = Shiboken::Conversions::isPythonToCppConvertible(SbkNatronEngineTypeConverters[SBK_NATRONENGINE_STD_VECTOR_DOUBLE_IDX], (pyArgs[2])))) {
+        overloadId = 0; // setPointsAtTimes(std::vector<double>,std::vector<double>,std::vector<double>)
+    }
+
+    // Function signature not found.
+    if (overloadId == -1) goto Sbk_BezierCurveFunc_setPointsAtTimes_TypeError;
+
+    // Call function/method
+    {
+        ::std::vector<double > cppArg0;
+        pythonToCpp[0](pyArgs[0], &cppArg0);
+        ::std::vector<double > cppArg1;
+        pythonToCpp[1](pyArgs[1], &cppArg1);
+        ::std::vector<double > cppArg2;
+        pythonToCpp[2](pyArgs[2], &cppArg2);
+
+        if (!PyErr_Occurred()) {
+            // setPointsAtTimes(std::vector<double>,std::vector<double>,std::vector<double>)
+            cppSelf->setPointsAtTimes(cppArg0, cppArg1, cppArg2);
+        }
+    }
+
+    if (PyErr_Occurred()) {
+        return 0;
+    }
+    Py_RETURN_NONE;
+
+    Sbk_BezierCurveFunc_setPointsAtTimes_TypeError:
+        const char* overloads[] = {"list, list, list", 0};
+        Shiboken::setErrorAboutWrongArguments(args, "NatronEngine.BezierCurve.setPointsAtTimes", overloads);
+        return 0;
+}
+
 static PyMethodDef Sbk_BezierCurve_methods[] = {
     {"addControlPoint", (PyCFunction)Sbk_BezierCurveFunc_addControlPoint, METH_VARARGS},
     {"addControlPointOnSegment", (PyCFunction)Sbk_BezierCurveFunc_addControlPointOnSegment, METH_VARARGS},
@@ -1735,6 +1793,7 @@ static PyMethodDef Sbk_BezierCurve_methods[] = {
     {"setOpacity", (PyCFunction)Sbk_BezierCurveFunc_setOpacity, METH_VARARGS},
     {"setOverlayColor", (PyCFunction)Sbk_BezierCurveFunc_setOverlayColor, METH_VARARGS},
     {"setPointAtIndex", (PyCFunction)Sbk_BezierCurveFunc_setPointAtIndex, METH_VARARGS},
+    {"setPointsAtTimes", (PyCFunction)Sbk_BezierCurveFunc_setPointsAtTimes, METH_VARARGS},
 
     {0} // Sentinel
 };
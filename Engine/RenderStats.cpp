@@ -49,6 +49,9 @@ struct NodeRenderStatsPrivate
     //Is identity
     NodeWPtr isWholeImageIdentity;
 
+    //Number of pass-through nodes skipped between this node and isWholeImageIdentity
+    int nbPassThroughNodesElided;
+
     //The list of all tiles rendered
     std::list<RectI> rectanglesRendered;
 
@@ -78,10 +81,17 @@ struct NodeRenderStatsPrivate
     //Premultiplication of the output imge
     ImagePremultiplicationEnum outputPremult;
 
+    //Roto shapes geometry: number of shapes evaluated (one per motion blur sample), how many were found in the
+    //caches of the Beziers, and the time spent computing or fetching them
+    int nbShapeGeometries;
+    int nbShapeGeometriesCached;
+    double timeSpentInShapeGeometry;
+
     NodeRenderStatsPrivate()
         : totalTimeSpentRendering(0)
         , rod()
         , isWholeImageIdentity()
+        , nbPassThroughNodesElided(0)
         , rectanglesRendered()
         , identityRectangles()
         , mipmapLevelsAccessed()
@@ -93,6 +103,9 @@ struct NodeRenderStatsPrivate
         , renderScaleSupportEnabled(false)
         , channelsEnabled()
         , outputPremult(eImagePremultiplicationOpaque)
+        , nbShapeGeometries(0)
+        , nbShapeGeometriesCached(0)
+        , timeSpentInShapeGeometry(0)
     {
         for (int i = 0; i < 4; ++i) {
             channelsEnabled[i] = false;
@@ -121,6 +134,7 @@ NodeRenderStats::operator=(const NodeRenderStats& other)
     _imp->totalTimeSpentRendering = other._imp->totalTimeSpentRendering;
     _imp->rod = other._imp->rod;
     _imp->isWholeImageIdentity = other._imp->isWholeImageIdentity;
+    _imp->nbPassThroughNodesElided = other._imp->nbPassThroughNodesElided;
     _imp->rectanglesRendered = other._imp->rectanglesRendered;
     _imp->identityRectangles  = other._imp->identityRectangles;
     _imp->mipmapLevelsAccessed = other._imp->mipmapLevelsAccessed;
@@ -134,6 +148,9 @@ NodeRenderStats::operator=(const NodeRenderStats& other)
         _imp->channelsEnabled[i] = other._imp->channelsEnabled[i];
     }
     _imp->outputPremult = other._imp->outputPremult;
+    _imp->nbShapeGeometries = other._imp->nbShapeGeometries;
+    _imp->nbShapeGeometriesCached = other._imp->nbShapeGeometriesCached;
+    _imp->timeSpentInShapeGeometry = other._imp->timeSpentInShapeGeometry;
 }
 
 void
@@ -172,6 +189,18 @@ NodeRenderStats::getInputImageIdentity() const
     return _imp->isWholeImageIdentity.lock();
 }
 
+void
+NodeRenderStats::setNbPassThroughNodesElided(int nbNodes)
+{
+    _imp->nbPassThroughNodesElided = nbNodes;
+}
+
+int
+NodeRenderStats::getNbPassThroughNodesElided() const
+{
+    return _imp->nbPassThroughNodesElided;
+}
+
 void
 NodeRenderStats::addRenderedRectangle(const RectI& rectangle)
 {
@@ -302,6 +331,26 @@ NodeRenderStats::getOutputPremult() const
     return _imp->outputPremult;
 }
 
+void
+NodeRenderStats::addShapeGeometryInfos(int nbGeometries,
+                                       int nbCached,
+                                       double timeSpent)
+{
+    _imp->nbShapeGeometries += nbGeometries;
+    _imp->nbShapeGeometriesCached += nbCached;
+    _imp->timeSpentInShapeGeometry += timeSpent;
+}
+
+void
+NodeRenderStats::getShapeGeometryInfos(int* nbGeometries,
+                                       int* nbCached,
+                                       double* timeSpent) const
+{
+    *nbGeometries = _imp->nbShapeGeometries;
+    *nbCached = _imp->nbShapeGeometriesCached;
+    *timeSpent = _imp->timeSpentInShapeGeometry;
+}
+
 struct RenderStatsPrivate
 {
     mutable QMutex lock;
@@ -380,6 +429,20 @@ RenderStats::setNodeIdentity(const NodePtr& node,
     stats.setInputImageIdentity(identity);
 }
 
+void
+RenderStats::setNodePassThroughCollapsed(const NodePtr& node,
+                                         const NodePtr& identity,
+                                         int nbNodesElided)
+{
+    QMutexLocker k(&_imp->lock);
+
+    assert(_imp->doNodesProfiling);
+
+    NodeRenderStats& stats = _imp->findOrCreateNodeStats(node);
+    stats.setInputImageIdentity(identity);
+    stats.setNbPassThroughNodesElided(nbNodesElided);
+}
+
 void
 RenderStats::setGlobalRenderInfosForNode(const NodePtr& node,
                                          const RectD& rod,
@@ -436,6 +499,20 @@ RenderStats::addRenderInfosForNode(const NodePtr& node,
     stats.addPlaneRendered(plane);
 }
 
+void
+RenderStats::addShapeGeometryInfosForNode(const NodePtr& node,
+                                          int nbGeometries,
+                                          int nbCached,
+                                          double timeSpent)
+{
+    QMutexLocker k(&_imp->lock);
+
+    assert(_imp->doNodesProfiling);
+
+    NodeRenderStats& stats = _imp->findOrCreateNodeStats(node);
+    stats.addShapeGeometryInfos(nbGeometries, nbCached, timeSpent);
+}
+
 std::map<NodePtr, NodeRenderStats >
 RenderStats::getStats(double *totalTimeSpent) const
 {
@@ -67,6 +67,9 @@ public:
     void setInputImageIdentity(const NodePtr& identity);
     NodePtr getInputImageIdentity() const;
 
+    void setNbPassThroughNodesElided(int nbNodes);
+    int getNbPassThroughNodesElided() const;
+
     void addRenderedRectangle(const RectI& rectangle);
     const std::list<RectI>& getRenderedRectangles() const;
 
@@ -94,6 +97,9 @@ public:
     void setOutputPremult(ImagePremultiplicationEnum premult);
     ImagePremultiplicationEnum getOutputPremult() const;
 
+    void addShapeGeometryInfos(int nbGeometries, int nbCached, double timeSpent);
+    void getShapeGeometryInfos(int* nbGeometries, int* nbCached, double* timeSpent) const;
+
 private:
 
     std::unique_ptr<NodeRenderStatsPrivate> _imp;
@@ -119,6 +125,12 @@ public:
 
     void setNodeIdentity(const NodePtr& node, const NodePtr& identity);
 
+    /**
+     * @brief Called when the identity chain starting at node was collapsed by the request pass:
+     * the render went directly to identity, skipping nbNodesElided pass-through nodes in-between.
+     **/
+    void setNodePassThroughCollapsed(const NodePtr& node, const NodePtr& identity, int nbNodesElided);
+
     void setGlobalRenderInfosForNode(const NodePtr& node,
                                      const RectD& rod,
                                      ImagePremultiplicationEnum outputPremult,
@@ -137,6 +149,15 @@ public:
                                const RectI& rectangle,
                                double timeSpent);
 
+    /**
+     * @brief Called when the masks of Roto shapes are rendered for node: nbGeometries shape geometries were needed,
+     * nbCached of which were found in the caches of the Beziers, and timeSpent seconds were spent getting them.
+     **/
+    void addShapeGeometryInfosForNode(const NodePtr& node,
+                                      int nbGeometries,
+                                      int nbCached,
+                                      double timeSpent);
+
     std::map<NodePtr, NodeRenderStats > getStats(double *totalTimeSpent) const;
 
 private:
@@ -32,6 +32,7 @@
 #include <cassert>
 #include <stdexcept>
 #include <cstring> // for std::memcpy, std::memset
+#include <functional>
 #include <sstream> // stringstream
 
 #include <QtCore/QLineF>
@@ -39,6 +40,12 @@
 
 //#define ROTO_RENDER_TRIANGLES_ONLY
 
+// Render the masks of closed beziers with RotoShapeRasterizer instead of cairo
+#define ROTO_RENDER_NATIVE_RASTERIZER
+
+// Render the masks of finished strokes and open beziers with RotoStrokeStamper instead of cairo
+#define ROTO_RENDER_NATIVE_STAMPER
+
 #include "libtess.h"
 
 #include "Engine/RotoContextPrivate.h"
@@ -48,6 +55,7 @@
 #include "Engine/BezierCP.h"
 #include "Engine/CreateNodeArgs.h"
 #include "Engine/CoonsRegularization.h"
+#include "Engine/EffectInstance.h"
 #include "Engine/FeatherPoint.h"
 #include "Engine/Format.h"
 #include "Engine/Hash64.h"
@@ -60,9 +68,11 @@
 #include "Engine/RotoContextSerialization.h"
 #include "Engine/RotoDrawableItem.h"
 #include "Engine/RotoLayer.h"
+#include "Engine/RotoRenderBands.h"
 #include "Engine/RotoStrokeItem.h"
 #include "Engine/Settings.h"
 #include "Engine/TimeLine.h"
+#include "Engine/Timer.h"
 #include "Engine/Transform.h"
 #include "Engine/ViewerInstance.h"
 #include "Engine/ViewIdx.h"
@@ -94,6 +104,12 @@
 // http://www.davidrevoy.com/article182/calibrating-wacom-stylus-pressure-on-krita
 #define ROTO_PRESSURE_LEVELS 512
 
+// Minimum number of pixels added on each side when the image of a paint stroke being drawn must grow
+#define ROTO_STROKE_IMAGE_MIN_PADDING 64
+
+// Minimum number of rows of a band when rendering a paint stroke over several threads
+#define ROTO_STROKE_RENDER_MIN_BAND_HEIGHT 16
+
 #ifndef M_PI
 #define M_PI        3.14159265358979323846264338327950288   /* pi             */
 #endif
@@ -269,6 +285,7 @@ RotoContext::addLayerInternal(bool declarePython)
         QMutexLocker l(&_imp->rotoContextMutex);
 
         _imp->layers.push_back(item);
+        _imp->spatialIndex.invalidateAll();
 
         _imp->lastInsertedItem = item;
     }
@@ -294,6 +311,7 @@ RotoContext::addLayer(const RotoLayerPtr & layer)
 
     if ( it == _imp->layers.end() ) {
         _imp->layers.push_back(layer);
+        _imp->spatialIndex.invalidateAll();
     }
 }
 
@@ -620,6 +638,7 @@ RotoContext::removeItemRecursively(const RotoItemPtr& item,
         for (std::list<RotoLayerPtr>::iterator it = _imp->layers.begin(); it != _imp->layers.end(); ++it) {
             if (*it == isLayer) {
                 _imp->layers.erase(it);
+                _imp->spatialIndex.invalidateAll();
                 break;
             }
         }
@@ -663,6 +682,7 @@ RotoContext::addItem(const RotoLayerPtr& layer,
             std::list<RotoLayerPtr>::iterator foundLayer = std::find(_imp->layers.begin(), _imp->layers.end(), isLayer);
             if ( foundLayer == _imp->layers.end() ) {
                 _imp->layers.push_back(isLayer);
+                _imp->spatialIndex.invalidateAll();
             }
         }
         _imp->lastInsertedItem = item;
@@ -690,18 +710,19 @@ RotoContext::isNearbyBezier(double x,
     ///MT-safe: only called on the main-thread
     assert( QThread::currentThread() == qApp->thread() );
 
+    // Only test the beziers whose bounding box is within the acceptance of the point
+    std::vector<RotoDrawableItemPtr> candidates = getItemsIntersectingRect( getTimelineCurrentTime(),
+                                                                            RectD(x - acceptance, y - acceptance, x + acceptance, y + acceptance) );
+
     QMutexLocker l(&_imp->rotoContextMutex);
     std::list<std::pair<BezierPtr, std::pair<int, double> > > nearbyBeziers;
-    for (std::list<RotoLayerPtr>::const_iterator it = _imp->layers.begin(); it != _imp->layers.end(); ++it) {
-        const RotoItems & items = (*it)->getItems();
-        for (RotoItems::const_iterator it2 = items.begin(); it2 != items.end(); ++it2) {
-            BezierPtr b = std::dynamic_pointer_cast<Bezier>(*it2);
-            if ( b && !b->isLockedRecursive() ) {
-                double param;
-                int i = b->isPointOnCurve(x, y, acceptance, &param, feather);
-                if (i != -1) {
-                    nearbyBeziers.push_back( std::make_pair( b, std::make_pair(i, param) ) );
-                }
+    for (std::vector<RotoDrawableItemPtr>::const_iterator it = candidates.begin(); it != candidates.end(); ++it) {
+        BezierPtr b = std::dynamic_pointer_cast<Bezier>(*it);
+        if ( b && !b->isLockedRecursive() ) {
+            double param;
+            int i = b->isPointOnCurve(x, y, acceptance, &param, feather);
+            if (i != -1) {
+                nearbyBeziers.push_back( std::make_pair( b, std::make_pair(i, param) ) );
             }
         }
     }
@@ -732,6 +753,36 @@ RotoContext::isNearbyBezier(double x,
     }
 
     return BezierPtr();
+} // RotoContext::isNearbyBezier
+
+std::vector<RotoDrawableItemPtr>
+RotoContext::getItemsIntersectingRect(double time,
+                                      const RectD& rect) const
+{
+    std::vector<RotoDrawableItemPtr> ret;
+    RotoSpatialIndex::ItemsProvider provider = [this](std::vector<RotoDrawableItemPtr>* items) {
+        QMutexLocker l(&_imp->rotoContextMutex);
+
+        for (std::list<RotoLayerPtr>::const_iterator it = _imp->layers.begin(); it != _imp->layers.end(); ++it) {
+            RotoItems layerItems = (*it)->getItems_mt_safe();
+            for (RotoItems::iterator it2 = layerItems.begin(); it2 != layerItems.end(); ++it2) {
+                RotoDrawableItemPtr drawable = std::dynamic_pointer_cast<RotoDrawableItem>(*it2);
+                if (drawable) {
+                    items->push_back(drawable);
+                }
+            }
+        }
+    };
+
+    _imp->spatialIndex.getItemsIntersecting(time, rect, provider, &ret);
+
+    return ret;
+}
+
+void
+RotoContext::invalidateItemBounds(const RotoDrawableItem* item)
+{
+    _imp->spatialIndex.invalidateItem(item);
 }
 
 void
@@ -1241,6 +1292,8 @@ RotoContext::selectInternal(const RotoItemPtr & item, bool slaveKnobs)
                 }
             }
         }
+        // the slaved knobs now drive the geometry of the item
+        invalidateItemBounds(isDrawable);
     } else if (isLayer) {
         const RotoItems & children = isLayer->getItems();
         for (RotoItems::const_iterator it = children.begin(); it != children.end(); ++it) {
@@ -1396,6 +1449,7 @@ RotoContext::deselectInternal(RotoItemPtr b)
                 }
             }
         }
+        invalidateItemBounds(isDrawable);
     } else if (isLayer) {
         const RotoItems & children = isLayer->getItems();
         for (RotoItems::const_iterator it = children.begin(); it != children.end(); ++it) {
@@ -2319,6 +2373,87 @@ convertCairoImageToNatronImage_noColor(cairo_surface_t* cairoImg,
     }
 }
 
+#if defined(ROTO_RENDER_NATIVE_RASTERIZER) || defined(ROTO_RENDER_NATIVE_STAMPER)
+template <typename PIX, int maxValue, int dstNComps>
+static void
+convertCoverageToNatronImageForDstComponents(const float* coverage,
+                                             Image::WriteAccess& acc,
+                                             const RectI & tile,
+                                             double shapeColor[3],
+                                             double opacity,
+                                             bool inverted)
+{
+    double r = shapeColor[0] * opacity;
+    double g = shapeColor[1] * opacity;
+    double b = shapeColor[2] * opacity;
+    int width = tile.width();
+
+    for (int y = tile.y1; y < tile.y2; ++y) {
+        PIX* dstPix = (PIX*)acc.pixelAt(tile.x1, y);
+        assert(dstPix);
+        const float* srcPix = coverage + (std::size_t)(y - tile.y1) * width;
+
+        for (int x = 0; x < width; ++x,
+             dstPix += dstNComps,
+             ++srcPix) {
+            // same as convertCairoImageToNatronImageForInverted_noColor
+            float pixel = !inverted ? (*srcPix * maxValue) : 1. - (*srcPix * maxValue);
+            switch (dstNComps) {
+            case 4:
+                dstPix[0] = PIX(pixel * r);
+                dstPix[1] = PIX(pixel * g);
+                dstPix[2] = PIX(pixel * b);
+                dstPix[3] = PIX(pixel * opacity);
+                break;
+            case 1:
+                dstPix[0] = PIX(pixel * opacity);
+                break;
+            case 3:
+                dstPix[0] = PIX(pixel * r);
+                dstPix[1] = PIX(pixel * g);
+                dstPix[2] = PIX(pixel * b);
+                break;
+            case 2:
+                dstPix[0] = PIX(pixel * r);
+                dstPix[1] = PIX(pixel * g);
+                break;
+
+            default:
+                break;
+            }
+        }
+    }
+}
+
+template <typename PIX, int maxValue>
+static void
+convertCoverageToNatronImage(const float* coverage,
+                             Image::WriteAccess& acc,
+                             int nComps,
+                             const RectI & tile,
+                             double shapeColor[3],
+                             double opacity,
+                             bool inverted)
+{
+    switch (nComps) {
+    case 1:
+        convertCoverageToNatronImageForDstComponents<PIX, maxValue, 1>(coverage, acc, tile, shapeColor, opacity, inverted);
+        break;
+    case 2:
+        convertCoverageToNatronImageForDstComponents<PIX, maxValue, 2>(coverage, acc, tile, shapeColor, opacity, inverted);
+        break;
+    case 3:
+        convertCoverageToNatronImageForDstComponents<PIX, maxValue, 3>(coverage, acc, tile, shapeColor, opacity, inverted);
+        break;
+    case 4:
+        convertCoverageToNatronImageForDstComponents<PIX, maxValue, 4>(coverage, acc, tile, shapeColor, opacity, inverted);
+        break;
+    default:
+        break;
+    }
+}
+#endif // defined(ROTO_RENDER_NATIVE_RASTERIZER) || defined(ROTO_RENDER_NATIVE_STAMPER)
+
 #if 0
 template <typename PIX, int maxValue, int srcNComps, int dstNComps>
 static void
@@ -2605,11 +2740,32 @@ RotoStrokeItem::renderSingleStroke(const RectD& pointsBbox,
             *image = source;
         } else {
             RectD otherRoD = (*image)->getRoD();
-            RectI oldBounds = (*image)->getBounds();
+            const RectI oldBounds = (*image)->getBounds();
             RectD mergeRoD = pointsBbox;
             mergeRoD.merge(otherRoD);
             source->setRoD(mergeRoD);
-            source->ensureBounds(pixelPointsBbox, true);
+            if ( !oldBounds.contains(pixelPointsBbox) ) {
+                // Grow the stroke image geometrically on the sides where the stroke goes out of it: otherwise
+                // each new point near the border reallocates and copies the whole image.
+                const int minPadding = ROTO_STROKE_IMAGE_MIN_PADDING;
+                const int padX = std::max( minPadding, oldBounds.width() / 2 );
+                const int padY = std::max( minPadding, oldBounds.height() / 2 );
+                RectI grownBounds = oldBounds;
+                if (pixelPointsBbox.x1 < oldBounds.x1) {
+                    grownBounds.x1 = pixelPointsBbox.x1 - padX;
+                }
+                if (pixelPointsBbox.x2 > oldBounds.x2) {
+                    grownBounds.x2 = pixelPointsBbox.x2 + padX;
+                }
+                if (pixelPointsBbox.y1 < oldBounds.y1) {
+                    grownBounds.y1 = pixelPointsBbox.y1 - padY;
+                }
+                if (pixelPointsBbox.y2 > oldBounds.y2) {
+                    grownBounds.y2 = pixelPointsBbox.y2 + padY;
+                }
+                grownBounds.merge(pixelPointsBbox);
+                source->ensureBounds(grownBounds, true);
+            }
         }
         copyFromImage = true;
     }
@@ -2720,16 +2876,29 @@ RotoDrawableItem::renderMaskFromStroke(const ImagePlaneDesc& components,
     NodePtr node = getContext()->getNode();
     ImagePtr image; // = stroke->getStrokeTimePreview();
 
-    ///compute an enhanced hash different from the one of the merge node of the item in order to differentiate within the cache
-    ///the output image of the node and the mask image.
+    ///The mask only depends on this item: hash its own state rather than the hash of its merge node, which depends on all
+    ///the items upstream, so that editing an item does not invalidate the cached masks of the items rendered after it.
+    ///The merge node tree then recomposites the output from the cached masks.
     U64 rotoHash;
     {
         Hash64 hash;
-        U64 mergeNodeHash = getMergeNode()->getEffectInstance()->getRenderHash();
-        hash.append(mergeNodeHash);
+        hash.append(_imp->serial);
+        hash.append( (U64)(int)_imp->maskAge );
+#ifdef NATRON_ROTO_ENABLE_MOTION_BLUR
+        hash.append( getContext()->getMotionBlurTypeKnob()->getValue() );
+#endif
+        if ( getInverted(time) ) {
+            hash.append(rotoNodeSrcRod.x1);
+            hash.append(rotoNodeSrcRod.y1);
+            hash.append(rotoNodeSrcRod.x2);
+            hash.append(rotoNodeSrcRod.y2);
+        }
+        if ( hasKnobsDrivenByOthers() ) {
+            // the item may change without being edited
+            hash.append( getMergeNode()->getEffectInstance()->getRenderHash() );
+        }
         hash.computeHash();
         rotoHash = hash.value();
-        assert(mergeNodeHash != rotoHash);
     }
     std::unique_ptr<ImageKey> key( new ImageKey(this,
                                                   rotoHash,
@@ -2842,9 +3011,145 @@ RotoDrawableItem::renderMaskFromStroke(const ImagePlaneDesc& components,
 
     image = renderMaskInternal(pixelRod, components, startTime, endTime, mbFrameStep, time, inverted, depth, mipmapLevel, strokes, image);
 
+    ///The render stops at the abort checkpoints and leaves a partial mask: do not let later renders find it in the cache
+    if ( EffectInstance::isCurrentThreadRenderAborted() ) {
+        appPTR->removeFromNodeCache(image);
+    }
+
     return image;
 } // RotoDrawableItem::renderMaskFromStroke
 
+/**
+ * @brief Renders the dots of a paint stroke or an open bezier to the image over several threads: natively with
+ * RotoStrokeStamper, or with one cairo surface per band of the RoI.
+ **/
+static void
+renderStrokeMaskByBands(const RotoDrawableItem* item,
+                        const RectI & roi,
+                        cairo_format_t cairoImgFormat,
+                        int srcNComps,
+                        bool doBuildUp,
+                        double opacity,
+                        double shapeColor[3],
+                        double time,
+                        bool inverted,
+                        bool useOpacityToConvert,
+                        ImageBitDepthEnum depth,
+                        unsigned int mipmapLevel,
+                        const std::list<std::list<std::pair<Point, double> > >& strokes,
+                        const ImagePtr &image)
+{
+    if ( roi.isNull() ) {
+        return;
+    }
+
+    // The dots are laid along the strokes once, each band then only renders the dots overlapping it
+    RotoStrokeBrush brush = RotoStrokeBrush();
+    std::vector<RotoStrokeDot> dots;
+    if ( !strokes.empty() && RotoContextPrivate::getStrokeBrush(item, doBuildUp, opacity, time, mipmapLevel, &brush) ) {
+        RotoContextPrivate::computeStrokeDots(brush, strokes, 0, &dots);
+    }
+    if ( EffectInstance::isCurrentThreadRenderAborted() ) {
+        return;
+    }
+
+#ifdef ROTO_RENDER_NATIVE_STAMPER
+    Q_UNUSED(cairoImgFormat);
+    Q_UNUSED(srcNComps);
+    Image::WriteAccess acc = image->getWriteRights();
+    int nComps = (int)image->getComponentsCount();
+    // strokes are converted without opacity: it is already in the dots
+    double convertOpacity = useOpacityToConvert ? opacity : 1.;
+    RotoStrokeStamper::TileWriter writer = [&](const RectI& tile, const float* coverage) {
+        switch (depth) {
+        case eImageBitDepthFloat:
+            convertCoverageToNatronImage<float, 1>(coverage, acc, nComps, tile, shapeColor, convertOpacity, inverted);
+            break;
+        case eImageBitDepthByte:
+            convertCoverageToNatronImage<unsigned char, 255>(coverage, acc, nComps, tile, shapeColor, convertOpacity, inverted);
+            break;
+        case eImageBitDepthShort:
+            convertCoverageToNatronImage<unsigned short, 65535>(coverage, acc, nComps, tile, shapeColor, convertOpacity, inverted);
+            break;
+        case eImageBitDepthHalf:
+        case eImageBitDepthNone:
+            assert(false);
+            break;
+        }
+    };
+    RotoStrokeStamper::render(brush, dots, roi, writer);
+#else
+    // Split the RoI in bands of rows, each rendered on its own cairo surface
+    RotoRenderBands renderBands(roi, ROTO_STROKE_RENDER_MIN_BAND_HEIGHT);
+    const std::vector<RectI>& bands = renderBands.getBands();
+
+    renderBands.render([&](const int& b) {
+        const RectI& band = bands[b];
+        CairoImageWrapper imgWrapper;
+
+        imgWrapper.cairoImg = cairo_image_surface_create( cairoImgFormat, band.width(), band.height() );
+        cairo_surface_set_device_offset(imgWrapper.cairoImg, -band.x1, -band.y1);
+        if (cairo_surface_status(imgWrapper.cairoImg) != CAIRO_STATUS_SUCCESS) {
+            return;
+        }
+        if ( !dots.empty() ) {
+            imgWrapper.ctx = cairo_create(imgWrapper.cairoImg);
+            cairo_set_fill_rule(imgWrapper.ctx, CAIRO_FILL_RULE_WINDING);
+            // see renderMaskInternal
+            cairo_set_antialias(imgWrapper.ctx, CAIRO_ANTIALIAS_NONE);
+
+            std::vector<cairo_pattern_t*> dotPatterns(ROTO_PRESSURE_LEVELS, (cairo_pattern_t*)0);
+            RotoContextPrivate::renderStrokeDots(imgWrapper.ctx, dotPatterns, brush, dots, &band);
+            for (std::size_t i = 0; i < dotPatterns.size(); ++i) {
+                if (dotPatterns[i]) {
+                    cairo_pattern_destroy(dotPatterns[i]);
+                }
+            }
+        }
+
+        ///A call to cairo_surface_flush() is required before accessing the pixel data
+        ///to ensure that all pending drawing operations are finished.
+        cairo_surface_flush(imgWrapper.cairoImg);
+
+        switch (depth) {
+        case eImageBitDepthFloat:
+            convertCairoImageToNatronImage_noColor<float, 1>(imgWrapper.cairoImg, srcNComps, image.get(), band, shapeColor, opacity, inverted, useOpacityToConvert);
+            break;
+        case eImageBitDepthByte:
+            convertCairoImageToNatronImage_noColor<unsigned char, 255>(imgWrapper.cairoImg, srcNComps,  image.get(), band, shapeColor, opacity, inverted,  useOpacityToConvert);
+            break;
+        case eImageBitDepthShort:
+            convertCairoImageToNatronImage_noColor<unsigned short, 65535>(imgWrapper.cairoImg, srcNComps, image.get(), band, shapeColor, opacity, inverted, useOpacityToConvert);
+            break;
+        case eImageBitDepthHalf:
+        case eImageBitDepthNone:
+            assert(false);
+            break;
+        }
+    });
+#endif // ROTO_RENDER_NATIVE_STAMPER
+} // renderStrokeMaskByBands
+
+///The statistics of the render which requested the mask of the item, if in-depth profiling is enabled.
+///The mask is requested from the render of the merge node of the item, or of its effect node.
+static RenderStatsPtr
+getMaskRenderStats(const RotoDrawableItem* item)
+{
+    NodePtr nodes[2] = { item->getMergeNode(), item->getEffectNode() };
+
+    for (int i = 0; i < 2; ++i) {
+        if (!nodes[i]) {
+            continue;
+        }
+        ParallelRenderArgsPtr frameArgs = nodes[i]->getEffectInstance()->getParallelRenderArgsTLS();
+        if ( frameArgs && frameArgs->stats && frameArgs->stats->isInDepthProfilingEnabled() ) {
+            return frameArgs->stats;
+        }
+    }
+
+    return RenderStatsPtr();
+}
+
 ImagePtr
 RotoDrawableItem::renderMaskInternal(const RectI & roi,
                                      const ImagePlaneDesc& components,
@@ -2892,6 +3197,68 @@ RotoDrawableItem::renderMaskInternal(const RectI & roi,
 
     double opacity = getOpacity(time);
 
+#ifdef ROTO_RENDER_NATIVE_RASTERIZER
+    if ( !isStroke && isBezier && !isBezier->isOpenBezier() ) {
+        ///render the bezier only if finished (closed) and activated, as in RotoContextPrivate::renderBezier
+        std::vector<RotoShapeRenderData> samples;
+        if ( isBezier->isCurveFinished() && isBezier->isActivated(time) && (isBezier->getControlPointsCount() > 1) ) {
+            RenderStatsPtr stats = getMaskRenderStats(this);
+            TimeLapsePtr timeRecorder;
+            if (stats) {
+                timeRecorder = std::make_shared<TimeLapse>();
+            }
+            int nbGeometries = 0, nbCached = 0;
+            for (double t = startTime; t <= endTime; t += timeStep) {
+                // the partial mask of an aborted render is removed from the cache by renderMaskFromStroke
+                if ( EffectInstance::isCurrentThreadRenderAborted() ) {
+                    return image;
+                }
+                RotoShapeRenderData sample;
+                if ( isBezier->getRenderDataAtTime(t, mipmapLevel, &sample) ) {
+                    ++nbCached;
+                }
+                ++nbGeometries;
+                // samples where the shape does not move are accumulated in a single pass
+                RotoShapeRasterizer::appendSample(sample, &samples);
+            }
+            if (stats) {
+                stats->addShapeGeometryInfosForNode( node, nbGeometries, nbCached, timeRecorder->getTimeSinceCreation() );
+            }
+        }
+
+        Image::WriteAccess acc = image->getWriteRights();
+        int nComps = (int)image->getComponentsCount();
+        RotoShapeRasterizer::TileWriter writer = [&](const RectI& tile, const float* coverage) {
+            switch (depth) {
+            case eImageBitDepthFloat:
+                convertCoverageToNatronImage<float, 1>(coverage, acc, nComps, tile, shapeColor, opacity, inverted);
+                break;
+            case eImageBitDepthByte:
+                convertCoverageToNatronImage<unsigned char, 255>(coverage, acc, nComps, tile, shapeColor, opacity, inverted);
+                break;
+            case eImageBitDepthShort:
+                convertCoverageToNatronImage<unsigned short, 65535>(coverage, acc, nComps, tile, shapeColor, opacity, inverted);
+                break;
+            case eImageBitDepthHalf:
+            case eImageBitDepthNone:
+                assert(false);
+                break;
+            }
+        };
+        RotoShapeRasterizer::render(samples, roi, writer);
+
+        return image;
+    }
+#endif
+
+    assert(isStroke || isBezier);
+    if ( isStroke || !isBezier || ( isBezier && isBezier->isOpenBezier() ) ) {
+        // open beziers are converted with the opacity, as below
+        renderStrokeMaskByBands(this, roi, cairoImgFormat, srcNComps, doBuildUp, opacity, shapeColor, time, inverted, isBezier != 0, depth, mipmapLevel, strokes, image);
+
+        return image;
+    }
+
     ////Allocate the cairo temporary buffer
     CairoImageWrapper imgWrapper;
 
@@ -2913,23 +3280,7 @@ RotoDrawableItem::renderMaskInternal(const RectI & roi,
     cairo_set_antialias(imgWrapper.ctx, CAIRO_ANTIALIAS_NONE);
 
 
-    assert(isStroke || isBezier);
-    if ( isStroke || !isBezier || ( isBezier && isBezier->isOpenBezier() ) ) {
-        std::vector<cairo_pattern_t*> dotPatterns(ROTO_PRESSURE_LEVELS);
-        for (std::size_t i = 0; i < dotPatterns.size(); ++i) {
-            dotPatterns[i] = (cairo_pattern_t*)0;
-        }
-        RotoContextPrivate::renderStroke(imgWrapper.ctx, dotPatterns, strokes, 0, this, doBuildUp, opacity, time, mipmapLevel);
-
-        for (std::size_t i = 0; i < dotPatterns.size(); ++i) {
-            if (dotPatterns[i]) {
-                cairo_pattern_destroy(dotPatterns[i]);
-                dotPatterns[i] = 0;
-            }
-        }
-    } else {
-        RotoContextPrivate::renderBezier(imgWrapper.ctx, isBezier, opacity, time, startTime, endTime, timeStep, mipmapLevel);
-    }
+    RotoContextPrivate::renderBezier(imgWrapper.ctx, isBezier, opacity, time, startTime, endTime, timeStep, mipmapLevel);
 
     bool useOpacityToConvert = (isBezier != 0);
 
@@ -2960,25 +3311,6 @@ RotoDrawableItem::renderMaskInternal(const RectI & roi,
     return image;
 } // RotoDrawableItem::renderMaskInternal
 
-static inline
-double
-hardnessGaussLookup(double f)
-{
-    //2 hyperbolas + 1 parabola to approximate a gauss function
-    if (f < -0.5) {
-        f = -1. - f;
-
-        return (2. * f * f);
-    }
-
-    if (f < 0.5) {
-        return (1. - 2. * f * f);
-    }
-    f = 1. - f;
-
-    return (2. * f * f);
-}
-
 void
 RotoContextPrivate::renderDot(cairo_t* cr,
                               std::vector<cairo_pattern_t*>* dotPatterns,
@@ -2988,10 +3320,13 @@ RotoContextPrivate::renderDot(cairo_t* cr,
                               double pressure,
                               bool doBuildUp,
                               const std::vector<std::pair<double, double> >& opacityStops,
-                              double opacity)
+                              double opacity,
+                              bool checkBounds)
 {
+    Q_UNUSED(checkBounds);
     if ( !opacityStops.empty() ) {
         cairo_pattern_t* pattern;
+        bool ownsPattern = false;
         // sometimes, Qt gives a pressure level > 1... so we clamp it
         int pressureInt = int(std::max( 0., std::min(pressure, 1.) ) * (ROTO_PRESSURE_LEVELS - 1) + 0.5);
         assert(pressureInt >= 0 && pressureInt < ROTO_PRESSURE_LEVELS);
@@ -3007,10 +3342,15 @@ RotoContextPrivate::renderDot(cairo_t* cr,
                 }
             }
             //dotPatterns[pressureInt] = pattern;
+            ownsPattern = true;
         }
         cairo_translate(cr, center.x, center.y);
         cairo_set_source(cr, pattern);
         cairo_translate(cr, -center.x, -center.y);
+        if (ownsPattern) {
+            // the context holds its own reference on the source
+            cairo_pattern_destroy(pattern);
+        }
     } else {
         if (doBuildUp) {
             cairo_set_source_rgba(cr, 1., 1., 1., opacity);
@@ -3020,148 +3360,108 @@ RotoContextPrivate::renderDot(cairo_t* cr,
     }
 #ifdef DEBUG
     //Make sure the dot we are about to render falls inside the clip region, otherwise the bounds of the image are mis-calculated.
-    cairo_surface_t* target = cairo_get_target(cr);
-    int w = cairo_image_surface_get_width(target);
-    int h = cairo_image_surface_get_height(target);
-    double x1, y1;
-    cairo_surface_get_device_offset(target, &x1, &y1);
-    assert(std::floor(center.x - externalDotRadius) >= -x1 && std::floor(center.x + externalDotRadius) < -x1 + w &&
-           std::floor(center.y - externalDotRadius) >= -y1 && std::floor(center.y + externalDotRadius) < -y1 + h);
+    //This does not hold when the image is rendered by bands, each band only receiving the part of the dots that overlaps it.
+    if (checkBounds) {
+        cairo_surface_t* target = cairo_get_target(cr);
+        int w = cairo_image_surface_get_width(target);
+        int h = cairo_image_surface_get_height(target);
+        double x1, y1;
+        cairo_surface_get_device_offset(target, &x1, &y1);
+        assert(std::floor(center.x - externalDotRadius) >= -x1 && std::floor(center.x + externalDotRadius) < -x1 + w &&
+               std::floor(center.y - externalDotRadius) >= -y1 && std::floor(center.y + externalDotRadius) < -y1 + h);
+    }
 #endif
     cairo_arc(cr, center.x, center.y, externalDotRadius, 0, M_PI * 2);
     cairo_fill(cr);
 }
 
-static void
-getRenderDotParams(double alpha,
-                   double brushSizePixel,
-                   double brushHardness,
-                   double brushSpacing,
-                   double pressure,
-                   bool pressureAffectsOpacity,
-                   bool pressureAffectsSize,
-                   bool pressureAffectsHardness,
-                   double* internalDotRadius,
-                   double* externalDotRadius,
-                   double * spacing,
-                   std::vector<std::pair<double, double> >* opacityStops)
-{
-    if (pressureAffectsSize) {
-        brushSizePixel *= pressure;
-    }
-    if (pressureAffectsHardness) {
-        brushHardness *= pressure;
-    }
-    if (pressureAffectsOpacity) {
-        alpha *= pressure;
-    }
-
-    *internalDotRadius = std::max(brushSizePixel * brushHardness, 1.) / 2.;
-    *externalDotRadius = std::max(brushSizePixel, 1.) / 2.;
-    *spacing = *externalDotRadius * 2. * brushSpacing;
-
-
-    opacityStops->clear();
-
-    double exp = brushHardness != 1.0 ?  0.4 / (1.0 - brushHardness) : 0.;
-    const int maxStops = 8;
-    double incr = 1. / maxStops;
-
-    if (brushHardness != 1.) {
-        for (double d = 0; d <= 1.; d += incr) {
-            double o = hardnessGaussLookup( std::pow(d, exp) );
-            opacityStops->push_back( std::make_pair(d, o * alpha) );
-        }
-    }
-}
-
-double
-RotoContextPrivate::renderStroke(cairo_t* cr,
-                                 std::vector<cairo_pattern_t*>& dotPatterns,
-                                 const std::list<std::list<std::pair<Point, double> > >& strokes,
-                                 double distToNext,
-                                 const RotoDrawableItem* stroke,
-                                 bool doBuildup,
-                                 double alpha,
-                                 double time,
-                                 unsigned int mipmapLevel)
+bool
+RotoContextPrivate::getStrokeBrush(const RotoDrawableItem* stroke,
+                                   bool doBuildup,
+                                   double opacity,
+                                   double time,
+                                   unsigned int mipmapLevel,
+                                   RotoStrokeBrush* brush)
 {
-    if ( strokes.empty() ) {
-        return distToNext;
-    }
-
     if ( !stroke || !stroke->isActivated(time) ) {
-        return distToNext;
+        return false;
     }
 
-    assert(dotPatterns.size() == ROTO_PRESSURE_LEVELS);
-
     KnobDoublePtr brushSizeKnob = stroke->getBrushSizeKnob();
     double brushSize = brushSizeKnob->getValueAtTime(time);
     KnobDoublePtr brushSpacingKnob = stroke->getBrushSpacingKnob();
     double brushSpacing = brushSpacingKnob->getValueAtTime(time);
     if (brushSpacing == 0.) {
-        return distToNext;
+        return false;
     }
 
 
-    brushSpacing = std::max(brushSpacing, 0.05);
+    brush->brushSpacing = std::max(brushSpacing, 0.05);
 
     KnobDoublePtr brushHardnessKnob = stroke->getBrushHardnessKnob();
-    double brushHardness = brushHardnessKnob->getValueAtTime(time);
+    brush->brushHardness = brushHardnessKnob->getValueAtTime(time);
     KnobDoublePtr visiblePortionKnob = stroke->getBrushVisiblePortionKnob();
-    double writeOnStart = visiblePortionKnob->getValueAtTime(time, 0);
-    double writeOnEnd = visiblePortionKnob->getValueAtTime(time, 1);
-    if ( (writeOnEnd - writeOnStart) <= 0. ) {
-        return distToNext;
+    brush->writeOnStart = visiblePortionKnob->getValueAtTime(time, 0);
+    brush->writeOnEnd = visiblePortionKnob->getValueAtTime(time, 1);
+    if ( (brush->writeOnEnd - brush->writeOnStart) <= 0. ) {
+        return false;
     }
 
     KnobBoolPtr pressureOpacityKnob = stroke->getPressureOpacityKnob();
     KnobBoolPtr pressureSizeKnob = stroke->getPressureSizeKnob();
     KnobBoolPtr pressureHardnessKnob = stroke->getPressureHardnessKnob();
-    bool pressureAffectsOpacity = pressureOpacityKnob->getValueAtTime(time);
-    bool pressureAffectsSize = pressureSizeKnob->getValueAtTime(time);
-    bool pressureAffectsHardness = pressureHardnessKnob->getValueAtTime(time);
-    double brushSizePixel = brushSize;
+    brush->pressureAffectsOpacity = pressureOpacityKnob->getValueAtTime(time);
+    brush->pressureAffectsSize = pressureSizeKnob->getValueAtTime(time);
+    brush->pressureAffectsHardness = pressureHardnessKnob->getValueAtTime(time);
+    brush->brushSizePixel = brushSize;
     if (mipmapLevel != 0) {
-        brushSizePixel = std::max( 1., brushSizePixel / (1 << mipmapLevel) );
+        brush->brushSizePixel = std::max( 1., brush->brushSizePixel / (1 << mipmapLevel) );
     }
-    cairo_set_operator(cr, doBuildup ? CAIRO_OPERATOR_OVER : CAIRO_OPERATOR_LIGHTEN);
+    brush->opacity = opacity;
+    brush->doBuildUp = doBuildup;
 
+    return true;
+} // RotoContextPrivate::getStrokeBrush
 
+double
+RotoContextPrivate::computeStrokeDots(const RotoStrokeBrush& brush,
+                                      const std::list<std::list<std::pair<Point, double> > >& strokes,
+                                      double distToNext,
+                                      std::vector<RotoStrokeDot>* dots)
+{
     for (std::list<std::list<std::pair<Point, double> > >::const_iterator strokeIt = strokes.begin(); strokeIt != strokes.end(); ++strokeIt) {
-        int firstPoint = (int)std::floor( (strokeIt->size() * writeOnStart) );
-        int endPoint = (int)std::ceil( (strokeIt->size() * writeOnEnd) );
+        // Abort checkpoint: the partial mask of an aborted render is removed from the cache by renderMaskFromStroke
+        if ( EffectInstance::isCurrentThreadRenderAborted() ) {
+            return distToNext;
+        }
+
+        int firstPoint = (int)std::floor( (strokeIt->size() * brush.writeOnStart) );
+        int endPoint = (int)std::ceil( (strokeIt->size() * brush.writeOnEnd) );
         assert( firstPoint >= 0 && firstPoint < (int)strokeIt->size() && endPoint > firstPoint && endPoint <= (int)strokeIt->size() );
 
 
         ///The visible portion of the paint's stroke with points adjusted to pixel coordinates
-        std::list<std::pair<Point, double> > visiblePortion;
-        std::list<std::pair<Point, double> >::const_iterator startingIt = strokeIt->begin();
+        std::list<std::pair<Point, double> >::const_iterator it = strokeIt->begin();
         std::list<std::pair<Point, double> >::const_iterator endingIt = strokeIt->begin();
-        std::advance(startingIt, firstPoint);
+        std::advance(it, firstPoint);
         std::advance(endingIt, endPoint);
-        for (std::list<std::pair<Point, double> >::const_iterator it = startingIt; it != endingIt; ++it) {
-            visiblePortion.push_back(*it);
-        }
-        if ( visiblePortion.empty() ) {
+        if (it == endingIt) {
             return distToNext;
         }
 
-        std::list<std::pair<Point, double> >::iterator it = visiblePortion.begin();
+        double internalDotRadius, externalDotRadius, spacing;
+        std::vector<std::pair<double, double> > opacityStops;
+        std::list<std::pair<Point, double> >::const_iterator next = it;
+        ++next;
 
-        if (visiblePortion.size() == 1) {
-            double internalDotRadius, externalDotRadius, spacing;
-            std::vector<std::pair<double, double> > opacityStops;
-            getRenderDotParams(alpha, brushSizePixel, brushHardness, brushSpacing, it->second, pressureAffectsOpacity, pressureAffectsSize, pressureAffectsHardness, &internalDotRadius, &externalDotRadius, &spacing, &opacityStops);
-            renderDot(cr, &dotPatterns, it->first, internalDotRadius, externalDotRadius, it->second, doBuildup, opacityStops, alpha);
+        if (next == endingIt) {
+            RotoStrokeStamper::getDotParams(brush.opacity, brush.brushSizePixel, brush.brushHardness, brush.brushSpacing, it->second, brush.pressureAffectsOpacity, brush.pressureAffectsSize, brush.pressureAffectsHardness, &internalDotRadius, &externalDotRadius, &spacing, &opacityStops);
+            RotoStrokeDot dot = { it->first, it->second, externalDotRadius };
+            dots->push_back(dot);
             continue;
         }
 
-        std::list<std::pair<Point, double> >::iterator next = it;
-        ++next;
-
-        while ( next != visiblePortion.end() ) {
+        while (next != endingIt) {
             //Render for each point a dot. Spacing is a percentage of brushSize:
             //Spacing at 1 means no dot is overlapping another (so the spacing is in fact brushSize)
             //Spacing at 0 we do not render the stroke
@@ -3171,17 +3471,14 @@ RotoContextPrivate::renderStroke(cairo_t* cr,
             // while the next point can be drawn on this segment, draw a point and advance
             while (distToNext <= dist) {
                 double a = dist == 0. ? 0. : distToNext / dist;
-                Point center = {
-                    it->first.x * (1 - a) + next->first.x * a,
-                    it->first.y * (1 - a) + next->first.y * a
-                };
-                double pressure = it->second * (1 - a) + next->second * a;
-
-                // draw the dot
-                double internalDotRadius, externalDotRadius, spacing;
-                std::vector<std::pair<double, double> > opacityStops;
-                getRenderDotParams(alpha, brushSizePixel, brushHardness, brushSpacing, pressure, pressureAffectsOpacity, pressureAffectsSize, pressureAffectsHardness, &internalDotRadius, &externalDotRadius, &spacing, &opacityStops);
-                renderDot(cr, &dotPatterns, center, internalDotRadius, externalDotRadius, pressure, doBuildup, opacityStops, alpha);
+                RotoStrokeDot dot;
+                dot.center.x = it->first.x * (1 - a) + next->first.x * a;
+                dot.center.y = it->first.y * (1 - a) + next->first.y * a;
+                dot.pressure = it->second * (1 - a) + next->second * a;
+
+                RotoStrokeStamper::getDotParams(brush.opacity, brush.brushSizePixel, brush.brushHardness, brush.brushSpacing, dot.pressure, brush.pressureAffectsOpacity, brush.pressureAffectsSize, brush.pressureAffectsHardness, &internalDotRadius, &externalDotRadius, &spacing, &opacityStops);
+                dot.externalDotRadius = externalDotRadius;
+                dots->push_back(dot);
 
                 distToNext += spacing;
             }
@@ -3193,6 +3490,56 @@ RotoContextPrivate::renderStroke(cairo_t* cr,
         }
     }
 
+    return distToNext;
+} // RotoContextPrivate::computeStrokeDots
+
+void
+RotoContextPrivate::renderStrokeDots(cairo_t* cr,
+                                     std::vector<cairo_pattern_t*>& dotPatterns,
+                                     const RotoStrokeBrush& brush,
+                                     const std::vector<RotoStrokeDot>& dots,
+                                     const RectI* clip)
+{
+    assert(dotPatterns.size() == ROTO_PRESSURE_LEVELS);
+
+    cairo_set_operator(cr, brush.doBuildUp ? CAIRO_OPERATOR_OVER : CAIRO_OPERATOR_LIGHTEN);
+
+    double internalDotRadius, externalDotRadius, spacing;
+    std::vector<std::pair<double, double> > opacityStops;
+    for (std::vector<RotoStrokeDot>::const_iterator it = dots.begin(); it != dots.end(); ++it) {
+        if ( clip &&
+             ( ( (it->center.x + it->externalDotRadius) < clip->x1 ) || ( (it->center.x - it->externalDotRadius) >= clip->x2 ) ||
+               ( (it->center.y + it->externalDotRadius) < clip->y1 ) || ( (it->center.y - it->externalDotRadius) >= clip->y2 ) ) ) {
+            continue;
+        }
+        RotoStrokeStamper::getDotParams(brush.opacity, brush.brushSizePixel, brush.brushHardness, brush.brushSpacing, it->pressure, brush.pressureAffectsOpacity, brush.pressureAffectsSize, brush.pressureAffectsHardness, &internalDotRadius, &externalDotRadius, &spacing, &opacityStops);
+        renderDot(cr, &dotPatterns, it->center, internalDotRadius, externalDotRadius, it->pressure, brush.doBuildUp, opacityStops, brush.opacity, clip == 0);
+    }
+} // RotoContextPrivate::renderStrokeDots
+
+double
+RotoContextPrivate::renderStroke(cairo_t* cr,
+                                 std::vector<cairo_pattern_t*>& dotPatterns,
+                                 const std::list<std::list<std::pair<Point, double> > >& strokes,
+                                 double distToNext,
+                                 const RotoDrawableItem* stroke,
+                                 bool doBuildup,
+                                 double alpha,
+                                 double time,
+                                 unsigned int mipmapLevel)
+{
+    if ( strokes.empty() ) {
+        return distToNext;
+    }
+
+    RotoStrokeBrush brush;
+    if ( !getStrokeBrush(stroke, doBuildup, alpha, time, mipmapLevel, &brush) ) {
+        return distToNext;
+    }
+
+    std::vector<RotoStrokeDot> dots;
+    distToNext = computeStrokeDots(brush, strokes, distToNext, &dots);
+    renderStrokeDots(cr, dotPatterns, brush, dots, 0);
 
     return distToNext;
 } // RotoContextPrivate::renderStroke
@@ -3231,7 +3578,7 @@ RotoContext::allocateAndRenderSingleDotStroke(int brushSizePixel,
     const double pressure = 1.;
     const double brushspacing = 0.;
 
-    getRenderDotParams(alpha, brushSizePixel, brushHardness, brushspacing, pressure, false, false, false, &internalDotRadius, &externalDotRadius, &spacing, &opacityStops);
+    RotoStrokeStamper::getDotParams(alpha, brushSizePixel, brushHardness, brushspacing, pressure, false, false, false, &internalDotRadius, &externalDotRadius, &spacing, &opacityStops);
     RotoContextPrivate::renderDot(wrapper.ctx, 0, p, internalDotRadius, externalDotRadius, pressure, true, opacityStops, alpha);
 
     return true;
@@ -3254,6 +3601,11 @@ RotoContextPrivate::renderBezier(cairo_t* cr,
 
     for (double t = startTime; t <= endTime; t+=mbFrameStep) {
 
+        // Abort checkpoint between motion-blur samples: the partial mask is removed from the cache by renderMaskFromStroke
+        if ( EffectInstance::isCurrentThreadRenderAborted() ) {
+            return;
+        }
+
         double fallOff = bezier->getFeatherFallOff(t);
         double featherDist = bezier->getFeatherDistance(t);
         double shapeColor[3];
@@ -3317,8 +3669,19 @@ RotoContextPrivate::renderFeather(const Bezier* bezier,
 {
     ///Note that we do not use the opacity when rendering the bezier, it is rendered with correct floating point opacity/color when converting
     ///to the Natron image.
+    std::vector<RotoShapeRenderData::FeatherQuad> feather;
 
-    double fallOffInverse = 1. / fallOff;
+    computeFeatherQuads(bezier, time, mipmapLevel, featherDist, &feather);
+    RotoShapeRasterizer::renderFeatherCairo(feather, shapeColor, fallOff, mesh);
+}
+
+void
+RotoContextPrivate::computeFeatherQuads(const Bezier* bezier,
+                                        double time,
+                                        unsigned int mipmapLevel,
+                                        double featherDist,
+                                        std::vector<RotoShapeRenderData::FeatherQuad>* feather)
+{
     /*
      * We descretize the feather control points to obtain a polygon so that the feather distance will be of the same thickness around all the shape.
      * If we were to extend only the end points, the resulting bezier interpolation would create a feather with different thickness around the shape,
@@ -3386,9 +3749,6 @@ RotoContextPrivate::renderFeather(const Bezier* bezier,
     }
 
 
-    double innerOpacity = 1.;
-    double outterOpacity = 0.;
-
     Point origin = p1;
     featherContour.push_back(p1);
 
@@ -3442,7 +3802,7 @@ RotoContextPrivate::renderFeather(const Bezier* bezier,
             continue;
         }*/
 
-        Point p0, p0p1, p1p0, p2, p2p3, p3p2, p3;
+        Point p0, p2, p3;
         p0.x = prevBez->x;
         p0.y = prevBez->y;
         p3.x = bezIT->x;
@@ -3473,46 +3833,12 @@ RotoContextPrivate::renderFeather(const Bezier* bezier,
         }
         featherContour.push_back(p2);
 
-        ///linear interpolation
-        p0p1.x = (p0.x * fallOff * 2. + fallOffInverse * p1.x) / (fallOff * 2. + fallOffInverse);
-        p0p1.y = (p0.y * fallOff * 2. + fallOffInverse * p1.y) / (fallOff * 2. + fallOffInverse);
-        p1p0.x = (p0.x * fallOff + 2. * fallOffInverse * p1.x) / (fallOff + 2. * fallOffInverse);
-        p1p0.y = (p0.y * fallOff + 2. * fallOffInverse * p1.y) / (fallOff + 2. * fallOffInverse);
-
-
-        p2p3.x = (p3.x * fallOff + 2. * fallOffInverse * p2.x) / (fallOff + 2. * fallOffInverse);
-        p2p3.y = (p3.y * fallOff + 2. * fallOffInverse * p2.y) / (fallOff + 2. * fallOffInverse);
-        p3p2.x = (p3.x * fallOff * 2. + fallOffInverse * p2.x) / (fallOff * 2. + fallOffInverse);
-        p3p2.y = (p3.y * fallOff * 2. + fallOffInverse * p2.y) / (fallOff * 2. + fallOffInverse);
-
-
-        ///move to the initial point
-        cairo_mesh_pattern_begin_patch(mesh);
-        cairo_mesh_pattern_move_to(mesh, p0.x, p0.y);
-        cairo_mesh_pattern_curve_to(mesh, p0p1.x, p0p1.y, p1p0.x, p1p0.y, p1.x, p1.y);
-        cairo_mesh_pattern_line_to(mesh, p2.x, p2.y);
-        cairo_mesh_pattern_curve_to(mesh, p2p3.x, p2p3.y, p3p2.x, p3p2.y, p3.x, p3.y);
-        cairo_mesh_pattern_line_to(mesh, p0.x, p0.y);
-        ///Set the 4 corners color
-        ///inner is full color
-
-        // IMPORTANT NOTE:
-        // The two sqrt below are due to a probable cairo bug.
-        // To check whether the bug is present is a given cairo version,
-        // make any shape with a very large feather and set
-        // opacity to 0.5. Then, zoom on the polygon border to check if the intensity is continuous
-        // and approximately equal to 0.5.
-        // If the bug if ixed in cairo, please use #if CAIRO_VERSION>xxx to keep compatibility with
-        // older Cairo versions.
-        cairo_mesh_pattern_set_corner_color_rgba( mesh, 0, shapeColor[0], shapeColor[1], shapeColor[2], innerOpacity);
-        ///outer is faded
-        cairo_mesh_pattern_set_corner_color_rgba(mesh, 1, shapeColor[0], shapeColor[1], shapeColor[2], outterOpacity);
-        cairo_mesh_pattern_set_corner_color_rgba(mesh, 2, shapeColor[0], shapeColor[1], shapeColor[2], outterOpacity);
-        ///inner is full color
-        cairo_mesh_pattern_set_corner_color_rgba(mesh, 3, shapeColor[0], shapeColor[1], shapeColor[2], innerOpacity);
-        assert(cairo_pattern_status(mesh) == CAIRO_STATUS_SUCCESS);
-
-        cairo_mesh_pattern_end_patch(mesh);
+        RotoShapeRenderData::FeatherQuad quad;
+        quad.p0 = p0;
+        quad.p1 = p1;
+        quad.p2 = p2;
+        quad.p3 = p3;
+        feather->push_back(quad);
 
         if (mustStop) {
             break;
@@ -3537,7 +3863,7 @@ RotoContextPrivate::renderFeather(const Bezier* bezier,
             ++prevBez;
         }
     }  // for each point in polygon
-} // RotoContextPrivate::renderFeather
+} // RotoContextPrivate::computeFeatherQuads
 
 void
 RotoContextPrivate::renderFeather_cairo(const std::list<RotoFeatherVertex>& vertices, double shapeColor[3], double fallOff, cairo_pattern_t * mesh)
@@ -3809,6 +4135,56 @@ static void tess_intersection_combine_callback(double coords[3], void */*data*/[
     myData->allocatedIntersections.push_back(ret);
 }
 
+///Returns true if the closed polygon is convex and does not wind more than once around its interior, in which case
+///it is a triangle fan from any of its vertices. Collinear vertices are allowed.
+static bool
+isConvexPolygon(const std::vector<Point>& polygon)
+{
+    int n = (int)polygon.size();
+
+    if (n < 3) {
+        return false;
+    }
+    double orientation = 0.;
+    int nXDirectionChanges = 0;
+    double prevDx = 0.;
+    for (int i = 0; i < n; ++i) {
+        const Point& a = polygon[i];
+        const Point& b = polygon[(i + 1) % n];
+        const Point& c = polygon[(i + 2) % n];
+        double cross = (b.x - a.x) * (c.y - b.y) - (b.y - a.y) * (c.x - b.x);
+        if (cross != 0.) {
+            if (orientation == 0.) {
+                orientation = cross;
+            } else if ( (orientation > 0.) != (cross > 0.) ) {
+                return false;
+            }
+        }
+
+        // a polygon turning in the same direction at every vertex may still wind several times (e.g. a star):
+        // a convex one only goes back and forth once along x
+        double dx = b.x - a.x;
+        if (dx != 0.) {
+            if ( (prevDx != 0.) && ( (prevDx > 0.) != (dx > 0.) ) ) {
+                ++nXDirectionChanges;
+            }
+            prevDx = dx;
+        }
+    }
+    // close the sequence of directions
+    for (int i = 0; i < n; ++i) {
+        double dx = polygon[(i + 1) % n].x - polygon[i].x;
+        if (dx != 0.) {
+            if ( (prevDx > 0.) != (dx > 0.) ) {
+                ++nXDirectionChanges;
+            }
+            break;
+        }
+    }
+
+    return orientation != 0. && nXDirectionChanges <= 2;
+} // isConvexPolygon
+
 void
 RotoContextPrivate::computeTriangles(const Bezier * bezier, double time, unsigned int mipmapLevel, double featherDist,
                                      std::list<RotoFeatherVertex>* featherMesh,
@@ -3988,6 +4364,30 @@ RotoContextPrivate::computeTriangles(const Bezier * bezier, double time, unsigne
 
     } // for all points in polygon
 
+    // Convex shapes (e.g. rectangles and ellipses) are a single triangle fan and do not need the tessellator.
+    // Consecutive segments share their end points, which must appear only once in the fan.
+    std::vector<Point> polygon;
+    for (std::list<std::list<ParametricPoint> >::const_iterator it = bezierPolygon.begin(); it != bezierPolygon.end(); ++it) {
+        for (std::list<ParametricPoint>::const_iterator it2 = it->begin(); it2 != it->end(); ++it2) {
+            if ( polygon.empty() || (polygon.back().x != it2->x) || (polygon.back().y != it2->y) ) {
+                Point p;
+                p.x = it2->x;
+                p.y = it2->y;
+                polygon.push_back(p);
+            }
+        }
+    }
+    while ( (polygon.size() > 1) && (polygon.back().x == polygon.front().x) && (polygon.back().y == polygon.front().y) ) {
+        polygon.pop_back();
+    }
+    if ( isConvexPolygon(polygon) ) {
+        RotoTriangleFans fan;
+        fan.vertices.assign( polygon.begin(), polygon.end() );
+        internalFans->push_back(fan);
+
+        return;
+    }
+
     // Now tessellate the internal bezier using glu
     tessPolygonData tessData;
     tessData.internalStrips = internalStrips;
@@ -4162,9 +4562,10 @@ RotoContextPrivate::renderInternalShape(double time,
     std::list<BezierCPs> coonPatches;
     bezulate(time, cps, &coonPatches);
 
-    for (std::list<BezierCPs>::iterator it = coonPatches.begin(); it != coonPatches.end(); ++it) {
-        std::list<BezierCPs> fixedPatch;
-        CoonsRegularization::regularize(*it, time, &fixedPatch);
+    ///The patches are independent, regularize them all at once
+    std::list<BezierCPs> fixedPatch;
+    CoonsRegularization::regularizeAll(coonPatches, time, &fixedPatch);
+    {
         for (std::list<BezierCPs>::iterator it2 = fixedPatch.begin(); it2 != fixedPatch.end(); ++it2) {
             std::size_t size = it2->size();
             assert(size <= 4 && size >= 2);
@@ -4284,9 +4685,19 @@ RotoContextPrivate::renderInternalShape(double time,
         }
     }
 #else // ifdef ROTO_USE_MESH_PATTERN_ONLY
+    std::vector<RotoShapeRenderData::Cubic> shape;
+    computeInternalShape(time, mipmapLevel, transform, cps, &shape);
+    RotoShapeRasterizer::renderShapeCairo(shape, cr);
+#endif // ifdef ROTO_USE_MESH_PATTERN_ONLY
+} // RotoContextPrivate::renderInternalShape
 
-    cairo_set_source_rgba(cr, 1, 1, 1, 1);
-
+void
+RotoContextPrivate::computeInternalShape(double time,
+                                         unsigned int mipmapLevel,
+                                         const Transform::Matrix3x3& transform,
+                                         const BezierCPs & cps,
+                                         std::vector<RotoShapeRenderData::Cubic>* shape)
+{
     BezierCPs::const_iterator point = cps.begin();
     assert( point != cps.end() );
     if ( point == cps.end() ) {
@@ -4298,14 +4709,12 @@ RotoContextPrivate::renderInternalShape(double time,
     }
 
 
-    Transform::Point3D initCp;
-    (*point)->getPositionAtTime(false, time, ViewIdx(0), &initCp.x, &initCp.y);
-    initCp.z = 1.;
-    initCp = Transform::matApply(transform, initCp);
-
-    adjustToPointToScale(mipmapLevel, initCp.x, initCp.y);
+    Transform::Point3D cur;
+    (*point)->getPositionAtTime(false, time, ViewIdx(0), &cur.x, &cur.y);
+    cur.z = 1.;
+    cur = Transform::matApply(transform, cur);
 
-    cairo_move_to(cr, initCp.x, initCp.y);
+    adjustToPointToScale(mipmapLevel, cur.x, cur.y);
 
     while ( point != cps.end() ) {
         if ( nextPoint == cps.end() ) {
@@ -4327,7 +4736,18 @@ RotoContextPrivate::renderInternalShape(double time,
         adjustToPointToScale(mipmapLevel, right.x, right.y);
         adjustToPointToScale(mipmapLevel, next.x, next.y);
         adjustToPointToScale(mipmapLevel, nextLeft.x, nextLeft.y);
-        cairo_curve_to(cr, right.x, right.y, nextLeft.x, nextLeft.y, next.x, next.y);
+
+        RotoShapeRenderData::Cubic c;
+        c.p0.x = cur.x;
+        c.p0.y = cur.y;
+        c.p1.x = right.x;
+        c.p1.y = right.y;
+        c.p2.x = nextLeft.x;
+        c.p2.y = nextLeft.y;
+        c.p3.x = next.x;
+        c.p3.y = next.y;
+        shape->push_back(c);
+        cur = next;
 
         // increment for next iteration
         ++point;
@@ -4335,25 +4755,30 @@ RotoContextPrivate::renderInternalShape(double time,
             ++nextPoint;
         }
     } // while()
-//    if (cairo_get_antialias(cr) != CAIRO_ANTIALIAS_NONE ) {
-//        cairo_fill_preserve(cr);
-//        // These line properties make for a nicer looking polygon mesh
-//        cairo_set_line_join(cr, CAIRO_LINE_JOIN_BEVEL);
-//        cairo_set_line_cap(cr, CAIRO_LINE_CAP_BUTT);
-//        // Comment out the following call to cairo_set_line width
-//        // since the hard-coded width value of 1.0 is not appropriate
-//        // for fills of small areas. Instead, use the line width that
-//        // has already been set by the user via the above call of
-//        // poly_line which in turn calls set_current_context which in
-//        // turn calls cairo_set_line_width for the user-specified
-//        // width.
-//        cairo_set_line_width(cr, 1.0);
-//        cairo_stroke(cr);
-//    } else {
-    cairo_fill(cr);
-//    }
-#endif // ifdef ROTO_USE_MESH_PATTERN_ONLY
-} // RotoContextPrivate::renderInternalShape
+} // RotoContextPrivate::computeInternalShape
+
+void
+RotoContextPrivate::computeBezierRenderData(const Bezier* bezier,
+                                            double time,
+                                            unsigned int mipmapLevel,
+                                            RotoShapeRenderData* data)
+{
+    data->fallOff = bezier->getFeatherFallOff(time);
+
+    ///Adjust the feather distance so it takes the mipmap level into account
+    double featherDist = bezier->getFeatherDistance(time);
+    if (mipmapLevel != 0) {
+        featherDist /= (1 << mipmapLevel);
+    }
+
+    Transform::Matrix3x3 transform;
+    bezier->getTransformAtTime(time, &transform);
+
+    computeFeatherQuads(bezier, time, mipmapLevel, featherDist, &data->feather);
+
+    BezierCPs cps = bezier->getControlPoints_mt_safe();
+    computeInternalShape(time, mipmapLevel, transform, cps, &data->shape);
+}
 
 struct qpointf_compare_less
 {
@@ -4702,6 +5127,9 @@ RotoContext::getOrCreateGlobalMergeNode(int *availableInputIndex)
 void
 RotoContext::refreshRotoPaintTree()
 {
+    // Items were added, removed or reordered
+    _imp->spatialIndex.invalidateAll();
+
     if (_imp->isCurrentlyLoading) {
         return;
     }
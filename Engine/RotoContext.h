@@ -31,6 +31,7 @@
 #include <list>
 #include <set>
 #include <string>
+#include <vector>
 
 // clang-format off
 CLANG_DIAG_OFF(deprecated-declarations)
@@ -191,6 +192,19 @@ public:
      **/
     BezierPtr isNearbyBezier(double x, double y, double acceptance, int* index, double* t, bool *feather) const;
 
+    /**
+     * @brief Returns the drawable items that may draw inside the given rectangle (in canonical coordinates) at the given time,
+     * in the order of the layers. The bounding boxes of the items are kept in a spatial index, so that only the items
+     * around the rectangle are tested.
+     * MT-safe
+     **/
+    std::vector<RotoDrawableItemPtr> getItemsIntersectingRect(double time, const RectD& rect) const;
+
+    /**
+     * @brief Called when the geometry of an item may have changed, so that its bounding box gets updated in the spatial index.
+     **/
+    void invalidateItemBounds(const RotoDrawableItem* item);
+
 
     /**
      * @brief Returns the region of definition of the shape unioned to the region of definition of the node
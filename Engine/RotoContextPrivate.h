@@ -30,6 +30,7 @@
 
 #include <list>
 #include <map>
+#include <memory>
 #include <string>
 #include <vector>
 #include <limits>
@@ -39,6 +40,7 @@
 CLANG_DIAG_OFF(deprecated)
 CLANG_DIAG_OFF(uninitialized)
 #include <QtCore/QMutex>
+#include <QtCore/QAtomicInt>
 #include <QtCore/QReadWriteLock>
 #include <QtCore/QCoreApplication>
 #include <QtCore/QThread>
@@ -52,6 +54,7 @@ CLANG_DIAG_ON(uninitialized)
 #include "Global/GlobalDefines.h"
 
 #include "Engine/AppManager.h"
+#include "Engine/Bezier.h"
 #include "Engine/BezierCP.h"
 #include "Engine/Curve.h"
 #include "Engine/EffectInstance.h"
@@ -61,6 +64,9 @@ CLANG_DIAG_ON(uninitialized)
 #include "Engine/Node.h"
 #include "Engine/RotoContext.h"
 #include "Engine/RotoPaint.h"
+#include "Engine/RotoShapeRasterizer.h"
+#include "Engine/RotoSpatialIndex.h"
+#include "Engine/RotoStrokeStamper.h"
 #include "Engine/Transform.h"
 #include "Engine/ViewIdx.h"
 #include "Engine/EngineFwd.h"
@@ -392,6 +398,71 @@ struct RotoTriangles
     std::list<Point> vertices;
 };
 
+/**
+ * @brief What a polygon cached by a Bezier was computed from.
+ **/
+enum BezierPolygonCacheTypeEnum
+{
+    eBezierPolygonCacheTypeShape = 0, //< evaluateAtTime_DeCasteljau
+    eBezierPolygonCacheTypeFeather, //< evaluateFeatherPointsAtTime_DeCasteljau, skipping feather segments equal to the shape
+    eBezierPolygonCacheTypeFeatherAll, //< evaluateFeatherPointsAtTime_DeCasteljau, all feather segments
+    eBezierPolygonCacheTypeBbox, //< the bbox of the control points as used by getBoundingBox, no polygon
+    eBezierPolygonCacheTypeRenderData //< getRenderDataAtTime, no polygon
+};
+
+struct BezierPolygonCacheKey
+{
+    double time;
+    double precision; //< nbPointsPerSegment or errorScale, 0 for eBezierPolygonCacheTypeBbox, the feather distance for eBezierPolygonCacheTypeRenderData
+    unsigned int mipmapLevel;
+    BezierPolygonCacheTypeEnum type;
+    bool useGuiCurves;
+
+    BezierPolygonCacheKey(BezierPolygonCacheTypeEnum type,
+                          bool useGuiCurves,
+                          double time,
+                          unsigned int mipmapLevel,
+                          double precision)
+        : time(time)
+        , precision(precision)
+        , mipmapLevel(mipmapLevel)
+        , type(type)
+        , useGuiCurves(useGuiCurves)
+    {
+    }
+
+    bool operator<(const BezierPolygonCacheKey& other) const
+    {
+        if (time != other.time) {
+            return time < other.time;
+        }
+        if (precision != other.precision) {
+            return precision < other.precision;
+        }
+        if (mipmapLevel != other.mipmapLevel) {
+            return mipmapLevel < other.mipmapLevel;
+        }
+        if (type != other.type) {
+            return type < other.type;
+        }
+
+        return useGuiCurves < other.useGuiCurves;
+    }
+};
+
+struct BezierPolygonCacheEntry
+{
+    ///The transform of the item the polygon was computed with: it is animated separately from the
+    ///control points so an entry is only valid if the transform at that time did not change.
+    Transform::Matrix3x3 transform;
+    std::list<std::list<ParametricPoint> > polygon; //< one list per segment
+    RectD bbox;
+    std::shared_ptr<const RotoShapeRenderData> renderData; //< for eBezierPolygonCacheTypeRenderData
+};
+
+typedef std::shared_ptr<const BezierPolygonCacheEntry> BezierPolygonCacheEntryConstPtr;
+typedef std::map<BezierPolygonCacheKey, BezierPolygonCacheEntryConstPtr> BezierPolygonCache;
+
 struct BezierPrivate
 {
     BezierCPs points; //< the control points of the curve
@@ -409,6 +480,12 @@ struct BezierPrivate
     mutable QMutex guiCopyMutex;
     bool mustCopyGui;
 
+    ///Polygons evaluated by evaluateAtTime_DeCasteljau & co, so that the renderer, the overlay and
+    ///getBoundingBox do not re-evaluate the control points curves when the shape did not change.
+    mutable QMutex polygonCacheMutex; //< protects polygonCache and polygonCacheAge
+    mutable BezierPolygonCache polygonCache;
+    U64 polygonCacheAge; //< incremented each time the cache is invalidated
+
     BezierPrivate(bool isOpenBezier)
         : points()
         , featherPoints()
@@ -421,9 +498,30 @@ struct BezierPrivate
         , isOpenBezier(isOpenBezier)
         , guiCopyMutex()
         , mustCopyGui(false)
+        , polygonCacheMutex()
+        , polygonCache()
+        , polygonCacheAge(0)
     {
     }
 
+    /**
+     * @brief Returns the cached polygon for the given key if it was computed with the same transform,
+     * otherwise returns NULL and age is set to the value that must be passed to insertCachedPolygon.
+     **/
+    BezierPolygonCacheEntryConstPtr getCachedPolygon(const BezierPolygonCacheKey& key,
+                                                     const Transform::Matrix3x3& transform,
+                                                     U64* age) const;
+
+    /**
+     * @brief Caches the polygon unless the cache was invalidated since getCachedPolygon returned age,
+     * in which case it may have been computed from control points that were being edited.
+     **/
+    void insertCachedPolygon(const BezierPolygonCacheKey& key,
+                             U64 age,
+                             const BezierPolygonCacheEntryConstPtr& entry) const;
+
+    void invalidatePolygonCache();
+
     void setMustCopyGuiBezier(bool copy)
     {
         QMutexLocker k(&guiCopyMutex);
@@ -781,6 +879,12 @@ public:
     //Used to prevent 2 threads from writing the same image in the rotocontext
     mutable QReadWriteLock cacheAccessMutex;
 
+    ///Identifies the item in the hash of its cached masks, which does not depend on the other items
+    U64 serial;
+
+    ///Incremented whenever the geometry or the parameters of the item change, to invalidate its cached masks
+    QAtomicInt maskAge;
+
     RotoDrawableItemPrivate(bool isPaintingNode)
         : effectNode()
         , mergeNode()
@@ -829,6 +933,8 @@ public:
         , timeOffsetMode()
         , knobs()
         , cacheAccessMutex()
+        , serial(0)
+        , maskAge()
     {
         opacity = std::make_shared<KnobDouble>((KnobHolder*)NULL, tr(kRotoOpacityParamLabel), 1, true);
         opacity->setHintToolTip( tr(kRotoOpacityHint) );
@@ -1400,6 +1506,9 @@ public:
      */
     NodesList globalMergeNodes;
 
+    ///The bounding boxes of the drawable items, to find the ones intersecting a region without testing all of them
+    mutable RotoSpatialIndex spatialIndex;
+
     RotoContextPrivate(const NodePtr& n )
         : rotoContextMutex()
         , isPaintNode(false)
@@ -1413,6 +1522,7 @@ public:
         , doingNeatRender(false)
         , mustDoNeatRender(false)
         , globalMergeNodes()
+        , spatialIndex()
     {
         EffectInstancePtr effect = n->getEffectInstance();
         RotoPaint* isRotoNode = dynamic_cast<RotoPaint*>( effect.get() );
@@ -2213,7 +2323,8 @@ public:
                           double pressure,
                           bool doBuildUp,
                           const std::vector<std::pair<double, double> >& opacityStops,
-                          double opacity);
+                          double opacity,
+                          bool checkBounds = true);
     static double renderStroke(cairo_t* cr,
                                std::vector<cairo_pattern_t*>& dotPatterns,
                                const std::list<std::list<std::pair<Point, double> > >& strokes,
@@ -2223,8 +2334,37 @@ public:
                                double opacity,
                                double time,
                                unsigned int mipmapLevel);
+
+    /**
+     * @brief Returns the brush of the given stroke at the given time, or false if the stroke does not render anything
+     **/
+    static bool getStrokeBrush(const RotoDrawableItem* stroke,
+                               bool doBuildup,
+                               double opacity,
+                               double time,
+                               unsigned int mipmapLevel,
+                               RotoStrokeBrush* brush);
+
+    /**
+     * @brief Computes the dots laid along the given strokes, as rendered by renderStroke.
+     * The returned value is the distance to the next dot after the last point of the strokes.
+     **/
+    static double computeStrokeDots(const RotoStrokeBrush& brush,
+                                    const std::list<std::list<std::pair<Point, double> > >& strokes,
+                                    double distToNext,
+                                    std::vector<RotoStrokeDot>* dots);
+
+    /**
+     * @brief Renders the given dots. If clip is not NULL, dots which do not intersect it are skipped.
+     **/
+    static void renderStrokeDots(cairo_t* cr,
+                                 std::vector<cairo_pattern_t*>& dotPatterns,
+                                 const RotoStrokeBrush& brush,
+                                 const std::vector<RotoStrokeDot>& dots,
+                                 const RectI* clip);
     static void renderBezier(cairo_t* cr, const Bezier* bezier, double opacity, double time, double startTime, double endTime, double mbFrameStep, unsigned int mipmapLevel);
     static void renderFeather(const Bezier * bezier, double time, unsigned int mipmapLevel, double shapeColor[3], double opacity, double featherDist, double fallOff, cairo_pattern_t * mesh);
+    static void computeFeatherQuads(const Bezier * bezier, double time, unsigned int mipmapLevel, double featherDist, std::vector<RotoShapeRenderData::FeatherQuad>* feather);
     static void renderFeather_cairo(const std::list<RotoFeatherVertex>& vertices, double shapeColor[3],  double fallOff, cairo_pattern_t * mesh);
     static void renderInternalShape_cairo(const std::list<RotoTriangles>& triangles,
                                           const std::list<RotoTriangleFans>& fans,
@@ -2232,6 +2372,12 @@ public:
                                           double shapeColor[3],  cairo_pattern_t * mesh);
     static void computeTriangles(const Bezier * bezier, double time, unsigned int mipmapLevel,  double featherDist, std::list<RotoFeatherVertex>* featherMesh, std::list<RotoTriangleFans>* internalFans, std::list<RotoTriangles>* internalTriangles,std::list<RotoTriangleStrips>* internalStrips);
     static void renderInternalShape(double time, unsigned int mipmapLevel, double shapeColor[3], double opacity, const Transform::Matrix3x3 & transform, cairo_t * cr, cairo_pattern_t * mesh, const BezierCPs &cps);
+    static void computeInternalShape(double time, unsigned int mipmapLevel, const Transform::Matrix3x3 & transform, const BezierCPs &cps, std::vector<RotoShapeRenderData::Cubic>* shape);
+
+    /**
+     * @brief Computes the geometry of the bezier at the given time as rendered by renderBezier, for the native rasterizer
+     **/
+    static void computeBezierRenderData(const Bezier * bezier, double time, unsigned int mipmapLevel, RotoShapeRenderData* data);
     static void bezulate(double time, const BezierCPs& cps, std::list<BezierCPs>* patches);
     static void applyAndDestroyMask(cairo_t* cr, cairo_pattern_t* mesh);
 };
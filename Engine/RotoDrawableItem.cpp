@@ -94,6 +94,9 @@ NATRON_NAMESPACE_ENTER
 
 ////////////////////////////////////RotoDrawableItem////////////////////////////////////
 
+// Serial numbers of the drawable items, used in the hash of their masks
+static QAtomicInt rotoDrawableItemSerial;
+
 RotoDrawableItem::RotoDrawableItem(const RotoContextPtr& context,
                                    const std::string & name,
                                    const RotoLayerPtr& parent,
@@ -101,6 +104,7 @@ RotoDrawableItem::RotoDrawableItem(const RotoContextPtr& context,
     : RotoItem(context, name, parent)
     , _imp( new RotoDrawableItemPrivate(isStroke) )
 {
+    _imp->serial = (U64)rotoDrawableItemSerial.fetchAndAddRelaxed(1);
 #ifdef NATRON_ROTO_INVERTIBLE
     QObject::connect( _imp->inverted->getSignalSlotHandler().get(), SIGNAL(valueChanged(ViewSpec,int,int)), this, SIGNAL(invertedStateChanged()) );
 #endif
@@ -651,6 +655,8 @@ RotoDrawableItem::rotoKnobChanged(const KnobIPtr& knob,
 void
 RotoDrawableItem::incrementNodesAge()
 {
+    incrementMaskAge();
+    getContext()->invalidateItemBounds(this);
     if ( getContext()->getNode()->getApp()->getProject()->isLoadingProject() ) {
         return;
     }
@@ -668,6 +674,12 @@ RotoDrawableItem::incrementNodesAge()
     }
 }
 
+void
+RotoDrawableItem::incrementMaskAge()
+{
+    _imp->maskAge.fetchAndAddRelaxed(1);
+}
+
 NodePtr
 RotoDrawableItem::getEffectNode() const
 {
@@ -1384,6 +1396,20 @@ RotoDrawableItem::getKnobs() const
     return _imp->knobs;
 }
 
+bool
+RotoDrawableItem::hasKnobsDrivenByOthers() const
+{
+    for (std::list<KnobIPtr>::const_iterator it = _imp->knobs.begin(); it != _imp->knobs.end(); ++it) {
+        for (int i = 0; i < (*it)->getDimension(); ++i) {
+            if ( !(*it)->getExpression(i).empty() || (*it)->getMaster(i).second ) {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
 KnobIPtr
 RotoDrawableItem::getKnobByName(const std::string& name) const
 {
@@ -80,7 +80,7 @@ public:
 
     void setNodesThreadSafetyForRotopainting();
 
-    void incrementNodesAge();
+    virtual void incrementNodesAge();
 
     void refreshNodesConnections();
 
@@ -172,6 +172,12 @@ public:
 
     const std::list<KnobIPtr>& getKnobs() const;
 
+    /**
+     * @brief Returns true if a parameter of the item is driven by an expression or by another parameter, in which
+     * case it may change without the item being edited.
+     **/
+    bool hasKnobsDrivenByOthers() const;
+
     KnobIPtr getKnobByName(const std::string& name) const;
 
     virtual RectD getBoundingBox(double time) const = 0;
@@ -239,6 +245,11 @@ protected:
 
     void rotoKnobChanged(const KnobIPtr& knob, ValueChangedReasonEnum reason);
 
+    /**
+     * @brief Invalidates the masks of this item in the cache, without changing the hash of the other items.
+     **/
+    void incrementMaskAge();
+
     virtual void onTransformSet(double /*time*/) {}
 
     void addKnob(const KnobIPtr& knob);
@@ -1421,6 +1421,44 @@ RotoPaint::getFramesNeeded(double time,
     return ret;
 }
 
+// The items are merged with their own mask, so outside of their bounding boxes the tree leaves the source
+// unchanged. Only the items around the rectangle (in canonical coordinates) are looked up in the spatial index
+// of the context.
+static bool
+isRectDrawnByItems(const NodePtr& node,
+                   const RotoContextPtr& roto,
+                   double time,
+                   const RectD& rect)
+{
+    double startTime = time, endTime = time, mbFrameStep = 1.;
+#ifdef NATRON_ROTO_ENABLE_MOTION_BLUR
+    if (roto->getMotionBlurTypeKnob()->getValue() == 1) {
+        roto->getGlobalMotionBlurSettings(time, &startTime, &endTime, &mbFrameStep);
+    }
+#endif
+    if (startTime != endTime) {
+        return true;
+    }
+
+    // The bounds of the stroke being drawn are only known by the render
+    NodePtr activeRotoPaintNode;
+    RotoStrokeItemPtr activeStroke;
+    bool isDrawing = false;
+    node->getApp()->getActiveRotoDrawingStroke(&activeRotoPaintNode, &activeStroke, &isDrawing);
+    if (isDrawing && activeRotoPaintNode == node) {
+        return true;
+    }
+
+    std::vector<RotoDrawableItemPtr> drawnItems = roto->getItemsIntersectingRect(time, rect);
+    for (std::vector<RotoDrawableItemPtr>::const_iterator it = drawnItems.begin(); it != drawnItems.end(); ++it) {
+        if ( (*it)->isActivated(time) ) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
 void
 RotoPaint::getRegionsOfInterest(double time,
                                 const RenderScale & scale,
@@ -1429,10 +1467,11 @@ RotoPaint::getRegionsOfInterest(double time,
                                 ViewIdx view,
                                 RoIMap* ret)
 {
-    RotoContextPtr roto = getNode()->getRotoContext();
+    NodePtr node = getNode();
+    RotoContextPtr roto = node->getRotoContext();
     NodePtr bottomMerge = roto->getRotoPaintBottomMergeNode();
 
-    if (bottomMerge) {
+    if ( bottomMerge && isRectDrawnByItems(node, roto, time, renderWindow) ) {
         ret->insert( std::make_pair(bottomMerge->getEffectInstance(), renderWindow) );
     }
     EffectInstance::getRegionsOfInterest(time, scale, outputRoD, renderWindow, view, ret);
@@ -1464,7 +1503,8 @@ RotoPaint::isIdentity(double time,
         }
     }
 
-    std::list<RotoDrawableItemPtr> items = node->getRotoContext()->getCurvesByRenderOrder();
+    RotoContextPtr roto = node->getRotoContext();
+    std::list<RotoDrawableItemPtr> items = roto->getCurvesByRenderOrder();
     if ( items.empty() ) {
         *inputNb = 0;
         *inputTime = time;
@@ -1472,8 +1512,20 @@ RotoPaint::isIdentity(double time,
         return true;
     }
 
+    // Only test the region of definition here: the identity result is cached per hash, time and view, and must not
+    // depend on the RoI. Items outside of the RoI are culled by render() and getRegionsOfInterest().
+    RectD rod;
+    bool isProjectFormat;
+    StatusEnum stat = getRegionOfDefinition_public(getRenderHash(), time, scale, view, &rod, &isProjectFormat);
+    if ( (stat == eStatusOK) && !isRectDrawnByItems(node, roto, time, rod) ) {
+        *inputNb = 0;
+        *inputTime = time;
+
+        return true;
+    }
+
     return false;
-}
+} // RotoPaint::isIdentity
 
 StatusEnum
 RotoPaint::render(const RenderActionArgs& args)
@@ -1492,7 +1544,14 @@ RotoPaint::render(const RenderActionArgs& args)
     assert(premultKnob);
     bool premultiply = premultKnob->getValueAtTime(args.time);
 
-    if ( items.empty() ) {
+    // Outside of the items the tree leaves the source unchanged, so do not render it
+    bool isRoIDrawn = false;
+    if ( !items.empty() ) {
+        const RectD canonicalRoI = args.roi.toCanonical_noClipping( args.mappedScale.toMipmapLevel(), getAspectRatio(-1) );
+        isRoIDrawn = isRectDrawnByItems(getNode(), roto, args.time, canonicalRoI);
+    }
+
+    if (!isRoIDrawn) {
         RectI bgImgRoI;
         ImagePtr bgImg = getImage(0, args.time, args.mappedScale, args.view, 0, 0, false /*mapToClipPrefs*/, false /*dontUpscale*/, eStorageModeRAM /*returnOpenGLtexture*/, 0 /*textureDepth*/, &bgImgRoI);
 
@@ -0,0 +1,78 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <https://natrongithub.github.io/>,
+ * (C) 2018-2023 The Natron developers
+ * (C) 2013-2018 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "RotoRenderBands.h"
+
+#include <algorithm> // min, max
+
+#include <QtCore/QThreadPool>
+#include <QtConcurrentMap> // QtCore on Qt4, QtConcurrent on Qt5
+
+#include "Engine/EffectInstance.h"
+
+// Number of bands per idle thread
+#define ROTO_RENDER_BANDS_PER_THREAD 4
+
+NATRON_NAMESPACE_ENTER
+
+RotoRenderBands::RotoRenderBands(const RectI& roi,
+                                 int minBandHeight)
+    : _nThreads(1)
+    , _bandHeight(1)
+    , _bands()
+{
+    QThreadPool* pool = QThreadPool::globalInstance();
+
+    _nThreads = std::max(1, pool->maxThreadCount() - pool->activeThreadCount() + 1);
+    int nBands = _nThreads * ROTO_RENDER_BANDS_PER_THREAD;
+    _bandHeight = std::max( std::max(1, minBandHeight), (roi.height() + nBands - 1) / nBands );
+    for (int y = roi.y1; y < roi.y2; y += _bandHeight) {
+        _bands.push_back( RectI( roi.x1, y, roi.x2, std::min(y + _bandHeight, roi.y2) ) );
+    }
+}
+
+bool
+RotoRenderBands::render(const std::function<void (const int&)>& renderBand) const
+{
+    if ( (_bands.size() <= 1) || (_nThreads == 1) ) {
+        for (std::size_t i = 0; i < _bands.size(); ++i) {
+            if ( EffectInstance::isCurrentThreadRenderAborted() ) {
+                return false;
+            }
+            renderBand( (int)i );
+        }
+    } else {
+        std::vector<int> bandIndices( _bands.size() );
+        for (std::size_t i = 0; i < bandIndices.size(); ++i) {
+            bandIndices[i] = (int)i;
+        }
+        QFuture<void> ret = QtConcurrent::map(bandIndices, renderBand);
+        ret.waitForFinished();
+    }
+
+    return !EffectInstance::isCurrentThreadRenderAborted();
+}
+
+NATRON_NAMESPACE_EXIT
@@ -0,0 +1,80 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <https://natrongithub.github.io/>,
+ * (C) 2018-2023 The Natron developers
+ * (C) 2013-2018 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+#ifndef NATRON_ENGINE_ROTORENDERBANDS_H
+#define NATRON_ENGINE_ROTORENDERBANDS_H
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "Global/Macros.h"
+
+#include <functional>
+#include <vector>
+
+#include "Engine/RectI.h"
+#include "Engine/EngineFwd.h"
+
+NATRON_NAMESPACE_ENTER
+
+/**
+ * @brief Splits the RoI of a Roto render in bands of rows, a few per idle thread of the global thread pool so that
+ * the load is balanced, and renders the bands, in parallel when several threads are idle.
+ * This is shared by the shape rasterizer, the stroke stamper and the cairo stroke renderer.
+ **/
+class RotoRenderBands
+{
+public:
+
+    /**
+     * @brief Splits roi in bands of at least minBandHeight rows (the last band may be smaller).
+     **/
+    RotoRenderBands(const RectI& roi,
+                    int minBandHeight);
+
+    int getBandHeight() const
+    {
+        return _bandHeight;
+    }
+
+    const std::vector<RectI>& getBands() const
+    {
+        return _bands;
+    }
+
+    /**
+     * @brief Calls renderBand with the index of each band. The bands are rendered on the global thread pool, or one
+     * after the other on the calling thread if there is a single band or no idle thread.
+     * Returns false if the render was aborted.
+     **/
+    bool render(const std::function<void (const int&)>& renderBand) const;
+
+private:
+
+    int _nThreads;
+    int _bandHeight;
+    std::vector<RectI> _bands;
+};
+
+NATRON_NAMESPACE_EXIT
+
+#endif // NATRON_ENGINE_ROTORENDERBANDS_H
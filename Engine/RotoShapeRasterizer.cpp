@@ -0,0 +1,542 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <https://natrongithub.github.io/>,
+ * (C) 2018-2023 The Natron developers
+ * (C) 2013-2018 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "RotoShapeRasterizer.h"
+
+#include <algorithm> // min, max, sort
+#include <cassert>
+#include <cmath>
+#include <cstring> // memset
+#include <limits>
+#include <utility> // move
+
+#include <cairo/cairo.h>
+
+#include "Engine/EffectInstance.h"
+#include "Engine/RotoRenderBands.h"
+
+// Maximum distance in pixels between a Bezier segment and its polygonal approximation, same as the cairo default
+#define ROTO_RASTERIZER_FLATTEN_TOLERANCE 0.1
+
+// Maximum number of subdivisions of a Bezier segment
+#define ROTO_RASTERIZER_FLATTEN_MAX_DEPTH 10
+
+// Number of entries of the table giving the feather opacity as a function of the distance to the inner edge
+#define ROTO_RASTERIZER_FALLOFF_LUT_SIZE 1024
+
+// Minimum height of a band of rows rendered by a thread
+#define ROTO_RASTERIZER_MIN_BAND_HEIGHT 16
+
+NATRON_NAMESPACE_ENTER
+
+NATRON_NAMESPACE_ANONYMOUS_ENTER
+
+// A polygon edge, oriented so that y1 < y2
+struct RasterEdge
+{
+    double x1, y1, x2, y2;
+    double dxdy;
+    int winding;
+};
+
+// A feather triangle: d is 0 on the inner edge and 1 on the outer edge of the feather quad
+struct RasterTriangle
+{
+    double x[3], y[3], d[3];
+    double invDet;
+    double bx1, by1, bx2, by2;
+};
+
+// A motion blur sample, ready to be rasterized by all bands
+struct RasterSample
+{
+    std::vector<RasterEdge> edges;
+    std::vector<RasterTriangle> triangles;
+    std::vector<float> fallOffLut;
+    int nSamples;
+};
+
+static void
+addEdge(const Point& a,
+        const Point& b,
+        std::vector<RasterEdge>* edges)
+{
+    if (a.y == b.y) {
+        // horizontal edges never cross a scanline
+        return;
+    }
+    RasterEdge e;
+    if (a.y < b.y) {
+        e.x1 = a.x;
+        e.y1 = a.y;
+        e.x2 = b.x;
+        e.y2 = b.y;
+        e.winding = 1;
+    } else {
+        e.x1 = b.x;
+        e.y1 = b.y;
+        e.x2 = a.x;
+        e.y2 = a.y;
+        e.winding = -1;
+    }
+    e.dxdy = (e.x2 - e.x1) / (e.y2 - e.y1);
+    edges->push_back(e);
+}
+
+static void
+flattenCubic(const Point& p0,
+             const Point& p1,
+             const Point& p2,
+             const Point& p3,
+             int depth,
+             std::vector<RasterEdge>* edges)
+{
+    // distance of the control points to the chord
+    double dx = p3.x - p0.x;
+    double dy = p3.y - p0.y;
+    double d1 = std::abs( (p1.x - p3.x) * dy - (p1.y - p3.y) * dx );
+    double d2 = std::abs( (p2.x - p3.x) * dy - (p2.y - p3.y) * dx );
+    double chord2 = dx * dx + dy * dy;
+    bool flat;
+    if (chord2 == 0.) {
+        double e1 = (p1.x - p0.x) * (p1.x - p0.x) + (p1.y - p0.y) * (p1.y - p0.y);
+        double e2 = (p2.x - p0.x) * (p2.x - p0.x) + (p2.y - p0.y) * (p2.y - p0.y);
+        flat = std::max(e1, e2) <= ROTO_RASTERIZER_FLATTEN_TOLERANCE * ROTO_RASTERIZER_FLATTEN_TOLERANCE;
+    } else {
+        flat = (d1 + d2) * (d1 + d2) <= ROTO_RASTERIZER_FLATTEN_TOLERANCE * ROTO_RASTERIZER_FLATTEN_TOLERANCE * chord2;
+    }
+    if ( flat || (depth >= ROTO_RASTERIZER_FLATTEN_MAX_DEPTH) ) {
+        addEdge(p0, p3, edges);
+
+        return;
+    }
+
+    // de Casteljau subdivision at t = 0.5
+    Point p01, p12, p23, p012, p123, mid;
+    p01.x = (p0.x + p1.x) * 0.5;
+    p01.y = (p0.y + p1.y) * 0.5;
+    p12.x = (p1.x + p2.x) * 0.5;
+    p12.y = (p1.y + p2.y) * 0.5;
+    p23.x = (p2.x + p3.x) * 0.5;
+    p23.y = (p2.y + p3.y) * 0.5;
+    p012.x = (p01.x + p12.x) * 0.5;
+    p012.y = (p01.y + p12.y) * 0.5;
+    p123.x = (p12.x + p23.x) * 0.5;
+    p123.y = (p12.y + p23.y) * 0.5;
+    mid.x = (p012.x + p123.x) * 0.5;
+    mid.y = (p012.y + p123.y) * 0.5;
+    flattenCubic(p0, p01, p012, mid, depth + 1, edges);
+    flattenCubic(mid, p123, p23, p3, depth + 1, edges);
+}
+
+static void
+addTriangle(const Point& a, double da,
+            const Point& b, double db,
+            const Point& c, double dc,
+            std::vector<RasterTriangle>* triangles)
+{
+    double det = (b.y - c.y) * (a.x - c.x) + (c.x - b.x) * (a.y - c.y);
+    if (det == 0.) {
+        // degenerate triangle, it does not cover any pixel center
+        return;
+    }
+    RasterTriangle t;
+    t.x[0] = a.x; t.y[0] = a.y; t.d[0] = da;
+    t.x[1] = b.x; t.y[1] = b.y; t.d[1] = db;
+    t.x[2] = c.x; t.y[2] = c.y; t.d[2] = dc;
+    t.invDet = 1. / det;
+    t.bx1 = std::min( a.x, std::min(b.x, c.x) );
+    t.bx2 = std::max( a.x, std::max(b.x, c.x) );
+    t.by1 = std::min( a.y, std::min(b.y, c.y) );
+    t.by2 = std::max( a.y, std::max(b.y, c.y) );
+    triangles->push_back(t);
+}
+
+/*
+ * With cairo, the inner to outer edges of a feather quad are Bezier curves along a straight line, whose
+ * control points depend on the fall-off, and the opacity is linear in the curve parameter u.
+ * The position along the edge is B(u) = 3a.u.(1-u)^2 + 3b.u^2.(1-u) + u^3: the table stores 1 - B^-1(d).
+ */
+static void
+makeFallOffLut(double fallOff,
+               std::vector<float>* lut)
+{
+    double fallOffInverse = 1. / fallOff;
+    double a = fallOffInverse / (fallOff * 2. + fallOffInverse);
+    double b = 2. * fallOffInverse / (fallOff + 2. * fallOffInverse);
+
+    lut->resize(ROTO_RASTERIZER_FALLOFF_LUT_SIZE);
+    for (int i = 0; i < ROTO_RASTERIZER_FALLOFF_LUT_SIZE; ++i) {
+        double d = (double)i / (ROTO_RASTERIZER_FALLOFF_LUT_SIZE - 1);
+        // B is monotonic since 0 <= a <= b <= 1: bisect
+        double lo = 0., hi = 1.;
+        for (int k = 0; k < 30; ++k) {
+            double u = (lo + hi) * 0.5;
+            double v = 1. - u;
+            double bu = 3. * a * u * v * v + 3. * b * u * u * v + u * u * u;
+            if (bu < d) {
+                lo = u;
+            } else {
+                hi = u;
+            }
+        }
+        (*lut)[i] = (float)( 1. - (lo + hi) * 0.5 );
+    }
+}
+
+static void
+prepareSample(const RotoShapeRenderData& data,
+              RasterSample* sample)
+{
+    sample->nSamples = data.nSamples;
+    if ( !data.shape.empty() ) {
+        for (std::size_t i = 0; i < data.shape.size(); ++i) {
+            const RotoShapeRenderData::Cubic& c = data.shape[i];
+            flattenCubic(c.p0, c.p1, c.p2, c.p3, 0, &sample->edges);
+        }
+        // close the path
+        addEdge(data.shape.back().p3, data.shape.front().p0, &sample->edges);
+    }
+
+    // Each quad p0 (inner), p1 (outer), p2 (outer), p3 (inner) is split in 2 triangles
+    sample->triangles.reserve(data.feather.size() * 2);
+    for (std::size_t i = 0; i < data.feather.size(); ++i) {
+        const RotoShapeRenderData::FeatherQuad& q = data.feather[i];
+        addTriangle(q.p0, 0., q.p1, 1., q.p2, 1., &sample->triangles);
+        addTriangle(q.p0, 0., q.p2, 1., q.p3, 0., &sample->triangles);
+    }
+    if ( !sample->triangles.empty() ) {
+        makeFallOffLut(data.fallOff, &sample->fallOffLut);
+    }
+}
+
+// Sets fill to 1 for the pixels whose center is inside the shape, with the non-zero winding rule
+static void
+fillShape(const std::vector<RasterEdge>& allEdges,
+          const RectI& band,
+          unsigned char* fill)
+{
+    int width = band.width();
+    // Only keep the edges crossing the band
+    std::vector<const RasterEdge*> edges;
+    for (std::size_t i = 0; i < allEdges.size(); ++i) {
+        const RasterEdge& e = allEdges[i];
+        if ( (e.y2 > band.y1 + 0.5) && (e.y1 <= band.y2 - 0.5) ) {
+            edges.push_back(&e);
+        }
+    }
+    if ( edges.empty() ) {
+        return;
+    }
+
+    std::vector<std::pair<double, int> > crossings;
+    for (int y = band.y1; y < band.y2; ++y) {
+        double yc = y + 0.5;
+        crossings.clear();
+        for (std::size_t i = 0; i < edges.size(); ++i) {
+            const RasterEdge& e = *edges[i];
+            if ( (yc >= e.y1) && (yc < e.y2) ) {
+                crossings.push_back( std::make_pair(e.x1 + (yc - e.y1) * e.dxdy, e.winding) );
+            }
+        }
+        if ( crossings.empty() ) {
+            continue;
+        }
+        std::sort( crossings.begin(), crossings.end() );
+
+        unsigned char* row = fill + (std::size_t)(y - band.y1) * width;
+        int winding = 0;
+        for (std::size_t i = 0; i + 1 < crossings.size(); ++i) {
+            winding += crossings[i].second;
+            if (winding == 0) {
+                continue;
+            }
+            // fill the pixels whose center is in [crossings[i], crossings[i + 1])
+            int xStart = (int)std::ceil(crossings[i].first - 0.5) - band.x1;
+            int xEnd = (int)std::ceil(crossings[i + 1].first - 0.5) - band.x1;
+            xStart = std::max(xStart, 0);
+            xEnd = std::min(xEnd, width);
+            for (int x = xStart; x < xEnd; ++x) {
+                row[x] = 1;
+            }
+        }
+    }
+} // fillShape
+
+// Paints the feather opacity of the triangles: as with cairo mesh patterns, a patch replaces the ones painted before
+static void
+fillFeather(const RasterSample& sample,
+            const RectI& band,
+            float* feather)
+{
+    int width = band.width();
+    const float* lut = sample.fallOffLut.empty() ? 0 : &sample.fallOffLut.front();
+    const double lutScale = ROTO_RASTERIZER_FALLOFF_LUT_SIZE - 1;
+    const double eps = 1e-9;
+
+    for (std::size_t i = 0; i < sample.triangles.size(); ++i) {
+        const RasterTriangle& t = sample.triangles[i];
+        // Cull triangles outside of the band
+        if ( (t.bx2 < band.x1) || (t.bx1 > band.x2) || (t.by2 < band.y1) || (t.by1 > band.y2) ) {
+            continue;
+        }
+        int x1 = std::max( (int)std::floor(t.bx1), band.x1 );
+        int x2 = std::min( (int)std::ceil(t.bx2) + 1, band.x2 );
+        int y1 = std::max( (int)std::floor(t.by1), band.y1 );
+        int y2 = std::min( (int)std::ceil(t.by2) + 1, band.y2 );
+        for (int y = y1; y < y2; ++y) {
+            double py = y + 0.5;
+            float* row = feather + (std::size_t)(y - band.y1) * width - band.x1;
+            for (int x = x1; x < x2; ++x) {
+                double px = x + 0.5;
+                double w0 = ( (t.y[1] - t.y[2]) * (px - t.x[2]) + (t.x[2] - t.x[1]) * (py - t.y[2]) ) * t.invDet;
+                double w1 = ( (t.y[2] - t.y[0]) * (px - t.x[2]) + (t.x[0] - t.x[2]) * (py - t.y[2]) ) * t.invDet;
+                double w2 = 1. - w0 - w1;
+                if ( (w0 < -eps) || (w1 < -eps) || (w2 < -eps) ) {
+                    continue;
+                }
+                double d = w0 * t.d[0] + w1 * t.d[1] + w2 * t.d[2];
+                d = std::max( 0., std::min(d, 1.) ) * lutScale;
+                int index = std::min( (int)d, ROTO_RASTERIZER_FALLOFF_LUT_SIZE - 2 );
+                double f = d - index;
+                assert(lut);
+                row[x] = (float)( lut[index] * (1. - f) + lut[index + 1] * f );
+            }
+        }
+    }
+} // fillFeather
+
+static void
+renderBand(const std::vector<RasterSample>& samples,
+           const RectI& band,
+           float* coverage)
+{
+    std::size_t area = (std::size_t)band.width() * band.height();
+
+    std::fill(coverage, coverage + area, 0.f);
+
+    std::vector<unsigned char> fill(area);
+    std::vector<float> feather(area);
+    for (std::size_t s = 0; s < samples.size(); ++s) {
+        if ( !samples[s].edges.empty() ) {
+            std::fill(fill.begin(), fill.end(), 0);
+            fillShape(samples[s].edges, band, &fill.front());
+            for (std::size_t i = 0; i < area; ++i) {
+                if (fill[i]) {
+                    coverage[i] = 1.f;
+                }
+            }
+        }
+        if ( !samples[s].triangles.empty() ) {
+            std::fill(feather.begin(), feather.end(), 0.f);
+            fillFeather(samples[s], band, &feather.front());
+            int n = samples[s].nSamples;
+            if (n == 1) {
+                for (std::size_t i = 0; i < area; ++i) {
+                    float a = feather[i] * feather[i];
+                    coverage[i] = a + coverage[i] * (1.f - a);
+                }
+            } else {
+                // Painting the same sample n times: the shape fill is idempotent and the feather
+                // leaves (1 - a)^n of the transparency
+                for (std::size_t i = 0; i < area; ++i) {
+                    float a = feather[i] * feather[i];
+                    if (a > 0.f) {
+                        coverage[i] = 1.f - std::pow(1.f - a, (float)n) * (1.f - coverage[i]);
+                    }
+                }
+            }
+        }
+    }
+}
+
+static inline bool
+pointsEqual(const Point& a,
+            const Point& b)
+{
+    return a.x == b.x && a.y == b.y;
+}
+
+NATRON_NAMESPACE_ANONYMOUS_EXIT
+
+
+bool
+RotoShapeRenderData::hasSameGeometry(const RotoShapeRenderData& other) const
+{
+    if ( (fallOff != other.fallOff) || ( shape.size() != other.shape.size() ) || ( feather.size() != other.feather.size() ) ) {
+        return false;
+    }
+    for (std::size_t i = 0; i < shape.size(); ++i) {
+        const Cubic& a = shape[i];
+        const Cubic& b = other.shape[i];
+        if ( !pointsEqual(a.p0, b.p0) || !pointsEqual(a.p1, b.p1) || !pointsEqual(a.p2, b.p2) || !pointsEqual(a.p3, b.p3) ) {
+            return false;
+        }
+    }
+    for (std::size_t i = 0; i < feather.size(); ++i) {
+        const FeatherQuad& a = feather[i];
+        const FeatherQuad& b = other.feather[i];
+        if ( !pointsEqual(a.p0, b.p0) || !pointsEqual(a.p1, b.p1) || !pointsEqual(a.p2, b.p2) || !pointsEqual(a.p3, b.p3) ) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void
+RotoShapeRasterizer::appendSample(RotoShapeRenderData& sample,
+                                  std::vector<RotoShapeRenderData>* samples)
+{
+    if ( !samples->empty() && samples->back().hasSameGeometry(sample) ) {
+        samples->back().nSamples += sample.nSamples;
+    } else {
+        samples->push_back( std::move(sample) );
+    }
+}
+
+void
+RotoShapeRasterizer::renderSequential(const std::vector<RotoShapeRenderData>& samples,
+                                      const RectI& rect,
+                                      float* coverage)
+{
+    if ( rect.isNull() ) {
+        return;
+    }
+    std::vector<RasterSample> rasterSamples( samples.size() );
+    for (std::size_t i = 0; i < samples.size(); ++i) {
+        prepareSample(samples[i], &rasterSamples[i]);
+    }
+    renderBand(rasterSamples, rect, coverage);
+}
+
+bool
+RotoShapeRasterizer::render(const std::vector<RotoShapeRenderData>& samples,
+                            const RectI& roi,
+                            const TileWriter& writer)
+{
+    if ( roi.isNull() ) {
+        return true;
+    }
+
+    std::vector<RasterSample> rasterSamples( samples.size() );
+    for (std::size_t i = 0; i < samples.size(); ++i) {
+        prepareSample(samples[i], &rasterSamples[i]);
+    }
+
+    if ( EffectInstance::isCurrentThreadRenderAborted() ) {
+        return false;
+    }
+
+    // Split the RoI in bands of rows, a few per thread so that the load is balanced
+    RotoRenderBands renderBands(roi, ROTO_RASTERIZER_MIN_BAND_HEIGHT);
+    const std::vector<RectI>& bands = renderBands.getBands();
+
+    return renderBands.render([&](const int& b) {
+        const RectI& band = bands[b];
+        std::vector<float> coverage( (std::size_t)band.width() * band.height() );
+        renderBand(rasterSamples, band, &coverage.front());
+        writer(band, &coverage.front());
+    });
+} // RotoShapeRasterizer::render
+
+void
+RotoShapeRasterizer::renderFeatherCairo(const std::vector<RotoShapeRenderData::FeatherQuad>& feather,
+                                        double shapeColor[3],
+                                        double fallOff,
+                                        cairo_pattern_t* mesh)
+{
+    double fallOffInverse = 1. / fallOff;
+    double innerOpacity = 1.;
+    double outterOpacity = 0.;
+
+    for (std::size_t i = 0; i < feather.size(); ++i) {
+        const Point& p0 = feather[i].p0;
+        const Point& p1 = feather[i].p1;
+        const Point& p2 = feather[i].p2;
+        const Point& p3 = feather[i].p3;
+        Point p0p1, p1p0, p2p3, p3p2;
+
+        ///linear interpolation
+        p0p1.x = (p0.x * fallOff * 2. + fallOffInverse * p1.x) / (fallOff * 2. + fallOffInverse);
+        p0p1.y = (p0.y * fallOff * 2. + fallOffInverse * p1.y) / (fallOff * 2. + fallOffInverse);
+        p1p0.x = (p0.x * fallOff + 2. * fallOffInverse * p1.x) / (fallOff + 2. * fallOffInverse);
+        p1p0.y = (p0.y * fallOff + 2. * fallOffInverse * p1.y) / (fallOff + 2. * fallOffInverse);
+
+
+        p2p3.x = (p3.x * fallOff + 2. * fallOffInverse * p2.x) / (fallOff + 2. * fallOffInverse);
+        p2p3.y = (p3.y * fallOff + 2. * fallOffInverse * p2.y) / (fallOff + 2. * fallOffInverse);
+        p3p2.x = (p3.x * fallOff * 2. + fallOffInverse * p2.x) / (fallOff * 2. + fallOffInverse);
+        p3p2.y = (p3.y * fallOff * 2. + fallOffInverse * p2.y) / (fallOff * 2. + fallOffInverse);
+
+
+        ///move to the initial point
+        cairo_mesh_pattern_begin_patch(mesh);
+        cairo_mesh_pattern_move_to(mesh, p0.x, p0.y);
+        cairo_mesh_pattern_curve_to(mesh, p0p1.x, p0p1.y, p1p0.x, p1p0.y, p1.x, p1.y);
+        cairo_mesh_pattern_line_to(mesh, p2.x, p2.y);
+        cairo_mesh_pattern_curve_to(mesh, p2p3.x, p2p3.y, p3p2.x, p3p2.y, p3.x, p3.y);
+        cairo_mesh_pattern_line_to(mesh, p0.x, p0.y);
+        ///Set the 4 corners color
+        ///inner is full color
+
+        // IMPORTANT NOTE:
+        // The two sqrt below are due to a probable cairo bug.
+        // To check whether the bug is present is a given cairo version,
+        // make any shape with a very large feather and set
+        // opacity to 0.5. Then, zoom on the polygon border to check if the intensity is continuous
+        // and approximately equal to 0.5.
+        // If the bug if ixed in cairo, please use #if CAIRO_VERSION>xxx to keep compatibility with
+        // older Cairo versions.
+        cairo_mesh_pattern_set_corner_color_rgba( mesh, 0, shapeColor[0], shapeColor[1], shapeColor[2], innerOpacity);
+        ///outer is faded
+        cairo_mesh_pattern_set_corner_color_rgba(mesh, 1, shapeColor[0], shapeColor[1], shapeColor[2], outterOpacity);
+        cairo_mesh_pattern_set_corner_color_rgba(mesh, 2, shapeColor[0], shapeColor[1], shapeColor[2], outterOpacity);
+        ///inner is full color
+        cairo_mesh_pattern_set_corner_color_rgba(mesh, 3, shapeColor[0], shapeColor[1], shapeColor[2], innerOpacity);
+        assert(cairo_pattern_status(mesh) == CAIRO_STATUS_SUCCESS);
+
+        cairo_mesh_pattern_end_patch(mesh);
+    }
+} // RotoShapeRasterizer::renderFeatherCairo
+
+void
+RotoShapeRasterizer::renderShapeCairo(const std::vector<RotoShapeRenderData::Cubic>& shape,
+                                      cairo_t* cr)
+{
+    if ( shape.empty() ) {
+        return;
+    }
+    cairo_set_source_rgba(cr, 1, 1, 1, 1);
+
+    cairo_move_to(cr, shape.front().p0.x, shape.front().p0.y);
+    for (std::size_t i = 0; i < shape.size(); ++i) {
+        const RotoShapeRenderData::Cubic& c = shape[i];
+        cairo_curve_to(cr, c.p1.x, c.p1.y, c.p2.x, c.p2.y, c.p3.x, c.p3.y);
+    }
+    cairo_fill(cr);
+}
+
+NATRON_NAMESPACE_EXIT
@@ -0,0 +1,136 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <https://natrongithub.github.io/>,
+ * (C) 2018-2023 The Natron developers
+ * (C) 2013-2018 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+#ifndef NATRON_ENGINE_ROTOSHAPERASTERIZER_H
+#define NATRON_ENGINE_ROTOSHAPERASTERIZER_H
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "Global/Macros.h"
+
+#include <functional>
+#include <vector>
+
+#include "Global/GlobalDefines.h"
+#include "Engine/RectI.h"
+#include "Engine/EngineFwd.h"
+
+// same declarations as in cairo.h, so that this header can be included without cairo
+typedef struct _cairo cairo_t;
+typedef struct _cairo_pattern cairo_pattern_t;
+
+NATRON_NAMESPACE_ENTER
+
+/**
+ * @brief The geometry of a closed Bezier at one time, in pixel coordinates at the mipmap level of the render.
+ * The internal shape is filled with the non-zero winding rule, and each feather quad fades from opaque
+ * along its inner edge (p0,p3) to transparent along its outer edge (p1,p2).
+ **/
+struct RotoShapeRenderData
+{
+    struct Cubic
+    {
+        Point p0, p1, p2, p3;
+    };
+
+    struct FeatherQuad
+    {
+        Point p0, p1, p2, p3;
+    };
+
+    std::vector<Cubic> shape;
+    std::vector<FeatherQuad> feather;
+    double fallOff;
+
+    ///The number of consecutive motion blur samples that have this geometry
+    int nSamples;
+
+    RotoShapeRenderData()
+        : shape()
+        , feather()
+        , fallOff(1.)
+        , nSamples(1)
+    {
+    }
+
+    bool hasSameGeometry(const RotoShapeRenderData& other) const;
+};
+
+/**
+ * @brief Renders the masks of closed Beziers, either with cairo or with a native scanline rasterizer.
+ * The native rasterizer splits the RoI in bands of rows which are rendered concurrently, and each band only
+ * processes the edges and feather triangles that intersect it.
+ * The motion blur samples are composited as with cairo: the internal shape is painted over the previous
+ * samples, then the feather is painted with its own alpha as mask, i.e. with a squared alpha.
+ **/
+class RotoShapeRasterizer
+{
+public:
+
+    /**
+     * @brief Called concurrently with disjoint tiles: coverage points to the tile.width() * tile.height()
+     * values in [0,1] of the tile, stored by rows from tile.y1.
+     **/
+    typedef std::function<void (const RectI& tile, const float* coverage)> TileWriter;
+
+    /**
+     * @brief Appends a motion blur sample to samples. If it has the same geometry as the last one (e.g. the shape
+     * does not move between two keyframes) the last sample is counted once more instead, and the geometry
+     * is rasterized only once.
+     **/
+    static void appendSample(RotoShapeRenderData& sample,
+                             std::vector<RotoShapeRenderData>* samples);
+
+    /**
+     * @brief Rasterizes the given motion blur samples over the roi. Returns false if the render was aborted,
+     * in which case some tiles may not have been written.
+     **/
+    static bool render(const std::vector<RotoShapeRenderData>& samples,
+                       const RectI& roi,
+                       const TileWriter& writer);
+
+    /**
+     * @brief Sequential version of render() over the given rect, which does not check for render abortion.
+     **/
+    static void renderSequential(const std::vector<RotoShapeRenderData>& samples,
+                                 const RectI& rect,
+                                 float* coverage);
+
+    /**
+     * @brief Adds the feather quads to the cairo mesh pattern, to be applied with cairo_mask().
+     **/
+    static void renderFeatherCairo(const std::vector<RotoShapeRenderData::FeatherQuad>& feather,
+                                   double shapeColor[3],
+                                   double fallOff,
+                                   cairo_pattern_t* mesh);
+
+    /**
+     * @brief Fills the internal shape with opaque white.
+     **/
+    static void renderShapeCairo(const std::vector<RotoShapeRenderData::Cubic>& shape,
+                                 cairo_t* cr);
+};
+
+NATRON_NAMESPACE_EXIT
+
+#endif // NATRON_ENGINE_ROTOSHAPERASTERIZER_H
@@ -27,9 +27,15 @@
 
 #include <algorithm> // min, max
 #include <cassert>
+#include <cstring> // memcpy
 #include <stdexcept>
+#include <vector>
 
-#include <cairo/cairo.h>
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+// Blend one RGBA pixel at once
+#define ROTO_SMEAR_USE_SSE2
+#include <emmintrin.h>
+#endif
 
 #include "Global/MathUtils.h"
 
@@ -38,6 +44,7 @@
 #include "Engine/KnobTypes.h"
 #include "Engine/RotoStrokeItem.h"
 #include "Engine/RotoContext.h"
+#include "Engine/RotoStrokeStamper.h"
 #include "Engine/ViewIdx.h"
 
 NATRON_NAMESPACE_ENTER
@@ -139,66 +146,99 @@ RotoSmear::isIdentity(double time,
     return false;
 }
 
+// Blends the pixels of src over dst with the given mask value
+template <int nComps>
 static void
-renderSmearDot(const unsigned char* maskData,
-               const int maskStride,
+blendSmearPixels(const float* mask,
+                 const float* src,
+                 float* dst,
+                 int width)
+{
+    for (int x = 0; x < width; ++x, src += nComps, dst += nComps) {
+        const float m = mask[x];
+#ifdef ROTO_SMEAR_USE_SSE2
+        if (nComps == 4) {
+            // dst + m * (src - dst)
+            __m128 d = _mm_loadu_ps(dst);
+            d = _mm_add_ps( d, _mm_mul_ps( _mm_set1_ps(m), _mm_sub_ps(_mm_loadu_ps(src), d) ) );
+            _mm_storeu_ps(dst, d);
+            continue;
+        }
+#endif
+        for (int k = 0; k < nComps; ++k) {
+            dst[k] = src[k] * m + dst[k] * (1.f - m);
+        }
+    }
+}
+
+static void
+renderSmearDot(const std::vector<float>& mask,
                const int maskWidth,
                const int maskHeight,
                const Point& prev,
                const Point& next,
                const double brushSizePixels,
                int nComps,
-               const ImagePtr& outputImage)
+               const ImagePtr& outputImage,
+               std::vector<float>* prevDotBuffer)
 {
-    /// First copy the portion of the image around the previous dot into tmpBuf
+    /// First copy the portion of the image around the previous dot into prevDotBuffer, as the two dots may overlap
     RectD prevDotRoD(prev.x - brushSizePixels / 2., prev.y - brushSizePixels / 2., prev.x + brushSizePixels / 2., prev.y + brushSizePixels / 2.);
     const RectI prevDotBounds = prevDotRoD.toPixelEnclosing(0, outputImage->getPixelAspectRatio());
-    ImagePtr tmpBuf( new Image(outputImage->getComponents(),
-                               prevDotRoD,
-                               prevDotBounds,
-                               0,
-                               outputImage->getPixelAspectRatio(),
-                               outputImage->getBitDepth(),
-                               outputImage->getPremultiplication(),
-                               outputImage->getFieldingOrder(),
-                               false) );
-    tmpBuf->pasteFrom(*outputImage, prevDotBounds, false);
-
-    Image::ReadAccess tmpAcc( tmpBuf.get() );
-    Image::WriteAccess wacc( outputImage.get() );
+    const RectI& outputBounds = outputImage->getBounds();
+    const RectI prevDotValidBounds = prevDotBounds.intersect(outputBounds);
+    if ( prevDotValidBounds.isNull() ) {
+        return;
+    }
+
     RectI nextDotBounds;
     nextDotBounds.x1 = next.x - maskWidth / 2;
     nextDotBounds.x2 = next.x + maskWidth / 2;
     nextDotBounds.y1 = next.y - maskHeight / 2;
     nextDotBounds.y2 = next.y + maskHeight / 2;
 
-    const unsigned char* mask_pixels = maskData;
-    int yPrev = prevDotBounds.y1;
-    for (int y = nextDotBounds.y1; y < nextDotBounds.y2;
-         ++y,
-         ++yPrev,
-         mask_pixels += maskStride) {
-        float* dstPixels = (float*)wacc.pixelAt(nextDotBounds.x1, y);
-        assert(dstPixels);
-        if (!dstPixels) {
-            continue;
-        }
+    // Only the pixels which are both in the output image and under a valid pixel of the previous dot are smeared
+    const int offsetX = prevDotBounds.x1 - nextDotBounds.x1;
+    const int offsetY = prevDotBounds.y1 - nextDotBounds.y1;
+    RectI dstBounds( prevDotValidBounds.x1 - offsetX, prevDotValidBounds.y1 - offsetY, prevDotValidBounds.x2 - offsetX, prevDotValidBounds.y2 - offsetY );
+    dstBounds.clip(nextDotBounds);
+    dstBounds.clip(outputBounds);
+    if ( dstBounds.isNull() ) {
+        return;
+    }
+    const RectI srcBounds( dstBounds.x1 + offsetX, dstBounds.y1 + offsetY, dstBounds.x2 + offsetX, dstBounds.y2 + offsetY );
 
-        int xPrev = prevDotBounds.x1;
-        for (int x = nextDotBounds.x1; x < nextDotBounds.x2;
-             ++x, ++xPrev,
-             dstPixels += nComps) {
-            const float* srcPixels = (const float*)tmpAcc.pixelAt(xPrev, yPrev);
+    const int width = dstBounds.width();
+    const std::size_t rowSize = (std::size_t)width * nComps;
+    prevDotBuffer->resize( rowSize * dstBounds.height() );
 
-            if (srcPixels) {
-                float mask_scale = Image::convertPixelDepth<unsigned char, float>(mask_pixels[x - nextDotBounds.x1]);
-                float one_minus_mask_scale = 1. - mask_scale;
+    Image::WriteAccess wacc( outputImage.get() );
+    for (int y = srcBounds.y1; y < srcBounds.y2; ++y) {
+        const float* srcPixels = (const float*)wacc.pixelAt(srcBounds.x1, y);
+        assert(srcPixels);
+        std::memcpy( &(*prevDotBuffer)[(y - srcBounds.y1) * rowSize], srcPixels, rowSize * sizeof(float) );
+    }
 
-                for (int k = 0; k < nComps; ++k) {
-                    dstPixels[k] = srcPixels[k] * mask_scale + dstPixels[k] * one_minus_mask_scale;
-                }
-            } else {
-            }
+    for (int y = dstBounds.y1; y < dstBounds.y2; ++y) {
+        float* dstPixels = (float*)wacc.pixelAt(dstBounds.x1, y);
+        assert(dstPixels);
+        const float* srcPixels = &(*prevDotBuffer)[(y - dstBounds.y1) * rowSize];
+        const float* maskPixels = &mask[(y - nextDotBounds.y1) * maskWidth + (dstBounds.x1 - nextDotBounds.x1)];
+        switch (nComps) {
+        case 1:
+            blendSmearPixels<1>(maskPixels, srcPixels, dstPixels, width);
+            break;
+        case 2:
+            blendSmearPixels<2>(maskPixels, srcPixels, dstPixels, width);
+            break;
+        case 3:
+            blendSmearPixels<3>(maskPixels, srcPixels, dstPixels, width);
+            break;
+        case 4:
+            blendSmearPixels<4>(maskPixels, srcPixels, dstPixels, width);
+            break;
+        default:
+            break;
         }
     }
 } // renderSmearDot
@@ -271,16 +311,12 @@ RotoSmear::render(const RenderActionArgs& args)
     //renderPoint is the final point we rendered, recorded for the next call to render when we are building up the smear
     std::pair<Point, double> prev, cur, renderPoint;
     bool bgInitialized = false;
-    CairoImageWrapper imgWrapper;
-    if ( !RotoContext::allocateAndRenderSingleDotStroke(brushSizePixel, brushHardness, opacity, imgWrapper) ) {
-        return eStatusFailed;
-    }
-
-
-    int maskWidth = cairo_image_surface_get_width(imgWrapper.cairoImg);
-    int maskHeight = cairo_image_surface_get_height(imgWrapper.cairoImg);
-    int maskStride = cairo_image_surface_get_stride(imgWrapper.cairoImg);
-    unsigned char* maskData = cairo_image_surface_get_data(imgWrapper.cairoImg);
+    // The dab is stamped once, and the image under the previous dot is copied in the same buffer for each dot
+    std::vector<float> maskData;
+    std::vector<float> prevDotBuffer;
+    RotoStrokeStamper::renderDabMask(brushSizePixel, brushHardness, opacity, &maskData);
+    int maskWidth = (int)brushSizePixel + 1;
+    int maskHeight = maskWidth;
 
     for (std::list<std::list<std::pair<Point, double> > >::const_iterator itStroke = strokes.begin(); itStroke != strokes.end(); ++itStroke) {
         int firstPoint = (int)std::floor( (itStroke->size() * writeOnStart) );
@@ -343,7 +379,7 @@ RotoSmear::render(const RenderActionArgs& args)
                 // This is the very first dot we render
                 prev = *it;
                 ++it;
-                renderSmearDot(maskData, maskStride, maskWidth, maskHeight, prev.first, it->first, brushSizePixel, nComps, plane->second);
+                renderSmearDot(maskData, maskWidth, maskHeight, prev.first, it->first, brushSizePixel, nComps, plane->second, &prevDotBuffer);
                 didPaint = true;
                 renderPoint = *it;
                 prev = renderPoint;
@@ -406,7 +442,7 @@ RotoSmear::render(const RenderActionArgs& args)
 
                 prevPoint.x = prev.first.x + vx * v.x;
                 prevPoint.y = prev.first.y + vy * v.y;
-                renderSmearDot(maskData, maskStride, maskWidth, maskHeight, prevPoint, renderPoint.first, brushSizePixel, nComps, plane->second);
+                renderSmearDot(maskData, maskWidth, maskHeight, prevPoint, renderPoint.first, brushSizePixel, nComps, plane->second, &prevDotBuffer);
                 didPaint = true;
                 prev = renderPoint;
                 cur = renderPoint;
@@ -0,0 +1,440 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <https://natrongithub.github.io/>,
+ * (C) 2018-2023 The Natron developers
+ * (C) 2013-2018 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "RotoSpatialIndex.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "Engine/Bezier.h"
+#include "Engine/RotoDrawableItem.h"
+#include "Engine/RotoStrokeItem.h"
+
+// The grids have at most ROTO_SPATIAL_GRID_MAX_SIZE x ROTO_SPATIAL_GRID_MAX_SIZE cells
+#define ROTO_SPATIAL_GRID_MAX_SIZE 256
+
+// Items spanning more than 1/ROTO_SPATIAL_GRID_LARGE_ITEM_RATIO of the cells are always tested
+#define ROTO_SPATIAL_GRID_LARGE_ITEM_RATIO 4
+
+// Number of times for which the grids are kept
+#define ROTO_SPATIAL_INDEX_MAX_TIMES 4
+
+NATRON_NAMESPACE_ENTER
+
+RotoSpatialGrid::RotoSpatialGrid()
+    : _bounds()
+    , _ranges()
+    , _gridBounds()
+    , _cellWidth(1.)
+    , _cellHeight(1.)
+    , _nx(0)
+    , _ny(0)
+    , _cells()
+    , _alwaysTested()
+    , _stamps()
+    , _stamp(0)
+{
+}
+
+RotoSpatialGrid::~RotoSpatialGrid()
+{
+}
+
+bool
+RotoSpatialGrid::intersects(const RotoItemBounds& bounds,
+                            const RectD& rect)
+{
+    switch (bounds.type) {
+    case RotoItemBounds::eTypeEmpty:
+
+        return false;
+    case RotoItemBounds::eTypeUnbounded:
+
+        return true;
+    case RotoItemBounds::eTypeRect:
+        break;
+    }
+
+    // Boxes are closed, so that flat boxes (e.g. a horizontal open bezier) are found
+    return bounds.bbox.x1 <= rect.x2 && rect.x1 <= bounds.bbox.x2 &&
+           bounds.bbox.y1 <= rect.y2 && rect.y1 <= bounds.bbox.y2;
+}
+
+static int
+clampCell(double c,
+          int n)
+{
+    if ( !(c > 0.) ) { // also catches NaN
+        return 0;
+    }
+    if ( c >= (double)(n - 1) ) {
+        return n - 1;
+    }
+
+    return (int)c;
+}
+
+RotoSpatialGrid::CellRange
+RotoSpatialGrid::getCellRange(const RotoItemBounds& bounds) const
+{
+    CellRange range = {0, 0, 0, 0};
+
+    if ( (bounds.type != RotoItemBounds::eTypeRect) || (_nx == 0) ) {
+        return range;
+    }
+    range.x1 = clampCell( std::floor( (bounds.bbox.x1 - _gridBounds.x1) / _cellWidth ), _nx );
+    range.x2 = clampCell( std::floor( (bounds.bbox.x2 - _gridBounds.x1) / _cellWidth ), _nx ) + 1;
+    range.y1 = clampCell( std::floor( (bounds.bbox.y1 - _gridBounds.y1) / _cellHeight ), _ny );
+    range.y2 = clampCell( std::floor( (bounds.bbox.y2 - _gridBounds.y1) / _cellHeight ), _ny ) + 1;
+
+    return range;
+}
+
+void
+RotoSpatialGrid::insertInCells(int index,
+                               const CellRange& range)
+{
+    for (int y = range.y1; y < range.y2; ++y) {
+        for (int x = range.x1; x < range.x2; ++x) {
+            _cells[y * _nx + x].push_back(index);
+        }
+    }
+}
+
+void
+RotoSpatialGrid::removeFromCells(int index,
+                                 const CellRange& range)
+{
+    for (int y = range.y1; y < range.y2; ++y) {
+        for (int x = range.x1; x < range.x2; ++x) {
+            std::vector<int>& cell = _cells[y * _nx + x];
+            std::vector<int>::iterator found = std::find(cell.begin(), cell.end(), index);
+            if ( found != cell.end() ) {
+                *found = cell.back();
+                cell.pop_back();
+            }
+        }
+    }
+}
+
+void
+RotoSpatialGrid::build(const std::vector<RotoItemBounds>& bounds)
+{
+    _bounds = bounds;
+    _ranges.assign( bounds.size(), CellRange() );
+    _stamps.assign(bounds.size(), 0);
+    _stamp = 0;
+    _alwaysTested.clear();
+    _cells.clear();
+    _nx = _ny = 0;
+
+    int nRects = 0;
+    for (std::size_t i = 0; i < bounds.size(); ++i) {
+        if (bounds[i].type != RotoItemBounds::eTypeRect) {
+            continue;
+        }
+        if (nRects == 0) {
+            _gridBounds = bounds[i].bbox;
+        } else {
+            _gridBounds.merge(bounds[i].bbox);
+        }
+        ++nRects;
+    }
+
+    if (nRects > 0) {
+        // About one item per cell
+        int size = std::min( (int)std::ceil( std::sqrt( (double)nRects ) ), ROTO_SPATIAL_GRID_MAX_SIZE );
+        _nx = _ny = std::max(size, 1);
+        _cellWidth = _gridBounds.width() > 0. ? _gridBounds.width() / _nx : 1.;
+        _cellHeight = _gridBounds.height() > 0. ? _gridBounds.height() / _ny : 1.;
+        _cells.resize(_nx * _ny);
+    }
+
+    const int maxCells = std::max(16, _nx * _ny / ROTO_SPATIAL_GRID_LARGE_ITEM_RATIO);
+    for (std::size_t i = 0; i < bounds.size(); ++i) {
+        const RotoItemBounds& b = bounds[i];
+        CellRange range = getCellRange(b);
+        int nCells = (range.x2 - range.x1) * (range.y2 - range.y1);
+        if ( (b.type == RotoItemBounds::eTypeUnbounded) || (nCells > maxCells) ) {
+            _alwaysTested.push_back( (int)i );
+            range.x1 = range.x2 = range.y1 = range.y2 = 0;
+        } else {
+            insertInCells( (int)i, range );
+        }
+        _ranges[i] = range;
+    }
+} // RotoSpatialGrid::build
+
+void
+RotoSpatialGrid::update(int index,
+                        const RotoItemBounds& bounds)
+{
+    assert( index >= 0 && index < (int)_bounds.size() );
+
+    const CellRange& oldRange = _ranges[index];
+    if (oldRange.x1 < oldRange.x2) {
+        removeFromCells(index, oldRange);
+    } else {
+        std::vector<int>::iterator found = std::find(_alwaysTested.begin(), _alwaysTested.end(), index);
+        if ( found != _alwaysTested.end() ) {
+            _alwaysTested.erase(found);
+        }
+    }
+
+    _bounds[index] = bounds;
+
+    // Boxes outside of the grid are clamped to the border cells, items that were empty when the grid
+    // was built are tested every time
+    CellRange range = getCellRange(bounds);
+    int nCells = (range.x2 - range.x1) * (range.y2 - range.y1);
+    const int maxCells = std::max(16, _nx * _ny / ROTO_SPATIAL_GRID_LARGE_ITEM_RATIO);
+    if ( (bounds.type == RotoItemBounds::eTypeUnbounded) || (nCells > maxCells) ||
+         ( (bounds.type == RotoItemBounds::eTypeRect) && (_nx == 0) ) ) {
+        _alwaysTested.push_back(index);
+        range.x1 = range.x2 = range.y1 = range.y2 = 0;
+    } else if (nCells > 0) {
+        insertInCells(index, range);
+    }
+    _ranges[index] = range;
+}
+
+void
+RotoSpatialGrid::getItemsIntersecting(const RectD& rect,
+                                      std::vector<int>* indices) const
+{
+    const std::size_t firstIndex = indices->size();
+
+    for (std::vector<int>::const_iterator it = _alwaysTested.begin(); it != _alwaysTested.end(); ++it) {
+        if ( intersects(_bounds[*it], rect) ) {
+            indices->push_back(*it);
+        }
+    }
+
+    if (_nx > 0) {
+        ++_stamp;
+        if (_stamp == 0) {
+            std::fill(_stamps.begin(), _stamps.end(), 0);
+            _stamp = 1;
+        }
+
+        RotoItemBounds query;
+        query.type = RotoItemBounds::eTypeRect;
+        query.bbox = rect;
+        const CellRange range = getCellRange(query);
+        for (int y = range.y1; y < range.y2; ++y) {
+            for (int x = range.x1; x < range.x2; ++x) {
+                const std::vector<int>& cell = _cells[y * _nx + x];
+                for (std::vector<int>::const_iterator it = cell.begin(); it != cell.end(); ++it) {
+                    if (_stamps[*it] == _stamp) {
+                        continue;
+                    }
+                    _stamps[*it] = _stamp;
+                    if ( intersects(_bounds[*it], rect) ) {
+                        indices->push_back(*it);
+                    }
+                }
+            }
+        }
+    }
+
+    std::sort( indices->begin() + firstIndex, indices->end() );
+} // RotoSpatialGrid::getItemsIntersecting
+
+RotoSpatialIndex::RotoSpatialIndex()
+    : _lock()
+    , _updateLock()
+    , _age(0)
+    , _grids()
+{
+}
+
+RotoSpatialIndex::~RotoSpatialIndex()
+{
+}
+
+void
+RotoSpatialIndex::invalidateAll()
+{
+    QMutexLocker k(&_lock);
+
+    ++_age;
+    _grids.clear();
+}
+
+void
+RotoSpatialIndex::invalidateItem(const RotoDrawableItem* item)
+{
+    QMutexLocker k(&_lock);
+
+    ++_age;
+    for (std::list<TimeGridPtr>::iterator it = _grids.begin(); it != _grids.end(); ++it) {
+        std::map<const RotoDrawableItem*, int>::const_iterator found = (*it)->indices.find(item);
+        if ( found != (*it)->indices.end() ) {
+            (*it)->dirtyItems.push_back(found->second);
+        }
+    }
+}
+
+RotoItemBounds
+RotoSpatialIndex::getItemBounds(const RotoDrawableItemPtr& item,
+                                double time)
+{
+    RotoItemBounds ret;
+
+    if (!item) {
+        return ret;
+    }
+
+    // The item may change without being edited, e.g. when it is selected its parameters are driven by the
+    // ones of the context
+    if ( item->hasKnobsDrivenByOthers() || item->getInverted(time) ) {
+        ret.type = RotoItemBounds::eTypeUnbounded;
+
+        return ret;
+    }
+
+    Bezier* isBezier = dynamic_cast<Bezier*>( item.get() );
+    RotoStrokeItem* isStroke = dynamic_cast<RotoStrokeItem*>( item.get() );
+    if (isBezier && !isStroke) {
+        // The feather points of open beziers are not in their bounding box but they may be picked, and the
+        // points moved during a render are only in the gui curves
+        if ( (isBezier->getControlPointsCount() <= 1) || isBezier->isOpenBezier() || isBezier->hasPendingGuiActions() ) {
+            ret.type = RotoItemBounds::eTypeUnbounded;
+
+            return ret;
+        }
+    }
+
+    ret.bbox = item->getBoundingBox(time);
+    if (isStroke) {
+        // the bounding box of a stroke is null when it is not activated
+        if ( !ret.bbox.isNull() ) {
+            ret.type = RotoItemBounds::eTypeRect;
+        }
+    } else if ( (ret.bbox.x1 <= ret.bbox.x2) && (ret.bbox.y1 <= ret.bbox.y2) ) {
+        // a flat bezier can still be picked
+        ret.type = RotoItemBounds::eTypeRect;
+    }
+
+    return ret;
+} // RotoSpatialIndex::getItemBounds
+
+RotoSpatialIndex::TimeGridPtr
+RotoSpatialIndex::getGrid(double time,
+                          const ItemsProvider& provider)
+{
+    // Called with _updateLock held: the items are never called with _lock held, since they may be
+    // invalidated while their own mutex is locked
+    TimeGridPtr grid;
+    std::vector<int> dirtyItems;
+    U64 age;
+    {
+        QMutexLocker k(&_lock);
+        age = _age;
+        for (std::list<TimeGridPtr>::iterator it = _grids.begin(); it != _grids.end(); ++it) {
+            if ( (*it)->time == time ) {
+                grid = *it;
+                if ( it != _grids.begin() ) {
+                    _grids.erase(it);
+                    _grids.push_front(grid);
+                }
+                dirtyItems.swap(grid->dirtyItems);
+                break;
+            }
+        }
+    }
+
+    if (grid) {
+        if ( dirtyItems.empty() ) {
+            return grid;
+        }
+        std::sort( dirtyItems.begin(), dirtyItems.end() );
+        dirtyItems.erase( std::unique( dirtyItems.begin(), dirtyItems.end() ), dirtyItems.end() );
+
+        if ( (int)dirtyItems.size() * 2 > grid->grid.getNumItems() ) {
+            // Most items changed: rebuilding the grid also adapts its cells to the new bounds
+            std::vector<RotoItemBounds> bounds( grid->items.size() );
+            for (std::size_t i = 0; i < grid->items.size(); ++i) {
+                bounds[i] = getItemBounds(grid->items[i].lock(), time);
+            }
+            grid->grid.build(bounds);
+        } else {
+            for (std::vector<int>::const_iterator it = dirtyItems.begin(); it != dirtyItems.end(); ++it) {
+                grid->grid.update( *it, getItemBounds(grid->items[*it].lock(), time) );
+            }
+        }
+
+        return grid;
+    }
+
+    grid = std::make_shared<TimeGrid>();
+    grid->time = time;
+
+    std::vector<RotoDrawableItemPtr> items;
+    provider(&items);
+
+    std::vector<RotoItemBounds> bounds( items.size() );
+    grid->items.resize( items.size() );
+    for (std::size_t i = 0; i < items.size(); ++i) {
+        grid->items[i] = items[i];
+        grid->indices[items[i].get()] = (int)i;
+        bounds[i] = getItemBounds(items[i], time);
+    }
+    grid->grid.build(bounds);
+
+    {
+        QMutexLocker k(&_lock);
+        // Do not keep the grid if an item changed while it was built
+        if (_age == age) {
+            _grids.push_front(grid);
+            if ( (int)_grids.size() > ROTO_SPATIAL_INDEX_MAX_TIMES ) {
+                _grids.pop_back();
+            }
+        }
+    }
+
+    return grid;
+} // RotoSpatialIndex::getGrid
+
+void
+RotoSpatialIndex::getItemsIntersecting(double time,
+                                       const RectD& rect,
+                                       const ItemsProvider& provider,
+                                       std::vector<RotoDrawableItemPtr>* items)
+{
+    QMutexLocker k(&_updateLock);
+    TimeGridPtr grid = getGrid(time, provider);
+    std::vector<int> indices;
+
+    grid->grid.getItemsIntersecting(rect, &indices);
+    for (std::vector<int>::const_iterator it = indices.begin(); it != indices.end(); ++it) {
+        RotoDrawableItemPtr item = grid->items[*it].lock();
+        if (item) {
+            items->push_back(item);
+        }
+    }
+}
+
+NATRON_NAMESPACE_EXIT
@@ -0,0 +1,214 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <https://natrongithub.github.io/>,
+ * (C) 2018-2023 The Natron developers
+ * (C) 2013-2018 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+#ifndef NATRON_ENGINE_ROTOSPATIALINDEX_H
+#define NATRON_ENGINE_ROTOSPATIALINDEX_H
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "Global/Macros.h"
+
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include <QtCore/QMutex>
+
+#include "Global/GlobalDefines.h"
+#include "Engine/RectD.h"
+#include "Engine/EngineFwd.h"
+
+NATRON_NAMESPACE_ENTER
+
+/**
+ * @brief The region covered by a Roto item at a given time, in canonical coordinates.
+ **/
+struct RotoItemBounds
+{
+    enum TypeEnum
+    {
+        eTypeEmpty = 0, //< the item does not draw anything
+        eTypeRect, //< the item only draws inside bbox (which may be flat, e.g. for a straight open bezier)
+        eTypeUnbounded //< the item must always be considered, e.g. inverted shapes
+    };
+
+    TypeEnum type;
+    RectD bbox;
+
+    RotoItemBounds()
+        : type(eTypeEmpty)
+        , bbox()
+    {
+    }
+};
+
+/**
+ * @brief A uniform grid over the bounding boxes of items identified by their index, which returns the items
+ * whose bounding box intersects a rectangle without testing all of them.
+ * The cells are sized from the number of items, and the boxes outside of the grid are clamped to its border
+ * cells, so that a grid stays correct (only slower) when items are moved after it was built.
+ * Items covering a large part of the grid are kept in a separate list which is always tested.
+ **/
+class RotoSpatialGrid
+{
+public:
+
+    RotoSpatialGrid();
+
+    ~RotoSpatialGrid();
+
+    /**
+     * @brief Rebuilds the grid: the index of an item is its index in bounds.
+     **/
+    void build(const std::vector<RotoItemBounds>& bounds);
+
+    /**
+     * @brief Changes the bounds of one item, only updating the cells it was and is now in.
+     **/
+    void update(int index, const RotoItemBounds& bounds);
+
+    int getNumItems() const
+    {
+        return (int)_bounds.size();
+    }
+
+    const RotoItemBounds& getBounds(int index) const
+    {
+        return _bounds[index];
+    }
+
+    /**
+     * @brief Appends to indices the items whose bounding box intersects rect, or which are unbounded,
+     * by increasing index.
+     **/
+    void getItemsIntersecting(const RectD& rect, std::vector<int>* indices) const;
+
+private:
+
+    // the cell range [x1,x2[ x [y1,y2[ of a box, empty if the item is not in the cells
+    struct CellRange
+    {
+        int x1, y1, x2, y2;
+    };
+
+    CellRange getCellRange(const RotoItemBounds& bounds) const;
+
+    void insertInCells(int index, const CellRange& range);
+
+    void removeFromCells(int index, const CellRange& range);
+
+    static bool intersects(const RotoItemBounds& bounds, const RectD& rect);
+
+    std::vector<RotoItemBounds> _bounds;
+    std::vector<CellRange> _ranges;
+    RectD _gridBounds;
+    double _cellWidth, _cellHeight;
+    int _nx, _ny;
+    std::vector<std::vector<int> > _cells;
+
+    // unbounded items and items spanning too many cells
+    std::vector<int> _alwaysTested;
+
+    // stamps used to return items spanning several cells only once
+    mutable std::vector<unsigned int> _stamps;
+    mutable unsigned int _stamp;
+};
+
+/**
+ * @brief A cache of the grids of the drawable items of a RotoContext at the last few times queried.
+ * Editing an item only recomputes the bounds of this item at the next query, while adding, removing or
+ * reordering items drops the grids.
+ * The items are returned in the order in which the provider lists them.
+ * MT-safe
+ **/
+class RotoSpatialIndex
+{
+public:
+
+    /**
+     * @brief Lists all the drawable items, called when a grid must be rebuilt.
+     **/
+    typedef std::function<void (std::vector<RotoDrawableItemPtr>* items)> ItemsProvider;
+
+    RotoSpatialIndex();
+
+    ~RotoSpatialIndex();
+
+    /**
+     * @brief Drops all the grids, when items are added, removed or reordered.
+     **/
+    void invalidateAll();
+
+    /**
+     * @brief Marks the bounds of the item as outdated in all the grids.
+     **/
+    void invalidateItem(const RotoDrawableItem* item);
+
+    /**
+     * @brief Returns the items that may draw inside rect (in canonical coordinates) at the given time.
+     **/
+    void getItemsIntersecting(double time,
+                              const RectD& rect,
+                              const ItemsProvider& provider,
+                              std::vector<RotoDrawableItemPtr>* items);
+
+    /**
+     * @brief Computes the region covered by the item at the given time. Items whose geometry may change without
+     * them being edited (e.g. through expressions or links to other parameters) and Beziers whose interactive
+     * changes are not applied yet are unbounded.
+     **/
+    static RotoItemBounds getItemBounds(const RotoDrawableItemPtr& item, double time);
+
+private:
+
+    struct TimeGrid
+    {
+        double time;
+        std::vector<RotoDrawableItemWPtr> items;
+        std::map<const RotoDrawableItem*, int> indices;
+        std::vector<int> dirtyItems;
+        RotoSpatialGrid grid;
+    };
+
+    typedef std::shared_ptr<TimeGrid> TimeGridPtr;
+
+    TimeGridPtr getGrid(double time, const ItemsProvider& provider);
+
+    // protects _age and _grids, and the dirty items of the grids
+    QMutex _lock;
+
+    // held while a grid is updated or queried, so that concurrent queries see up to date bounds
+    QMutex _updateLock;
+
+    // incremented whenever an item changes
+    U64 _age;
+
+    // most recently used first
+    std::list<TimeGridPtr> _grids;
+};
+
+NATRON_NAMESPACE_EXIT
+
+#endif // NATRON_ENGINE_ROTOSPATIALINDEX_H
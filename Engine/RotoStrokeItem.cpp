@@ -287,6 +287,7 @@ RotoStrokeItem::setStrokeFinished()
     }
 
     resetTransformCenter();
+    incrementMaskAge();
 
     NodePtr effectNode = getEffectNode();
     NodePtr mergeNode = getMergeNode();
@@ -416,6 +417,9 @@ RotoStrokeItem::appendPoint(bool newStroke,
         stroke->pressureCurve->setKeyFrameInterpolation(eKeyframeTypeCatmullRom, ki);
     } // QMutexLocker k(&itemMutex);
 
+    // the nodes age is not incremented while drawing, but the stroke grew
+    incrementMaskAge();
+    getContext()->invalidateItemBounds(this);
 
     return true;
 } // RotoStrokeItem::appendPoint
@@ -545,38 +549,29 @@ RotoStrokeItem::getMostRecentStrokeChangesSinceAge(double time,
         *wholeStrokeBbox = computeBoundingBoxInternal(time);
     }
 
-    KeyFrameSet xCurve = stroke->xCurve->getKeyFrames_mt_safe();
-    KeyFrameSet yCurve = stroke->yCurve->getKeyFrames_mt_safe();
-    KeyFrameSet pCurve = stroke->pressureCurve->getKeyFrames_mt_safe();
-
-    if ( xCurve.empty() ) {
+    int nKeys = stroke->xCurve->getKeyFramesCount();
+    if (nKeys == 0) {
         return false;
     }
     if (lastAge == -1) {
         lastAge = 0;
     }
 
-    if (lastAge >= (int) xCurve.size()) {
+    if (lastAge >= nKeys) {
         return false;
     }
 
-    KeyFrameSet realX, realY, realP;
-    KeyFrameSet::iterator xIt = xCurve.begin();
-    KeyFrameSet::iterator yIt = yCurve.begin();
-    KeyFrameSet::iterator pIt = pCurve.begin();
-    std::advance(xIt, lastAge);
-    std::advance(yIt, lastAge);
-    std::advance(pIt, lastAge);
-    *newAge = (int)xCurve.size() - 1;
-
-    if ( lastAge != (int)(xCurve.size() - 1) ) {
-        for (; xIt != xCurve.end(); ++xIt, ++yIt, ++pIt) {
-            realX.insert(*xIt);
-            realY.insert(*yIt);
-            realP.insert(*pIt);
-        }
+    *newAge = nKeys - 1;
+    if ( lastAge == (nKeys - 1) ) {
+        return false;
     }
 
+    // Only fetch the keyframes appended since the last rendered one, so that the cost of each update
+    // does not grow with the length of the stroke
+    KeyFrameSet realX = stroke->xCurve->getKeyFramesFromIndex_mt_safe(lastAge);
+    KeyFrameSet realY = stroke->yCurve->getKeyFramesFromIndex_mt_safe(lastAge);
+    KeyFrameSet realP = stroke->pressureCurve->getKeyFramesFromIndex_mt_safe(lastAge);
+
     if ( realX.empty() ) {
         return false;
     }
@@ -0,0 +1,416 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <https://natrongithub.github.io/>,
+ * (C) 2018-2023 The Natron developers
+ * (C) 2013-2018 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "RotoStrokeStamper.h"
+
+#include <algorithm> // min, max
+#include <cassert>
+#include <cmath>
+#include <cstring> // memset
+
+#include "Engine/EffectInstance.h"
+#include "Engine/RotoRenderBands.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+// Blend 4 pixels at once
+#define ROTO_STAMPER_USE_SSE2
+#include <emmintrin.h>
+#endif
+
+// Same as in RotoContext.cpp: the dab profiles are shared by the dots of the same pressure level
+#define ROTO_PRESSURE_LEVELS 512
+
+// Number of entries of the table giving the opacity of a dab as a function of the normalized squared distance to its center
+#define ROTO_STAMPER_PROFILE_LUT_SIZE 1024
+
+// Minimum height of a band of rows stamped by a thread
+#define ROTO_STAMPER_MIN_BAND_HEIGHT 16
+
+NATRON_NAMESPACE_ENTER
+
+NATRON_NAMESPACE_ANONYMOUS_ENTER
+
+static inline
+double
+hardnessGaussLookup(double f)
+{
+    //2 hyperbolas + 1 parabola to approximate a gauss function
+    if (f < -0.5) {
+        f = -1. - f;
+
+        return (2. * f * f);
+    }
+
+    if (f < 0.5) {
+        return (1. - 2. * f * f);
+    }
+    f = 1. - f;
+
+    return (2. * f * f);
+}
+
+static inline
+int
+getPressureLevel(double pressure)
+{
+    // sometimes, Qt gives a pressure level > 1... so we clamp it
+    int pressureInt = int(std::max( 0., std::min(pressure, 1.) ) * (ROTO_PRESSURE_LEVELS - 1) + 0.5);
+
+    assert(pressureInt >= 0 && pressureInt < ROTO_PRESSURE_LEVELS);
+
+    return pressureInt;
+}
+
+// Evaluates the cairo radial gradient between the internal and external radius, padded on both sides
+static double
+evaluateGradient(double r,
+                 double internalDotRadius,
+                 double externalDotRadius,
+                 const std::vector<std::pair<double, double> >& opacityStops)
+{
+    double t;
+
+    if (externalDotRadius > internalDotRadius) {
+        t = (r - internalDotRadius) / (externalDotRadius - internalDotRadius);
+    } else {
+        t = r < internalDotRadius ? 0. : 1.;
+    }
+    if ( t <= opacityStops.front().first ) {
+        return opacityStops.front().second;
+    }
+    for (std::size_t i = 1; i < opacityStops.size(); ++i) {
+        if (t <= opacityStops[i].first) {
+            const std::pair<double, double>& s0 = opacityStops[i - 1];
+            const std::pair<double, double>& s1 = opacityStops[i];
+            double a = s1.first > s0.first ? (t - s0.first) / (s1.first - s0.first) : 1.;
+
+            return s0.second * (1. - a) + s1.second * a;
+        }
+    }
+
+    return opacityStops.back().second;
+}
+
+template <bool doBuildUp>
+static void
+stampRow(const float* lut,
+         double dx0,
+         double dy2,
+         float lutScale,
+         int n,
+         float* dst)
+{
+    int x = 0;
+
+#ifdef ROTO_STAMPER_USE_SSE2
+    const __m128 vFour = _mm_set1_ps(4.f);
+    const __m128 vOne = _mm_set1_ps(1.f);
+    const __m128 vDy2 = _mm_set1_ps( (float)dy2 );
+    const __m128 vScale = _mm_set1_ps(lutScale);
+    const __m128 vMax = _mm_set1_ps( (float)ROTO_STAMPER_PROFILE_LUT_SIZE );
+    __m128 vDx = _mm_setr_ps( (float)dx0, (float)(dx0 + 1.), (float)(dx0 + 2.), (float)(dx0 + 3.) );
+    for (; x + 4 <= n; x += 4) {
+        __m128 d2 = _mm_add_ps(_mm_mul_ps(vDx, vDx), vDy2);
+        __m128i idx = _mm_cvttps_epi32( _mm_min_ps(_mm_mul_ps(d2, vScale), vMax) );
+        // there is no gather in SSE2
+        int i[4];
+        _mm_storeu_si128( (__m128i*)i, idx );
+        __m128 v = _mm_setr_ps(lut[i[0]], lut[i[1]], lut[i[2]], lut[i[3]]);
+        __m128 d = _mm_loadu_ps(dst + x);
+        if (doBuildUp) {
+            // over: v + d * (1 - v)
+            d = _mm_add_ps( d, _mm_mul_ps( v, _mm_sub_ps(vOne, d) ) );
+        } else {
+            // lighten
+            d = _mm_max_ps(d, v);
+        }
+        _mm_storeu_ps(dst + x, d);
+        vDx = _mm_add_ps(vDx, vFour);
+    }
+#endif
+
+    for (; x < n; ++x) {
+        double dx = dx0 + x;
+        int i = std::min( (int)( (float)(dx * dx + dy2) * lutScale ), ROTO_STAMPER_PROFILE_LUT_SIZE );
+        float v = lut[i];
+        if (doBuildUp) {
+            dst[x] += v * (1.f - dst[x]);
+        } else {
+            dst[x] = std::max(dst[x], v);
+        }
+    }
+}
+
+// The dots of the brush with their profile, shared by all bands
+struct StampDot
+{
+    const RotoDabProfile* profile;
+    Point center;
+    double externalDotRadius;
+};
+
+static void
+prepareDots(const RotoStrokeBrush& brush,
+            const std::vector<RotoStrokeDot>& dots,
+            std::vector<RotoDabProfile>* profiles,
+            std::vector<StampDot>* stampDots)
+{
+    profiles->resize(ROTO_PRESSURE_LEVELS);
+    stampDots->resize( dots.size() );
+
+    double internalDotRadius, externalDotRadius, spacing;
+    std::vector<std::pair<double, double> > opacityStops;
+    for (std::size_t i = 0; i < dots.size(); ++i) {
+        int level = getPressureLevel(dots[i].pressure);
+        RotoDabProfile& profile = (*profiles)[level];
+        if ( profile.lut.empty() ) {
+            double pressure = level / (double)(ROTO_PRESSURE_LEVELS - 1);
+            RotoStrokeStamper::getDotParams(brush.opacity, brush.brushSizePixel, brush.brushHardness, brush.brushSpacing, pressure,
+                                            brush.pressureAffectsOpacity, brush.pressureAffectsSize, brush.pressureAffectsHardness,
+                                            &internalDotRadius, &externalDotRadius, &spacing, &opacityStops);
+            RotoStrokeStamper::computeDabProfile(internalDotRadius, externalDotRadius, opacityStops, brush.opacity, &profile);
+        }
+        StampDot& d = (*stampDots)[i];
+        d.profile = &profile;
+        d.center = dots[i].center;
+        d.externalDotRadius = dots[i].externalDotRadius;
+    }
+}
+
+static void
+stampBand(const std::vector<StampDot>& dots,
+          const std::vector<int>& indices,
+          bool doBuildUp,
+          const RectI& band,
+          float* coverage)
+{
+    std::memset( coverage, 0, sizeof(float) * band.width() * band.height() );
+    for (std::size_t i = 0; i < indices.size(); ++i) {
+        const StampDot& d = dots[indices[i]];
+        RotoStrokeStamper::stampDot(*d.profile, d.center, d.externalDotRadius, doBuildUp, band, coverage);
+    }
+}
+
+NATRON_NAMESPACE_ANONYMOUS_EXIT
+
+
+void
+RotoStrokeStamper::getDotParams(double alpha,
+                                double brushSizePixel,
+                                double brushHardness,
+                                double brushSpacing,
+                                double pressure,
+                                bool pressureAffectsOpacity,
+                                bool pressureAffectsSize,
+                                bool pressureAffectsHardness,
+                                double* internalDotRadius,
+                                double* externalDotRadius,
+                                double * spacing,
+                                std::vector<std::pair<double, double> >* opacityStops)
+{
+    if (pressureAffectsSize) {
+        brushSizePixel *= pressure;
+    }
+    if (pressureAffectsHardness) {
+        brushHardness *= pressure;
+    }
+    if (pressureAffectsOpacity) {
+        alpha *= pressure;
+    }
+
+    *internalDotRadius = std::max(brushSizePixel * brushHardness, 1.) / 2.;
+    *externalDotRadius = std::max(brushSizePixel, 1.) / 2.;
+    *spacing = *externalDotRadius * 2. * brushSpacing;
+
+
+    opacityStops->clear();
+
+    double exp = brushHardness != 1.0 ?  0.4 / (1.0 - brushHardness) : 0.;
+    const int maxStops = 8;
+    double incr = 1. / maxStops;
+
+    if (brushHardness != 1.) {
+        for (double d = 0; d <= 1.; d += incr) {
+            double o = hardnessGaussLookup( std::pow(d, exp) );
+            opacityStops->push_back( std::make_pair(d, o * alpha) );
+        }
+    }
+} // RotoStrokeStamper::getDotParams
+
+void
+RotoStrokeStamper::computeDabProfile(double internalDotRadius,
+                                     double externalDotRadius,
+                                     const std::vector<std::pair<double, double> >& opacityStops,
+                                     double opacity,
+                                     RotoDabProfile* profile)
+{
+    profile->lut.resize(ROTO_STAMPER_PROFILE_LUT_SIZE + 1);
+    for (int i = 0; i <= ROTO_STAMPER_PROFILE_LUT_SIZE; ++i) {
+        if ( opacityStops.empty() ) {
+            // hard brush: see RotoContextPrivate::renderDot
+            profile->lut[i] = (float)opacity;
+            continue;
+        }
+        // entry i is used for the normalized squared distances in [i, i + 1) / ROTO_STAMPER_PROFILE_LUT_SIZE
+        double d2 = std::min(i + 0.5, (double)ROTO_STAMPER_PROFILE_LUT_SIZE) / ROTO_STAMPER_PROFILE_LUT_SIZE;
+        double r = std::sqrt(d2) * externalDotRadius;
+        profile->lut[i] = (float)evaluateGradient(r, internalDotRadius, externalDotRadius, opacityStops);
+    }
+}
+
+void
+RotoStrokeStamper::stampDot(const RotoDabProfile& profile,
+                            const Point& center,
+                            double externalDotRadius,
+                            bool doBuildUp,
+                            const RectI& rect,
+                            float* coverage)
+{
+    assert(profile.lut.size() == ROTO_STAMPER_PROFILE_LUT_SIZE + 1);
+    const double r2 = externalDotRadius * externalDotRadius;
+    if (r2 <= 0.) {
+        return;
+    }
+    const float lutScale = (float)(ROTO_STAMPER_PROFILE_LUT_SIZE / r2);
+    const int width = rect.width();
+
+    // a pixel is covered if its center is inside the dot
+    int y1 = std::max( rect.y1, (int)std::ceil(center.y - externalDotRadius - 0.5) );
+    int y2 = std::min( rect.y2, (int)std::floor(center.y + externalDotRadius - 0.5) + 1 );
+    for (int y = y1; y < y2; ++y) {
+        double dy = y + 0.5 - center.y;
+        double dy2 = dy * dy;
+        if (dy2 > r2) {
+            continue;
+        }
+        double w = std::sqrt(r2 - dy2);
+        int x1 = std::max( rect.x1, (int)std::ceil(center.x - w - 0.5) );
+        int x2 = std::min( rect.x2, (int)std::floor(center.x + w - 0.5) + 1 );
+        if (x2 <= x1) {
+            continue;
+        }
+        float* dst = coverage + (std::size_t)(y - rect.y1) * width + (x1 - rect.x1);
+        double dx0 = x1 + 0.5 - center.x;
+        if (doBuildUp) {
+            stampRow<true>(&profile.lut.front(), dx0, dy2, lutScale, x2 - x1, dst);
+        } else {
+            stampRow<false>(&profile.lut.front(), dx0, dy2, lutScale, x2 - x1, dst);
+        }
+    }
+} // RotoStrokeStamper::stampDot
+
+void
+RotoStrokeStamper::renderSequential(const RotoStrokeBrush& brush,
+                                    const std::vector<RotoStrokeDot>& dots,
+                                    const RectI& rect,
+                                    float* coverage)
+{
+    if ( rect.isNull() ) {
+        return;
+    }
+    std::vector<RotoDabProfile> profiles;
+    std::vector<StampDot> stampDots;
+    prepareDots(brush, dots, &profiles, &stampDots);
+
+    std::vector<int> indices( stampDots.size() );
+    for (std::size_t i = 0; i < indices.size(); ++i) {
+        indices[i] = (int)i;
+    }
+    stampBand(stampDots, indices, brush.doBuildUp, rect, coverage);
+}
+
+bool
+RotoStrokeStamper::render(const RotoStrokeBrush& brush,
+                          const std::vector<RotoStrokeDot>& dots,
+                          const RectI& roi,
+                          const TileWriter& writer)
+{
+    if ( roi.isNull() ) {
+        return true;
+    }
+
+    std::vector<RotoDabProfile> profiles;
+    std::vector<StampDot> stampDots;
+    prepareDots(brush, dots, &profiles, &stampDots);
+
+    if ( EffectInstance::isCurrentThreadRenderAborted() ) {
+        return false;
+    }
+
+    // Split the RoI in bands of rows, a few per thread so that the load is balanced
+    RotoRenderBands renderBands(roi, ROTO_STAMPER_MIN_BAND_HEIGHT);
+    const std::vector<RectI>& bands = renderBands.getBands();
+    const int bandHeight = renderBands.getBandHeight();
+
+    // Dispatch the dots to the bands they overlap, keeping their order
+    std::vector<std::vector<int> > bandDots( bands.size() );
+    for (std::size_t i = 0; i < stampDots.size(); ++i) {
+        const StampDot& d = stampDots[i];
+        if ( ( (d.center.x + d.externalDotRadius) < roi.x1 ) || ( (d.center.x - d.externalDotRadius) >= roi.x2 ) ) {
+            continue;
+        }
+        int first = (int)std::floor( (d.center.y - d.externalDotRadius - roi.y1) / bandHeight );
+        int last = (int)std::floor( (d.center.y + d.externalDotRadius - roi.y1) / bandHeight );
+        first = std::max(first, 0);
+        last = std::min(last, (int)bands.size() - 1);
+        for (int b = first; b <= last; ++b) {
+            bandDots[b].push_back( (int)i );
+        }
+    }
+
+    return renderBands.render([&](const int& b) {
+        const RectI& band = bands[b];
+        std::vector<float> coverage( (std::size_t)band.width() * band.height() );
+        stampBand(stampDots, bandDots[b], brush.doBuildUp, band, &coverage.front());
+        writer(band, &coverage.front());
+    });
+} // RotoStrokeStamper::render
+
+void
+RotoStrokeStamper::renderDabMask(int brushSizePixel,
+                                 double brushHardness,
+                                 double alpha,
+                                 std::vector<float>* mask)
+{
+    // see RotoContext::allocateAndRenderSingleDotStroke
+    const RectI rect(0, 0, brushSizePixel + 1, brushSizePixel + 1);
+    mask->assign( (std::size_t)rect.width() * rect.height(), 0.f );
+
+    Point p;
+    p.x = brushSizePixel / 2.;
+    p.y = brushSizePixel / 2.;
+
+    const double pressure = 1.;
+    const double brushspacing = 0.;
+    double internalDotRadius, externalDotRadius, spacing;
+    std::vector<std::pair<double, double> > opacityStops;
+    getDotParams(alpha, brushSizePixel, brushHardness, brushspacing, pressure, false, false, false, &internalDotRadius, &externalDotRadius, &spacing, &opacityStops);
+
+    RotoDabProfile profile;
+    computeDabProfile(internalDotRadius, externalDotRadius, opacityStops, alpha, &profile);
+    stampDot(profile, p, externalDotRadius, true, rect, &mask->front());
+}
+
+NATRON_NAMESPACE_EXIT
@@ -0,0 +1,158 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <https://natrongithub.github.io/>,
+ * (C) 2018-2023 The Natron developers
+ * (C) 2013-2018 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+#ifndef NATRON_ENGINE_ROTOSTROKESTAMPER_H
+#define NATRON_ENGINE_ROTOSTROKESTAMPER_H
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "Global/Macros.h"
+
+#include <functional>
+#include <utility>
+#include <vector>
+
+#include "Global/GlobalDefines.h"
+#include "Engine/RectI.h"
+#include "Engine/EngineFwd.h"
+
+NATRON_NAMESPACE_ENTER
+
+/**
+ * @brief The brush parameters of a paint stroke (or an open bezier) at a given time and scale.
+ **/
+struct RotoStrokeBrush
+{
+    double opacity;
+    double brushSizePixel;
+    double brushHardness;
+    double brushSpacing;
+    double writeOnStart, writeOnEnd;
+    bool pressureAffectsOpacity;
+    bool pressureAffectsSize;
+    bool pressureAffectsHardness;
+    bool doBuildUp;
+};
+
+/**
+ * @brief A dot of a paint stroke, in pixel coordinates.
+ **/
+struct RotoStrokeDot
+{
+    Point center;
+    double pressure;
+    double externalDotRadius;
+};
+
+/**
+ * @brief The opacity of a dab as a function of the squared distance to its center divided by the squared
+ * radius of the dab, tabulated once per brush and pressure level so that stamping does not evaluate the
+ * gradient for each pixel.
+ **/
+struct RotoDabProfile
+{
+    std::vector<float> lut;
+};
+
+/**
+ * @brief Renders the dots of paint strokes natively in float buffers, as the cairo radial gradients of
+ * RotoContextPrivate::renderDot without antialiasing would: a pixel is covered by a dot if its center is
+ * inside the dot. The dots are composited with "over" in build-up mode, and with "lighten" otherwise.
+ * The RoI is split in bands of rows stamped concurrently, each band only stamping the dots overlapping it.
+ **/
+class RotoStrokeStamper
+{
+public:
+
+    /**
+     * @brief Called concurrently with disjoint tiles: coverage points to the tile.width() * tile.height()
+     * values in [0,1] of the tile, stored by rows from tile.y1.
+     **/
+    typedef std::function<void (const RectI& tile, const float* coverage)> TileWriter;
+
+    /**
+     * @brief Computes the radii of a dot, the distance to the next dot, and the color stops of its radial
+     * gradient (empty for a hard brush) for the given pressure.
+     **/
+    static void getDotParams(double alpha,
+                             double brushSizePixel,
+                             double brushHardness,
+                             double brushSpacing,
+                             double pressure,
+                             bool pressureAffectsOpacity,
+                             bool pressureAffectsSize,
+                             bool pressureAffectsHardness,
+                             double* internalDotRadius,
+                             double* externalDotRadius,
+                             double * spacing,
+                             std::vector<std::pair<double, double> >* opacityStops);
+
+    /**
+     * @brief Tabulates the opacity of a dot with the given radii and gradient stops.
+     **/
+    static void computeDabProfile(double internalDotRadius,
+                                  double externalDotRadius,
+                                  const std::vector<std::pair<double, double> >& opacityStops,
+                                  double opacity,
+                                  RotoDabProfile* profile);
+
+    /**
+     * @brief Stamps one dot in the coverage buffer of rect.
+     **/
+    static void stampDot(const RotoDabProfile& profile,
+                         const Point& center,
+                         double externalDotRadius,
+                         bool doBuildUp,
+                         const RectI& rect,
+                         float* coverage);
+
+    /**
+     * @brief Stamps the given dots over the roi. Returns false if the render was aborted,
+     * in which case some tiles may not have been written.
+     **/
+    static bool render(const RotoStrokeBrush& brush,
+                       const std::vector<RotoStrokeDot>& dots,
+                       const RectI& roi,
+                       const TileWriter& writer);
+
+    /**
+     * @brief Sequential version of render() over the given rect, which does not check for render abortion.
+     **/
+    static void renderSequential(const RotoStrokeBrush& brush,
+                                 const std::vector<RotoStrokeDot>& dots,
+                                 const RectI& rect,
+                                 float* coverage);
+
+    /**
+     * @brief Renders a single dot of full pressure centered in a (brushSizePixel + 1) pixels wide square,
+     * as used by the smear brush.
+     **/
+    static void renderDabMask(int brushSizePixel,
+                              double brushHardness,
+                              double alpha,
+                              std::vector<float>* mask);
+};
+
+NATRON_NAMESPACE_EXIT
+
+#endif // NATRON_ENGINE_ROTOSTROKESTAMPER_H
@@ -25,6 +25,7 @@
 
 #include "Settings.h"
 
+#include <algorithm> // min, max
 #include <cassert>
 #include <limits>
 #include <stdexcept>
@@ -346,6 +347,20 @@ Settings::initializeKnobsThreading()
                                                  "a separate process so that if the main application crashes, the render goes on.").arg( QString::fromUtf8(NATRON_APPLICATION_NAME) ) );
     _threadingPage->addKnob(_renderInSeparateProcess);
 
+    _nRenderProcesses = AppManager::createKnob<KnobInt>( this, tr("Number of render processes (0=\"guess\")") );
+    _nRenderProcesses->setName("nRenderProcesses");
+    _nRenderProcesses->setHintToolTip( tr("When rendering in a separate process, controls how many processes render the frame range "
+                                          "of a Write node at the same time. The frame range is split in chunks and each process renders "
+                                          "one chunk at a time. This helps using all the cores of the computer when some plug-ins "
+                                          "are not thread-safe and cannot render several frames at once in the same process. "
+                                          "A value of 0 launches as many processes as there are cores. "
+                                          "When rendering from the command line, the frame range is split across processes whenever "
+                                          "this is greater than 1, even if rendering in a separate process is disabled. "
+                                          "Writers producing a single file (such as video files) are always rendered by a single process.") );
+    _nRenderProcesses->setMinimum(0);
+    _nRenderProcesses->disableSlider();
+    _threadingPage->addKnob(_nRenderProcesses);
+
     _queueRenders = AppManager::createKnob<KnobBool>( this, tr("Append new renders to queue") );
     _queueRenders->setHintToolTip( tr("When checked, renders will be queued in the Progress Panel and will start only when all "
                                       "other prior tasks are done.") );
@@ -1480,6 +1495,7 @@ Settings::setDefaultValues()
     _useThreadPool->setDefaultValue(true);
     _nThreadsPerEffect->setDefaultValue(0);
     _renderInSeparateProcess->setDefaultValue(false, 0);
+    _nRenderProcesses->setDefaultValue(1);
     _queueRenders->setDefaultValue(false);
 
     // General/Rendering
@@ -2888,6 +2904,18 @@ Settings::isRenderInSeparatedProcessEnabled() const
     return _renderInSeparateProcess->getValue();
 }
 
+int
+Settings::getNumberOfRenderProcesses() const
+{
+    int nProcesses = _nRenderProcesses->getValue();
+
+    if (nProcesses == 0) {
+        nProcesses = appPTR->getHardwareIdealThreadCount();
+    }
+
+    return std::max(1, nProcesses);
+}
+
 int
 Settings::getMaximumUndoRedoNodeGraph() const
 {
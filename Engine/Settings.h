@@ -167,6 +167,8 @@ public:
 
     bool isRenderInSeparatedProcessEnabled() const;
 
+    int getNumberOfRenderProcesses() const;
+
     bool isRenderQueuingEnabled() const;
 
     void setRenderQueuingEnabled(bool enabled);
@@ -444,6 +446,7 @@ private:
     KnobBoolPtr _useThreadPool;
     KnobIntPtr _nThreadsPerEffect;
     KnobBoolPtr _renderInSeparateProcess;
+    KnobIntPtr _nRenderProcesses;
     KnobBoolPtr _queueRenders;
 
     // General/Rendering
@@ -86,6 +86,9 @@ typedef OfxRangeD RangeD;
 
 #define kProgressChangedStringShort "-p"
 
+// Followed by "<node>;<time spent>;<cache misses>;<cache hits>;<downscaled cache hits>;<rectangles rendered>;<identity>"
+#define kNodeRenderStatsStringShort "-n"
+
 #define kRenderingFinishedStringShort "-e"
 
 #define kAbortRenderingStringShort "-a"
@@ -95,6 +95,8 @@ namespace Python { }
 // - NatronInfo.plist (for OSX)
 // - tools/linux/include/qs/natron.qs
 #define NATRON_PROJECT_FILE_EXT "ntp"
+// binary variant of the project format, faster to load and save but not portable across boost versions
+#define NATRON_PROJECT_BINARY_FILE_EXT "ntpb"
 #define NATRON_PROJECT_FILE_MIME_TYPE "application/vnd.natron.project"
 #define NATRON_PROJECT_UNTITLED "Untitled." NATRON_PROJECT_FILE_EXT
 #define NATRON_CACHE_FILE_EXT "ntc"
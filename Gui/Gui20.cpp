@@ -1030,6 +1030,7 @@ Gui::openProject()
     std::vector<std::string> filters;
 
     filters.push_back(NATRON_PROJECT_FILE_EXT);
+    filters.push_back(NATRON_PROJECT_BINARY_FILE_EXT);
     std::string selectedFile =  popOpenFileDialog( false, filters, _imp->_lastLoadProjectOpenedDir.toStdString(), false );
 
     if ( !selectedFile.empty() ) {
@@ -1182,6 +1183,7 @@ Gui::saveProjectAs()
     std::vector<std::string> filter;
 
     filter.push_back(NATRON_PROJECT_FILE_EXT);
+    filter.push_back(NATRON_PROJECT_BINARY_FILE_EXT);
     std::string outFile = popSaveFileDialog( false, filter, _imp->_lastSaveProjectOpenedDir.toStdString(), false );
     if (outFile.size() > 0) {
         return saveProjectAs(outFile);
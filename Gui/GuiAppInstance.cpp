@@ -392,7 +392,8 @@ GuiAppInstance::loadInternal(const CLArgs& cl,
             ///If this is a Python script, execute it
             loadPythonScript(info);
             execOnProjectCreatedCallback();
-        } else if ( info.suffix() == QString::fromUtf8(NATRON_PROJECT_FILE_EXT) ) {
+        } else if ( ( info.suffix() == QString::fromUtf8(NATRON_PROJECT_FILE_EXT) ) ||
+                    ( info.suffix() == QString::fromUtf8(NATRON_PROJECT_BINARY_FILE_EXT) ) ) {
             ///Otherwise just load the project specified.
             QString name = info.fileName();
             QString path = info.path();
@@ -1266,7 +1267,8 @@ GuiAppInstance::handleFileOpenEvent(const std::string &filename)
 
     fileCopy.replace( QLatin1Char('\\'), QLatin1Char('/') );
     QString ext = QtCompat::removeFileExtension(fileCopy);
-    if ( ext == QString::fromUtf8(NATRON_PROJECT_FILE_EXT) ) {
+    if ( ( ext == QString::fromUtf8(NATRON_PROJECT_FILE_EXT) ) ||
+         ( ext == QString::fromUtf8(NATRON_PROJECT_BINARY_FILE_EXT) ) ) {
         AppInstancePtr app = getGui()->openProject(filename);
         if (!app) {
             Dialogs::errorDialog(tr("Project").toStdString(), tr("Failed to open project").toStdString() + ' ' + filename);
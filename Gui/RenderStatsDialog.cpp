@@ -36,6 +36,7 @@
 #include <QItemSelectionModel>
 #include <QtCore/QRegExp>
 
+#include "Engine/AbortableRenderInfo.h"
 #include "Engine/Node.h"
 #include "Engine/Timer.h"
 #include "Engine/Utils.h" // convertFromPlainText
@@ -77,6 +78,9 @@ enum ItemsRoleEnum
     eItemsRoleIdentityTilesInfo = 102,
     eItemsRoleRenderedTilesNb = 103,
     eItemsRoleRenderedTilesInfo = 104,
+    eItemsRoleShapeGeometryTime = 105,
+    eItemsRoleShapeGeometryNb = 106,
+    eItemsRoleShapeGeometryCachedNb = 107,
 };
 
 struct RowInfo
@@ -231,13 +235,22 @@ public:
         {
             TableItem* item = 0;
             double timeSoFar;
+            int nbShapes, nbShapesCached;
+            double shapesTime;
+            stats.getShapeGeometryInfos(&nbShapes, &nbShapesCached, &shapesTime);
             if (exists) {
                 item = view->item(row, COL_TIME);
                 timeSoFar = item->data( (int)eItemsRoleTime ).toDouble();
                 timeSoFar += stats.getTotalTimeSpentRendering();
+                shapesTime += item->data( (int)eItemsRoleShapeGeometryTime ).toDouble();
+                nbShapes += item->data( (int)eItemsRoleShapeGeometryNb ).toInt();
+                nbShapesCached += item->data( (int)eItemsRoleShapeGeometryCachedNb ).toInt();
             } else {
                 item = new TableItem;
-                QString tt = NATRON_NAMESPACE::convertFromPlainText(tr("The time spent rendering by this node across all threads."), NATRON_NAMESPACE::WhiteSpaceNormal);
+                QString tt = NATRON_NAMESPACE::convertFromPlainText(tr("The time spent rendering by this node across all threads.\n"
+                                                               "For Roto nodes, the time spent computing the geometry of the shapes "
+                                                               "is also indicated, with the number of shapes whose geometry was "
+                                                               "already cached."), NATRON_NAMESPACE::WhiteSpaceNormal);
                 item->setToolTip(tt);
                 timeSoFar = stats.getTotalTimeSpentRendering();
                 item->setFlags(Qt::ItemIsSelectable | Qt::ItemIsEnabled);
@@ -248,7 +261,14 @@ public:
                 item->setBackgroundColor(c);
             }
             item->setData( (int)eItemsRoleTime, timeSoFar );
-            item->setText( Timer::printAsTime(timeSoFar, false) );
+            item->setData( (int)eItemsRoleShapeGeometryTime, shapesTime );
+            item->setData( (int)eItemsRoleShapeGeometryNb, nbShapes );
+            item->setData( (int)eItemsRoleShapeGeometryCachedNb, nbShapesCached );
+            QString str = Timer::printAsTime(timeSoFar, false);
+            if (nbShapes > 0) {
+                str += tr(" (shapes: %1, %2/%3 cached)").arg( Timer::printAsTime(shapesTime, false) ).arg(nbShapesCached).arg(nbShapes);
+            }
+            item->setText(str);
 
             if (!exists) {
                 view->setItem(row, COL_TIME, item);
@@ -441,6 +461,10 @@ public:
             NodePtr identity = stats.getInputImageIdentity();
             if (identity) {
                 str = QString::fromUtf8( identity->getLabel().c_str() );
+                int nbElided = stats.getNbPassThroughNodesElided();
+                if (nbElided > 0) {
+                    str += tr(" (%1 pass-through node(s) collapsed)").arg(nbElided);
+                }
             } else {
                 str = QLatin1Char('-');
             }
@@ -703,6 +727,8 @@ struct RenderStatsDialogPrivate
     QCheckBox* advancedCheckbox;
     Label* totalTimeSpentDescLabel;
     Label* totalTimeSpentValueLabel;
+    Label* abortLatencyDescLabel;
+    Label* abortLatencyValueLabel;
     double totalSpentTime;
     Button* resetButton;
     QWidget* filterContainer;
@@ -729,6 +755,8 @@ struct RenderStatsDialogPrivate
         , advancedCheckbox(0)
         , totalTimeSpentDescLabel(0)
         , totalTimeSpentValueLabel(0)
+        , abortLatencyDescLabel(0)
+        , abortLatencyValueLabel(0)
         , totalSpentTime(0)
         , resetButton(0)
         , filterContainer(0)
@@ -747,6 +775,8 @@ struct RenderStatsDialogPrivate
 
     void editNodeRow(const NodePtr& node, const NodeRenderStats& stats);
 
+    void refreshAbortLatency();
+
     void updateVisibleRowsInternal(const QString& nameFilter, const QString& pluginIDFilter);
 };
 
@@ -811,6 +841,19 @@ RenderStatsDialog::RenderStatsDialog(Gui* gui)
     _imp->globalInfosLayout->addWidget(_imp->totalTimeSpentDescLabel);
     _imp->globalInfosLayout->addWidget(_imp->totalTimeSpentValueLabel);
 
+    _imp->globalInfosLayout->addSpacing(20);
+
+    QString abortLatencytt = NATRON_NAMESPACE::convertFromPlainText(tr("Time elapsed between the moment a render was aborted (e.g: because a parameter "
+                                                                       "changed while the Viewer was rendering) and the moment the last thread working on it exited.\n"
+                                                                       "This is displayed as: last / average / maximum over all aborted renders so far."), NATRON_NAMESPACE::WhiteSpaceNormal);
+    _imp->abortLatencyDescLabel = new Label(tr("Abort latency:"), _imp->globalInfosContainer);
+    _imp->abortLatencyDescLabel->setToolTip(abortLatencytt);
+    _imp->abortLatencyValueLabel = new Label(QString::fromUtf8("-"), _imp->globalInfosContainer);
+    _imp->abortLatencyValueLabel->setToolTip(abortLatencytt);
+
+    _imp->globalInfosLayout->addWidget(_imp->abortLatencyDescLabel);
+    _imp->globalInfosLayout->addWidget(_imp->abortLatencyValueLabel);
+
     _imp->resetButton = new Button(tr("Reset"), _imp->globalInfosContainer);
     _imp->resetButton->setToolTip( tr("Clears the statistics.") );
     QObject::connect( _imp->resetButton, SIGNAL(clicked(bool)), this, SLOT(resetStats()) );
@@ -988,6 +1031,7 @@ RenderStatsDialog::addStats(int /*time*/,
 
     _imp->totalSpentTime += wallTime;
     _imp->totalTimeSpentValueLabel->setText( Timer::printAsTime(_imp->totalSpentTime, false) );
+    _imp->refreshAbortLatency();
 
     for (std::map<NodePtr, NodeRenderStats >::const_iterator it = stats.begin(); it != stats.end(); ++it) {
         _imp->model->editNodeRow(it->first, it->second);
@@ -1000,6 +1044,26 @@ RenderStatsDialog::addStats(int /*time*/,
     }
 }
 
+void
+RenderStatsDialogPrivate::refreshAbortLatency()
+{
+    int nbAbortedRenders;
+    double lastLatency, averageLatency, maxLatency;
+
+    AbortableRenderInfo::getAbortLatencyStatistics(&nbAbortedRenders, &lastLatency, &averageLatency, &maxLatency);
+    if (nbAbortedRenders == 0) {
+        abortLatencyValueLabel->setText( QString::fromUtf8("-") );
+
+        return;
+    }
+    // Latencies are in the order of the millisecond, printAsTime would round them
+    abortLatencyValueLabel->setText( QString::fromUtf8("%1 / %2 / %3 ms (%4 renders)")
+                                     .arg(lastLatency * 1000., 0, 'f', 1)
+                                     .arg(averageLatency * 1000., 0, 'f', 1)
+                                     .arg(maxLatency * 1000., 0, 'f', 1)
+                                     .arg(nbAbortedRenders) );
+}
+
 void
 RenderStatsDialog::closeEvent(QCloseEvent * /*event*/)
 {
@@ -25,11 +25,22 @@
 
 #include "Global/Macros.h"
 
+#include <algorithm>
+#include <cmath>
 #include <cstdlib>
+#include <iostream>
+#include <set>
+#include <stdexcept>
+#include <vector>
 
 #include "BaseTest.h"
 
+#include <QtCore/QCoreApplication>
+#include <QtCore/QDir>
+#include <QtCore/QElapsedTimer>
 #include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QTextStream>
 #include <QtCore/QThreadPool>
 
 // ofxhPropertySuite.h:565:37: warning: 'this' pointer cannot be null in well-defined C++ code; comparison may be assumed to always evaluate to true [-Wtautological-undefined-compare]
@@ -46,16 +57,27 @@ CLANG_DIAG_ON(tautological-undefined-compare)
 CLANG_DIAG_ON(unknown-pragmas)
 // clang-format on
 
+#include "Engine/AbortableRenderInfo.h"
 #include "Engine/CreateNodeArgs.h"
 #include "Engine/Node.h"
+#include "Engine/NodeGroup.h"
 #include "Engine/Project.h"
 #include "Engine/AppManager.h"
 #include "Engine/AppInstance.h"
+#include "Engine/Bezier.h"
+#include "Engine/BezierCP.h"
+#include "Engine/KnobExpression.h"
 #include "Engine/KnobTypes.h"
 #include "Engine/EffectInstance.h"
+#include "Engine/Image.h"
+#include "Engine/ParallelRenderArgs.h"
 #include "Engine/Plugin.h"
 #include "Engine/Curve.h"
 #include "Engine/CLArgs.h"
+#include "Engine/RotoContext.h"
+#include "Engine/RotoItem.h"
+#include "Engine/StandardPaths.h"
+#include "Engine/TimeLine.h"
 #include "Engine/ViewIdx.h"
 
 NATRON_NAMESPACE_USING
@@ -239,6 +261,69 @@ BaseTest::disconnectNodes(NodePtr input,
     }
 } // disconnectNodes
 
+ImagePtr
+BaseTest::renderNodeWindow(const NodePtr& node,
+                           double time,
+                           const RectI& renderWindow)
+{
+    EffectInstancePtr effect = node->getEffectInstance();
+    U64 nodeHash = node->getHashValue();
+    RectD rod;
+    bool isProjectFormat;
+    StatusEnum stat = effect->getRegionOfDefinition_public(nodeHash, time, RenderScale::identity, ViewIdx(0), &rod, &isProjectFormat);
+    if (stat == eStatusFailed) {
+        return ImagePtr();
+    }
+
+    RenderingFlagSetter flagIsRendering(node);
+    AbortableRenderInfoPtr abortInfo = AbortableRenderInfo::create(false, 0);
+    ParallelRenderArgsSetter frameRenderArgs( time,
+                                              ViewIdx(0),
+                                              false, // isRenderUserInteraction
+                                              false, // isSequential
+                                              abortInfo,
+                                              node, // tree root
+                                              0, // texture index
+                                              getApp()->getTimeLine().get(),
+                                              NodePtr(), // rotoPaint node
+                                              false, // isAnalysis
+                                              false, // isDraft
+                                              RenderStatsPtr() );
+    const RectD canonicalWindow = renderWindow.toCanonical_noClipping( 0, effect->getAspectRatio(-1) );
+    FrameRequestMap request;
+    stat = EffectInstance::computeRequestPass(time, ViewIdx(0), 0, canonicalWindow, node, request);
+    if (stat == eStatusFailed) {
+        return ImagePtr();
+    }
+    frameRenderArgs.updateNodesRequest(request);
+
+    std::list<ImagePlaneDesc> requestedComps;
+    {
+        ImagePlaneDesc plane, pairedPlane;
+        effect->getMetadataComponents(-1, &plane, &pairedPlane);
+        requestedComps.push_back(plane);
+    }
+    EffectInstance::RenderRoIArgs renderArgs(time,
+                                             RenderScale::identity,
+                                             0, // mipmapLevel
+                                             ViewIdx(0),
+                                             false, // byPassCache
+                                             renderWindow,
+                                             rod,
+                                             requestedComps,
+                                             eImageBitDepthFloat,
+                                             false,
+                                             effect.get(),
+                                             eStorageModeRAM,
+                                             time);
+    std::map<ImagePlaneDesc, ImagePtr> planes;
+    if ( (effect->renderRoI(renderArgs, &planes) != EffectInstance::eRenderRoIRetCodeOk) || planes.empty() ) {
+        return ImagePtr();
+    }
+
+    return planes.begin()->second;
+} // renderNodeWindow
+
 ///High level test: render 1 frame of dot generator
 TEST_F(BaseTest, GenerateDot)
 {
@@ -308,6 +393,83 @@ TEST_F(BaseTest, SetValues)
     }
 }
 
+///Sets the expressions of the noiseZ and noiseZSlope parameters of a generator. With a ret variable
+///Python always evaluates them, otherwise they are evaluated natively when possible.
+static void
+setGeneratorExpressions(const NodePtr& generator,
+                        const std::string& zExpression,
+                        const std::string& slopeExpression,
+                        bool hasRetVariable)
+{
+    KnobIPtr z = generator->getKnobByName("noiseZ");
+    KnobIPtr slope = generator->getKnobByName("noiseZSlope");
+
+    ASSERT_TRUE(z && slope);
+    std::string prefix = hasRetVariable ? "ret = " : "";
+    z->setExpression(0, prefix + zExpression, hasRetVariable, true);
+    slope->setExpression(0, prefix + slopeExpression, hasRetVariable, true);
+}
+
+///Checks that both generators agree on the noiseZ and noiseZSlope values over the frame range
+static void
+expectSameGeneratorValues(const NodePtr& native,
+                          const NodePtr& python)
+{
+    const char* names[2] = { "noiseZ", "noiseZSlope" };
+
+    for (int i = 0; i < 2; ++i) {
+        KnobDouble* nativeKnob = dynamic_cast<KnobDouble*>( native->getKnobByName(names[i]).get() );
+        KnobDouble* pythonKnob = dynamic_cast<KnobDouble*>( python->getKnobByName(names[i]).get() );
+        ASSERT_TRUE(nativeKnob && pythonKnob);
+        for (int t = 0; t <= 100; t += 5) {
+            double nativeValue = nativeKnob->getValueAtTime(t);
+            double pythonValue = pythonKnob->getValueAtTime(t);
+            EXPECT_TRUE( std::isfinite(nativeValue) );
+            EXPECT_NEAR(pythonValue, nativeValue, 1e-9 * std::max( 1., std::abs(pythonValue) ) ) << names[i] << " at frame " << t;
+        }
+    }
+}
+
+///Expressions referencing each other must terminate and give the same values as Python
+TEST_F(BaseTest, NativeExpressionCycle)
+{
+    NodePtr native = createNode(_generatorPluginID);
+    NodePtr python = createNode(_generatorPluginID);
+
+    ASSERT_TRUE(native && python);
+    std::string zExpression = "thisNode.noiseZSlope.getValueAtTime(frame) + 1";
+    std::string slopeExpression = "thisNode.noiseZ.getValueAtTime(frame) * 0.5";
+    setGeneratorExpressions(native, zExpression, slopeExpression, false);
+    setGeneratorExpressions(python, zExpression, slopeExpression, true);
+
+    ignore_result( NativeKnobExpression::getStats(true) );
+    expectSameGeneratorValues(native, python);
+    EXPECT_GT(NativeKnobExpression::getStats(true).nativeEvaluations, 0);
+}
+
+///Time-dependent expressions reading animated parameters give the same values natively and in Python
+TEST_F(BaseTest, NativeExpressionAnimated)
+{
+    NodePtr nodes[2] = { createNode(_generatorPluginID), createNode(_generatorPluginID) };
+
+    for (int i = 0; i < 2; ++i) {
+        ASSERT_TRUE(nodes[i]);
+        KnobDouble* gain = dynamic_cast<KnobDouble*>( nodes[i]->getKnobByName("gain").get() );
+        ASSERT_TRUE(gain);
+        gain->setValueAtTime(0, 0.2, ViewSpec::all(), 0);
+        gain->setValueAtTime(40, 1.3, ViewSpec::all(), 0);
+        gain->setValueAtTime(100, 0.7, ViewSpec::all(), 0);
+        setGeneratorExpressions(nodes[i],
+                                "thisNode.gain.getValueAtTime(frame - 1) * 2 + frame % 7",
+                                "max(thisNode.gain.getValueAtTime(frame), 0.5) ** 2 - frame / 3. + thisNode.gain.curve(frame + 0.5)",
+                                i == 1);
+    }
+
+    ignore_result( NativeKnobExpression::getStats(true) );
+    expectSameGeneratorValues(nodes[0], nodes[1]);
+    EXPECT_GT(NativeKnobExpression::getStats(true).nativeEvaluations, 0);
+}
+
 ///High level test: simple node connections test
 TEST_F(BaseTest, SimpleNodeConnections) {
     ///create the generator
@@ -323,3 +485,406 @@ TEST_F(BaseTest, SimpleNodeConnections) {
     disconnectNodes(generator, writer, false);
     connectNodes(generator, writer, 0, true);
 }
+
+///Editing a node only flags the hashes downstream, they are recomputed when asked for
+TEST_F(BaseTest, LazyHashInvalidation)
+{
+    NodePtr generator = createNode(_generatorPluginID);
+    NodePtr writer = createNode(_writeOIIOPluginID);
+
+    ASSERT_TRUE(writer && generator);
+    connectNodes(generator, writer, 0, true);
+    U64 writerHash = writer->getHashValue();
+
+    KnobDouble* slope = dynamic_cast<KnobDouble*>( generator->getKnobByName("noiseZSlope").get() );
+    ASSERT_TRUE(slope != 0);
+
+    U64 invalidationsBefore, recomputationsBefore;
+    writer->getHashCounters(&invalidationsBefore, &recomputationsBefore);
+
+    ///Several edits before the hash is needed only invalidate it once
+    for (int i = 1; i <= 10; ++i) {
+        slope->setValue(i / 10.);
+    }
+
+    U64 invalidations, recomputations;
+    writer->getHashCounters(&invalidations, &recomputations);
+    EXPECT_EQ(invalidationsBefore + 1, invalidations);
+    EXPECT_EQ(recomputationsBefore, recomputations);
+
+    EXPECT_NE( writerHash, writer->getHashValue() );
+    writer->getHashCounters(&invalidations, &recomputations);
+    EXPECT_EQ(recomputationsBefore + 1, recomputations);
+
+    ///A resolved hash is not recomputed again
+    ignore_result( writer->getHashValue() );
+    writer->getHashCounters(&invalidations, &recomputations);
+    EXPECT_EQ(recomputationsBefore + 1, recomputations);
+}
+
+// The positions of a circle of nbPoints control points at the given frame, as in BezierCurve.setPointsAtTimes
+static void
+appendCirclePositions(int nbPoints,
+                      int frame,
+                      double radius,
+                      std::vector<double>* values)
+{
+    for (int i = 0; i < nbPoints; ++i) {
+        double a = 2. * M_PI * i / nbPoints;
+        double x = 500. + frame + radius * std::cos(a);
+        double y = 500. + radius * std::sin(a);
+        double tx = -10. * std::sin(a);
+        double ty = 10. * std::cos(a);
+        double cp[6] = { x, y, x - tx, y - ty, x + tx, y + ty };
+        values->insert(values->end(), cp, cp + 6);
+    }
+}
+
+static BezierPtr
+makeShape(const RotoContextPtr& context,
+          int nbPoints)
+{
+    BezierPtr bezier = context->makeBezier(0, 0, kRotoBezierBaseName, 0, false);
+
+    for (int i = 0; i < nbPoints; ++i) {
+        bezier->addControlPoint(std::cos(2. * M_PI * i / nbPoints), std::sin(2. * M_PI * i / nbPoints), 0);
+    }
+    bezier->setCurveFinished(true);
+
+    return bezier;
+}
+
+///Sets the keyframes of a shape with a setPointAtIndex call per control point and per frame, as scripts do
+static void
+setPointsAtIndices(const BezierPtr& bezier,
+                   int nbPoints,
+                   const std::vector<double>& times,
+                   const std::vector<double>& points,
+                   const std::vector<double>& featherPoints)
+{
+    for (std::size_t f = 0; f < times.size(); ++f) {
+        for (int i = 0; i < nbPoints; ++i) {
+            const double* cp = &points[(f * nbPoints + i) * 6];
+            const double* fp = &featherPoints[(f * nbPoints + i) * 6];
+            bezier->setPointAtIndex(false, i, times[f], cp[0], cp[1], cp[2], cp[3], cp[4], cp[5]);
+            bezier->setPointAtIndex(true, i, times[f], fp[0], fp[1], fp[2], fp[3], fp[4], fp[5]);
+        }
+    }
+}
+
+///Imports an animated shape with a setPointAtIndex call per control point and per frame, as scripts do, and with
+///a single setPointsAtTimes call, and checks that both give the same animation
+TEST_F(BaseTest, RotoBulkKeyframes)
+{
+    NodePtr roto = createNode( QString::fromUtf8(PLUGINID_NATRON_ROTO) );
+    ASSERT_TRUE(roto);
+    RotoContextPtr context = roto->getRotoContext();
+    ASSERT_TRUE(context);
+
+    const int nbPoints = 20;
+    const int nbFrames = 100;
+    std::vector<double> times, points, featherPoints;
+    for (int f = 1; f <= nbFrames; ++f) {
+        times.push_back(f);
+        appendCirclePositions(nbPoints, f, 100. + f, &points);
+        appendCirclePositions(nbPoints, f, 110. + f, &featherPoints);
+    }
+
+    // scripts rely on auto-keying to set keyframes with setPointAtIndex
+    context->setAutoKeyingEnabled(true);
+    BezierPtr perKey = makeShape(context, nbPoints);
+    BezierPtr bulk = makeShape(context, nbPoints);
+    setPointsAtIndices(perKey, nbPoints, times, points, featherPoints);
+    bulk->setPointsAtTimes(times, points, featherPoints);
+
+    std::set<double> perKeyTimes, bulkTimes;
+    perKey->getKeyframeTimes(&perKeyTimes);
+    bulk->getKeyframeTimes(&bulkTimes);
+    EXPECT_TRUE(perKeyTimes == bulkTimes);
+    for (int f = 1; f <= nbFrames; f += 7) {
+        for (int i = 0; i < nbPoints; ++i) {
+            double x1, y1, x2, y2;
+            perKey->getControlPointAtIndex(i)->getLeftBezierPointAtTime(false, f, ViewIdx(0), &x1, &y1);
+            bulk->getControlPointAtIndex(i)->getLeftBezierPointAtTime(false, f, ViewIdx(0), &x2, &y2);
+            EXPECT_EQ(x1, x2);
+            EXPECT_EQ(y1, y2);
+            perKey->getFeatherPointAtIndex(i)->getPositionAtTime(false, f, ViewIdx(0), &x1, &y1);
+            bulk->getFeatherPointAtIndex(i)->getPositionAtTime(false, f, ViewIdx(0), &x2, &y2);
+            EXPECT_EQ(x1, x2);
+            EXPECT_EQ(y1, y2);
+        }
+    }
+
+    // the number of values must match the control points
+    points.pop_back();
+    EXPECT_THROW(bulk->setPointsAtTimes(times, points, featherPoints), std::invalid_argument);
+}
+
+///Compares the time taken to import an animated shape with setPointAtIndex and with setPointsAtTimes.
+///Run it with --gtest_also_run_disabled_tests.
+TEST_F(BaseTest, DISABLED_RotoBulkKeyframesBenchmark)
+{
+    NodePtr roto = createNode( QString::fromUtf8(PLUGINID_NATRON_ROTO) );
+    ASSERT_TRUE(roto);
+    RotoContextPtr context = roto->getRotoContext();
+    ASSERT_TRUE(context);
+
+    const int nbPoints = 20;
+    const int nbFrames = 100;
+    std::vector<double> times, points, featherPoints;
+    for (int f = 1; f <= nbFrames; ++f) {
+        times.push_back(f);
+        appendCirclePositions(nbPoints, f, 100. + f, &points);
+        appendCirclePositions(nbPoints, f, 110. + f, &featherPoints);
+    }
+
+    context->setAutoKeyingEnabled(true);
+    BezierPtr perKey = makeShape(context, nbPoints);
+    BezierPtr bulk = makeShape(context, nbPoints);
+    QElapsedTimer timer;
+    timer.start();
+    setPointsAtIndices(perKey, nbPoints, times, points, featherPoints);
+    double perKeyTime = (double)timer.nsecsElapsed() / 1e6;
+
+    timer.restart();
+    bulk->setPointsAtTimes(times, points, featherPoints);
+    double bulkTime = (double)timer.nsecsElapsed() / 1e6;
+
+    std::cout << "Roto import of " << nbFrames << " frames of a " << nbPoints << " points shape: setPointAtIndex() "
+              << perKeyTime << " ms, setPointsAtTimes(): " << bulkTime << " ms" << std::endl;
+}
+
+static BezierPtr
+makeCircle(const RotoContextPtr& context,
+           double cx,
+           double cy,
+           double radius)
+{
+    BezierPtr bezier = context->makeBezier(0, 0, kRotoBezierBaseName, 1, false);
+    const int nbPoints = 8;
+
+    for (int i = 0; i < nbPoints; ++i) {
+        double a = 2. * M_PI * i / nbPoints;
+        bezier->addControlPoint(cx + radius * std::cos(a), cy + radius * std::sin(a), 1);
+    }
+    bezier->setCurveFinished(true);
+
+    return bezier;
+}
+
+static float
+getLastComponentAt(const ImagePtr& image,
+                   int x,
+                   int y)
+{
+    Image::ReadAccess acc = image->getReadRights();
+    const float* pix = (const float*)acc.pixelAt(x, y);
+
+    return pix ? pix[image->getComponentsCount() - 1] : -1.f;
+}
+
+///Renders a window of a Roto node that contains no shape, then a window that contains one: the first render
+///must not make the second one return the source of the node
+TEST_F(BaseTest, RotoRoICulling)
+{
+    NodePtr roto = createNode( QString::fromUtf8(PLUGINID_NATRON_ROTO) );
+    ASSERT_TRUE(roto);
+    RotoContextPtr context = roto->getRotoContext();
+    ASSERT_TRUE(context);
+
+    ASSERT_TRUE( makeCircle(context, 500., 500., 100.) );
+
+    ImagePtr emptyImage = renderNodeWindow( roto, 1, RectI(0, 0, 64, 64) );
+    ASSERT_TRUE(emptyImage);
+    ASSERT_EQ(eImageBitDepthFloat, emptyImage->getBitDepth());
+    EXPECT_EQ(0.f, getLastComponentAt(emptyImage, 32, 32));
+
+    ImagePtr shapeImage = renderNodeWindow( roto, 1, RectI(468, 468, 532, 532) );
+    ASSERT_TRUE(shapeImage);
+    ASSERT_EQ(eImageBitDepthFloat, shapeImage->getBitDepth());
+    EXPECT_EQ(1.f, getLastComponentAt(shapeImage, 500, 500));
+}
+
+///The mask of each item is cached from its own state: editing one of two shapes must only re-render its own mask
+TEST_F(BaseTest, RotoMaskCachePerItem)
+{
+    NodePtr roto = createNode( QString::fromUtf8(PLUGINID_NATRON_ROTO) );
+    ASSERT_TRUE(roto);
+    RotoContextPtr context = roto->getRotoContext();
+    ASSERT_TRUE(context);
+
+    BezierPtr edited = makeCircle(context, 200., 200., 100.);
+    BezierPtr untouched = makeCircle(context, 600., 600., 100.);
+    const ImagePlaneDesc& alpha = ImagePlaneDesc::getAlphaComponents();
+
+    ImagePtr editedMask = edited->renderMaskFromStroke(alpha, 1, ViewIdx(0), eImageBitDepthFloat, 0, RectD());
+    ImagePtr untouchedMask = untouched->renderMaskFromStroke(alpha, 1, ViewIdx(0), eImageBitDepthFloat, 0, RectD());
+    ASSERT_TRUE(editedMask);
+    ASSERT_TRUE(untouchedMask);
+
+    edited->movePointByIndex(0, 1, 20., 0.);
+
+    EXPECT_TRUE( untouched->renderMaskFromStroke(alpha, 1, ViewIdx(0), eImageBitDepthFloat, 0, RectD()) == untouchedMask );
+    EXPECT_TRUE( edited->renderMaskFromStroke(alpha, 1, ViewIdx(0), eImageBitDepthFloat, 0, RectD()) != editedMask );
+}
+
+///Adds nbShapes shapes of nbPoints control points, each animated over nbFrames frames, to a Roto node
+static void
+makeAnimatedShapes(const RotoContextPtr& context,
+                   int nbShapes,
+                   int nbPoints,
+                   int nbFrames)
+{
+    for (int s = 0; s < nbShapes; ++s) {
+        std::vector<double> times, points, featherPoints;
+        for (int f = 1; f <= nbFrames; ++f) {
+            times.push_back(f);
+            appendCirclePositions(nbPoints, f, 100. + s + f, &points);
+            appendCirclePositions(nbPoints, f, 110. + s + f, &featherPoints);
+        }
+        makeShape(context, nbPoints)->setPointsAtTimes(times, points, featherPoints);
+    }
+}
+
+static QString
+makeTemporaryProjectDir()
+{
+    QDir dir( StandardPaths::writableLocation(StandardPaths::eStandardLocationTemp) );
+    QString dirName = QString::fromUtf8("NatronUnitTest") + QString::number( QCoreApplication::applicationPid() );
+
+    dir.mkpath(dirName);
+
+    return dir.absoluteFilePath(dirName) + QLatin1Char('/');
+}
+
+///Saves a project with animated shapes in the binary format and checks that loading it gives back the same shapes
+TEST_F(BaseTest, ProjectBinaryRoundTrip)
+{
+    NodePtr roto = createNode( QString::fromUtf8(PLUGINID_NATRON_ROTO) );
+    ASSERT_TRUE(roto);
+    RotoContextPtr context = roto->getRotoContext();
+    ASSERT_TRUE(context);
+    makeAnimatedShapes(context, 3, 20, 10);
+
+    const std::string scriptName = roto->getScriptName();
+    std::list<double> savedTimes;
+    context->getBeziersKeyframeTimes(&savedTimes);
+    roto.reset();
+    context.reset();
+
+    QString path = makeTemporaryProjectDir();
+    QString name = QString::fromUtf8("RoundTrip." NATRON_PROJECT_BINARY_FILE_EXT);
+    ProjectPtr project = getApp()->getProject();
+    ASSERT_TRUE( project->saveProject(path, name, 0) );
+    ASSERT_TRUE( QFile::exists(path + name) );
+    ASSERT_TRUE( project->loadProject(path, name) );
+
+    NodePtr loaded = project->getNodeByName(scriptName);
+    ASSERT_TRUE(loaded);
+    ASSERT_TRUE( loaded->getRotoContext() );
+    EXPECT_EQ( 3, (int)loaded->getRotoContext()->getCurvesByRenderOrder().size() );
+    std::list<double> loadedTimes;
+    loaded->getRotoContext()->getBeziersKeyframeTimes(&loadedTimes);
+    EXPECT_TRUE(savedTimes == loadedTimes);
+
+    QFile::remove(path + name);
+    QDir().rmdir(path);
+}
+
+///Compares the save and load times of the XML and binary project formats on a project with many animated shapes.
+///Run it with --gtest_also_run_disabled_tests.
+TEST_F(BaseTest, DISABLED_ProjectFormatBenchmark)
+{
+    const int nbNodes = 20;
+    for (int i = 0; i < nbNodes; ++i) {
+        NodePtr roto = createNode( QString::fromUtf8(PLUGINID_NATRON_ROTO) );
+        ASSERT_TRUE(roto);
+        ASSERT_TRUE( roto->getRotoContext() );
+        makeAnimatedShapes(roto->getRotoContext(), 10, 20, 100);
+    }
+
+    ProjectPtr project = getApp()->getProject();
+    QString path = makeTemporaryProjectDir();
+    const char* extensions[2] = { NATRON_PROJECT_FILE_EXT, NATRON_PROJECT_BINARY_FILE_EXT };
+    for (int i = 0; i < 2; ++i) {
+        QString name = QString::fromUtf8("Benchmark.") + QString::fromUtf8(extensions[i]);
+        QElapsedTimer timer;
+        timer.start();
+        ASSERT_TRUE( project->saveProject(path, name, 0) );
+        double saveTime = (double)timer.nsecsElapsed() / 1e6;
+        qint64 fileSize = QFileInfo(path + name).size();
+
+        timer.restart();
+        ASSERT_TRUE( project->loadProject(path, name) );
+        double loadTime = (double)timer.nsecsElapsed() / 1e6;
+        EXPECT_EQ( nbNodes, (int)project->getNodes().size() );
+
+        std::cout << "." << extensions[i] << " project of " << nbNodes << " Roto nodes: " << fileSize << " bytes, save "
+                  << saveTime << " ms, load " << loadTime << " ms" << std::endl;
+        QFile::remove(path + name);
+    }
+    QDir().rmdir(path);
+}
+
+///Writes a PyPlug module and registers it without importing it, as loadPyPlugs() does for the files known from the registry cache
+static Plugin*
+registerUnimportedPyPlug(const QString& path,
+                         const QString& moduleName,
+                         bool isToolset)
+{
+    QFile file(path + moduleName + QString::fromUtf8(".py"));
+    if ( !file.open(QIODevice::WriteOnly | QIODevice::Text) ) {
+        return 0;
+    }
+    QString pluginID = QString::fromUtf8("fr.inria.unittest.") + moduleName;
+    QTextStream ts(&file);
+    ts << "def getPluginID():\n"
+       << "    return \"" << pluginID << "\"\n"
+       << "def getLabel():\n"
+       << "    return \"" << moduleName << "\"\n"
+       << "def getIsToolset():\n"
+       << "    return " << (isToolset ? "True" : "False") << "\n"
+       << "def createInstance(app, group):\n"
+       << "    app.createNode(\"" << PLUGINID_NATRON_DOT << "\", -1, group)\n";
+    ts.flush();
+    file.close();
+
+    std::string err;
+    if ( !NATRON_PYTHON_NAMESPACE::interpretPythonScript("import sys\nsys.path.append(str('" + path.toStdString() + "'))\n", &err, 0) ) {
+        return 0;
+    }
+
+    Plugin* plugin = appPTR->registerPlugin(path, QStringList( QString::fromUtf8(PLUGIN_GROUP_OTHER) ), pluginID, moduleName, QString(), QStringList(),
+                                            false, false, 0, false, 1, 0, false);
+    plugin->setPythonModule(path + moduleName);
+    plugin->setToolsetScript(isToolset);
+
+    return plugin;
+}
+
+///PyPlugs restored from the registry cache are only imported when a node is created from them
+TEST_F(BaseTest, PyPlugFromWarmRegistry)
+{
+    QString path = makeTemporaryProjectDir();
+    const QString toolsetModule = QString::fromUtf8("WarmRegistryToolset");
+    const QString groupModule = QString::fromUtf8("WarmRegistryGroup");
+    Plugin* toolset = registerUnimportedPyPlug(path, toolsetModule, true);
+    Plugin* group = registerUnimportedPyPlug(path, groupModule, false);
+    ASSERT_TRUE(toolset && group);
+
+    // A toolset does not return a node, it creates its nodes in the project
+    std::size_t nbNodes = getApp()->getProject()->getNodes().size();
+    CreateNodeArgs toolsetArgs( toolset->getPluginID().toStdString(), getApp()->getProject() );
+    getApp()->createNode(toolsetArgs);
+    EXPECT_EQ( nbNodes + 1, getApp()->getProject()->getNodes().size() );
+
+    NodePtr groupNode = createNode( group->getPluginID() );
+    ASSERT_TRUE(groupNode);
+    NodeGroupPtr groupContainer = std::dynamic_pointer_cast<NodeGroup>( groupNode->getEffectInstance() );
+    ASSERT_TRUE(groupContainer);
+    EXPECT_FALSE( groupContainer->getNodes().empty() );
+
+    QFile::remove(path + toolsetModule + QString::fromUtf8(".py"));
+    QFile::remove(path + groupModule + QString::fromUtf8(".py"));
+    QDir().rmdir(path);
+}
@@ -79,6 +79,10 @@ protected:
     ///disconnection is expected to succeed, and vice versa.
     void disconnectNodes(NodePtr input, NodePtr output, bool expectedReturnvalue);
 
+    ///Renders the given window (in pixel coordinates at scale 1) of the output of the node at the given time,
+    ///the same way the preview of a node is rendered. Returns a null pointer if the render failed.
+    ImagePtr renderNodeWindow(const NodePtr& node, double time, const RectI& renderWindow);
+
     void registerTestPlugins();
 
     ///////////////Pointers to plug-ins that might be used by all the tests. This makes
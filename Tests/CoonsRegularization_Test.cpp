@@ -0,0 +1,216 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <https://natrongithub.github.io/>,
+ * (C) 2018-2023 The Natron developers
+ * (C) 2013-2018 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "Global/Macros.h"
+
+#include <cstdlib>
+#include <iostream>
+#include <list>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <QtCore/QElapsedTimer>
+
+#include "Engine/BezierCP.h"
+#include "Engine/CoonsRegularization.h"
+#include "Engine/ViewIdx.h"
+
+NATRON_NAMESPACE_USING
+
+static double
+randomIn(double from,
+         double to)
+{
+    return from + (to - from) * ( std::rand() / (double)RAND_MAX );
+}
+
+static BezierCPPtr
+makeControlPoint(double x,
+                 double y,
+                 double leftX,
+                 double leftY,
+                 double rightX,
+                 double rightY)
+{
+    BezierCPPtr cp = std::make_shared<BezierCP>();
+
+    cp->setBroken(true);
+    cp->setStaticPosition(false, x, y);
+    cp->setLeftBezierStaticPosition(false, leftX, leftY);
+    cp->setRightBezierStaticPosition(false, rightX, rightY);
+
+    return cp;
+}
+
+// A polygon whose tangents are along its edges, shifted horizontally by bend
+static BezierCPs
+makePolygon(const std::vector<Point>& vertices,
+            double bend)
+{
+    BezierCPs cps;
+    int n = (int)vertices.size();
+
+    for (int i = 0; i < n; ++i) {
+        const Point& p = vertices[i];
+        const Point& prev = vertices[(i + n - 1) % n];
+        const Point& next = vertices[(i + 1) % n];
+        cps.push_back( makeControlPoint(p.x, p.y,
+                                        p.x + (prev.x - p.x) / 3. + bend, p.y + (prev.y - p.y) / 3.,
+                                        p.x + (next.x - p.x) / 3. + bend, p.y + (next.y - p.y) / 3.) );
+    }
+
+    return cps;
+}
+
+// 3 to 5 control points in random order with random smooth tangents: most of these patches self-intersect
+static BezierCPs
+makeRandomPatch()
+{
+    BezierCPs cps;
+    int n = 3 + std::rand() % 3;
+
+    for (int i = 0; i < n; ++i) {
+        double x = randomIn(0., 100.);
+        double y = randomIn(0., 100.);
+        double dx = randomIn(-30., 30.);
+        double dy = randomIn(-30., 30.);
+        cps.push_back( makeControlPoint(x, y, x - dx, y - dy, x + dx, y + dy) );
+    }
+
+    return cps;
+}
+
+static void
+getPositions(const std::list<BezierCPs>& patches,
+             std::vector<double>* positions)
+{
+    for (std::list<BezierCPs>::const_iterator it = patches.begin(); it != patches.end(); ++it) {
+        positions->push_back( (double)it->size() );
+        for (BezierCPs::const_iterator it2 = it->begin(); it2 != it->end(); ++it2) {
+            double x, y;
+            (*it2)->getPositionAtTime(false, 0., ViewIdx(0), &x, &y);
+            positions->push_back(x);
+            positions->push_back(y);
+            (*it2)->getLeftBezierPointAtTime(false, 0., ViewIdx(0), &x, &y);
+            positions->push_back(x);
+            positions->push_back(y);
+            (*it2)->getRightBezierPointAtTime(false, 0., ViewIdx(0), &x, &y);
+            positions->push_back(x);
+            positions->push_back(y);
+        }
+    }
+}
+
+TEST(CoonsRegularization, ConvexPatchIsKept)
+{
+    std::vector<Point> square(4);
+
+    square[1].x = 100.;
+    square[2].x = square[2].y = 100.;
+    square[3].y = 100.;
+    BezierCPs cps = makePolygon(square, 0.);
+
+    std::list<BezierCPs> fixed;
+    CoonsRegularization::regularize(cps, 0., &fixed);
+    ASSERT_EQ( (int)fixed.size(), 1 );
+    EXPECT_TRUE(fixed.front() == cps);
+}
+
+TEST(CoonsRegularization, SelfIntersectingPatches)
+{
+    // a bow tie
+    std::vector<Point> vertices(4);
+
+    vertices[1].x = 100.;
+    vertices[2].y = 100.;
+    vertices[3].x = vertices[3].y = 100.;
+
+    for (int bend = 0; bend <= 40; bend += 10) {
+        std::list<BezierCPs> fixed;
+        CoonsRegularization::regularize(makePolygon(vertices, bend), 0., &fixed);
+
+        // the recursive splits stop even when the degeneracy cannot be removed
+        EXPECT_GT( (int)fixed.size(), 1 );
+        EXPECT_LE( (int)fixed.size(), 256 );
+        for (std::list<BezierCPs>::const_iterator it = fixed.begin(); it != fixed.end(); ++it) {
+            EXPECT_GE( (int)it->size(), 2 );
+        }
+    }
+}
+
+// The concurrent regularization gives the same patches in the same order as the serial one
+TEST(CoonsRegularization, RegularizeAllMatchesSerial)
+{
+    std::srand(2);
+    std::list<BezierCPs> patches;
+    for (int i = 0; i < 100; ++i) {
+        patches.push_back( makeRandomPatch() );
+    }
+
+    std::list<BezierCPs> serial;
+    for (std::list<BezierCPs>::const_iterator it = patches.begin(); it != patches.end(); ++it) {
+        CoonsRegularization::regularize(*it, 0., &serial);
+    }
+    std::list<BezierCPs> concurrent;
+    CoonsRegularization::regularizeAll(patches, 0., &concurrent);
+
+    std::vector<double> serialPositions, concurrentPositions;
+    getPositions(serial, &serialPositions);
+    getPositions(concurrent, &concurrentPositions);
+    EXPECT_TRUE(serialPositions == concurrentPositions);
+}
+
+// Run with --gtest_also_run_disabled_tests
+TEST(CoonsRegularization, DISABLED_SelfIntersectingBenchmark)
+{
+    std::srand(1);
+    std::list<BezierCPs> patches;
+    for (int i = 0; i < 2000; ++i) {
+        patches.push_back( makeRandomPatch() );
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    std::list<BezierCPs> serial;
+    for (std::list<BezierCPs>::const_iterator it = patches.begin(); it != patches.end(); ++it) {
+        CoonsRegularization::regularize(*it, 0., &serial);
+    }
+    double serialTime = (double)timer.nsecsElapsed() / 1e6;
+
+    timer.restart();
+    std::list<BezierCPs> concurrent;
+    CoonsRegularization::regularizeAll(patches, 0., &concurrent);
+    double concurrentTime = (double)timer.nsecsElapsed() / 1e6;
+
+    // The concurrent regularization gives the same patches in the same order
+    std::vector<double> serialPositions, concurrentPositions;
+    getPositions(serial, &serialPositions);
+    getPositions(concurrent, &concurrentPositions);
+    EXPECT_TRUE(serialPositions == concurrentPositions);
+
+    std::cout << "CoonsRegularization: " << patches.size() << " patches regularized in " << serial.size() << " patches: "
+              << serialTime << " ms, regularizeAll(): " << concurrentTime << " ms" << std::endl;
+}
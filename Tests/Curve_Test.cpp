@@ -25,10 +25,15 @@
 
 #include "Global/Macros.h"
 
+#include <cmath>
+#include <iostream>
+#include <vector>
+
 #include <gtest/gtest.h>
 
 #include <QtCore/QString>
 #include <QtCore/QDir>
+#include <QtCore/QElapsedTimer>
 
 #include "Engine/Curve.h"
 
@@ -125,3 +130,96 @@ TEST(Curve, Basic)
 }
 
 
+
+TEST(Curve, SampleTable)
+{
+    Curve::setSampleTablesEnabled(false);
+    Curve ref;
+    Curve::setSampleTablesEnabled(true);
+    Curve c;
+
+    for (int i = 0; i < 20; ++i) {
+        KeyFrame k( i * 5., std::sin(i * 0.7) * 100., 0., 0., (i % 3) ? eKeyframeTypeSmooth : eKeyframeTypeCatmullRom );
+        EXPECT_TRUE( ref.addKeyFrame(k) );
+        EXPECT_TRUE( c.addKeyFrame(k) );
+    }
+    c.setYRange(-50., 50.);
+    ref.setYRange(-50., 50.);
+
+    // evaluate at motion blur sub-frames until the curve gets sampled
+    for (int pass = 0; pass < 3; ++pass) {
+        for (double t = -10.; t <= 110.; t += 0.125) {
+            EXPECT_EQ( ref.getValueAt(t, false), c.getValueAt(t, false) );
+            EXPECT_EQ( ref.getValueAt(t, true), c.getValueAt(t, true) );
+        }
+    }
+    EXPECT_TRUE( c.hasSampleTable() );
+    EXPECT_FALSE( ref.hasSampleTable() );
+
+    // times which are not samples are still interpolated
+    EXPECT_EQ( ref.getValueAt(12.3, false), c.getValueAt(12.3, false) );
+
+    // any change to the curve invalidates the samples
+    EXPECT_FALSE( c.addKeyFrame( KeyFrame(50., 0.) ) );
+    EXPECT_FALSE( ref.addKeyFrame( KeyFrame(50., 0.) ) );
+    EXPECT_FALSE( c.hasSampleTable() );
+    for (double t = -10.; t <= 110.; t += 0.125) {
+        EXPECT_EQ( ref.getValueAt(t, false), c.getValueAt(t, false) );
+    }
+    c.setYRange(-20., 20.);
+    ref.setYRange(-20., 20.);
+    EXPECT_FALSE( c.hasSampleTable() );
+    for (int pass = 0; pass < 3; ++pass) {
+        for (double t = -10.; t <= 110.; t += 1.) {
+            EXPECT_EQ( ref.getValueAt(t, true), c.getValueAt(t, true) );
+        }
+    }
+    EXPECT_TRUE( c.hasSampleTable() );
+    c.clearKeyFrames();
+    EXPECT_FALSE( c.hasSampleTable() );
+    EXPECT_EQ( 0., c.getValueAt(10.) );
+}
+
+// Dense animation, similar to a roto shape with many animated control points rendered with motion blur.
+// Run with --gtest_also_run_disabled_tests
+TEST(Curve, DISABLED_SampleTableBenchmark)
+{
+    const int nCurves = 800;
+    const int nKeys = 100;
+    const int nFrames = 200;
+    const int nMotionBlurSamples = 8;
+
+    std::vector<double> timings;
+    std::vector<double> sums;
+
+    for (int enabled = 0; enabled < 2; ++enabled) {
+        Curve::setSampleTablesEnabled(enabled != 0);
+
+        std::vector<CurvePtr> curves(nCurves);
+        for (int i = 0; i < nCurves; ++i) {
+            curves[i] = std::make_shared<Curve>();
+            for (int k = 0; k < nKeys; ++k) {
+                ignore_result( curves[i]->addKeyFrame( KeyFrame( k * 2., std::cos(i + k * 0.3) * 10., 0., 0., eKeyframeTypeSmooth ) ) );
+            }
+        }
+
+        QElapsedTimer timer;
+        timer.start();
+        double sum = 0.;
+        for (int f = 0; f < nFrames; ++f) {
+            for (int s = 0; s < nMotionBlurSamples; ++s) {
+                double t = f + (double)s / nMotionBlurSamples;
+                for (int i = 0; i < nCurves; ++i) {
+                    sum += curves[i]->getValueAt(t, false);
+                }
+            }
+        }
+        timings.push_back( (double)timer.nsecsElapsed() / 1e6 );
+        sums.push_back(sum);
+    }
+    Curve::setSampleTablesEnabled(true);
+
+    EXPECT_EQ(sums[0], sums[1]);
+    std::cout << "Curve::getValueAt() on " << nCurves << " curves x " << nFrames << " frames x " << nMotionBlurSamples
+              << " motion blur samples: " << timings[0] << " ms interpolated, " << timings[1] << " ms sampled" << std::endl;
+}
@@ -0,0 +1,65 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <https://natrongithub.github.io/>,
+ * (C) 2018-2023 The Natron developers
+ * (C) 2013-2018 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "Global/Macros.h"
+
+#include <gtest/gtest.h>
+
+#include "Engine/OutputSchedulerThread.h"
+
+NATRON_NAMESPACE_USING
+
+static const U64 kGiB = 1024ULL * 1024ULL * 1024ULL;
+
+// The cache occupancy is not an input of the admission: a full cache must not serialize the renders
+TEST(FrameAdmission,
+     FullCacheStillAdmitsFrames)
+{
+    const U64 budget = 8 * kGiB;
+    const U64 estimate = kGiB;
+
+    for (std::size_t nFrames = 0; nFrames < 8; ++nFrames) {
+        EXPECT_TRUE( OutputSchedulerThread::canAdmitFrame(nFrames, nFrames * estimate, estimate, budget, 4) ) << nFrames << " frames rendering";
+    }
+    EXPECT_FALSE( OutputSchedulerThread::canAdmitFrame(8, 8 * estimate, estimate, budget, 4) );
+}
+
+TEST(FrameAdmission,
+     FirstFrameIsAlwaysAdmitted)
+{
+    EXPECT_TRUE( OutputSchedulerThread::canAdmitFrame(0, 0, 16 * kGiB, kGiB, 4) );
+    EXPECT_FALSE( OutputSchedulerThread::canAdmitFrame(1, 16 * kGiB, 16 * kGiB, kGiB, 4) );
+}
+
+TEST(FrameAdmission,
+     UnknownEstimateIsCapped)
+{
+    const std::size_t maxFrames = 4;
+
+    for (std::size_t nFrames = 0; nFrames < maxFrames; ++nFrames) {
+        EXPECT_TRUE( OutputSchedulerThread::canAdmitFrame(nFrames, 0, 0, kGiB, maxFrames) ) << nFrames << " frames rendering";
+    }
+    EXPECT_FALSE( OutputSchedulerThread::canAdmitFrame(maxFrames, 0, 0, kGiB, maxFrames) );
+}
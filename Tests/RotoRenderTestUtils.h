@@ -0,0 +1,123 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <https://natrongithub.github.io/>,
+ * (C) 2018-2023 The Natron developers
+ * (C) 2013-2018 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+
+#ifndef ROTORENDERTESTUTILS_H
+#define ROTORENDERTESTUTILS_H
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "Global/Macros.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <cairo/cairo.h>
+
+#include "Engine/RectI.h"
+
+NATRON_NAMESPACE_ENTER
+
+// Helpers shared by the tests comparing the native Roto renderers with the cairo renderer they replace
+
+// The writer type of RotoShapeRasterizer::render and RotoStrokeStamper::render
+typedef std::function<void (const RectI& tile, const float* coverage)> CoverageTileWriter;
+
+// Reads the coverage of a cairo surface covering roi: the alpha of an A8 surface or the blue channel of an ARGB32 surface
+inline std::vector<float>
+readCairoCoverage(cairo_surface_t* surface,
+                  const RectI& roi)
+{
+    cairo_surface_flush(surface);
+
+    std::vector<float> ret( (std::size_t)roi.width() * roi.height() );
+    const bool isA8 = cairo_image_surface_get_format(surface) == CAIRO_FORMAT_A8;
+    const unsigned char* data = cairo_image_surface_get_data(surface);
+    int stride = cairo_image_surface_get_stride(surface);
+    for (int y = 0; y < roi.height(); ++y) {
+        for (int x = 0; x < roi.width(); ++x) {
+            if (isA8) {
+                ret[(std::size_t)y * roi.width() + x] = data[y * stride + x] / 255.f;
+            } else {
+                // blue channel of the native-endian ARGB pixel
+                unsigned int pixel = *(const unsigned int*)(data + y * stride + x * 4);
+                ret[(std::size_t)y * roi.width() + x] = (pixel & 0xff) / 255.f;
+            }
+        }
+    }
+
+    return ret;
+}
+
+// Returns a writer copying the tiles it receives to coverage, a buffer covering roi
+inline CoverageTileWriter
+makeCoverageWriter(const RectI& roi,
+                   std::vector<float>* coverage)
+{
+    return [roi, coverage](const RectI& tile, const float* tileCoverage) {
+        for (int y = tile.y1; y < tile.y2; ++y) {
+            std::copy( tileCoverage + (std::size_t)(y - tile.y1) * tile.width(),
+                       tileCoverage + (std::size_t)(y - tile.y1 + 1) * tile.width(),
+                       coverage->begin() + (std::size_t)(y - roi.y1) * roi.width() + (tile.x1 - roi.x1) );
+        }
+    };
+}
+
+// Checks that the sequential native render matches the cairo reference, and that the concurrent render by bands
+// gives the same result as the sequential one
+inline void
+expectCoverageMatchesCairo(const std::vector<float>& reference,
+                           const RectI& roi,
+                           const std::function<void (float* coverage)>& renderSequential,
+                           const std::function<bool (const CoverageTileWriter& writer)>& renderTiled)
+{
+    std::vector<float> native( reference.size() );
+
+    renderSequential( &native.front() );
+
+    // cairo composites in 8 bits, approximates circles and may differ on the edges of mesh patches,
+    // so only a few pixels on the borders may differ, the rest should match up to quantization
+    double sumError = 0.;
+    int nDifferent = 0;
+    for (std::size_t i = 0; i < reference.size(); ++i) {
+        double error = std::abs(reference[i] - native[i]);
+        sumError += error;
+        if (error > 0.1) {
+            ++nDifferent;
+        }
+    }
+    EXPECT_LT(sumError / reference.size(), 0.01);
+    EXPECT_LT( nDifferent, (int)(reference.size() / 100) );
+
+    std::vector<float> tiled( reference.size() );
+    EXPECT_TRUE( renderTiled( makeCoverageWriter(roi, &tiled) ) );
+    EXPECT_TRUE(native == tiled);
+}
+
+NATRON_NAMESPACE_EXIT
+
+#endif // ROTORENDERTESTUTILS_H
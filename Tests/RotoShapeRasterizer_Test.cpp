@@ -0,0 +1,238 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <https://natrongithub.github.io/>,
+ * (C) 2018-2023 The Natron developers
+ * (C) 2013-2018 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "Global/Macros.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <QtCore/QElapsedTimer>
+
+#include <cairo/cairo.h>
+
+#include "Engine/RotoShapeRasterizer.h"
+
+#include "RotoRenderTestUtils.h"
+
+NATRON_NAMESPACE_USING
+
+// A closed shape made of nPoints cubic segments around (cx,cy) whose radius varies with the angle,
+// with a feather of the given width around it, as computed by RotoContextPrivate::computeBezierRenderData
+static RotoShapeRenderData
+makeShape(double cx,
+          double cy,
+          double radius,
+          double wobble,
+          int nPoints,
+          double featherWidth,
+          double fallOff)
+{
+    RotoShapeRenderData data;
+
+    data.fallOff = fallOff;
+
+    const int nFeatherPoints = nPoints * 16;
+    std::vector<Point> contour(nFeatherPoints + 1);
+    std::vector<Point> outer(nFeatherPoints + 1);
+    for (int i = 0; i <= nFeatherPoints; ++i) {
+        double a = 2. * M_PI * i / nFeatherPoints;
+        double r = radius * ( 1. + wobble * std::sin(3. * a) );
+        contour[i].x = cx + r * std::cos(a);
+        contour[i].y = cy + r * std::sin(a);
+        outer[i].x = cx + (r + featherWidth) * std::cos(a);
+        outer[i].y = cy + (r + featherWidth) * std::sin(a);
+    }
+    for (int i = 0; i < nFeatherPoints; ++i) {
+        RotoShapeRenderData::FeatherQuad q;
+        q.p0 = contour[i];
+        q.p1 = outer[i];
+        q.p2 = outer[i + 1];
+        q.p3 = contour[i + 1];
+        data.feather.push_back(q);
+    }
+    // Cubics through every 16th point of the contour, with tangents from the neighbouring points
+    for (int i = 0; i < nPoints; ++i) {
+        const Point& p0 = contour[i * 16];
+        const Point& p3 = contour[(i + 1) * 16];
+        const Point& p0n = contour[i * 16 + 1];
+        const Point& p3p = contour[(i + 1) * 16 - 1];
+        RotoShapeRenderData::Cubic c;
+        c.p0 = p0;
+        c.p1.x = p0.x + (p0n.x - p0.x) * 16. / 3.;
+        c.p1.y = p0.y + (p0n.y - p0.y) * 16. / 3.;
+        c.p2.x = p3.x + (p3p.x - p3.x) * 16. / 3.;
+        c.p2.y = p3.y + (p3p.y - p3.y) * 16. / 3.;
+        c.p3 = p3;
+        data.shape.push_back(c);
+    }
+
+    return data;
+}
+
+// Renders the samples like RotoContextPrivate::renderBezier does
+static std::vector<float>
+renderCairo(const std::vector<RotoShapeRenderData>& samples,
+            const RectI& roi)
+{
+    cairo_surface_t* surface = cairo_image_surface_create( CAIRO_FORMAT_A8, roi.width(), roi.height() );
+    cairo_surface_set_device_offset(surface, -roi.x1, -roi.y1);
+    cairo_t* cr = cairo_create(surface);
+    cairo_set_fill_rule(cr, CAIRO_FILL_RULE_WINDING);
+    cairo_set_antialias(cr, CAIRO_ANTIALIAS_NONE);
+
+    double shapeColor[3] = {1., 1., 1.};
+    for (std::size_t i = 0; i < samples.size(); ++i) {
+        for (int n = 0; n < samples[i].nSamples; ++n) {
+            cairo_set_operator(cr, CAIRO_OPERATOR_OVER);
+            cairo_new_path(cr);
+            cairo_pattern_t* mesh = cairo_pattern_create_mesh();
+            RotoShapeRasterizer::renderFeatherCairo(samples[i].feather, shapeColor, samples[i].fallOff, mesh);
+            RotoShapeRasterizer::renderShapeCairo(samples[i].shape, cr);
+            cairo_set_source(cr, mesh);
+            cairo_mask(cr, mesh);
+            cairo_pattern_destroy(mesh);
+        }
+    }
+
+    std::vector<float> ret = readCairoCoverage(surface, roi);
+    cairo_destroy(cr);
+    cairo_surface_destroy(surface);
+
+    return ret;
+}
+
+static void
+compareWithCairo(const std::vector<RotoShapeRenderData>& samples,
+                 const RectI& roi)
+{
+    std::function<void (float*)> renderSequential = [&](float* coverage) {
+        RotoShapeRasterizer::renderSequential(samples, roi, coverage);
+    };
+    std::function<bool (const CoverageTileWriter&)> renderTiled = [&](const CoverageTileWriter& writer) {
+        return RotoShapeRasterizer::render(samples, roi, writer);
+    };
+
+    expectCoverageMatchesCairo(renderCairo(samples, roi), roi, renderSequential, renderTiled);
+}
+
+TEST(RotoShapeRasterizer, MatchesCairo)
+{
+    RectI roi(-20, 10, 300, 280);
+    std::vector<RotoShapeRenderData> samples;
+
+    // no feather
+    samples.push_back( makeShape(140., 140., 80., 0.2, 8, 0., 1.) );
+    samples.back().feather.clear();
+    compareWithCairo(samples, roi);
+
+    // linear feather
+    samples.clear();
+    samples.push_back( makeShape(140., 140., 80., 0.2, 8, 30., 1.) );
+    compareWithCairo(samples, roi);
+
+    // feather fall-off, shape partly outside of the RoI
+    samples.clear();
+    samples.push_back( makeShape(20., 140., 100., 0.3, 12, 40., 2.5) );
+    compareWithCairo(samples, roi);
+}
+
+TEST(RotoShapeRasterizer, MotionBlur)
+{
+    RectI roi(0, 0, 256, 256);
+    std::vector<RotoShapeRenderData> samples;
+
+    for (int i = 0; i < 5; ++i) {
+        samples.push_back( makeShape(100. + i * 8., 128., 60., 0.1, 6, 15., 0.5) );
+    }
+    compareWithCairo(samples, roi);
+}
+
+TEST(RotoShapeRasterizer, StaticSamples)
+{
+    RectI roi(0, 0, 256, 256);
+    std::vector<RotoShapeRenderData> samples;
+    std::vector<RotoShapeRenderData> merged;
+
+    // the shape holds still for 4 samples, moves for 3 samples, then holds still again for 3 samples
+    const double positions[10] = { 100., 100., 100., 100., 106., 112., 118., 118., 118., 118. };
+    for (int i = 0; i < 10; ++i) {
+        samples.push_back( makeShape(positions[i], 128., 60., 0.1, 6, 15., 0.5) );
+        RotoShapeRenderData sample = makeShape(positions[i], 128., 60., 0.1, 6, 15., 0.5);
+        RotoShapeRasterizer::appendSample(sample, &merged);
+    }
+    ASSERT_EQ( (int)merged.size(), 4 );
+    EXPECT_EQ(merged[0].nSamples, 4);
+    EXPECT_EQ(merged[1].nSamples, 1);
+    EXPECT_EQ(merged[2].nSamples, 1);
+    EXPECT_EQ(merged[3].nSamples, 4);
+
+    std::vector<float> expected( (std::size_t)roi.width() * roi.height() );
+    std::vector<float> actual( expected.size() );
+    RotoShapeRasterizer::renderSequential(samples, roi, &expected.front());
+    RotoShapeRasterizer::renderSequential(merged, roi, &actual.front());
+    for (std::size_t i = 0; i < expected.size(); ++i) {
+        EXPECT_NEAR(expected[i], actual[i], 1e-5);
+    }
+
+    compareWithCairo(merged, roi);
+}
+
+// Run with --gtest_also_run_disabled_tests
+TEST(RotoShapeRasterizer, DISABLED_MotionBlurBenchmark)
+{
+    RectI roi(0, 0, 1024, 1024);
+    const int sampleCounts[6] = { 1, 2, 5, 10, 20, 40 };
+
+    std::vector<float> coverage( (std::size_t)roi.width() * roi.height() );
+    RotoShapeRasterizer::TileWriter writer = makeCoverageWriter(roi, &coverage);
+
+    for (int c = 0; c < 6; ++c) {
+        int nSamples = sampleCounts[c];
+        std::vector<RotoShapeRenderData> moving;
+        std::vector<RotoShapeRenderData> still;
+        for (int i = 0; i < nSamples; ++i) {
+            RotoShapeRenderData sample = makeShape(400. + i * 4., 512., 300., 0.2, 16, 40., 1.);
+            RotoShapeRasterizer::appendSample(sample, &moving);
+            sample = makeShape(400., 512., 300., 0.2, 16, 40., 1.);
+            RotoShapeRasterizer::appendSample(sample, &still);
+        }
+
+        QElapsedTimer timer;
+        timer.start();
+        EXPECT_TRUE( RotoShapeRasterizer::render(moving, roi, writer) );
+        double movingTime = (double)timer.nsecsElapsed() / 1e6;
+
+        timer.restart();
+        EXPECT_TRUE( RotoShapeRasterizer::render(still, roi, writer) );
+        double stillTime = (double)timer.nsecsElapsed() / 1e6;
+
+        std::cout << "RotoShapeRasterizer::render() " << roi.width() << "x" << roi.height() << " with " << nSamples
+                  << " motion blur samples: " << movingTime << " ms moving, " << stillTime << " ms static" << std::endl;
+    }
+}
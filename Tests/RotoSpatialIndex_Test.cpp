@@ -0,0 +1,218 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <https://natrongithub.github.io/>,
+ * (C) 2018-2023 The Natron developers
+ * (C) 2013-2018 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "Global/Macros.h"
+
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <QtCore/QElapsedTimer>
+
+#include "Engine/RotoSpatialIndex.h"
+
+NATRON_NAMESPACE_USING
+
+static double
+randomIn(double from,
+         double to)
+{
+    return from + (to - from) * ( std::rand() / (double)RAND_MAX );
+}
+
+// Mostly small shapes over a 1000x1000 area, with a few large, flat, empty and unbounded ones
+static RotoItemBounds
+randomBounds()
+{
+    RotoItemBounds ret;
+    int kind = std::rand() % 20;
+
+    if (kind == 0) {
+        ret.type = RotoItemBounds::eTypeUnbounded;
+    } else if (kind == 1) {
+        ret.type = RotoItemBounds::eTypeEmpty;
+    } else {
+        ret.type = RotoItemBounds::eTypeRect;
+        double x = randomIn(-100., 1100.);
+        double y = randomIn(-100., 1100.);
+        double w = (kind == 2) ? randomIn(0., 1000.) : randomIn(0., 40.);
+        double h = (kind == 3) ? 0. : randomIn(0., 40.);
+        ret.bbox = RectD(x, y, x + w, y + h);
+    }
+
+    return ret;
+}
+
+static bool
+intersects(const RotoItemBounds& bounds,
+           const RectD& rect)
+{
+    if (bounds.type != RotoItemBounds::eTypeRect) {
+        return bounds.type == RotoItemBounds::eTypeUnbounded;
+    }
+
+    return bounds.bbox.x1 <= rect.x2 && rect.x1 <= bounds.bbox.x2 && bounds.bbox.y1 <= rect.y2 && rect.y1 <= bounds.bbox.y2;
+}
+
+static void
+checkQuery(const RotoSpatialGrid& grid,
+           const std::vector<RotoItemBounds>& bounds,
+           const RectD& rect)
+{
+    std::vector<int> found;
+
+    grid.getItemsIntersecting(rect, &found);
+
+    std::vector<int> expected;
+    for (std::size_t i = 0; i < bounds.size(); ++i) {
+        if ( intersects(bounds[i], rect) ) {
+            expected.push_back( (int)i );
+        }
+    }
+    EXPECT_TRUE(found == expected);
+}
+
+static RectD
+randomQuery()
+{
+    double x = randomIn(-200., 1200.);
+    double y = randomIn(-200., 1200.);
+
+    if (std::rand() % 4 == 0) {
+        // a point, as for hit tests
+        return RectD(x, y, x, y);
+    }
+
+    return RectD( x, y, x + randomIn(0., 300.), y + randomIn(0., 300.) );
+}
+
+TEST(RotoSpatialGrid, MatchesLinearScan)
+{
+    std::srand(1);
+    for (int i = 0; i < 20; ++i) {
+        std::vector<RotoItemBounds> bounds( std::rand() % 1000 );
+        for (std::size_t j = 0; j < bounds.size(); ++j) {
+            bounds[j] = randomBounds();
+        }
+        RotoSpatialGrid grid;
+        grid.build(bounds);
+        for (int q = 0; q < 100; ++q) {
+            checkQuery( grid, bounds, randomQuery() );
+        }
+    }
+}
+
+TEST(RotoSpatialGrid, IncrementalUpdates)
+{
+    std::srand(2);
+    std::vector<RotoItemBounds> bounds(500);
+    for (std::size_t j = 0; j < bounds.size(); ++j) {
+        bounds[j] = randomBounds();
+    }
+    RotoSpatialGrid grid;
+    grid.build(bounds);
+
+    for (int q = 0; q < 2000; ++q) {
+        int index = std::rand() % (int)bounds.size();
+        bounds[index] = randomBounds();
+        if (std::rand() % 4 == 0) {
+            // moved out of the grid: clamped to the border cells
+            bounds[index].type = RotoItemBounds::eTypeRect;
+            bounds[index].bbox = RectD(5000., -3000., 5010., -2990.);
+        }
+        grid.update(index, bounds[index]);
+        checkQuery( grid, bounds, randomQuery() );
+        checkQuery( grid, bounds, RectD(4990., -3005., 5000., -2995.) );
+    }
+}
+
+TEST(RotoSpatialGrid, EmptyGrid)
+{
+    std::vector<RotoItemBounds> bounds(3);
+    RotoSpatialGrid grid;
+
+    grid.build(bounds);
+    checkQuery( grid, bounds, RectD(0., 0., 10., 10.) );
+
+    // an item drawing something after the grid was built without any box
+    bounds[1].type = RotoItemBounds::eTypeRect;
+    bounds[1].bbox = RectD(2., 2., 4., 4.);
+    grid.update(1, bounds[1]);
+    checkQuery( grid, bounds, RectD(0., 0., 10., 10.) );
+    checkQuery( grid, bounds, RectD(5., 5., 10., 10.) );
+}
+
+// Run with --gtest_also_run_disabled_tests
+TEST(RotoSpatialGrid, DISABLED_HitTestBenchmark)
+{
+    std::srand(3);
+    std::vector<RotoItemBounds> bounds(20000);
+    for (std::size_t j = 0; j < bounds.size(); ++j) {
+        bounds[j].type = RotoItemBounds::eTypeRect;
+        double x = randomIn(0., 10000.);
+        double y = randomIn(0., 10000.);
+        bounds[j].bbox = RectD( x, y, x + randomIn(0., 50.), y + randomIn(0., 50.) );
+    }
+
+    std::vector<RectD> queries(10000);
+    for (std::size_t q = 0; q < queries.size(); ++q) {
+        double x = randomIn(0., 10000.);
+        double y = randomIn(0., 10000.);
+        queries[q] = RectD(x - 5., y - 5., x + 5., y + 5.);
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    RotoSpatialGrid grid;
+    grid.build(bounds);
+    double buildTime = (double)timer.nsecsElapsed() / 1e6;
+
+    timer.restart();
+    std::size_t nFound = 0;
+    std::vector<int> found;
+    for (std::size_t q = 0; q < queries.size(); ++q) {
+        found.clear();
+        grid.getItemsIntersecting(queries[q], &found);
+        nFound += found.size();
+    }
+    double gridTime = (double)timer.nsecsElapsed() / 1e6;
+
+    timer.restart();
+    std::size_t nExpected = 0;
+    for (std::size_t q = 0; q < queries.size(); ++q) {
+        for (std::size_t j = 0; j < bounds.size(); ++j) {
+            if ( intersects(bounds[j], queries[q]) ) {
+                ++nExpected;
+            }
+        }
+    }
+    double linearTime = (double)timer.nsecsElapsed() / 1e6;
+
+    EXPECT_EQ(nFound, nExpected);
+    std::cout << queries.size() << " queries over " << bounds.size() << " items: grid " << gridTime << " ms (built in "
+              << buildTime << " ms), linear scan: " << linearTime << " ms" << std::endl;
+}
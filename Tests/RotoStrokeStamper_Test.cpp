@@ -0,0 +1,228 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <https://natrongithub.github.io/>,
+ * (C) 2018-2023 The Natron developers
+ * (C) 2013-2018 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "Global/Macros.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <QtCore/QElapsedTimer>
+
+#include <cairo/cairo.h>
+
+#include "Engine/RotoStrokeStamper.h"
+
+#include "RotoRenderTestUtils.h"
+
+NATRON_NAMESPACE_USING
+
+static RotoStrokeBrush
+makeBrush(double size,
+          double hardness,
+          double opacity,
+          bool doBuildUp)
+{
+    RotoStrokeBrush brush;
+
+    brush.opacity = opacity;
+    brush.brushSizePixel = size;
+    brush.brushHardness = hardness;
+    brush.brushSpacing = 0.1;
+    brush.writeOnStart = 0.;
+    brush.writeOnEnd = 1.;
+    brush.pressureAffectsOpacity = true;
+    brush.pressureAffectsSize = true;
+    brush.pressureAffectsHardness = false;
+    brush.doBuildUp = doBuildUp;
+
+    return brush;
+}
+
+// Dots along a sine wave whose pressure varies along the stroke
+static std::vector<RotoStrokeDot>
+makeDots(const RotoStrokeBrush& brush,
+         double x1,
+         double x2,
+         double y,
+         double amplitude)
+{
+    std::vector<RotoStrokeDot> dots;
+    double internalDotRadius, externalDotRadius, spacing = 1.;
+    std::vector<std::pair<double, double> > opacityStops;
+
+    for (double x = x1; x < x2; x += spacing) {
+        RotoStrokeDot dot;
+        dot.center.x = x;
+        dot.center.y = y + amplitude * std::sin(x / 20.);
+        dot.pressure = 0.5 + 0.5 * std::sin(x / 35.);
+        RotoStrokeStamper::getDotParams(brush.opacity, brush.brushSizePixel, brush.brushHardness, brush.brushSpacing, dot.pressure,
+                                        brush.pressureAffectsOpacity, brush.pressureAffectsSize, brush.pressureAffectsHardness,
+                                        &internalDotRadius, &externalDotRadius, &spacing, &opacityStops);
+        dot.externalDotRadius = externalDotRadius;
+        dots.push_back(dot);
+        spacing = std::max(spacing, 0.5);
+    }
+
+    return dots;
+}
+
+// Renders the dots like RotoContextPrivate::renderStrokeDots does
+static std::vector<float>
+renderCairo(const RotoStrokeBrush& brush,
+            const std::vector<RotoStrokeDot>& dots,
+            const RectI& roi)
+{
+    cairo_format_t format = brush.doBuildUp ? CAIRO_FORMAT_A8 : CAIRO_FORMAT_ARGB32;
+    cairo_surface_t* surface = cairo_image_surface_create( format, roi.width(), roi.height() );
+
+    cairo_surface_set_device_offset(surface, -roi.x1, -roi.y1);
+    cairo_t* cr = cairo_create(surface);
+    cairo_set_fill_rule(cr, CAIRO_FILL_RULE_WINDING);
+    cairo_set_antialias(cr, CAIRO_ANTIALIAS_NONE);
+    cairo_set_operator(cr, brush.doBuildUp ? CAIRO_OPERATOR_OVER : CAIRO_OPERATOR_LIGHTEN);
+
+    double internalDotRadius, externalDotRadius, spacing;
+    std::vector<std::pair<double, double> > opacityStops;
+    for (std::size_t i = 0; i < dots.size(); ++i) {
+        const RotoStrokeDot& dot = dots[i];
+        RotoStrokeStamper::getDotParams(brush.opacity, brush.brushSizePixel, brush.brushHardness, brush.brushSpacing, dot.pressure,
+                                        brush.pressureAffectsOpacity, brush.pressureAffectsSize, brush.pressureAffectsHardness,
+                                        &internalDotRadius, &externalDotRadius, &spacing, &opacityStops);
+        if ( !opacityStops.empty() ) {
+            cairo_pattern_t* pattern = cairo_pattern_create_radial(0, 0, internalDotRadius, 0, 0, externalDotRadius);
+            for (std::size_t s = 0; s < opacityStops.size(); ++s) {
+                if (brush.doBuildUp) {
+                    cairo_pattern_add_color_stop_rgba(pattern, opacityStops[s].first, 1., 1., 1., opacityStops[s].second);
+                } else {
+                    cairo_pattern_add_color_stop_rgba(pattern, opacityStops[s].first, opacityStops[s].second, opacityStops[s].second, opacityStops[s].second, 1);
+                }
+            }
+            cairo_translate(cr, dot.center.x, dot.center.y);
+            cairo_set_source(cr, pattern);
+            cairo_translate(cr, -dot.center.x, -dot.center.y);
+            cairo_pattern_destroy(pattern);
+        } else if (brush.doBuildUp) {
+            cairo_set_source_rgba(cr, 1., 1., 1., brush.opacity);
+        } else {
+            cairo_set_source_rgba(cr, brush.opacity, brush.opacity, brush.opacity, 1.);
+        }
+        cairo_arc(cr, dot.center.x, dot.center.y, externalDotRadius, 0, M_PI * 2);
+        cairo_fill(cr);
+    }
+
+    std::vector<float> ret = readCairoCoverage(surface, roi);
+    cairo_destroy(cr);
+    cairo_surface_destroy(surface);
+
+    return ret;
+} // renderCairo
+
+static void
+compareWithCairo(const RotoStrokeBrush& brush,
+                 const std::vector<RotoStrokeDot>& dots,
+                 const RectI& roi)
+{
+    std::function<void (float*)> renderSequential = [&](float* coverage) {
+        RotoStrokeStamper::renderSequential(brush, dots, roi, coverage);
+    };
+    std::function<bool (const CoverageTileWriter&)> renderTiled = [&](const CoverageTileWriter& writer) {
+        return RotoStrokeStamper::render(brush, dots, roi, writer);
+    };
+
+    expectCoverageMatchesCairo(renderCairo(brush, dots, roi), roi, renderSequential, renderTiled);
+}
+
+TEST(RotoStrokeStamper, BuildUpMatchesCairo)
+{
+    RectI roi(-10, 0, 300, 200);
+    RotoStrokeBrush brush = makeBrush(25., 0.2, 0.3, true);
+
+    compareWithCairo( brush, makeDots(brush, 0., 290., 100., 50.), roi );
+}
+
+TEST(RotoStrokeStamper, LightenMatchesCairo)
+{
+    RectI roi(0, 0, 300, 200);
+    RotoStrokeBrush brush = makeBrush(30., 0.5, 0.8, false);
+
+    compareWithCairo( brush, makeDots(brush, -20., 320., 100., 60.), roi );
+}
+
+TEST(RotoStrokeStamper, HardBrushMatchesCairo)
+{
+    RectI roi(0, 0, 256, 256);
+    RotoStrokeBrush brush = makeBrush(12., 1., 0.5, true);
+
+    compareWithCairo( brush, makeDots(brush, 10., 250., 128., 80.), roi );
+}
+
+TEST(RotoStrokeStamper, DabMask)
+{
+    const int size = 31;
+    std::vector<float> mask;
+
+    RotoStrokeStamper::renderDabMask(size, 0.3, 1., &mask);
+    ASSERT_EQ( (int)mask.size(), (size + 1) * (size + 1) );
+
+    // the dab is opaque in its center, transparent in the corners, and decreases along a radius
+    EXPECT_NEAR(mask[(size / 2) * (size + 1) + size / 2], 1., 1e-3);
+    EXPECT_EQ(mask[0], 0.f);
+    EXPECT_EQ(mask[(size + 1) * (size + 1) - 1], 0.f);
+    for (int x = size / 2; x < size; ++x) {
+        EXPECT_GE( mask[(size / 2) * (size + 1) + x], mask[(size / 2) * (size + 1) + x + 1] );
+    }
+}
+
+// Run with --gtest_also_run_disabled_tests
+TEST(RotoStrokeStamper, DISABLED_DenseStrokesBenchmark)
+{
+    RectI roi(0, 0, 1024, 1024);
+    RotoStrokeBrush brush = makeBrush(40., 0.3, 0.2, true);
+    std::vector<RotoStrokeDot> dots;
+
+    for (int i = 0; i < 100; ++i) {
+        std::vector<RotoStrokeDot> strokeDots = makeDots(brush, 0., 1024., 5. + i * 10., 30.);
+        dots.insert( dots.end(), strokeDots.begin(), strokeDots.end() );
+    }
+
+    std::vector<float> coverage( (std::size_t)roi.width() * roi.height() );
+    RotoStrokeStamper::TileWriter writer = makeCoverageWriter(roi, &coverage);
+
+    QElapsedTimer timer;
+    timer.start();
+    EXPECT_TRUE( RotoStrokeStamper::render(brush, dots, roi, writer) );
+    double nativeTime = (double)timer.nsecsElapsed() / 1e6;
+
+    timer.restart();
+    std::vector<float> reference = renderCairo(brush, dots, roi);
+    double cairoTime = (double)timer.nsecsElapsed() / 1e6;
+
+    std::cout << "RotoStrokeStamper::render() " << roi.width() << "x" << roi.height() << " with " << dots.size()
+              << " dots: " << nativeTime << " ms, cairo: " << cairoTime << " ms" << std::endl;
+}
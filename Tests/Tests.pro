@@ -44,15 +44,21 @@ SOURCES += \
     google-test/src/gtest-all.cc \
     google-mock/src/gmock-all.cc \
     BaseTest.cpp \
+    CoonsRegularization_Test.cpp \
     Curve_Test.cpp \
     FileSystemModel_Test.cpp \
+    FrameAdmission_Test.cpp \
     Hash64_Test.cpp \
     Image_Test.cpp \
     KnobFile_Test.cpp \
     Lut_Test.cpp \
     OSGLContext_Test.cpp \
+    RotoShapeRasterizer_Test.cpp \
+    RotoSpatialIndex_Test.cpp \
+    RotoStrokeStamper_Test.cpp \
     Tracker_Test.cpp \
     wmain.cpp
 
 HEADERS += \
-    BaseTest.h
+    BaseTest.h \
+    RotoRenderTestUtils.h